@@ -0,0 +1,65 @@
+#pragma once
+
+#include <hal/timer.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Microbenchmarks timed with hal_cycle_count(): CPU cycles on the board,
+// nanoseconds on the host's Linux backend.
+//
+// A benchmark runs BENCH_BATCHES batches of `iterations` calls after one
+// warm-up call, and keeps the cycles per call of each batch. Results are
+// quantiles over the batches, so a batch that was preempted moves the max
+// but not the median. They print as CSV lines starting with "bench", which
+// stand out of the board's console log:
+//
+//   bench,name,iterations,batches,cycles_min,cycles_p25,cycles_median,
+//       cycles_p75,cycles_max,ns_median
+//
+// A batch must take less than 2^32 cycles (about 4 s on the host).
+
+constexpr size_t BENCH_BATCHES = 15;
+
+struct BenchResult {
+  const char* name;
+  // Calls per batch.
+  uint32_t iterations;
+  uint32_t batches;
+  // Cycles per call.
+  float cycles_min;
+  float cycles_p25;
+  float cycles_median;
+  float cycles_p75;
+  float cycles_max;
+  float ns_median;
+};
+
+// Keeps the compiler from dropping the computation of `value`.
+template <typename T>
+inline void bench_keep(const T& value) {
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+// Summarizes the cycles each of `batches` batches of `iterations` calls took.
+// Sorts `batch_cycles`.
+BenchResult bench_summarize(const char* name, uint32_t iterations,
+                            uint32_t* batch_cycles, size_t batches);
+
+// Times `fn()`. See above.
+template <typename Fn>
+BenchResult bench_run(const char* name, uint32_t iterations, Fn&& fn) {
+  uint32_t batch_cycles[BENCH_BATCHES];
+  fn();
+  for (size_t batch = 0; batch < BENCH_BATCHES; batch++) {
+    const uint32_t start = hal_cycle_count();
+    for (uint32_t i = 0; i < iterations; i++) {
+      fn();
+    }
+    batch_cycles[batch] = hal_cycle_count() - start;
+  }
+  return bench_summarize(name, iterations, batch_cycles, BENCH_BATCHES);
+}
+
+void bench_print_header();
+void bench_print(const BenchResult& result);
@@ -0,0 +1,49 @@
+#include "bench/bench.h"
+
+#include <hal/timer.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Nearest rank of quantile `q` of `sorted`, per call.
+static float quantile(const uint32_t* sorted, size_t count, float q,
+                      uint32_t iterations) {
+  const size_t rank = static_cast<size_t>(q * (count - 1) + 0.5f);
+  return static_cast<float>(sorted[rank]) / iterations;
+}
+
+BenchResult bench_summarize(const char* name, uint32_t iterations,
+                            uint32_t* batch_cycles, size_t batches) {
+  BenchResult result = {};
+  result.name = name;
+  result.iterations = iterations;
+  result.batches = batches;
+  if (batches == 0 || iterations == 0) {
+    return result;
+  }
+  std::sort(batch_cycles, batch_cycles + batches);
+  result.cycles_min = quantile(batch_cycles, batches, 0, iterations);
+  result.cycles_p25 = quantile(batch_cycles, batches, 0.25f, iterations);
+  result.cycles_median = quantile(batch_cycles, batches, 0.5f, iterations);
+  result.cycles_p75 = quantile(batch_cycles, batches, 0.75f, iterations);
+  result.cycles_max = quantile(batch_cycles, batches, 1, iterations);
+  result.ns_median = result.cycles_median * 1000 / hal_cycles_per_us();
+  return result;
+}
+
+void bench_print_header() {
+  std::printf(
+      "bench,name,iterations,batches,cycles_min,cycles_p25,cycles_median,"
+      "cycles_p75,cycles_max,ns_median\n");
+}
+
+void bench_print(const BenchResult& result) {
+  std::printf("bench,%s,%u,%u,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n", result.name,
+              static_cast<unsigned>(result.iterations),
+              static_cast<unsigned>(result.batches), result.cycles_min,
+              result.cycles_p25, result.cycles_median, result.cycles_p75,
+              result.cycles_max, result.ns_median);
+  std::fflush(stdout);
+}
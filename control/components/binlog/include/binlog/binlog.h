@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Binary deferred logging.
+//
+// A call site stores a format id and its raw arguments instead of formatting
+// text: no printf, no UART, a few dozen bytes copied. A background task ships
+// the records and the host expands them with the same format table (see
+// control/src/configs/log_format_config.h).
+//
+// Arguments are stored as 32-bit words: integers up to 32 bits (and enums)
+// as is, floating point as float. The format string decides how each word is
+// printed, so its conversions must match: %d/%i for signed, %u/%x/%X/%c for
+// unsigned, %f/%e/%g for floating point. Strings can't be deferred.
+
+constexpr size_t BINLOG_MAX_ARGS = 6;
+
+struct BinLogRecord {
+  uint64_t t_us;
+  uint16_t format;
+  uint8_t arg_count;
+  // CPU core the record was written on.
+  uint8_t core;
+  uint32_t args[BINLOG_MAX_ARGS];
+};
+
+template <typename T>
+uint32_t binlog_arg(T value) {
+  if constexpr (std::is_floating_point_v<T>) {
+    float f = static_cast<float>(value);
+    uint32_t word;
+    std::memcpy(&word, &f, sizeof(word));
+    return word;
+  } else {
+    static_assert(std::is_integral_v<T> || std::is_enum_v<T>,
+                  "Only numbers can be deferred");
+    static_assert(sizeof(T) <= sizeof(uint32_t),
+                  "64-bit arguments are not supported");
+    return static_cast<uint32_t>(value);
+  }
+}
+
+template <typename... Args>
+BinLogRecord make_binlog_record(uint64_t t_us, uint16_t format,
+                                Args... args) {
+  static_assert(sizeof...(Args) <= BINLOG_MAX_ARGS, "Too many arguments");
+  return {
+      .t_us = t_us,
+      .format = format,
+      .arg_count = sizeof...(Args),
+      .core = 0,
+      .args = {binlog_arg(args)...},
+  };
+}
+
+// Wire form of a record, little-endian:
+//   T_US (u32) | FORMAT (u16) | CORE << 4 | ARG_COUNT (u8) | ARG (u32)...
+// T_US wraps every 71 minutes; the expander unwraps it.
+constexpr size_t BINLOG_RECORD_MAX_SIZE = 7 + 4 * BINLOG_MAX_ARGS;
+
+size_t encode_binlog_record(const BinLogRecord& record, uint8_t* out,
+                            size_t out_cap);
+// Returns false if `data` is not a whole record.
+bool decode_binlog_record(const uint8_t* data, size_t len,
+                          BinLogRecord* record);
+
+// Records travel over the text console as lines of BINLOG_LINE_PREFIX
+// followed by the wire form in hex, so they can share the UART with
+// ESP_LOG output. Returns the line length without the terminating NUL, or 0
+// if `out_cap` is too small.
+constexpr char BINLOG_LINE_PREFIX[] = "#BL ";
+constexpr size_t BINLOG_LINE_MAX_SIZE =
+    sizeof(BINLOG_LINE_PREFIX) + 2 * BINLOG_RECORD_MAX_SIZE + 1;
+size_t format_binlog_line(const BinLogRecord& record, char* out,
+                          size_t out_cap);
+// Parses a console line (without the newline). Returns false for lines that
+// are not binlog records.
+bool parse_binlog_line(const char* line, size_t len, BinLogRecord* record);
@@ -0,0 +1,111 @@
+#include "binlog/binlog.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+constexpr size_t PREFIX_SIZE = sizeof(BINLOG_LINE_PREFIX) - 1;
+
+void put_le(uint8_t* out, uint32_t value, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    out[i] = value >> (8 * i);
+  }
+}
+
+uint32_t get_le(const uint8_t* data, size_t size) {
+  uint32_t value = 0;
+  for (size_t i = 0; i < size; i++) {
+    value |= static_cast<uint32_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+int hex_value(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+}  // namespace
+
+size_t encode_binlog_record(const BinLogRecord& record, uint8_t* out,
+                            size_t out_cap) {
+  size_t size = 7 + 4 * record.arg_count;
+  if (record.arg_count > BINLOG_MAX_ARGS || size > out_cap) {
+    return 0;
+  }
+  put_le(&out[0], static_cast<uint32_t>(record.t_us), 4);
+  put_le(&out[4], record.format, 2);
+  out[6] = (record.core << 4) | record.arg_count;
+  for (size_t i = 0; i < record.arg_count; i++) {
+    put_le(&out[7 + 4 * i], record.args[i], 4);
+  }
+  return size;
+}
+
+bool decode_binlog_record(const uint8_t* data, size_t len,
+                          BinLogRecord* record) {
+  if (len < 7) {
+    return false;
+  }
+  uint8_t arg_count = data[6] & 0x0F;
+  if (arg_count > BINLOG_MAX_ARGS || len != 7 + 4 * static_cast<size_t>(arg_count)) {
+    return false;
+  }
+  record->t_us = get_le(&data[0], 4);
+  record->format = get_le(&data[4], 2);
+  record->core = data[6] >> 4;
+  record->arg_count = arg_count;
+  for (size_t i = 0; i < arg_count; i++) {
+    record->args[i] = get_le(&data[7 + 4 * i], 4);
+  }
+  return true;
+}
+
+size_t format_binlog_line(const BinLogRecord& record, char* out,
+                          size_t out_cap) {
+  uint8_t wire[BINLOG_RECORD_MAX_SIZE];
+  size_t size = encode_binlog_record(record, wire, sizeof(wire));
+  size_t line_len = PREFIX_SIZE + 2 * size;
+  if (size == 0 || line_len + 1 > out_cap) {
+    return 0;
+  }
+  std::memcpy(out, BINLOG_LINE_PREFIX, PREFIX_SIZE);
+  for (size_t i = 0; i < size; i++) {
+    out[PREFIX_SIZE + 2 * i] = HEX_DIGITS[wire[i] >> 4];
+    out[PREFIX_SIZE + 2 * i + 1] = HEX_DIGITS[wire[i] & 0x0F];
+  }
+  out[line_len] = '\0';
+  return line_len;
+}
+
+bool parse_binlog_line(const char* line, size_t len, BinLogRecord* record) {
+  // Tolerate the carriage return of a serial monitor.
+  if (len > 0 && line[len - 1] == '\r') {
+    len--;
+  }
+  if (len < PREFIX_SIZE ||
+      std::memcmp(line, BINLOG_LINE_PREFIX, PREFIX_SIZE) != 0 ||
+      (len - PREFIX_SIZE) % 2 != 0 ||
+      (len - PREFIX_SIZE) / 2 > BINLOG_RECORD_MAX_SIZE) {
+    return false;
+  }
+  uint8_t wire[BINLOG_RECORD_MAX_SIZE];
+  size_t size = (len - PREFIX_SIZE) / 2;
+  for (size_t i = 0; i < size; i++) {
+    int high = hex_value(line[PREFIX_SIZE + 2 * i]);
+    int low = hex_value(line[PREFIX_SIZE + 2 * i + 1]);
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    wire[i] = (high << 4) | low;
+  }
+  return decode_binlog_record(wire, size, record);
+}
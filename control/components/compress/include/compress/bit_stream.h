@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Most significant bit first bit packing into a caller-owned byte buffer.
+// Bits are gathered in a 64-bit accumulator and stored a byte at a time, so
+// a write or read costs a few shifts rather than a loop over its bits.
+
+class BitWriter {
+ public:
+  BitWriter(uint8_t* out, size_t cap) : out_(out), cap_(cap) {}
+
+  // Appends the low `n` bits of `bits`, 0 <= n <= 32. Bits past the end of
+  // the buffer are dropped; check remaining_bits() first.
+  void write(uint32_t bits, int n) {
+    acc_ = (acc_ << n) | (bits & mask(n));
+    acc_bits_ += n;
+    while (acc_bits_ >= 8) {
+      acc_bits_ -= 8;
+      if (pos_ < cap_) {
+        out_[pos_] = acc_ >> acc_bits_;
+      }
+      pos_++;
+    }
+  }
+
+  void write64(uint64_t bits) {
+    write(bits >> 32, 32);
+    write(bits, 32);
+  }
+
+  // Pads the last byte with zeros. Returns the number of bytes written.
+  size_t flush() {
+    if (acc_bits_ > 0) {
+      write(0, 8 - acc_bits_);
+    }
+    return pos_;
+  }
+
+  size_t bits() const { return pos_ * 8 + acc_bits_; }
+  size_t remaining_bits() const { return cap_ * 8 - bits(); }
+
+ private:
+  static uint64_t mask(int n) { return (uint64_t{1} << n) - 1; }
+
+  uint8_t* out_;
+  size_t cap_;
+  size_t pos_ = 0;
+  uint64_t acc_ = 0;
+  int acc_bits_ = 0;
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t* data, size_t len) : data_(data), len_(len) {}
+
+  // Reads `n` bits, 0 <= n <= 32. Reading past the end returns zeros and
+  // sets overrun().
+  uint32_t read(int n) {
+    while (acc_bits_ < n) {
+      uint8_t byte = 0;
+      if (pos_ < len_) {
+        byte = data_[pos_];
+      } else {
+        overrun_ = true;
+      }
+      pos_++;
+      acc_ = (acc_ << 8) | byte;
+      acc_bits_ += 8;
+    }
+    acc_bits_ -= n;
+    return (acc_ >> acc_bits_) & ((uint64_t{1} << n) - 1);
+  }
+
+  uint64_t read64() {
+    uint64_t high = read(32);
+    return high << 32 | read(32);
+  }
+
+  // Counts one bits up to `max_ones`, consuming the zero that ends them, if
+  // any. With max_ones = 4: 0 -> 0, 10 -> 1, 110 -> 2, 1110 -> 3, 1111 -> 4.
+  int read_prefix(int max_ones) {
+    int ones = 0;
+    while (ones < max_ones && read(1) == 1) {
+      ones++;
+    }
+    return ones;
+  }
+
+  bool overrun() const { return overrun_; }
+
+ private:
+  const uint8_t* data_;
+  size_t len_;
+  size_t pos_ = 0;
+  uint64_t acc_ = 0;
+  int acc_bits_ = 0;
+  bool overrun_ = false;
+};
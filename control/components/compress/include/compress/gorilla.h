@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "compress/bit_stream.h"
+
+// Streaming compression of one channel's (timestamp, value) samples, after
+// Facebook's Gorilla (Pelkonen et al., VLDB 2015). Sensors change slowly
+// next to the sample rate, so most samples cost a few bits instead of 12
+// bytes: timestamps as the change of the sample interval (delta-of-delta),
+// values as the XOR with the previous value, of which only the bits that
+// changed are stored.
+//
+// Samples are compressed into self-contained blocks of at most the buffer
+// given to the encoder (e.g. a frame payload or a flash page), so RAM is
+// bounded and a lost block loses nothing else. Block layout:
+//
+//   COUNT (u16) | T0 (64 bits) | V0 (32 bits) | COUNT - 1 samples...
+//
+// Each sample, MSB first:
+//
+//   delta-of-delta of t_us:  0                      0
+//                            10   + 7 bits          [-64, 63]
+//                            110  + 10 bits         [-512, 511]
+//                            1110 + 16 bits         [-32768, 32767]
+//                            1111 + 64 bits         anything else
+//   value XOR previous:      0                      same value
+//                            10 + bits              changed bits within the
+//                                                   previous window
+//                            11 + 5 bits leading zeros + 5 bits length - 1
+//                               + bits              new window
+
+constexpr size_t GORILLA_HEADER_SIZE = 2;
+// Largest encoding of a sample: 4 + 64 bits of timestamp, 2 + 5 + 5 + 32
+// bits of value.
+constexpr size_t GORILLA_MAX_SAMPLE_BITS = 112;
+// Smallest buffer holding a block of one sample.
+constexpr size_t GORILLA_MIN_BLOCK_SIZE = GORILLA_HEADER_SIZE + 12;
+
+class GorillaEncoder {
+ public:
+  // Compresses into `out`, which must hold at least GORILLA_MIN_BLOCK_SIZE
+  // bytes.
+  GorillaEncoder(uint8_t* out, size_t cap);
+
+  // Adds a sample. Returns false, leaving the block unchanged, if the block
+  // is full; finish() it and start the next with reset().
+  bool append(uint64_t t_us, float value);
+
+  // Completes the block. Returns its size in bytes.
+  size_t finish();
+  // Starts a new, empty block in the same buffer.
+  void reset();
+
+  uint16_t count() const { return count_; }
+  // Size of the block so far.
+  size_t size() const;
+
+ private:
+  void append_time(uint64_t t_us);
+  void append_value(uint32_t bits);
+
+  uint8_t* out_;
+  size_t cap_;
+  // Starts after the header, which finish() fills in.
+  BitWriter writer_;
+  uint16_t count_ = 0;
+  uint64_t prev_t_us_ = 0;
+  int64_t prev_delta_us_ = 0;
+  uint32_t prev_bits_ = 0;
+  // Zeros before and after the window that changed value bits are stored
+  // in. Set once a value has changed.
+  bool has_window_ = false;
+  int prev_leading_ = 0;
+  int prev_trailing_ = 0;
+};
+
+// Reads back a block written by GorillaEncoder.
+class GorillaDecoder {
+ public:
+  GorillaDecoder(const uint8_t* data, size_t len);
+
+  // Decodes the next sample. Returns false after the last one, or if the
+  // block is truncated (see error()).
+  bool next(uint64_t* t_us, float* value);
+
+  uint16_t count() const { return count_; }
+  bool error() const { return error_; }
+
+ private:
+  BitReader reader_;
+  uint16_t count_ = 0;
+  uint16_t decoded_ = 0;
+  bool error_ = false;
+  uint64_t prev_t_us_ = 0;
+  int64_t prev_delta_us_ = 0;
+  uint32_t prev_bits_ = 0;
+  // Mirrors GorillaEncoder's state.
+  bool has_window_ = false;
+  int prev_leading_ = 0;
+  int prev_trailing_ = 0;
+};
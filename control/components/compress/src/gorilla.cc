@@ -0,0 +1,191 @@
+#include "compress/gorilla.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "compress/bit_stream.h"
+
+namespace {
+
+uint32_t float_bits(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float bits_float(uint32_t bits) {
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Sign-extends the low `n` bits of `bits`.
+int64_t sign_extend(uint64_t bits, int n) {
+  uint64_t sign = uint64_t{1} << (n - 1);
+  return static_cast<int64_t>((bits ^ sign) - sign);
+}
+
+}  // namespace
+
+GorillaEncoder::GorillaEncoder(uint8_t* out, size_t cap)
+    : out_(out),
+      cap_(cap),
+      writer_(out + GORILLA_HEADER_SIZE, cap - GORILLA_HEADER_SIZE) {}
+
+void GorillaEncoder::reset() {
+  writer_ = BitWriter(out_ + GORILLA_HEADER_SIZE, cap_ - GORILLA_HEADER_SIZE);
+  count_ = 0;
+}
+
+size_t GorillaEncoder::size() const {
+  return GORILLA_HEADER_SIZE + (writer_.bits() + 7) / 8;
+}
+
+bool GorillaEncoder::append(uint64_t t_us, float value) {
+  if (count_ == UINT16_MAX ||
+      writer_.remaining_bits() < GORILLA_MAX_SAMPLE_BITS) {
+    return false;
+  }
+  uint32_t bits = float_bits(value);
+  if (count_ == 0) {
+    writer_.write64(t_us);
+    writer_.write(bits, 32);
+    prev_delta_us_ = 0;
+    // The first changed value opens a window.
+    has_window_ = false;
+  } else {
+    append_time(t_us);
+    append_value(bits);
+  }
+  prev_t_us_ = t_us;
+  prev_bits_ = bits;
+  count_++;
+  return true;
+}
+
+void GorillaEncoder::append_time(uint64_t t_us) {
+  int64_t delta_us = static_cast<int64_t>(t_us - prev_t_us_);
+  int64_t dod = delta_us - prev_delta_us_;
+  prev_delta_us_ = delta_us;
+  if (dod == 0) {
+    writer_.write(0b0, 1);
+  } else if (dod >= -64 && dod <= 63) {
+    writer_.write(0b10, 2);
+    writer_.write(dod, 7);
+  } else if (dod >= -512 && dod <= 511) {
+    writer_.write(0b110, 3);
+    writer_.write(dod, 10);
+  } else if (dod >= -32768 && dod <= 32767) {
+    writer_.write(0b1110, 4);
+    writer_.write(dod, 16);
+  } else {
+    writer_.write(0b1111, 4);
+    writer_.write64(dod);
+  }
+}
+
+void GorillaEncoder::append_value(uint32_t bits) {
+  uint32_t xored = bits ^ prev_bits_;
+  if (xored == 0) {
+    writer_.write(0b0, 1);
+    return;
+  }
+  int leading = __builtin_clz(xored);
+  int trailing = __builtin_ctz(xored);
+  // Reuse the previous window when the changed bits fall inside it.
+  if (has_window_ && leading >= prev_leading_ && trailing >= prev_trailing_) {
+    writer_.write(0b10, 2);
+    writer_.write(xored >> prev_trailing_, 32 - prev_leading_ - prev_trailing_);
+    return;
+  }
+  int length = 32 - leading - trailing;
+  writer_.write(0b11, 2);
+  writer_.write(leading, 5);
+  writer_.write(length - 1, 5);
+  writer_.write(xored >> trailing, length);
+  prev_leading_ = leading;
+  prev_trailing_ = trailing;
+  has_window_ = true;
+}
+
+size_t GorillaEncoder::finish() {
+  out_[0] = count_ & 0xFF;
+  out_[1] = count_ >> 8;
+  return GORILLA_HEADER_SIZE + writer_.flush();
+}
+
+GorillaDecoder::GorillaDecoder(const uint8_t* data, size_t len)
+    : reader_(data + GORILLA_HEADER_SIZE,
+              len < GORILLA_HEADER_SIZE ? 0 : len - GORILLA_HEADER_SIZE) {
+  if (len < GORILLA_HEADER_SIZE) {
+    error_ = true;
+    return;
+  }
+  count_ = data[0] | (data[1] << 8);
+}
+
+bool GorillaDecoder::next(uint64_t* t_us, float* value) {
+  if (error_ || decoded_ == count_) {
+    return false;
+  }
+  if (decoded_ == 0) {
+    prev_t_us_ = reader_.read64();
+    prev_bits_ = reader_.read(32);
+    has_window_ = false;
+  } else {
+    int64_t dod;
+    switch (reader_.read_prefix(4)) {
+      case 0:
+        dod = 0;
+        break;
+      case 1:
+        dod = sign_extend(reader_.read(7), 7);
+        break;
+      case 2:
+        dod = sign_extend(reader_.read(10), 10);
+        break;
+      case 3:
+        dod = sign_extend(reader_.read(16), 16);
+        break;
+      default:
+        dod = static_cast<int64_t>(reader_.read64());
+        break;
+    }
+    prev_delta_us_ += dod;
+    prev_t_us_ += prev_delta_us_;
+
+    switch (reader_.read_prefix(2)) {
+      case 0:
+        break;
+      case 1:
+        if (!has_window_) {
+          error_ = true;
+          return false;
+        }
+        prev_bits_ ^= reader_.read(32 - prev_leading_ - prev_trailing_)
+                      << prev_trailing_;
+        break;
+      default: {
+        prev_leading_ = reader_.read(5);
+        int length = reader_.read(5) + 1;
+        prev_trailing_ = 32 - prev_leading_ - length;
+        if (prev_trailing_ < 0) {
+          error_ = true;
+          return false;
+        }
+        prev_bits_ ^= reader_.read(length) << prev_trailing_;
+        has_window_ = true;
+        break;
+      }
+    }
+  }
+  if (reader_.overrun()) {
+    error_ = true;
+    return false;
+  }
+  decoded_++;
+  *t_us = prev_t_us_;
+  *value = bits_float(prev_bits_);
+  return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "datalog/flash_log.h"
+
+// Always-on RAM ring of the most recent N records, for pre-trigger capture.
+//
+// Producers push full-rate records from any task; each push is wait-free and
+// overwrites the oldest record. When a trigger fires (an abort, a sequencer
+// step, a manual mark), freeze() stops producers from writing so the ring
+// holds the moments before the trigger. Once settled() the contents can be
+// read out, e.g. into the FlashLog, and thaw() starts over.
+//
+// freeze() never waits for producers, which the freezing task may have
+// preempted on the same core; poll settled() instead.
+
+template <size_t N>
+class CaptureRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  // Producer side, from any number of tasks. Returns false while frozen, in
+  // which case the record is not kept.
+  bool push(const LogRecord& record) {
+    pushing_.fetch_add(1);
+    bool kept = !frozen_.load();
+    if (kept) {
+      uint32_t index = head_.fetch_add(1, std::memory_order_relaxed);
+      slots_[index & (N - 1)] = record;
+    }
+    pushing_.fetch_sub(1);
+    return kept;
+  }
+
+  void freeze() { frozen_.store(true); }
+  bool frozen() const { return frozen_.load(std::memory_order_relaxed); }
+  // True once frozen and no push is still writing a slot.
+  bool settled() const { return frozen_.load() && pushing_.load() == 0; }
+
+  // Records held, once settled().
+  size_t size() const {
+    return std::min<size_t>(head_.load(std::memory_order_relaxed), N);
+  }
+  // The i-th oldest record, once settled().
+  const LogRecord& at(size_t i) const {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    return slots_[(head - size() + i) & (N - 1)];
+  }
+
+  // Empties the ring and lets producers in again.
+  void thaw() {
+    head_.store(0, std::memory_order_relaxed);
+    frozen_.store(false);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  std::array<LogRecord, N> slots_{};
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> pushing_{0};
+  std::atomic<bool> frozen_{false};
+};
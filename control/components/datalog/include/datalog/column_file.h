@@ -0,0 +1,189 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "datalog/flash_log.h"
+#include "datalog/flash_storage.h"
+
+// Columnar capture file, for post-test analysis.
+//
+// Samples are grouped per channel into fixed-size blocks holding a timestamp
+// column and a value column, so a host can memory-map the file and read any
+// channel as arrays without parsing or copying. Layout, little-endian, every
+// struct 8-byte aligned:
+//
+//   ColumnFileHeader                     at offset 0
+//   ColumnBlock...                       channels interleaved as they fill up
+//   ColumnIndexEntry[block_count]        at header.index_offset (the footer)
+//
+// The header is written first with index_offset and block_count left erased
+// (0xFFFFFFFF); finish() programs them after writing the index, which NOR
+// flash allows without erasing. A file that was never finished (e.g. a reset
+// mid-capture) can still be read by walking the blocks after the header until
+// one lacks COLUMN_BLOCK_MAGIC.
+
+constexpr uint32_t COLUMN_FILE_MAGIC = 0x4C4F4347;   // "GCOL"
+constexpr uint32_t COLUMN_BLOCK_MAGIC = 0x4B4C4247;  // "GBLK"
+constexpr uint16_t COLUMN_FILE_VERSION = 1;
+constexpr uint32_t COLUMN_UNFINISHED = 0xFFFFFFFF;
+
+constexpr size_t COLUMN_MAX_CHANNELS = 16;
+constexpr size_t COLUMN_BLOCK_SAMPLES = 256;
+
+// What a channel holds, in flash log terms: the type and id of the records
+// it collects (e.g. kPt and a Pt).
+struct ColumnChannel {
+  RecordType type;
+  uint8_t id;
+  uint16_t reserved;
+};
+
+struct ColumnFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t channel_count;
+  uint32_t block_samples;
+  // Flash log session the samples come from.
+  uint32_t session;
+  uint32_t index_offset;
+  uint32_t block_count;
+  ColumnChannel channels[COLUMN_MAX_CHANNELS];
+};
+static_assert(sizeof(ColumnFileHeader) % 8 == 0, "Blocks must stay aligned");
+
+struct ColumnBlockHeader {
+  uint32_t magic;
+  uint16_t channel;
+  // Valid samples in the block; the rest of the columns is padding.
+  uint16_t count;
+  uint64_t t_first_us;
+  uint64_t t_last_us;
+  float min;
+  float max;
+  float mean;
+  uint32_t reserved;
+};
+
+struct ColumnBlock {
+  ColumnBlockHeader header;
+  uint64_t t_us[COLUMN_BLOCK_SAMPLES];
+  float value[COLUMN_BLOCK_SAMPLES];
+};
+static_assert(sizeof(ColumnBlock) % 8 == 0, "Blocks must stay aligned");
+
+// A block's header with its offset in place of the magic.
+struct ColumnIndexEntry {
+  uint32_t offset;
+  uint16_t channel;
+  uint16_t count;
+  uint64_t t_first_us;
+  uint64_t t_last_us;
+  float min;
+  float max;
+  float mean;
+  uint32_t reserved;
+};
+static_assert(sizeof(ColumnIndexEntry) == sizeof(ColumnBlockHeader),
+              "Index entries mirror block headers");
+
+struct ColumnWriterStats {
+  uint32_t samples;
+  uint32_t blocks;
+  // Samples older than the last one of their channel, dropped.
+  uint32_t out_of_order;
+  // Samples dropped because the region was full or a write failed.
+  uint32_t dropped;
+};
+
+// Writes a column file to the start of a flash region, erasing sectors just
+// ahead of each write. Not thread-safe: use from a single task.
+class ColumnWriter {
+ public:
+  // `blocks` buffers the block being filled for each channel and must have an
+  // entry per channel of the files opened.
+  ColumnWriter(FlashStorage* storage, ColumnBlock* blocks)
+      : storage_(storage), blocks_(blocks) {}
+
+  // Starts a file with `channel_count` channels, replacing whatever the
+  // region held. Returns false if the region is too small or can't be
+  // written.
+  bool open(const ColumnChannel* channels, uint16_t channel_count,
+            uint32_t session);
+
+  // Adds a sample to `channel`. Timestamps must not decrease within a
+  // channel. Returns false if the sample was dropped.
+  bool append(uint16_t channel, uint64_t t_us, float value);
+  // Like append(), to the channel collecting `record`. Returns false if no
+  // channel does.
+  bool append(const LogRecord& record);
+
+  // Writes the partially filled blocks and the index. Returns false if they
+  // didn't fit.
+  bool finish();
+
+  ColumnWriterStats stats() const { return stats_; }
+  // Size of the file so far.
+  uint32_t bytes_written() const { return end_; }
+
+ private:
+  bool write(const void* data, size_t size);
+  bool write_block(ColumnBlock* block);
+
+  FlashStorage* storage_;
+  ColumnBlock* blocks_;
+  ColumnFileHeader header_ = {};
+  bool open_ = false;
+  uint32_t end_ = 0;
+  // Everything below is erased.
+  uint32_t erased_end_ = 0;
+  ColumnWriterStats stats_ = {};
+};
+
+// Finds the blocks of a column file in `storage`, from its index if it was
+// finished and by walking the blocks otherwise. Calls `on_block` for every
+// block header with its offset, in file order, and returns false if there is
+// no column file.
+template <typename Callback>
+bool scan_column_file(FlashStorage* storage, ColumnFileHeader* header,
+                      Callback on_block) {
+  if (!storage->read(0, header, sizeof(*header)) ||
+      header->magic != COLUMN_FILE_MAGIC ||
+      header->version != COLUMN_FILE_VERSION ||
+      header->channel_count > COLUMN_MAX_CHANNELS ||
+      header->block_samples != COLUMN_BLOCK_SAMPLES) {
+    return false;
+  }
+  if (header->index_offset != COLUMN_UNFINISHED) {
+    for (uint32_t i = 0; i < header->block_count; i++) {
+      ColumnIndexEntry entry;
+      if (!storage->read(header->index_offset + i * sizeof(entry), &entry,
+                         sizeof(entry))) {
+        return false;
+      }
+      on_block(entry);
+    }
+    return true;
+  }
+  for (uint32_t offset = sizeof(ColumnFileHeader);
+       offset + sizeof(ColumnBlock) <= storage->size();
+       offset += sizeof(ColumnBlock)) {
+    ColumnBlockHeader block;
+    if (!storage->read(offset, &block, sizeof(block)) ||
+        block.magic != COLUMN_BLOCK_MAGIC) {
+      break;
+    }
+    on_block(ColumnIndexEntry{
+        .offset = offset,
+        .channel = block.channel,
+        .count = block.count,
+        .t_first_us = block.t_first_us,
+        .t_last_us = block.t_last_us,
+        .min = block.min,
+        .max = block.max,
+        .mean = block.mean,
+        .reserved = 0,
+    });
+  }
+  return true;
+}
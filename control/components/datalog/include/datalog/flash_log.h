@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "datalog/flash_storage.h"
+
+// Flight-data log on a raw flash region.
+//
+// Producers append fixed-size records from any task without ever waiting on
+// flash: a record goes into one of two sector-sized RAM buffers, reserved with
+// a compare-and-swap, and is dropped (and counted) if both buffers are still
+// waiting to be written. A single low-priority writer calls service() to
+// program each full buffer as one sector, so every flash write is a whole,
+// aligned sector.
+//
+// Each sector starts with a LogSectorHeader followed by
+// FLASH_LOG_RECORDS_PER_SECTOR records, in the little-endian in-memory layout
+// of the structs below. Sessions (boots) are appended after each other; the
+// log ends at the first sector without a valid header.
+
+enum class RecordType : uint8_t {
+  kPad = 0x00,       // Unused slot in a sector written by flush().
+  kPt = 0x01,        // id: Pt, value: psi.
+  kLoadCell = 0x02,  // value: raw reading.
+  kValve = 0x03,     // id: Valve, aux: 1 if open.
+  kEvent = 0x04,     // id: LogEvent, aux: event argument.
+  kErased = 0xFF,    // Never written.
+};
+
+enum class LogEvent : uint8_t {
+  kBoot,
+  kArm,
+  kDisarm,
+  kAbort,
+  kMark,           // Manual mark from the ground. arg: operator tag.
+  kSequencerStep,  // arg: step index.
+  kRedline,        // arg: Redline index. The stand aborted on its own.
+  kFire,           // Firing sequence started from the ground.
+  kDegraded,       // arg: 1 entering degraded mode, 0 leaving it.
+  kLogEventMax  // Not a valid event, used for bounds checking.
+};
+
+struct LogRecord {
+  uint64_t t_us;
+  RecordType type;
+  uint8_t id;
+  uint16_t aux;
+  float value;
+};
+static_assert(sizeof(LogRecord) == 16, "LogRecord is stored as is");
+
+struct LogSectorHeader {
+  uint32_t magic;
+  uint32_t session;
+  // Index of the sector within the session.
+  uint32_t sector;
+  // Records before the padding.
+  uint32_t records;
+};
+static_assert(sizeof(LogSectorHeader) == sizeof(LogRecord),
+              "The header takes the first record slot");
+
+constexpr uint32_t FLASH_LOG_MAGIC = 0x474F4C47;  // "GLOG"
+constexpr uint32_t FLASH_LOG_RECORDS_PER_SECTOR =
+    FLASH_SECTOR_SIZE / sizeof(LogRecord) - 1;
+
+enum class EraseResult {
+  kErased,
+  kBusy,    // An append() was in progress; call again later.
+  kFailed,  // The flash erase failed.
+};
+
+struct FlashLogStats {
+  uint32_t records;  // Accepted by append().
+  // Rejected by append() because both buffers were waiting for flash, or the
+  // region was full.
+  uint32_t dropped;
+  // Most records buffered in RAM at once, out of
+  // 2 * FLASH_LOG_RECORDS_PER_SECTOR.
+  uint32_t high_water;
+  uint32_t sectors_written;
+  uint32_t write_errors;
+  // Slots padded by flush().
+  uint32_t padding;
+  bool full;
+};
+
+class FlashLog {
+ public:
+  explicit FlashLog(FlashStorage* storage) : storage_(storage) {}
+
+  // Finds the end of the sessions already in flash and starts a new session
+  // after them. Returns false if the region is unusable. Until open() is
+  // called, append() drops everything.
+  bool open();
+  uint32_t session() const { return session_; }
+
+  // Erases the whole region and starts over with session 1. Writer side;
+  // records appended meanwhile are dropped. Never waits for producers, which
+  // may be preempted by the caller: returns kBusy instead.
+  EraseResult erase_all();
+
+  // Producer side. Safe to call concurrently from any number of tasks or
+  // threads; never blocks. Returns false if the record was dropped.
+  bool append(const LogRecord& record);
+  // Like append(), for a caller that retries: a record that doesn't fit isn't
+  // counted as dropped until the caller gives up on it with drop().
+  bool try_append(const LogRecord& record);
+  void drop() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+  // Writer side, from a single task or thread.
+  //
+  // Programs the oldest buffer if it is complete. Erases the sector first if
+  // it isn't blank. Returns true if a sector was written; call again until it
+  // returns false.
+  bool service();
+  // Pads the partially filled buffer so the next service() writes it. Bounds
+  // how much is lost on a reset, at the cost of flash space.
+  void flush();
+
+  FlashLogStats stats() const;
+  // Space left for this session.
+  uint32_t free_bytes() const {
+    uint32_t used = first_sector_ + flushed_.load(std::memory_order_relaxed);
+    return used >= sector_count_ ? 0
+                                 : (sector_count_ - used) * FLASH_SECTOR_SIZE;
+  }
+  // Bytes programmed into flash by this session.
+  uint64_t bytes_written() const {
+    return static_cast<uint64_t>(stats_sectors_) * FLASH_SECTOR_SIZE;
+  }
+
+ private:
+  static constexpr uint32_t kRecords = FLASH_LOG_RECORDS_PER_SECTOR;
+
+  struct Buffer {
+    // Slot 0 is the header, filled in by the writer.
+    std::array<LogRecord, kRecords + 1> slots;
+    // Record slots written by producers or flush().
+    std::atomic<uint32_t> committed{0};
+    uint32_t padding = 0;
+  };
+
+  bool reserve_and_store(const LogRecord& record);
+  bool sector_blank(uint32_t sector);
+
+  FlashStorage* storage_;
+  std::atomic<bool> open_{false};
+  // append() calls in progress, so erase_all() can tell when they are done.
+  std::atomic<uint32_t> appending_{0};
+  uint32_t session_ = 0;
+  uint32_t first_sector_ = 0;
+  uint32_t sector_count_ = 0;
+  // Record index within the session of the next append().
+  std::atomic<uint32_t> next_{0};
+  // Sectors of the session written so far. Buffer `flushed_ % 2` is next.
+  std::atomic<uint32_t> flushed_{0};
+  std::array<Buffer, 2> buffers_;
+
+  std::atomic<uint32_t> records_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<uint32_t> high_water_{0};
+  std::atomic<bool> full_{false};
+  uint32_t stats_sectors_ = 0;
+  uint32_t write_errors_ = 0;
+  uint32_t padding_ = 0;
+};
+
+// Reads back a log region, for host tools. Calls `on_record` for every record
+// of every session, in order, and returns the number of sectors read.
+template <typename Callback>
+uint32_t read_flash_log(FlashStorage* storage, Callback on_record) {
+  uint32_t sectors = 0;
+  for (uint32_t offset = 0; offset + FLASH_SECTOR_SIZE <= storage->size();
+       offset += FLASH_SECTOR_SIZE) {
+    std::array<LogRecord, FLASH_LOG_RECORDS_PER_SECTOR + 1> slots;
+    if (!storage->read(offset, slots.data(), FLASH_SECTOR_SIZE)) {
+      break;
+    }
+    LogSectorHeader header;
+    std::memcpy(&header, &slots[0], sizeof(header));
+    if (header.magic != FLASH_LOG_MAGIC ||
+        header.records > FLASH_LOG_RECORDS_PER_SECTOR) {
+      break;
+    }
+    for (uint32_t i = 1; i <= header.records; i++) {
+      on_record(header.session, slots[i]);
+    }
+    sectors++;
+  }
+  return sectors;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Erase granularity of the SPI NOR flash.
+constexpr uint32_t FLASH_SECTOR_SIZE = 4096;
+
+// A raw region of NOR flash, e.g. a data partition. Offsets are relative to
+// the start of the region. Erasing sets bytes to 0xFF and writing can only
+// clear bits, so a range must be erased before it is written.
+class FlashStorage {
+ public:
+  virtual ~FlashStorage() = default;
+
+  // Size of the region in bytes, a multiple of FLASH_SECTOR_SIZE.
+  virtual uint32_t size() const = 0;
+  // `offset` and `size` must be multiples of FLASH_SECTOR_SIZE.
+  virtual bool erase(uint32_t offset, uint32_t size) = 0;
+  virtual bool write(uint32_t offset, const void* data, size_t size) = 0;
+  virtual bool read(uint32_t offset, void* data, size_t size) = 0;
+};
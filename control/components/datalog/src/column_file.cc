@@ -0,0 +1,183 @@
+#include "datalog/column_file.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "datalog/flash_log.h"
+#include "datalog/flash_storage.h"
+
+bool ColumnWriter::open(const ColumnChannel* channels, uint16_t channel_count,
+                        uint32_t session) {
+  open_ = false;
+  if (channel_count > COLUMN_MAX_CHANNELS ||
+      storage_->size() < sizeof(ColumnFileHeader) + sizeof(ColumnBlock)) {
+    return false;
+  }
+  header_ = {
+      .magic = COLUMN_FILE_MAGIC,
+      .version = COLUMN_FILE_VERSION,
+      .channel_count = channel_count,
+      .block_samples = COLUMN_BLOCK_SAMPLES,
+      .session = session,
+      .index_offset = COLUMN_UNFINISHED,
+      .block_count = COLUMN_UNFINISHED,
+      .channels = {},
+  };
+  std::copy(channels, channels + channel_count, header_.channels);
+  for (uint16_t i = 0; i < channel_count; i++) {
+    blocks_[i].header.count = 0;
+  }
+  end_ = 0;
+  erased_end_ = 0;
+  stats_ = {};
+  open_ = write(&header_, sizeof(header_));
+  return open_;
+}
+
+bool ColumnWriter::append(uint16_t channel, uint64_t t_us, float value) {
+  if (!open_ || channel >= header_.channel_count) {
+    stats_.dropped++;
+    return false;
+  }
+  ColumnBlock& block = blocks_[channel];
+  ColumnBlockHeader& header = block.header;
+  if (header.count > 0 && t_us < header.t_last_us) {
+    stats_.out_of_order++;
+    return false;
+  }
+  if (header.count == 0) {
+    header.t_first_us = t_us;
+    header.min = value;
+    header.max = value;
+  }
+  header.t_last_us = t_us;
+  header.min = std::min(header.min, value);
+  header.max = std::max(header.max, value);
+  block.t_us[header.count] = t_us;
+  block.value[header.count] = value;
+  header.count++;
+  stats_.samples++;
+  if (header.count == COLUMN_BLOCK_SAMPLES) {
+    return write_block(&block);
+  }
+  return true;
+}
+
+bool ColumnWriter::append(const LogRecord& record) {
+  // Valve states and event arguments live in `aux`.
+  float value = record.type == RecordType::kValve ||
+                        record.type == RecordType::kEvent
+                    ? record.aux
+                    : record.value;
+  for (uint16_t i = 0; i < header_.channel_count; i++) {
+    if (header_.channels[i].type == record.type &&
+        header_.channels[i].id == record.id) {
+      return append(i, record.t_us, value);
+    }
+  }
+  return false;
+}
+
+bool ColumnWriter::finish() {
+  if (!open_) {
+    return false;
+  }
+  for (uint16_t i = 0; i < header_.channel_count; i++) {
+    if (blocks_[i].header.count > 0) {
+      write_block(&blocks_[i]);
+    }
+  }
+  if (!open_) {
+    return false;
+  }
+
+  // Rebuild the index from the block headers in flash rather than keeping
+  // one in RAM for the whole capture.
+  const uint32_t index_offset = end_;
+  uint32_t block_count = 0;
+  ColumnIndexEntry entries[8];
+  size_t buffered = 0;
+  for (uint32_t offset = sizeof(ColumnFileHeader); offset < index_offset;
+       offset += sizeof(ColumnBlock)) {
+    ColumnBlockHeader block;
+    if (!storage_->read(offset, &block, sizeof(block))) {
+      open_ = false;
+      return false;
+    }
+    entries[buffered++] = {
+        .offset = offset,
+        .channel = block.channel,
+        .count = block.count,
+        .t_first_us = block.t_first_us,
+        .t_last_us = block.t_last_us,
+        .min = block.min,
+        .max = block.max,
+        .mean = block.mean,
+        .reserved = 0,
+    };
+    block_count++;
+    if (buffered == std::size(entries) ||
+        offset + sizeof(ColumnBlock) >= index_offset) {
+      if (!write(entries, buffered * sizeof(entries[0]))) {
+        return false;
+      }
+      buffered = 0;
+    }
+  }
+
+  // Both fields are still erased, so they can be programmed in place.
+  header_.index_offset = index_offset;
+  header_.block_count = block_count;
+  open_ = false;
+  return storage_->write(offsetof(ColumnFileHeader, index_offset),
+                         &header_.index_offset,
+                         sizeof(header_.index_offset) +
+                             sizeof(header_.block_count));
+}
+
+bool ColumnWriter::write(const void* data, size_t size) {
+  // Also keep the first word after the data erased, so a reader walking an
+  // unfinished file stops there instead of running into an older file.
+  uint32_t needed = std::min<uint32_t>(end_ + size + sizeof(uint32_t),
+                                       storage_->size());
+  if (end_ + size > storage_->size()) {
+    open_ = false;
+    return false;
+  }
+  while (erased_end_ < needed) {
+    if (!storage_->erase(erased_end_, FLASH_SECTOR_SIZE)) {
+      open_ = false;
+      return false;
+    }
+    erased_end_ += FLASH_SECTOR_SIZE;
+  }
+  if (!storage_->write(end_, data, size)) {
+    open_ = false;
+    return false;
+  }
+  end_ += size;
+  return true;
+}
+
+bool ColumnWriter::write_block(ColumnBlock* block) {
+  ColumnBlockHeader& header = block->header;
+  float sum = 0;
+  for (uint16_t i = 0; i < header.count; i++) {
+    sum += block->value[i];
+  }
+  header.magic = COLUMN_BLOCK_MAGIC;
+  header.channel = block - blocks_;
+  header.mean = sum / header.count;
+  header.reserved = 0;
+  bool written = write(block, sizeof(*block));
+  if (written) {
+    stats_.blocks++;
+  } else {
+    stats_.dropped += header.count;
+    stats_.samples -= header.count;
+  }
+  header.count = 0;
+  return written;
+}
@@ -0,0 +1,202 @@
+#include "datalog/flash_log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#include "datalog/flash_storage.h"
+
+namespace {
+
+bool read_header(FlashStorage* storage, uint32_t sector,
+                 LogSectorHeader* header) {
+  return storage->read(sector * FLASH_SECTOR_SIZE, header, sizeof(*header)) &&
+         header->magic == FLASH_LOG_MAGIC;
+}
+
+}  // namespace
+
+bool FlashLog::open() {
+  sector_count_ = storage_->size() / FLASH_SECTOR_SIZE;
+  if (sector_count_ == 0) {
+    return false;
+  }
+
+  // Sessions are contiguous from sector 0; the first sector without a header
+  // is where this one starts.
+  uint32_t last_session = 0;
+  first_sector_ = 0;
+  LogSectorHeader header;
+  while (first_sector_ < sector_count_ &&
+         read_header(storage_, first_sector_, &header)) {
+    last_session = header.session;
+    first_sector_++;
+  }
+  session_ = last_session + 1;
+  next_ = 0;
+  flushed_ = 0;
+  for (Buffer& buffer : buffers_) {
+    buffer.committed = 0;
+    buffer.padding = 0;
+  }
+  full_ = first_sector_ == sector_count_;
+  open_ = true;
+  return true;
+}
+
+EraseResult FlashLog::erase_all() {
+  open_ = false;
+  if (appending_.load() != 0) {
+    return EraseResult::kBusy;
+  }
+  if (!storage_->erase(0, storage_->size())) {
+    write_errors_++;
+    // Keep logging after whatever survived.
+    open();
+    return EraseResult::kFailed;
+  }
+  return open() ? EraseResult::kErased : EraseResult::kFailed;
+}
+
+bool FlashLog::append(const LogRecord& record) {
+  bool appended = try_append(record);
+  if (!appended) {
+    drop();
+  }
+  return appended;
+}
+
+bool FlashLog::try_append(const LogRecord& record) {
+  appending_.fetch_add(1);
+  bool appended = open_ && reserve_and_store(record);
+  appending_.fetch_sub(1);
+  return appended;
+}
+
+bool FlashLog::reserve_and_store(const LogRecord& record) {
+  // Reserve a slot, but only in a buffer that is free: the sector it maps to
+  // must be at most one ahead of the one being written.
+  uint32_t index = next_.load(std::memory_order_relaxed);
+  uint32_t flushed;
+  do {
+    uint32_t sector = index / kRecords;
+    flushed = flushed_.load(std::memory_order_acquire);
+    if (first_sector_ + sector >= sector_count_) {
+      full_.store(true, std::memory_order_relaxed);
+      return false;
+    }
+    if (sector >= flushed + 2) {
+      return false;
+    }
+  } while (!next_.compare_exchange_weak(index, index + 1,
+                                        std::memory_order_relaxed));
+
+  Buffer& buffer = buffers_[(index / kRecords) % 2];
+  buffer.slots[1 + index % kRecords] = record;
+  buffer.committed.fetch_add(1, std::memory_order_release);
+  records_.fetch_add(1, std::memory_order_relaxed);
+
+  uint32_t buffered = index + 1 - flushed * kRecords;
+  uint32_t high_water = high_water_.load(std::memory_order_relaxed);
+  while (buffered > high_water &&
+         !high_water_.compare_exchange_weak(high_water, buffered,
+                                            std::memory_order_relaxed)) {
+  }
+  return true;
+}
+
+bool FlashLog::sector_blank(uint32_t sector) {
+  uint32_t words[64];
+  for (uint32_t offset = 0; offset < FLASH_SECTOR_SIZE;
+       offset += sizeof(words)) {
+    if (!storage_->read(sector * FLASH_SECTOR_SIZE + offset, words,
+                        sizeof(words))) {
+      return false;
+    }
+    for (uint32_t word : words) {
+      if (word != UINT32_MAX) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool FlashLog::service() {
+  if (!open_) {
+    return false;
+  }
+  uint32_t sector = flushed_.load(std::memory_order_relaxed);
+  if (first_sector_ + sector >= sector_count_) {
+    return false;
+  }
+  Buffer& buffer = buffers_[sector % 2];
+  if (buffer.committed.load(std::memory_order_acquire) < kRecords) {
+    return false;
+  }
+
+  LogSectorHeader header = {
+      .magic = FLASH_LOG_MAGIC,
+      .session = session_,
+      .sector = sector,
+      .records = kRecords - buffer.padding,
+  };
+  std::memcpy(&buffer.slots[0], &header, sizeof(header));
+
+  // open() leaves the sectors after the log untouched; erase leftovers of an
+  // interrupted erase_all() before programming.
+  uint32_t offset = (first_sector_ + sector) * FLASH_SECTOR_SIZE;
+  if (!sector_blank(first_sector_ + sector) &&
+      !storage_->erase(offset, FLASH_SECTOR_SIZE)) {
+    write_errors_++;
+  } else if (!storage_->write(offset, buffer.slots.data(),
+                              FLASH_SECTOR_SIZE)) {
+    write_errors_++;
+  } else {
+    stats_sectors_++;
+  }
+
+  // Hand the buffer back to producers. A failed sector is skipped rather than
+  // retried so the log keeps moving.
+  buffer.padding = 0;
+  buffer.committed.store(0, std::memory_order_relaxed);
+  flushed_.store(sector + 1, std::memory_order_release);
+  return true;
+}
+
+void FlashLog::flush() {
+  if (!open_) {
+    return;
+  }
+  // Claim the rest of the current sector so producers move on to the next.
+  uint32_t index = next_.load(std::memory_order_relaxed);
+  uint32_t end;
+  do {
+    if (index % kRecords == 0) {
+      return;  // Nothing buffered in a partial sector.
+    }
+    end = (index / kRecords + 1) * kRecords;
+  } while (!next_.compare_exchange_weak(index, end,
+                                        std::memory_order_relaxed));
+
+  Buffer& buffer = buffers_[(index / kRecords) % 2];
+  for (uint32_t i = index; i < end; i++) {
+    buffer.slots[1 + i % kRecords] = LogRecord{};
+  }
+  buffer.padding = end - index;
+  padding_ += end - index;
+  buffer.committed.fetch_add(end - index, std::memory_order_release);
+}
+
+FlashLogStats FlashLog::stats() const {
+  return {
+      .records = records_.load(std::memory_order_relaxed),
+      .dropped = dropped_.load(std::memory_order_relaxed),
+      .high_water = high_water_.load(std::memory_order_relaxed),
+      .sectors_written = stats_sectors_,
+      .write_errors = write_errors_,
+      .padding = padding_,
+      .full = full_.load(std::memory_order_relaxed),
+  };
+}
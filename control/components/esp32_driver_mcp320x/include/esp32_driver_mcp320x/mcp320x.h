@@ -2,8 +2,10 @@
 #define __ESP32_DRIVER_MCP320X_MCP320X_H__
 
 #include <stdint.h>
-#include "driver/gpio.h"
-#include "driver/spi_master.h"
+#include "esp_err.h"
+#include "hal/gpio.h"
+#include "hal/rtos.h"
+#include "hal/spi.h"
 
 #ifdef __cplusplus
 extern "C"
@@ -83,8 +85,8 @@ extern "C"
      */
     typedef struct
     {
-        spi_host_device_t host;       /** @brief SPI peripheral used to communicate with the device. */
-        gpio_num_t cs_io_num;         /** @brief GPIO pin used for Chip Select (CS). */
+        hal_spi_host_t host;          /** @brief SPI peripheral used to communicate with the device. */
+        hal_gpio_t cs_io_num;         /** @brief GPIO pin used for Chip Select (CS). */
         mcp320x_model_t device_model; /** @brief MCP320X model used with this configuration. */
         uint32_t clock_speed_hz;      /** @brief Clock speed, in Hz. Recommended the use of divisors of 80MHz. */
         uint16_t reference_voltage;   /** @brief Reference voltage, in millivolts. */
@@ -109,10 +111,10 @@ extern "C"
      * @note The bus must be released using the @ref mcp320x_release function.
      * @note This function is not thread safe when multiple tasks access the same SPI device.
      * @param[in] handle MCP320X handle.
-     * @param[in] timeout Time to wait before the bus is occupied by the device. Currently MUST BE set to portMAX_DELAY.
+     * @param[in] timeout Time to wait before the bus is occupied by the device. Currently MUST BE set to HAL_WAIT_FOREVER.
      * @return MCP320X_OK when success, otherwise any MCP320X_ERR* code.
      */
-    mcp320x_err_t mcp320x_acquire(mcp320x_t *handle, TickType_t timeout);
+    mcp320x_err_t mcp320x_acquire(mcp320x_t *handle, hal_tick_t timeout);
 
     /**
      * @brief Release the SPI bus occupied by the ADC. All other devices on the bus can start sending transactions.
@@ -1,4 +1,6 @@
+#include <stdlib.h>
 #include "esp32_driver_mcp320x/mcp320x.h"
+#include "hal/memory.h"
 #include "assertion.h"
 #include "log.h"
 
@@ -8,7 +10,7 @@
  */
 struct mcp320x_t
 {
-    spi_device_handle_t spi_handle;       /** @brief SPI device handle. */
+    hal_spi_device_t *spi_handle;         /** @brief SPI device handle. */
     mcp320x_model_t mcp_model;            /** @brief Device model. */
     float millivolts_per_resolution_step; /** @brief Millivolts per resolution step (Vref / MCP320X_RESOLUTION). */
 };
@@ -21,28 +23,23 @@ mcp320x_t *mcp320x_install(mcp320x_config_t const *config)
     CMP_CHECK((config->clock_speed_hz >= MCP320X_CLOCK_MIN_HZ), "clock speed error(<MCP320X_CLOCK_MIN_HZ)", NULL)
     CMP_CHECK((config->clock_speed_hz <= MCP320X_CLOCK_MAX_HZ), "clock speed error(>MCP320X_CLOCK_MAX_HZ)", NULL)
 
-    spi_device_interface_config_t dev_cfg = {
-        .command_bits = 0,
-        .address_bits = 0,
-        .dummy_bits = 0,
-        .mode = 0, // Clock idle: low, clock phase: leading, data write: CS on and CLK fall, data read: CS on and CLK rise.
-        .clock_source = SPI_CLK_SRC_DEFAULT,
-        .duty_cycle_pos = 128,
-        .cs_ena_pretrans = 0,
-        .cs_ena_posttrans = 0,
-        .clock_speed_hz = (int)config->clock_speed_hz,
-        .input_delay_ns = 0,
-        .spics_io_num = config->cs_io_num,
-        .flags = SPI_DEVICE_NO_DUMMY,
-        .queue_size = 1,
-        .pre_cb = NULL,
-        .post_cb = NULL};
-
-    spi_device_handle_t spi_device_handle;
-
-    CMP_CHECK(spi_bus_add_device(config->host, &dev_cfg, &spi_device_handle) == ESP_OK, "bus error(spi_bus_add_device)", NULL)
-
-    mcp320x_t *dev = (mcp320x_t *)malloc(sizeof(mcp320x_t));
+    hal_spi_device_config_t dev_cfg = {
+        .host = config->host,
+        .cs = config->cs_io_num,
+        .clock_speed_hz = config->clock_speed_hz,
+        .mode = 0}; // Clock idle: low, clock phase: leading, data write: CS on and CLK fall, data read: CS on and CLK rise.
+
+    hal_spi_device_t *spi_device_handle = hal_spi_add_device(&dev_cfg);
+
+    CMP_CHECK(spi_device_handle != NULL, "bus error(hal_spi_add_device)", NULL)
+
+    mcp320x_t *dev = (mcp320x_t *)hal_malloc(sizeof(mcp320x_t));
+    if (dev == NULL)
+    {
+        hal_spi_remove_device(spi_device_handle);
+    }
+    CMP_CHECK(dev != NULL, "memory error(hal_malloc)", NULL)
+
     dev->spi_handle = spi_device_handle;
     dev->mcp_model = config->device_model;
     dev->millivolts_per_resolution_step = (float)config->reference_voltage / (float)MCP320X_RESOLUTION;
@@ -53,17 +50,17 @@ mcp320x_t *mcp320x_install(mcp320x_config_t const *config)
 mcp320x_err_t mcp320x_delete(mcp320x_t *handle)
 {
     CMP_CHECK((handle != NULL), "handle error(NULL)", MCP320X_ERR_INVALID_HANDLE)
-    CMP_CHECK(spi_bus_remove_device(handle->spi_handle) == ESP_OK, "bus error(spi_bus_remove_device)", MCP320X_ERR_SPI_BUS)
+    hal_spi_remove_device(handle->spi_handle);
 
-    free(handle);
+    hal_free(handle);
 
     return MCP320X_OK;
 }
 
-mcp320x_err_t mcp320x_acquire(mcp320x_t *handle, TickType_t timeout)
+mcp320x_err_t mcp320x_acquire(mcp320x_t *handle, hal_tick_t timeout)
 {
     CMP_CHECK((handle != NULL), "handle error(NULL)", MCP320X_ERR_INVALID_HANDLE)
-    CMP_CHECK((spi_device_acquire_bus(handle->spi_handle, timeout) == ESP_OK), "device error(spi_device_acquire_bus)", MCP320X_ERR_SPI_BUS_ACQUIRE)
+    CMP_CHECK((hal_spi_acquire(handle->spi_handle)), "device error(hal_spi_acquire)", MCP320X_ERR_SPI_BUS_ACQUIRE)
 
     return MCP320X_OK;
 }
@@ -72,7 +69,7 @@ mcp320x_err_t mcp320x_release(mcp320x_t *handle)
 {
     CMP_CHECK((handle != NULL), "handle error(NULL)", MCP320X_ERR_INVALID_HANDLE)
 
-    spi_device_release_bus(handle->spi_handle);
+    hal_spi_release(handle->spi_handle);
 
     return MCP320X_OK;
 }
@@ -83,11 +80,7 @@ mcp320x_err_t mcp320x_get_actual_freq(mcp320x_t *handle,
     CMP_CHECK((handle != NULL), "handle error(NULL)", MCP320X_ERR_INVALID_HANDLE)
     CMP_CHECK((frequency_hz != NULL), "frequency_hz error(NULL)", MCP320X_ERR_INVALID_VALUE_HANDLE)
 
-    int calculated_freq_khz;
-
-    CMP_CHECK((spi_device_get_actual_freq(handle->spi_handle, &calculated_freq_khz) == ESP_OK), "device error(spi_device_get_actual_freq)", MCP320X_ERR_FAIL)
-
-    *frequency_hz = (uint32_t)calculated_freq_khz * 1000;
+    *frequency_hz = hal_spi_actual_freq_hz(handle->spi_handle);
 
     return MCP320X_OK;
 }
@@ -101,11 +94,8 @@ mcp320x_err_t mcp320x_read(mcp320x_t *handle,
     CMP_CHECK(((int)channel < (int)handle->mcp_model), "channel error(invalid)", MCP320X_ERR_INVALID_CHANNEL)
     CMP_CHECK((value != NULL), "value error(NULL)", MCP320X_ERR_INVALID_VALUE_HANDLE)
 
-    spi_transaction_t transaction = {
-        .flags = SPI_TRANS_USE_RXDATA | SPI_TRANS_USE_TXDATA,
-        .cmd = 0,
-        .addr = 0,
-        .length = 24};
+    uint8_t tx_data[3];
+    uint8_t rx_data[3];
 
     // Request format (tx_data) is eight bits aligned.
     //
@@ -131,11 +121,11 @@ mcp320x_err_t mcp320x_read(mcp320x_t *handle,
     //   * N: low null bit.
     //   * D: data output bits.
 
-    transaction.tx_data[0] = (uint8_t)(0b00000100 | (read_mode << 1) | (channel >> 2));
-    transaction.tx_data[1] = (uint8_t)(channel << 6);
-    transaction.tx_data[2] = 0;
+    tx_data[0] = (uint8_t)(0b00000100 | (read_mode << 1) | (channel >> 2));
+    tx_data[1] = (uint8_t)(channel << 6);
+    tx_data[2] = 0;
 
-    CMP_CHECK(spi_device_polling_transmit(handle->spi_handle, &transaction) == ESP_OK, "device error(spi_device_polling_transmit)", MCP320X_ERR_SPI_BUS)
+    CMP_CHECK(hal_spi_transfer(handle->spi_handle, tx_data, rx_data, sizeof(tx_data)), "device error(hal_spi_transfer)", MCP320X_ERR_SPI_BUS)
 
     // Response format (rx_data):
     //
@@ -171,8 +161,8 @@ mcp320x_err_t mcp320x_read(mcp320x_t *handle,
     //    > mask        = 0 0 0 0 1 1 1 1 1 1 1 1 1 1 1 1
     //    > result      = 0 0 0 0 0 1 0 0 1 1 1 1 0 1 1 0
 
-    const uint16_t first_part = transaction.rx_data[1];
-    const uint16_t second_part = transaction.rx_data[2];
+    const uint16_t first_part = rx_data[1];
+    const uint16_t second_part = rx_data[2];
 
     *value = ((first_part << 8) | second_part) & 0b0000111111111111;
 
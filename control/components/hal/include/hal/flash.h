@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Raw data partitions of the SPI NOR flash (see control/partitions.csv).
+// Erasing sets bytes to 0xFF and writing can only clear bits.
+
+typedef struct hal_partition_t hal_partition_t;
+
+// Returns the data partition labelled `label`, or NULL.
+const hal_partition_t* hal_partition_find(const char* label);
+uint32_t hal_partition_size(const hal_partition_t* partition);
+
+// `offset` and `size` must be multiples of the 4 kB sector.
+bool hal_partition_erase(const hal_partition_t* partition, uint32_t offset,
+                         uint32_t size);
+bool hal_partition_write(const hal_partition_t* partition, uint32_t offset,
+                         const void* data, size_t size);
+bool hal_partition_read(const hal_partition_t* partition, uint32_t offset,
+                        void* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hardware abstraction for the firmware's peripherals, so the control logic
+// also builds and runs on a Linux host (see control/host). The ESP-IDF
+// backend forwards to the IDF drivers; the Linux backend keeps peripheral
+// state in memory and lets host code play the other side (see hal/linux.h).
+
+// A GPIO number, as on the ESP32-S3.
+typedef int hal_gpio_t;
+
+// Not connected.
+#define HAL_GPIO_NC (-1)
+// Bounds for GPIO numbers, used for lookup tables indexed by pin.
+#define HAL_GPIO_MAX 49
+
+// Resets `pin` and makes it a push-pull output, or a floating input.
+void hal_gpio_output(hal_gpio_t pin);
+void hal_gpio_input(hal_gpio_t pin);
+
+void hal_gpio_set_level(hal_gpio_t pin, int level);
+int hal_gpio_get_level(hal_gpio_t pin);
+
+// Calls `handler` from an ISR on every rising edge of input `pin`. Returns
+// false if the interrupt can't be set up.
+typedef void (*hal_gpio_isr_t)(void* arg);
+bool hal_gpio_on_rising_edge(hal_gpio_t pin, hal_gpio_isr_t handler,
+                             void* arg);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LED PWM controller, used for the valve servos. A single low speed timer
+// drives every channel.
+
+#define HAL_LEDC_CHANNEL_MAX 8
+
+// Sets the PWM frequency and the duty resolution of every channel.
+bool hal_ledc_timer_init(uint32_t freq_hz, uint8_t duty_resolution_bits);
+
+// Routes `channel` (0 to HAL_LEDC_CHANNEL_MAX - 1) to `pin`, at 0 duty.
+bool hal_ledc_channel_init(int channel, hal_gpio_t pin);
+
+// Duty in steps of the timer's resolution, applied from the next period.
+void hal_ledc_set_duty(int channel, uint32_t duty);
+
+#ifdef __cplusplus
+}
+#endif
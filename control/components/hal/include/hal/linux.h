@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hal/gpio.h"
+#include "hal/spi.h"
+#include "hal/uart.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Linux backend only: the other side of the peripherals, for the host build
+// (control/host) and simulations. Unless something is attached, SPI devices
+// read zeros, inputs read low, UARTs neither send nor receive and there are
+// no flash partitions.
+
+// Drives input `pin` as an external circuit would. A rising edge calls the
+// pin's hal_gpio_on_rising_edge() handler on the calling thread.
+void hal_linux_gpio_drive(hal_gpio_t pin, int level);
+
+// Called on the firmware's thread whenever it sets output `pin`.
+typedef void (*hal_linux_gpio_fn_t)(void* ctx, hal_gpio_t pin, int level);
+void hal_linux_gpio_watch(hal_gpio_t pin, hal_linux_gpio_fn_t fn, void* ctx);
+
+// Makes hal_gpio_get_level() of input `pin` call `fn` instead of returning
+// the driven level, for lines that follow a device's internal timing (e.g. a
+// BUSY output). NULL restores the driven level.
+typedef int (*hal_linux_gpio_sense_fn_t)(void* ctx, hal_gpio_t pin);
+void hal_linux_gpio_sense(hal_gpio_t pin, hal_linux_gpio_sense_fn_t fn,
+                          void* ctx);
+
+// Puts a device on `host` behind chip select `cs`: `fn` answers every
+// transfer to it, on the firmware's thread with the bus held. Each call is one
+// assertion of chip select, clocked at `clock_hz` (what
+// hal_spi_actual_freq_hz() reports). `tx` and `rx` are never NULL and never
+// overlap.
+typedef void (*hal_linux_spi_fn_t)(void* ctx, uint32_t clock_hz,
+                                   const uint8_t* tx, uint8_t* rx, size_t len);
+void hal_linux_spi_attach(hal_spi_host_t host, hal_gpio_t cs,
+                          hal_linux_spi_fn_t fn, void* ctx);
+
+// Current duty of LEDC `channel`, and the pin it drives.
+uint32_t hal_linux_ledc_duty(int channel);
+hal_gpio_t hal_linux_ledc_pin(int channel);
+
+// Connects `port` to a file descriptor, e.g. the master side of a PTY, which
+// the backend reads and writes without taking ownership of.
+void hal_linux_uart_attach(hal_uart_port_t port, int fd);
+
+// Adds an erased, RAM-backed data partition of `size` bytes.
+bool hal_linux_add_partition(const char* label, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hal/rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Heap and stack accounting, to size buffers and task stacks from what they
+// actually use.
+
+// Allocations made through hal_malloc() are counted per call site.
+#define HAL_ALLOC_SITE_MAX 16
+
+#define HAL_STRINGIFY_(x) #x
+#define HAL_STRINGIFY(x) HAL_STRINGIFY_(x)
+#define hal_malloc(size) \
+  hal_malloc_at((size), __FILE__ ":" HAL_STRINGIFY(__LINE__))
+
+// malloc() that counts the allocation against `site`, a string literal.
+// Sites past HAL_ALLOC_SITE_MAX are counted under "other".
+void* hal_malloc_at(size_t size, const char* site);
+void hal_free(void* ptr);
+
+typedef struct {
+  const char* site;
+  uint32_t count;
+  // Total bytes asked for, freed or not.
+  uint32_t bytes;
+} hal_alloc_site_t;
+
+// Copies the call sites seen so far to `out`. Returns their number.
+size_t hal_alloc_sites(hal_alloc_site_t* out, size_t cap);
+
+// Heap allocations since boot. On the board every allocation counts, by
+// anyone, through the heap's hooks (CONFIG_HEAP_USE_HOOKS); on Linux only
+// hal_malloc()'s.
+uint32_t hal_heap_alloc_count(void);
+
+// Total heap size, and the least free heap there ever was: the heap's
+// high-water mark is their difference. On Linux, what the allocator holds.
+size_t hal_heap_size(void);
+size_t hal_min_free_heap_size(void);
+
+// From now on any heap allocation aborts, with a backtrace on the board, so
+// a firmware that should only allocate while it initializes proves it.
+void hal_heap_forbid_allocs(void);
+
+// Tasks whose stacks are reported. hal_task_create() tracks the tasks it
+// starts; tasks started otherwise, e.g. app_main's, can be added. `name`
+// must outlive the task.
+#define HAL_TRACKED_TASK_MAX 16
+
+void hal_task_track(hal_task_t task, const char* name, uint32_t stack_size);
+// Stops tracking a task, e.g. before it exits.
+void hal_task_untrack(hal_task_t task);
+
+// Least free stack a task ever had, in bytes. HAL_STACK_UNKNOWN on Linux,
+// where tasks run on the threads' own stacks.
+#define HAL_STACK_UNKNOWN UINT32_MAX
+uint32_t hal_task_stack_free_min(hal_task_t task);
+
+typedef struct {
+  const char* name;
+  uint32_t stack_size;
+  uint32_t free_min;
+} hal_task_stack_t;
+
+// Copies the stack usage of every tracked task to `out`. Returns their
+// number. Tracked tasks must not exit meanwhile.
+size_t hal_task_stacks(hal_task_stack_t* out, size_t cap);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FreeRTOS primitives. On Linux tasks are threads, priorities are ignored
+// and a tick is a millisecond.
+
+#ifdef ESP_PLATFORM
+typedef TickType_t hal_tick_t;
+#define HAL_TICK_PERIOD_MS portTICK_PERIOD_MS
+#define HAL_CORE_COUNT portNUM_PROCESSORS
+#define HAL_WAIT_FOREVER portMAX_DELAY
+#else
+typedef uint32_t hal_tick_t;
+#define HAL_TICK_PERIOD_MS 1
+// Threads migrate between host cores, so they all count as core 0 and
+// hal_mask_interrupts() serializes them instead.
+#define HAL_CORE_COUNT 1
+#define HAL_WAIT_FOREVER UINT32_MAX
+#endif
+
+// Rounds down, like pdMS_TO_TICKS.
+#define HAL_MS_TO_TICKS(ms) ((hal_tick_t)((ms) / HAL_TICK_PERIOD_MS))
+
+typedef void (*hal_task_fn_t)(void* arg);
+typedef struct hal_task* hal_task_t;
+
+// Starts `fn` as a task with `stack_size` bytes of stack. `task` may be NULL.
+bool hal_task_create(hal_task_fn_t fn, const char* name, uint32_t stack_size,
+                     void* arg, int priority, hal_task_t* task);
+
+// Ends the calling task, which must have been started by hal_task_create().
+// Doesn't return.
+void hal_task_exit(void);
+
+hal_tick_t hal_tick_count(void);
+void hal_delay_ticks(hal_tick_t ticks);
+// Blocks until `period` ticks after `*last_wake` and advances it by
+// `period`, so a periodic task doesn't drift by its own run time.
+void hal_delay_until(hal_tick_t* last_wake, hal_tick_t period);
+
+// Task notifications, as a bit set per task.
+void hal_task_notify(hal_task_t task, uint32_t bits);
+void hal_task_notify_from_isr(hal_task_t task, uint32_t bits);
+// Waits up to `timeout` ticks for bits and clears them. Returns the bits
+// received, 0 on timeout.
+uint32_t hal_task_notify_wait(hal_tick_t timeout);
+hal_task_t hal_task_current(void);
+
+// Critical sections shared between tasks on both cores. Keep them short:
+// interrupts are masked on the holder's core.
+#ifdef ESP_PLATFORM
+typedef portMUX_TYPE hal_spinlock_t;
+#define HAL_SPINLOCK_INIT portMUX_INITIALIZER_UNLOCKED
+
+static inline void hal_enter_critical(hal_spinlock_t* lock) {
+  taskENTER_CRITICAL(lock);
+}
+static inline void hal_exit_critical(hal_spinlock_t* lock) {
+  taskEXIT_CRITICAL(lock);
+}
+#else
+typedef struct {
+  pthread_mutex_t mutex;
+} hal_spinlock_t;
+#define HAL_SPINLOCK_INIT {PTHREAD_MUTEX_INITIALIZER}
+
+void hal_enter_critical(hal_spinlock_t* lock);
+void hal_exit_critical(hal_spinlock_t* lock);
+#endif
+
+// Masks interrupts on the calling core, so nothing else runs on it until
+// hal_unmask_interrupts() is called with the returned state. Safe from ISRs.
+uint32_t hal_mask_interrupts(void);
+void hal_unmask_interrupts(uint32_t state);
+
+// 0 to HAL_CORE_COUNT - 1.
+int hal_core_id(void);
+
+// Microseconds `core` has spent idle since boot, wrapping at 2^32, for its
+// CPU load. On the board this is the run time of its idle task, which needs
+// CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS (0 without it); on Linux, the wall
+// time the process didn't spend on a CPU.
+uint32_t hal_idle_time_us(int core);
+
+#ifdef __cplusplus
+}
+#endif
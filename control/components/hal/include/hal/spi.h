@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hal/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SPI master. Transfers are full duplex and polled: the calling task owns
+// the CPU until the last bit is clocked.
+
+// An SPI peripheral of the chip, e.g. 2 for SPI3_HOST on the ESP32-S3.
+typedef int hal_spi_host_t;
+
+typedef struct {
+  hal_spi_host_t host;
+  hal_gpio_t mosi;
+  hal_gpio_t miso;
+  hal_gpio_t sclk;
+  // Largest single transfer, in bytes.
+  size_t max_transfer_size;
+} hal_spi_bus_config_t;
+
+typedef struct {
+  hal_spi_host_t host;
+  // Chip select, driven low by the controller for each transfer.
+  hal_gpio_t cs;
+  uint32_t clock_speed_hz;
+  // SPI mode 0-3 (clock polarity and phase).
+  uint8_t mode;
+} hal_spi_device_config_t;
+
+typedef struct hal_spi_device_t hal_spi_device_t;
+
+bool hal_spi_bus_init(const hal_spi_bus_config_t* config);
+
+// Adds a device to an initialized bus. Returns NULL on failure.
+hal_spi_device_t* hal_spi_add_device(const hal_spi_device_config_t* config);
+void hal_spi_remove_device(hal_spi_device_t* device);
+
+// Occupies the bus for a run of transfers to `device`, blocking until the
+// other devices' transfers are done.
+bool hal_spi_acquire(hal_spi_device_t* device);
+void hal_spi_release(hal_spi_device_t* device);
+
+// Clocks out `len` bytes of `tx` while filling `rx`. Either may be NULL.
+bool hal_spi_transfer(hal_spi_device_t* device, const uint8_t* tx,
+                      uint8_t* rx, size_t len);
+
+// The clock the device actually runs at, which the controller derives from
+// its own clock by an integer divider.
+uint32_t hal_spi_actual_freq_hz(hal_spi_device_t* device);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Free bytes in the heap.
+size_t hal_free_heap_size(void);
+
+// 32 random bits from the hardware RNG.
+uint32_t hal_random(void);
+
+#ifdef __cplusplus
+}
+#endif
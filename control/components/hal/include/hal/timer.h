@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Microseconds since boot (esp_timer).
+int64_t hal_time_us(void);
+
+// CPU cycle counter, for timing short sections. Wraps; subtract two readings
+// as uint32_t.
+uint32_t hal_cycle_count(void);
+// Rate of hal_cycle_count(), in cycles per microsecond.
+uint32_t hal_cycles_per_us(void);
+
+// Busy-waits, for delays shorter than a tick.
+void hal_delay_us(uint32_t us);
+
+#ifdef __cplusplus
+}
+#endif
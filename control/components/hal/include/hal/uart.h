@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hal/rtos.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// UART driver with RX and TX ring buffers, for the console port.
+
+typedef int hal_uart_port_t;
+
+bool hal_uart_install(hal_uart_port_t port, size_t rx_buffer_size,
+                      size_t tx_buffer_size);
+void hal_uart_set_baud_rate(hal_uart_port_t port, uint32_t baud_rate);
+// Waits for the TX FIFO to drain, without the driver.
+void hal_uart_wait_tx_idle(hal_uart_port_t port);
+// Sends stdout through the driver's TX buffer too, so it is interleaved
+// with hal_uart_write() a write at a time.
+void hal_uart_route_stdout(hal_uart_port_t port);
+
+// Reads up to `len` bytes, waiting up to `timeout` ticks for the first.
+// Returns the number of bytes read, or -1 on error.
+int hal_uart_read(hal_uart_port_t port, uint8_t* data, size_t len,
+                  hal_tick_t timeout);
+// Queues `len` bytes, blocking while the TX buffer is full.
+int hal_uart_write(hal_uart_port_t port, const uint8_t* data, size_t len);
+size_t hal_uart_tx_free(hal_uart_port_t port);
+
+#ifdef __cplusplus
+}
+#endif
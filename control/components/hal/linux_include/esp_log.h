@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdio.h>
+
+#include "hal/timer.h"
+
+// ESP_LOGx for the host build, in the IDF's line format. Like the firmware's
+// default log level, debug and verbose lines are compiled out.
+
+#define HAL_LINUX_LOG(letter, tag, format, ...)                        \
+  printf(letter " (%lld) %s: " format "\n",                            \
+         (long long)(hal_time_us() / 1000), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...) HAL_LINUX_LOG("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HAL_LINUX_LOG("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HAL_LINUX_LOG("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) \
+  do {                             \
+  } while (0)
+#define ESP_LOGV(tag, format, ...) \
+  do {                             \
+  } while (0)
@@ -0,0 +1,33 @@
+#include "hal/flash.h"
+
+#include <esp_err.h>
+#include <esp_partition.h>
+
+// A hal_partition_t is the IDF's partition entry.
+static const esp_partition_t* entry(const hal_partition_t* partition) {
+  return reinterpret_cast<const esp_partition_t*>(partition);
+}
+
+const hal_partition_t* hal_partition_find(const char* label) {
+  return reinterpret_cast<const hal_partition_t*>(esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label));
+}
+
+uint32_t hal_partition_size(const hal_partition_t* partition) {
+  return entry(partition)->size;
+}
+
+bool hal_partition_erase(const hal_partition_t* partition, uint32_t offset,
+                         uint32_t size) {
+  return esp_partition_erase_range(entry(partition), offset, size) == ESP_OK;
+}
+
+bool hal_partition_write(const hal_partition_t* partition, uint32_t offset,
+                         const void* data, size_t size) {
+  return esp_partition_write(entry(partition), offset, data, size) == ESP_OK;
+}
+
+bool hal_partition_read(const hal_partition_t* partition, uint32_t offset,
+                        void* data, size_t size) {
+  return esp_partition_read(entry(partition), offset, data, size) == ESP_OK;
+}
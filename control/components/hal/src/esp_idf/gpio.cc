@@ -0,0 +1,34 @@
+#include "hal/gpio.h"
+
+#include <driver/gpio.h>
+#include <esp_err.h>
+
+static gpio_num_t gpio(hal_gpio_t pin) { return static_cast<gpio_num_t>(pin); }
+
+void hal_gpio_output(hal_gpio_t pin) {
+  gpio_reset_pin(gpio(pin));
+  gpio_set_direction(gpio(pin), GPIO_MODE_OUTPUT);
+}
+
+void hal_gpio_input(hal_gpio_t pin) {
+  gpio_reset_pin(gpio(pin));
+  gpio_set_direction(gpio(pin), GPIO_MODE_INPUT);
+}
+
+void hal_gpio_set_level(hal_gpio_t pin, int level) {
+  gpio_set_level(gpio(pin), level);
+}
+
+int hal_gpio_get_level(hal_gpio_t pin) { return gpio_get_level(gpio(pin)); }
+
+bool hal_gpio_on_rising_edge(hal_gpio_t pin, hal_gpio_isr_t handler,
+                             void* arg) {
+  hal_gpio_input(pin);
+  gpio_set_intr_type(gpio(pin), GPIO_INTR_POSEDGE);
+  // The ISR service may already be installed by another driver.
+  esp_err_t ret = gpio_install_isr_service(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+    return false;
+  }
+  return gpio_isr_handler_add(gpio(pin), handler, arg) == ESP_OK;
+}
@@ -0,0 +1,38 @@
+#include "hal/ledc.h"
+
+#include <driver/gpio.h>
+#include <driver/ledc.h>
+#include <esp_err.h>
+
+// Low speed mode is the only mode available for Heltec v3 (ESP32-S3).
+constexpr ledc_mode_t LEDC_MODE = LEDC_LOW_SPEED_MODE;
+// All channels share the same timer.
+constexpr ledc_timer_t LEDC_TIMER = LEDC_TIMER_0;
+
+bool hal_ledc_timer_init(uint32_t freq_hz, uint8_t duty_resolution_bits) {
+  ledc_timer_config_t ledc_timer = {
+      .speed_mode = LEDC_MODE,
+      .duty_resolution = static_cast<ledc_timer_bit_t>(duty_resolution_bits),
+      .timer_num = LEDC_TIMER,
+      .freq_hz = freq_hz,
+  };
+  return ledc_timer_config(&ledc_timer) == ESP_OK;
+}
+
+bool hal_ledc_channel_init(int channel, hal_gpio_t pin) {
+  gpio_reset_pin(static_cast<gpio_num_t>(pin));
+  ledc_channel_config_t ledc_channel = {
+      .gpio_num = pin,
+      .speed_mode = LEDC_MODE,
+      .channel = static_cast<ledc_channel_t>(channel),
+      .intr_type = LEDC_INTR_DISABLE,
+      .timer_sel = LEDC_TIMER,
+      .duty = 0,
+  };
+  return ledc_channel_config(&ledc_channel) == ESP_OK;
+}
+
+void hal_ledc_set_duty(int channel, uint32_t duty) {
+  ledc_set_duty(LEDC_MODE, static_cast<ledc_channel_t>(channel), duty);
+  ledc_update_duty(LEDC_MODE, static_cast<ledc_channel_t>(channel));
+}
@@ -0,0 +1,81 @@
+#include "hal/rtos.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "hal/memory.h"
+
+static TaskHandle_t handle(hal_task_t task) {
+  return reinterpret_cast<TaskHandle_t>(task);
+}
+
+bool hal_task_create(hal_task_fn_t fn, const char* name, uint32_t stack_size,
+                     void* arg, int priority, hal_task_t* task) {
+  TaskHandle_t created = nullptr;
+  if (xTaskCreate(fn, name, stack_size, arg, priority, &created) != pdPASS) {
+    return false;
+  }
+  if (task != nullptr) {
+    *task = reinterpret_cast<hal_task_t>(created);
+  }
+  hal_task_track(reinterpret_cast<hal_task_t>(created), name, stack_size);
+  return true;
+}
+
+uint32_t hal_task_stack_free_min(hal_task_t task) {
+  // Stacks are counted in bytes on ESP-IDF.
+  return uxTaskGetStackHighWaterMark(handle(task));
+}
+
+void hal_task_exit(void) {
+  hal_task_untrack(hal_task_current());
+  vTaskDelete(nullptr);
+}
+
+hal_tick_t hal_tick_count(void) { return xTaskGetTickCount(); }
+
+void hal_delay_ticks(hal_tick_t ticks) { vTaskDelay(ticks); }
+
+void hal_delay_until(hal_tick_t* last_wake, hal_tick_t period) {
+  vTaskDelayUntil(last_wake, period);
+}
+
+void hal_task_notify(hal_task_t task, uint32_t bits) {
+  xTaskNotify(handle(task), bits, eSetBits);
+}
+
+void hal_task_notify_from_isr(hal_task_t task, uint32_t bits) {
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(handle(task), bits, eSetBits, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+uint32_t hal_task_notify_wait(hal_tick_t timeout) {
+  uint32_t bits = 0;
+  if (xTaskNotifyWait(0, UINT32_MAX, &bits, timeout) != pdTRUE) {
+    return 0;
+  }
+  return bits;
+}
+
+hal_task_t hal_task_current(void) {
+  return reinterpret_cast<hal_task_t>(xTaskGetCurrentTaskHandle());
+}
+
+uint32_t hal_mask_interrupts(void) { return portSET_INTERRUPT_MASK_FROM_ISR(); }
+
+void hal_unmask_interrupts(uint32_t state) {
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(state);
+}
+
+int hal_core_id(void) { return xPortGetCoreID(); }
+
+uint32_t hal_idle_time_us(int core) {
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+  // The run time counter is esp_timer microseconds, see
+  // CONFIG_FREERTOS_RUN_TIME_STATS_USING_ESP_TIMER.
+  return ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+#else
+  return 0;
+#endif
+}
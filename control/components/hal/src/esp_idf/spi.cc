@@ -0,0 +1,113 @@
+#include "hal/spi.h"
+
+#include <driver/spi_master.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+
+#include <cstring>
+
+#include "hal/memory.h"
+
+struct hal_spi_device_t {
+  spi_device_handle_t handle;
+};
+
+// Transfers that fit the controller's FIFO don't need DMA.
+constexpr size_t SPI_FIFO_SIZE = 64;
+
+bool hal_spi_bus_init(const hal_spi_bus_config_t* config) {
+  spi_bus_config_t bus_cfg = {
+      .mosi_io_num = config->mosi,
+      .miso_io_num = config->miso,
+      .sclk_io_num = config->sclk,
+      .quadwp_io_num = GPIO_NUM_NC,
+      .quadhd_io_num = GPIO_NUM_NC,
+      .data4_io_num = GPIO_NUM_NC,
+      .data5_io_num = GPIO_NUM_NC,
+      .data6_io_num = GPIO_NUM_NC,
+      .data7_io_num = GPIO_NUM_NC,
+      .max_transfer_sz = static_cast<int>(config->max_transfer_size),
+      .flags = SPICOMMON_BUSFLAG_MASTER,
+      .isr_cpu_id = ESP_INTR_CPU_AFFINITY_AUTO,
+      .intr_flags = 0,
+  };
+  spi_dma_chan_t dma = config->max_transfer_size > SPI_FIFO_SIZE
+                           ? SPI_DMA_CH_AUTO
+                           : SPI_DMA_DISABLED;
+  return spi_bus_initialize(static_cast<spi_host_device_t>(config->host),
+                            &bus_cfg, dma) == ESP_OK;
+}
+
+hal_spi_device_t* hal_spi_add_device(const hal_spi_device_config_t* config) {
+  spi_device_interface_config_t dev_cfg = {
+      .command_bits = 0,
+      .address_bits = 0,
+      .dummy_bits = 0,
+      .mode = config->mode,
+      .clock_source = SPI_CLK_SRC_DEFAULT,
+      .duty_cycle_pos = 128,
+      .cs_ena_pretrans = 0,
+      .cs_ena_posttrans = 0,
+      .clock_speed_hz = static_cast<int>(config->clock_speed_hz),
+      .input_delay_ns = 0,
+      .spics_io_num = config->cs,
+      // Transfers are full duplex, which can't have dummy bits.
+      .flags = SPI_DEVICE_NO_DUMMY,
+      .queue_size = 1,
+      .pre_cb = nullptr,
+      .post_cb = nullptr,
+  };
+  spi_device_handle_t handle;
+  if (spi_bus_add_device(static_cast<spi_host_device_t>(config->host),
+                         &dev_cfg, &handle) != ESP_OK) {
+    return nullptr;
+  }
+  hal_spi_device_t* device =
+      static_cast<hal_spi_device_t*>(hal_malloc(sizeof(hal_spi_device_t)));
+  device->handle = handle;
+  return device;
+}
+
+void hal_spi_remove_device(hal_spi_device_t* device) {
+  spi_bus_remove_device(device->handle);
+  hal_free(device);
+}
+
+bool hal_spi_acquire(hal_spi_device_t* device) {
+  return spi_device_acquire_bus(device->handle, portMAX_DELAY) == ESP_OK;
+}
+
+void hal_spi_release(hal_spi_device_t* device) {
+  spi_device_release_bus(device->handle);
+}
+
+bool hal_spi_transfer(hal_spi_device_t* device, const uint8_t* tx,
+                      uint8_t* rx, size_t len) {
+  spi_transaction_t transaction = {};
+  transaction.length = len * 8;
+  // Up to 4 bytes travel in the transaction itself rather than through
+  // buffers the driver may have to copy for DMA.
+  const bool inline_data = len <= sizeof(transaction.tx_data);
+  if (inline_data) {
+    transaction.flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_USE_RXDATA;
+    if (tx != nullptr) {
+      std::memcpy(transaction.tx_data, tx, len);
+    }
+  } else {
+    transaction.tx_buffer = tx;
+    transaction.rx_buffer = rx;
+  }
+  if (spi_device_polling_transmit(device->handle, &transaction) != ESP_OK) {
+    return false;
+  }
+  if (inline_data && rx != nullptr) {
+    std::memcpy(rx, transaction.rx_data, len);
+  }
+  return true;
+}
+
+uint32_t hal_spi_actual_freq_hz(hal_spi_device_t* device) {
+  int freq_khz = 0;
+  spi_device_get_actual_freq(device->handle, &freq_khz);
+  return static_cast<uint32_t>(freq_khz) * 1000;
+}
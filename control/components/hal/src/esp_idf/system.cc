@@ -0,0 +1,19 @@
+#include "hal/system.h"
+
+#include <esp_heap_caps.h>
+#include <esp_random.h>
+#include <esp_system.h>
+
+#include "hal/memory.h"
+
+size_t hal_free_heap_size(void) { return esp_get_free_heap_size(); }
+
+size_t hal_heap_size(void) {
+  return heap_caps_get_total_size(MALLOC_CAP_DEFAULT);
+}
+
+size_t hal_min_free_heap_size(void) {
+  return esp_get_minimum_free_heap_size();
+}
+
+uint32_t hal_random(void) { return esp_random(); }
@@ -0,0 +1,14 @@
+#include "hal/timer.h"
+
+#include <esp_cpu.h>
+#include <esp_rom_sys.h>
+#include <esp_timer.h>
+#include <sdkconfig.h>
+
+int64_t hal_time_us(void) { return esp_timer_get_time(); }
+
+uint32_t hal_cycle_count(void) { return esp_cpu_get_cycle_count(); }
+
+uint32_t hal_cycles_per_us(void) { return CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ; }
+
+void hal_delay_us(uint32_t us) { esp_rom_delay_us(us); }
@@ -0,0 +1,42 @@
+#include "hal/uart.h"
+
+#include <driver/uart.h>
+#include <driver/uart_vfs.h>
+#include <esp_err.h>
+
+static uart_port_t uart(hal_uart_port_t port) {
+  return static_cast<uart_port_t>(port);
+}
+
+bool hal_uart_install(hal_uart_port_t port, size_t rx_buffer_size,
+                      size_t tx_buffer_size) {
+  return uart_driver_install(uart(port), rx_buffer_size, tx_buffer_size, 0,
+                             nullptr, 0) == ESP_OK;
+}
+
+void hal_uart_set_baud_rate(hal_uart_port_t port, uint32_t baud_rate) {
+  uart_set_baudrate(uart(port), baud_rate);
+}
+
+void hal_uart_wait_tx_idle(hal_uart_port_t port) {
+  uart_wait_tx_idle_polling(uart(port));
+}
+
+void hal_uart_route_stdout(hal_uart_port_t port) {
+  uart_vfs_dev_use_driver(port);
+}
+
+int hal_uart_read(hal_uart_port_t port, uint8_t* data, size_t len,
+                  hal_tick_t timeout) {
+  return uart_read_bytes(uart(port), data, len, timeout);
+}
+
+int hal_uart_write(hal_uart_port_t port, const uint8_t* data, size_t len) {
+  return uart_write_bytes(uart(port), data, len);
+}
+
+size_t hal_uart_tx_free(hal_uart_port_t port) {
+  size_t free = 0;
+  uart_get_tx_buffer_free_size(uart(port), &free);
+  return free;
+}
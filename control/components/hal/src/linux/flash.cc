@@ -0,0 +1,88 @@
+#include "hal/flash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hal/linux.h"
+
+// Erase granularity of the SPI NOR flash.
+constexpr uint32_t SECTOR_SIZE = 4096;
+
+struct hal_partition_t {
+  std::string label;
+  std::vector<uint8_t> data;
+};
+
+namespace {
+
+// Entries are never removed, so pointers to them stay valid.
+std::list<hal_partition_t> PARTITIONS;
+std::mutex PARTITIONS_LOCK;
+
+bool in_range(const hal_partition_t* partition, uint32_t offset, size_t size) {
+  return offset <= partition->data.size() &&
+         size <= partition->data.size() - offset;
+}
+
+}  // namespace
+
+const hal_partition_t* hal_partition_find(const char* label) {
+  std::lock_guard<std::mutex> lock(PARTITIONS_LOCK);
+  for (const hal_partition_t& partition : PARTITIONS) {
+    if (partition.label == label) {
+      return &partition;
+    }
+  }
+  return nullptr;
+}
+
+uint32_t hal_partition_size(const hal_partition_t* partition) {
+  return partition->data.size();
+}
+
+bool hal_partition_erase(const hal_partition_t* partition, uint32_t offset,
+                         uint32_t size) {
+  if (offset % SECTOR_SIZE != 0 || size % SECTOR_SIZE != 0 ||
+      !in_range(partition, offset, size)) {
+    return false;
+  }
+  auto* bytes = const_cast<uint8_t*>(partition->data.data());
+  std::fill(bytes + offset, bytes + offset + size, 0xFF);
+  return true;
+}
+
+bool hal_partition_write(const hal_partition_t* partition, uint32_t offset,
+                         const void* data, size_t size) {
+  if (!in_range(partition, offset, size)) {
+    return false;
+  }
+  // Programming can only clear bits.
+  auto* bytes = const_cast<uint8_t*>(partition->data.data()) + offset;
+  const auto* in = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    bytes[i] &= in[i];
+  }
+  return true;
+}
+
+bool hal_partition_read(const hal_partition_t* partition, uint32_t offset,
+                        void* data, size_t size) {
+  if (!in_range(partition, offset, size)) {
+    return false;
+  }
+  std::memcpy(data, partition->data.data() + offset, size);
+  return true;
+}
+
+bool hal_linux_add_partition(const char* label, uint32_t size) {
+  if (size % SECTOR_SIZE != 0 || hal_partition_find(label) != nullptr) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(PARTITIONS_LOCK);
+  PARTITIONS.push_back({label, std::vector<uint8_t>(size, 0xFF)});
+  return true;
+}
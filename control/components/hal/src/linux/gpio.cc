@@ -0,0 +1,91 @@
+#include "hal/gpio.h"
+
+#include <array>
+#include <atomic>
+
+#include "hal/linux.h"
+
+namespace {
+
+struct Pin {
+  std::atomic<int> level{0};
+  hal_gpio_isr_t isr = nullptr;
+  void* isr_arg = nullptr;
+  hal_linux_gpio_fn_t watch = nullptr;
+  void* watch_ctx = nullptr;
+  hal_linux_gpio_sense_fn_t sense = nullptr;
+  void* sense_ctx = nullptr;
+};
+
+std::array<Pin, HAL_GPIO_MAX> PINS;
+
+Pin* pin_at(hal_gpio_t pin) {
+  return pin >= 0 && pin < HAL_GPIO_MAX ? &PINS[pin] : nullptr;
+}
+
+}  // namespace
+
+void hal_gpio_output(hal_gpio_t pin) {}
+
+void hal_gpio_input(hal_gpio_t pin) {}
+
+void hal_gpio_set_level(hal_gpio_t pin, int level) {
+  Pin* p = pin_at(pin);
+  if (p == nullptr) {
+    return;
+  }
+  p->level = level != 0;
+  if (p->watch != nullptr) {
+    p->watch(p->watch_ctx, pin, level != 0);
+  }
+}
+
+int hal_gpio_get_level(hal_gpio_t pin) {
+  Pin* p = pin_at(pin);
+  if (p == nullptr) {
+    return 0;
+  }
+  if (p->sense != nullptr) {
+    return p->sense(p->sense_ctx, pin) != 0;
+  }
+  return p->level.load();
+}
+
+bool hal_gpio_on_rising_edge(hal_gpio_t pin, hal_gpio_isr_t handler,
+                             void* arg) {
+  Pin* p = pin_at(pin);
+  if (p == nullptr) {
+    return false;
+  }
+  p->isr_arg = arg;
+  p->isr = handler;
+  return true;
+}
+
+void hal_linux_gpio_drive(hal_gpio_t pin, int level) {
+  Pin* p = pin_at(pin);
+  if (p == nullptr) {
+    return;
+  }
+  int previous = p->level.exchange(level != 0);
+  if (!previous && level && p->isr != nullptr) {
+    p->isr(p->isr_arg);
+  }
+}
+
+void hal_linux_gpio_watch(hal_gpio_t pin, hal_linux_gpio_fn_t fn, void* ctx) {
+  Pin* p = pin_at(pin);
+  if (p != nullptr) {
+    p->watch_ctx = ctx;
+    p->watch = fn;
+  }
+}
+
+void hal_linux_gpio_sense(hal_gpio_t pin, hal_linux_gpio_sense_fn_t fn,
+                          void* ctx) {
+  Pin* p = pin_at(pin);
+  if (p != nullptr) {
+    p->sense_ctx = ctx;
+    p->sense = fn;
+  }
+}
@@ -0,0 +1,48 @@
+#include "hal/ledc.h"
+
+#include <array>
+#include <atomic>
+
+#include "hal/linux.h"
+
+namespace {
+
+struct Channel {
+  std::atomic<hal_gpio_t> pin{HAL_GPIO_NC};
+  std::atomic<uint32_t> duty{0};
+};
+
+std::array<Channel, HAL_LEDC_CHANNEL_MAX> CHANNELS;
+
+bool valid(int channel) {
+  return channel >= 0 && channel < HAL_LEDC_CHANNEL_MAX;
+}
+
+}  // namespace
+
+bool hal_ledc_timer_init(uint32_t freq_hz, uint8_t duty_resolution_bits) {
+  return freq_hz > 0 && duty_resolution_bits > 0 && duty_resolution_bits <= 20;
+}
+
+bool hal_ledc_channel_init(int channel, hal_gpio_t pin) {
+  if (!valid(channel)) {
+    return false;
+  }
+  CHANNELS[channel].duty = 0;
+  CHANNELS[channel].pin = pin;
+  return true;
+}
+
+void hal_ledc_set_duty(int channel, uint32_t duty) {
+  if (valid(channel)) {
+    CHANNELS[channel].duty = duty;
+  }
+}
+
+uint32_t hal_linux_ledc_duty(int channel) {
+  return valid(channel) ? CHANNELS[channel].duty.load() : 0;
+}
+
+hal_gpio_t hal_linux_ledc_pin(int channel) {
+  return valid(channel) ? CHANNELS[channel].pin.load() : HAL_GPIO_NC;
+}
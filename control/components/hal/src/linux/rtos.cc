@@ -0,0 +1,143 @@
+#include "hal/rtos.h"
+
+#include <pthread.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "hal/memory.h"
+
+struct hal_task {
+  std::mutex mutex;
+  std::condition_variable notified;
+  uint32_t bits = 0;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point START = Clock::now();
+
+// Threads that weren't started by hal_task_create() get a task on first use.
+thread_local hal_task* CURRENT = nullptr;
+
+// Stands in for the interrupt mask of the single core.
+std::recursive_mutex INTERRUPTS;
+
+Clock::time_point tick_time(hal_tick_t tick) {
+  return START + std::chrono::milliseconds(tick * HAL_TICK_PERIOD_MS);
+}
+
+}  // namespace
+
+bool hal_task_create(hal_task_fn_t fn, const char* name, uint32_t stack_size,
+                     void* arg, int priority, hal_task_t* task) {
+  // Never freed, like a FreeRTOS task that never returns.
+  hal_task* created = new hal_task;
+  if (task != nullptr) {
+    *task = created;
+  }
+  std::thread thread([fn, arg, created, thread_name = std::string(name)] {
+    // Linux limits thread names to 15 characters.
+    pthread_setname_np(pthread_self(), thread_name.substr(0, 15).c_str());
+    CURRENT = created;
+    fn(arg);
+  });
+  thread.detach();
+  hal_task_track(created, name, stack_size);
+  return true;
+}
+
+uint32_t hal_task_stack_free_min(hal_task_t task) { return HAL_STACK_UNKNOWN; }
+
+void hal_task_exit(void) {
+  hal_task_untrack(hal_task_current());
+  // Unwinds the thread, like returning from the task's function.
+  pthread_exit(nullptr);
+}
+
+hal_tick_t hal_tick_count(void) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                               START)
+             .count() /
+         HAL_TICK_PERIOD_MS;
+}
+
+void hal_delay_ticks(hal_tick_t ticks) {
+  std::this_thread::sleep_for(
+      std::chrono::milliseconds(ticks * HAL_TICK_PERIOD_MS));
+}
+
+void hal_delay_until(hal_tick_t* last_wake, hal_tick_t period) {
+  *last_wake += period;
+  std::this_thread::sleep_until(tick_time(*last_wake));
+}
+
+void hal_task_notify(hal_task_t task, uint32_t bits) {
+  {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->bits |= bits;
+  }
+  task->notified.notify_one();
+}
+
+void hal_task_notify_from_isr(hal_task_t task, uint32_t bits) {
+  hal_task_notify(task, bits);
+}
+
+uint32_t hal_task_notify_wait(hal_tick_t timeout) {
+  hal_task_t task = hal_task_current();
+  std::unique_lock<std::mutex> lock(task->mutex);
+  auto received = [task] { return task->bits != 0; };
+  if (timeout == HAL_WAIT_FOREVER) {
+    task->notified.wait(lock, received);
+  } else {
+    task->notified.wait_for(
+        lock, std::chrono::milliseconds(timeout * HAL_TICK_PERIOD_MS),
+        received);
+  }
+  uint32_t bits = task->bits;
+  task->bits = 0;
+  return bits;
+}
+
+hal_task_t hal_task_current(void) {
+  if (CURRENT == nullptr) {
+    CURRENT = new hal_task;
+  }
+  return CURRENT;
+}
+
+void hal_enter_critical(hal_spinlock_t* lock) {
+  pthread_mutex_lock(&lock->mutex);
+}
+
+void hal_exit_critical(hal_spinlock_t* lock) {
+  pthread_mutex_unlock(&lock->mutex);
+}
+
+uint32_t hal_mask_interrupts(void) {
+  INTERRUPTS.lock();
+  return 0;
+}
+
+void hal_unmask_interrupts(uint32_t state) { INTERRUPTS.unlock(); }
+
+int hal_core_id(void) { return 0; }
+
+uint32_t hal_idle_time_us(int core) {
+  timespec cpu;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu);
+  int64_t wall_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - START)
+                        .count();
+  int64_t busy_us = cpu.tv_sec * 1000000LL + cpu.tv_nsec / 1000;
+  return static_cast<uint32_t>(std::max<int64_t>(0, wall_us - busy_us));
+}
@@ -0,0 +1,114 @@
+#include "hal/spi.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "hal/linux.h"
+
+// Like the ESP32-S3's SPI2 and SPI3, plus SPI1 (the flash).
+constexpr int SPI_HOST_COUNT = 3;
+// The controllers divide the APB clock by an integer.
+constexpr uint32_t SPI_SOURCE_CLOCK_HZ = 80 * 1000 * 1000;
+
+struct hal_spi_device_t {
+  hal_spi_host_t host;
+  hal_gpio_t cs;
+  uint32_t clock_speed_hz;
+};
+
+namespace {
+
+struct Attached {
+  hal_linux_spi_fn_t fn = nullptr;
+  void* ctx = nullptr;
+};
+
+struct Bus {
+  // Held across hal_spi_acquire() and by every transfer.
+  std::recursive_mutex mutex;
+  std::array<Attached, HAL_GPIO_MAX> devices;
+};
+
+std::array<Bus, SPI_HOST_COUNT> BUSES;
+
+bool valid(hal_spi_host_t host, hal_gpio_t cs) {
+  return host >= 0 && host < SPI_HOST_COUNT && cs >= 0 && cs < HAL_GPIO_MAX;
+}
+
+}  // namespace
+
+bool hal_spi_bus_init(const hal_spi_bus_config_t* config) {
+  return config->host >= 0 && config->host < SPI_HOST_COUNT;
+}
+
+hal_spi_device_t* hal_spi_add_device(const hal_spi_device_config_t* config) {
+  if (!valid(config->host, config->cs)) {
+    return nullptr;
+  }
+  return new hal_spi_device_t{
+      .host = config->host,
+      .cs = config->cs,
+      .clock_speed_hz = config->clock_speed_hz,
+  };
+}
+
+void hal_spi_remove_device(hal_spi_device_t* device) { delete device; }
+
+bool hal_spi_acquire(hal_spi_device_t* device) {
+  BUSES[device->host].mutex.lock();
+  return true;
+}
+
+void hal_spi_release(hal_spi_device_t* device) {
+  BUSES[device->host].mutex.unlock();
+}
+
+bool hal_spi_transfer(hal_spi_device_t* device, const uint8_t* tx,
+                      uint8_t* rx, size_t len) {
+  Bus& bus = BUSES[device->host];
+  std::lock_guard<std::recursive_mutex> lock(bus.mutex);
+  const Attached& attached = bus.devices[device->cs];
+  if (attached.fn == nullptr) {
+    if (rx != nullptr) {
+      std::memset(rx, 0, len);
+    }
+    return true;
+  }
+  // The device sees every bit clocked, even when the caller sends nothing.
+  std::vector<uint8_t> sent;
+  std::vector<uint8_t> discard;
+  if (tx == nullptr) {
+    sent.resize(len);
+    tx = sent.data();
+  } else if (tx == rx) {
+    // Full duplex in place, as ra01s does: the device sees what was sent.
+    sent.assign(tx, tx + len);
+    tx = sent.data();
+  }
+  if (rx == nullptr) {
+    discard.resize(len);
+    rx = discard.data();
+  }
+  attached.fn(attached.ctx, hal_spi_actual_freq_hz(device), tx, rx, len);
+  return true;
+}
+
+uint32_t hal_spi_actual_freq_hz(hal_spi_device_t* device) {
+  // Like spi_get_actual_clock(), the fastest clock not above the requested
+  // one.
+  uint32_t requested = std::max<uint32_t>(device->clock_speed_hz, 1);
+  uint32_t divider = (SPI_SOURCE_CLOCK_HZ + requested - 1) / requested;
+  return SPI_SOURCE_CLOCK_HZ / std::max<uint32_t>(divider, 1);
+}
+
+void hal_linux_spi_attach(hal_spi_host_t host, hal_gpio_t cs,
+                          hal_linux_spi_fn_t fn, void* ctx) {
+  if (!valid(host, cs)) {
+    return;
+  }
+  std::lock_guard<std::recursive_mutex> lock(BUSES[host].mutex);
+  BUSES[host].devices[cs] = {.fn = fn, .ctx = ctx};
+}
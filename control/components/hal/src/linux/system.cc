@@ -0,0 +1,26 @@
+#include "hal/system.h"
+
+#include <malloc.h>
+
+#include <random>
+
+#include "hal/memory.h"
+
+size_t hal_free_heap_size(void) {
+  // What the allocator holds but hasn't handed out; the host has no fixed
+  // heap.
+  return mallinfo2().fordblks;
+}
+
+size_t hal_heap_size(void) {
+  struct mallinfo2 info = mallinfo2();
+  return info.arena + info.hblkhd;
+}
+
+// The host's heap grows on demand: report what is free now.
+size_t hal_min_free_heap_size(void) { return hal_free_heap_size(); }
+
+uint32_t hal_random(void) {
+  static thread_local std::random_device device;
+  return device();
+}
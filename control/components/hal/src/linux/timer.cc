@@ -0,0 +1,28 @@
+#include "hal/timer.h"
+
+#include <chrono>
+
+using Clock = std::chrono::steady_clock;
+
+// Boot is when the process starts.
+static const Clock::time_point BOOT = Clock::now();
+
+static int64_t ns_since_boot() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              BOOT)
+      .count();
+}
+
+int64_t hal_time_us(void) { return ns_since_boot() / 1000; }
+
+// Nanoseconds stand in for cycles: a host's cycle counter has no fixed rate,
+// and perf or valgrind give the real cycle counts.
+uint32_t hal_cycle_count(void) { return static_cast<uint32_t>(ns_since_boot()); }
+
+uint32_t hal_cycles_per_us(void) { return 1000; }
+
+void hal_delay_us(uint32_t us) {
+  const Clock::time_point until = Clock::now() + std::chrono::microseconds(us);
+  while (Clock::now() < until) {
+  }
+}
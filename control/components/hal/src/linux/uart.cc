@@ -0,0 +1,117 @@
+#include "hal/uart.h"
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "hal/linux.h"
+
+namespace {
+
+struct Port {
+  std::atomic<int> fd{-1};
+  size_t tx_buffer_size = 0;
+};
+
+// Like the ESP32-S3's UART0 to UART2.
+std::array<Port, 3> PORTS;
+
+Port* port_at(hal_uart_port_t port) {
+  return port >= 0 && port < static_cast<int>(PORTS.size()) ? &PORTS[port]
+                                                            : nullptr;
+}
+
+}  // namespace
+
+bool hal_uart_install(hal_uart_port_t port, size_t rx_buffer_size,
+                      size_t tx_buffer_size) {
+  Port* p = port_at(port);
+  if (p == nullptr) {
+    return false;
+  }
+  p->tx_buffer_size = tx_buffer_size;
+  return true;
+}
+
+// The PTY or pipe on the other end has no baud rate.
+void hal_uart_set_baud_rate(hal_uart_port_t port, uint32_t baud_rate) {}
+
+void hal_uart_wait_tx_idle(hal_uart_port_t port) {
+  Port* p = port_at(port);
+  if (p != nullptr && p->fd >= 0) {
+    tcdrain(p->fd);
+  }
+}
+
+// Log lines stay on the process's stdout, apart from the frames.
+void hal_uart_route_stdout(hal_uart_port_t port) {}
+
+int hal_uart_read(hal_uart_port_t port, uint8_t* data, size_t len,
+                  hal_tick_t timeout) {
+  Port* p = port_at(port);
+  if (p == nullptr) {
+    return -1;
+  }
+  int timeout_ms = timeout == HAL_WAIT_FOREVER
+                       ? -1
+                       : static_cast<int>(timeout * HAL_TICK_PERIOD_MS);
+  int fd = p->fd;
+  if (fd < 0) {
+    // Nothing attached: a quiet line.
+    if (timeout_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    }
+    return 0;
+  }
+  pollfd poll_fd = {fd, POLLIN, 0};
+  if (poll(&poll_fd, 1, timeout_ms) <= 0) {
+    return 0;
+  }
+  ssize_t n = read(fd, data, len);
+  return n < 0 ? 0 : static_cast<int>(n);
+}
+
+int hal_uart_write(hal_uart_port_t port, const uint8_t* data, size_t len) {
+  Port* p = port_at(port);
+  if (p == nullptr) {
+    return -1;
+  }
+  int fd = p->fd;
+  size_t written = 0;
+  while (fd >= 0 && written < len) {
+    ssize_t n = write(fd, data + written, len - written);
+    if (n <= 0) {
+      break;
+    }
+    written += n;
+  }
+  // Unplugged, the bytes are simply lost.
+  return static_cast<int>(len);
+}
+
+size_t hal_uart_tx_free(hal_uart_port_t port) {
+  Port* p = port_at(port);
+  if (p == nullptr) {
+    return 0;
+  }
+  int queued = 0;
+  if (p->fd >= 0 && ioctl(p->fd, TIOCOUTQ, &queued) != 0) {
+    queued = 0;
+  }
+  return queued >= static_cast<int>(p->tx_buffer_size)
+             ? 0
+             : p->tx_buffer_size - queued;
+}
+
+void hal_linux_uart_attach(hal_uart_port_t port, int fd) {
+  Port* p = port_at(port);
+  if (p != nullptr) {
+    p->fd = fd;
+  }
+}
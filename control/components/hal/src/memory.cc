@@ -0,0 +1,131 @@
+#include "hal/memory.h"
+
+#include <esp_attr.h>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#include "hal/rtos.h"
+
+namespace {
+
+std::atomic<uint32_t> ALLOC_COUNT{0};
+std::atomic<bool> ALLOCS_FORBIDDEN{false};
+
+hal_spinlock_t SITES_LOCK = HAL_SPINLOCK_INIT;
+hal_alloc_site_t SITES[HAL_ALLOC_SITE_MAX];
+size_t SITE_COUNT = 0;
+
+struct TrackedTask {
+  hal_task_t task;
+  const char* name;
+  uint32_t stack_size;
+};
+
+hal_spinlock_t TASKS_LOCK = HAL_SPINLOCK_INIT;
+TrackedTask TASKS[HAL_TRACKED_TASK_MAX];
+size_t TASK_COUNT = 0;
+
+void IRAM_ATTR count_alloc() {
+  ALLOC_COUNT.fetch_add(1, std::memory_order_relaxed);
+  if (ALLOCS_FORBIDDEN.load(std::memory_order_relaxed)) {
+    // The board's panic handler prints the backtrace of the caller.
+    std::abort();
+  }
+}
+
+}  // namespace
+
+#ifdef ESP_PLATFORM
+// Called by the heap after every allocation, from any context, with
+// CONFIG_HEAP_USE_HOOKS.
+extern "C" void IRAM_ATTR esp_heap_trace_alloc_hook(void* ptr, size_t size,
+                                                    uint32_t caps) {
+  count_alloc();
+}
+
+extern "C" void IRAM_ATTR esp_heap_trace_free_hook(void* ptr) {}
+#endif
+
+void* hal_malloc_at(size_t size, const char* site) {
+#ifndef ESP_PLATFORM
+  // The board's heap hook counts the malloc() below.
+  count_alloc();
+#endif
+  void* ptr = std::malloc(size);
+  hal_enter_critical(&SITES_LOCK);
+  size_t i = 0;
+  while (i < SITE_COUNT && SITES[i].site != site) {
+    i++;
+  }
+  if (i == SITE_COUNT) {
+    if (SITE_COUNT == HAL_ALLOC_SITE_MAX) {
+      // The last slot collects the sites that didn't fit.
+      i = HAL_ALLOC_SITE_MAX - 1;
+      SITES[i].site = "other";
+    } else {
+      SITES[SITE_COUNT++] = {.site = site, .count = 0, .bytes = 0};
+    }
+  }
+  SITES[i].count++;
+  SITES[i].bytes += size;
+  hal_exit_critical(&SITES_LOCK);
+  return ptr;
+}
+
+void hal_free(void* ptr) { std::free(ptr); }
+
+size_t hal_alloc_sites(hal_alloc_site_t* out, size_t cap) {
+  hal_enter_critical(&SITES_LOCK);
+  size_t count = SITE_COUNT < cap ? SITE_COUNT : cap;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = SITES[i];
+  }
+  hal_exit_critical(&SITES_LOCK);
+  return count;
+}
+
+uint32_t hal_heap_alloc_count(void) {
+  return ALLOC_COUNT.load(std::memory_order_relaxed);
+}
+
+void hal_heap_forbid_allocs(void) { ALLOCS_FORBIDDEN = true; }
+
+void hal_task_track(hal_task_t task, const char* name, uint32_t stack_size) {
+  hal_enter_critical(&TASKS_LOCK);
+  if (TASK_COUNT < HAL_TRACKED_TASK_MAX) {
+    TASKS[TASK_COUNT++] = {.task = task, .name = name, .stack_size = stack_size};
+  }
+  hal_exit_critical(&TASKS_LOCK);
+}
+
+void hal_task_untrack(hal_task_t task) {
+  hal_enter_critical(&TASKS_LOCK);
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    if (TASKS[i].task == task) {
+      TASKS[i] = TASKS[--TASK_COUNT];
+      break;
+    }
+  }
+  hal_exit_critical(&TASKS_LOCK);
+}
+
+size_t hal_task_stacks(hal_task_stack_t* out, size_t cap) {
+  TrackedTask tasks[HAL_TRACKED_TASK_MAX];
+  hal_enter_critical(&TASKS_LOCK);
+  size_t count = TASK_COUNT < cap ? TASK_COUNT : cap;
+  for (size_t i = 0; i < count; i++) {
+    tasks[i] = TASKS[i];
+  }
+  hal_exit_critical(&TASKS_LOCK);
+  // Outside the lock: reading the high-water mark scans the stack.
+  for (size_t i = 0; i < count; i++) {
+    out[i] = {
+        .name = tasks[i].name,
+        .stack_size = tasks[i].stack_size,
+        .free_min = hal_task_stack_free_min(tasks[i].task),
+    };
+  }
+  return count;
+}
@@ -5,7 +5,10 @@
 extern "C" {
 #endif
 
-#include "driver/spi_master.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hal/gpio.h"
 
 // return values
 #define ERR_NONE 0
@@ -494,6 +497,34 @@ void LoRaConfig(uint8_t spreadingFactor, uint8_t bandwidth, uint8_t codingRate,
                 bool invertIrq);
 uint8_t LoRaReceive(uint8_t* pData, int16_t len);
 bool LoRaSend(uint8_t* pData, int16_t len, uint8_t mode);
+// Completes a send started with SX126x_TXMODE_ASYNC. Returns false while the
+// packet is still on air. Otherwise clears TX_DONE, returns the radio to
+// continuous receive and sets *sent to whether the packet went out.
+bool LoRaSendDone(bool* sent);
+// Gives up on a send started with SX126x_TXMODE_ASYNC that never finished,
+// and returns the radio to continuous receive.
+void LoRaSendAbort(void);
+// Routes RX_DONE, TX_DONE and CAD_DONE to DIO1 and calls `handler` from the
+// GPIO ISR on every received or sent packet and every finished CAD. Call
+// after LoRaConfig(). Returns false when DIO1_GPIO is not configured. The
+// handler must not access the radio; wake a task that calls LoRaReceive(),
+// LoRaSendDone() or LoRaCadDone() instead.
+bool LoRaEnableRxInterrupt(hal_gpio_isr_t handler, void* arg);
+// Starts one channel activity detection. Returns false, starting nothing, if
+// our own transmission is still on air. See AN1200.48 for
+// cadDetPeak/cadDetMin per spreading factor.
+bool LoRaCadStart(uint8_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin);
+// Completes a CAD started with LoRaCadStart(). Returns false while it runs.
+// Otherwise clears CAD_DONE, returns the radio to continuous receive and sets
+// *active to whether LoRa symbols were detected.
+bool LoRaCadDone(bool* active);
+// Gives up on a CAD that never finished, and returns the radio to continuous
+// receive.
+void LoRaCadAbort(void);
+// Runs one channel activity detection, waiting for it a tick at a time, and
+// returns to continuous receive. Returns true if LoRa symbols were detected
+// (or CAD timed out), false if the channel is free.
+bool LoRaChannelActive(uint8_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin);
 void LoRaDebugPrint(bool enable);
 
 // Private function
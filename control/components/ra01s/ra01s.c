@@ -4,11 +4,12 @@
 #include <math.h>
 #include <stdlib.h>
 
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include <assert.h>
 
-#include <driver/spi_master.h>
-#include <driver/gpio.h>
+#include "hal/gpio.h"
+#include "hal/rtos.h"
+#include "hal/spi.h"
+#include "hal/timer.h"
 #include "esp_log.h"
 
 #include "ra01s.h"
@@ -17,12 +18,12 @@
 
 // SPI Stuff
 #if CONFIG_SPI2_HOST
-#define HOST_ID SPI2_HOST
+#define HOST_ID 1 // SPI2_HOST
 #elif CONFIG_SPI3_HOST
-#define HOST_ID SPI3_HOST
+#define HOST_ID 2 // SPI3_HOST
 #endif
 
-static spi_device_handle_t SpiHandle;
+static hal_spi_device_t *SpiHandle;
 
 // Global Stuff
 static uint8_t PacketParams[6];
@@ -34,10 +35,13 @@ static int SX126x_RESET;
 static int SX126x_BUSY;
 static int SX126x_TXEN;
 static int SX126x_RXEN;
+// Command and payload of ReadBuffer/WriteBuffer, so they don't allocate per
+// packet: a 255 byte payload behind at most 3 bytes.
+static uint8_t BufferTransfer[255+3];
 
 // Arduino compatible macros
-#define delayMicroseconds(us) esp_rom_delay_us(us)
-#define delay(ms) esp_rom_delay_us(ms*1000)
+#define delayMicroseconds(us) hal_delay_us(us)
+#define delay(ms) hal_delay_us(ms*1000)
 
 
 void LoRaErrorDefault(int error)
@@ -46,7 +50,7 @@ void LoRaErrorDefault(int error)
 		ESP_LOGE(TAG, "LoRaErrorDefault=%d", error);
 	}
 	while (true) {
-		vTaskDelay(1);
+		hal_delay_ticks(1);
 	}
 }
 
@@ -63,6 +67,7 @@ void LoRaInit(void)
 	ESP_LOGI(TAG, "CONFIG_BUSY_GPIO=%d", CONFIG_BUSY_GPIO);
 	ESP_LOGI(TAG, "CONFIG_TXEN_GPIO=%d", CONFIG_TXEN_GPIO);
 	ESP_LOGI(TAG, "CONFIG_RXEN_GPIO=%d", CONFIG_RXEN_GPIO);
+	ESP_LOGI(TAG, "CONFIG_DIO1_GPIO=%d", CONFIG_DIO1_GPIO);
 
 	SX126x_SPI_SELECT = CONFIG_NSS_GPIO;
 	SX126x_RESET = CONFIG_RST_GPIO;
@@ -73,63 +78,50 @@ void LoRaInit(void)
 	txActive = false;
 	debugPrint = false;
 
-	gpio_reset_pin(SX126x_SPI_SELECT);
-	gpio_set_direction(SX126x_SPI_SELECT, GPIO_MODE_OUTPUT);
-	gpio_set_level(SX126x_SPI_SELECT, 1);
+	hal_gpio_output(SX126x_SPI_SELECT);
+	hal_gpio_set_level(SX126x_SPI_SELECT, 1);
 
-	gpio_reset_pin(SX126x_RESET);
-	gpio_set_direction(SX126x_RESET, GPIO_MODE_OUTPUT);
+	hal_gpio_output(SX126x_RESET);
 	
-	gpio_reset_pin(SX126x_BUSY);
-	gpio_set_direction(SX126x_BUSY, GPIO_MODE_INPUT);
+	hal_gpio_input(SX126x_BUSY);
 
 	if (SX126x_TXEN != -1) {
-		gpio_reset_pin(SX126x_TXEN);
-		gpio_set_direction(SX126x_TXEN, GPIO_MODE_OUTPUT);
+		hal_gpio_output(SX126x_TXEN);
 	}
 
 	if (SX126x_RXEN != -1) {
-		gpio_reset_pin(SX126x_RXEN);
-		gpio_set_direction(SX126x_RXEN, GPIO_MODE_OUTPUT);
+		hal_gpio_output(SX126x_RXEN);
 	}
 
-	spi_bus_config_t spi_bus_config = {
-		.sclk_io_num = CONFIG_SCLK_GPIO,
-		.mosi_io_num = CONFIG_MOSI_GPIO,
-		.miso_io_num = CONFIG_MISO_GPIO,
-		.quadwp_io_num = -1,
-		.quadhd_io_num = -1
+	hal_spi_bus_config_t spi_bus_config = {
+		.host = HOST_ID,
+		.mosi = CONFIG_MOSI_GPIO,
+		.miso = CONFIG_MISO_GPIO,
+		.sclk = CONFIG_SCLK_GPIO,
+		// A full FIFO buffer plus the command and status bytes.
+		.max_transfer_size = 256 + 4
 	};
 
-	esp_err_t ret;
-	ret = spi_bus_initialize( HOST_ID, &spi_bus_config, SPI_DMA_CH_AUTO );
-	ESP_LOGI(TAG, "spi_bus_initialize=%d",ret);
-	assert(ret==ESP_OK);
+	bool ret;
+	ret = hal_spi_bus_init( &spi_bus_config );
+	ESP_LOGI(TAG, "hal_spi_bus_init=%d",ret);
+	assert(ret);
 
-	spi_device_interface_config_t devcfg = {
+	hal_spi_device_config_t devcfg = {
+		.host = HOST_ID,
+		.cs = CONFIG_NSS_GPIO,
 		.clock_speed_hz = 9000000,
-		.mode = 0,
-		.spics_io_num = CONFIG_NSS_GPIO,
-		.queue_size = 7,
-		.flags = 0,
-		.pre_cb = NULL
+		.mode = 0
 	};
-	//spi_device_handle_t handle;
-	ret = spi_bus_add_device( HOST_ID, &devcfg, &SpiHandle);
-	ESP_LOGI(TAG, "spi_bus_add_device=%d",ret);
-	assert(ret==ESP_OK);
+	SpiHandle = hal_spi_add_device( &devcfg );
+	ESP_LOGI(TAG, "hal_spi_add_device=%d",SpiHandle != NULL);
+	assert(SpiHandle != NULL);
 }
 
 void spi_write_byte(uint8_t* Dataout, size_t DataLength )
 {
-	spi_transaction_t SPITransaction;
-
 	if ( DataLength > 0 ) {
-		memset( &SPITransaction, 0, sizeof( spi_transaction_t ) );
-		SPITransaction.length = DataLength * 8;
-		SPITransaction.tx_buffer = Dataout;
-		SPITransaction.rx_buffer = NULL;
-		spi_device_transmit( SpiHandle, &SPITransaction );
+		hal_spi_transfer( SpiHandle, Dataout, NULL, DataLength );
 	}
 
 	return;
@@ -137,14 +129,8 @@ void spi_write_byte(uint8_t* Dataout, size_t DataLength )
 
 void spi_read_byte(uint8_t* Datain, uint8_t* Dataout, size_t DataLength )
 {
-	spi_transaction_t SPITransaction;
-
 	if ( DataLength > 0 ) {
-		memset( &SPITransaction, 0, sizeof( spi_transaction_t ) );
-		SPITransaction.length = DataLength * 8;
-		SPITransaction.tx_buffer = Dataout;
-		SPITransaction.rx_buffer = Datain;
-		spi_device_transmit( SpiHandle, &SPITransaction );
+		hal_spi_transfer( SpiHandle, Dataout, Datain, DataLength );
 	}
 
 	return;
@@ -295,6 +281,93 @@ void LoRaConfig(uint8_t spreadingFactor, uint8_t bandwidth, uint8_t codingRate,
 }
 
 
+bool LoRaEnableRxInterrupt(hal_gpio_isr_t handler, void *arg)
+{
+	if (CONFIG_DIO1_GPIO == -1) {
+		return false;
+	}
+
+	if (!hal_gpio_on_rising_edge(CONFIG_DIO1_GPIO, handler, arg)) {
+		ESP_LOGE(TAG, "hal_gpio_on_rising_edge failed");
+		return false;
+	}
+
+	// Raise DIO1 when a packet has been received or sent, or a CAD is done.
+	// The IRQs stay latched until LoRaReceive(), LoRaSendDone() or
+	// LoRaCadDone() clears them, so the line drops again after every one.
+	SetDioIrqParams(SX126X_IRQ_ALL, //all interrupts enabled
+		SX126X_IRQ_RX_DONE | SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT |
+		SX126X_IRQ_CAD_DONE | SX126X_IRQ_CAD_DETECTED, //interrupts on DIO1
+		SX126X_IRQ_NONE, //interrupts on DIO2
+		SX126X_IRQ_NONE //interrupts on DIO3
+	);
+	ClearIrqStatus(SX126X_IRQ_ALL);
+	return true;
+}
+
+
+bool LoRaCadStart(uint8_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin)
+{
+	// The channel is ours while our own transmission is still on air.
+	if (txActive) return false;
+
+	SetStandby(SX126X_STANDBY_RC);
+	ClearIrqStatus(SX126X_IRQ_ALL);
+	SetCadParams(cadSymbolNum, cadDetPeak, cadDetMin, SX126X_CAD_GOTO_STDBY, 0);
+	SetCad();
+	return true;
+}
+
+
+bool LoRaCadDone(bool *active)
+{
+	uint16_t irqStatus = GetIrqStatus();
+	if ( !(irqStatus & SX126X_IRQ_CAD_DONE) )
+	{
+		return false;
+	}
+	if (debugPrint) {
+		ESP_LOGI(TAG, "CAD irqStatus=0x%x", irqStatus);
+	}
+	ClearIrqStatus(SX126X_IRQ_CAD_DONE | SX126X_IRQ_CAD_DETECTED);
+
+	// Back to continuous receive before anything else: a detected preamble is
+	// usually a packet for us and the remaining preamble symbols still lock.
+	SetRx(0xFFFFFF);
+
+	*active = (irqStatus & SX126X_IRQ_CAD_DETECTED) != 0;
+	return true;
+}
+
+
+void LoRaCadAbort(void)
+{
+	SetStandby(SX126X_STANDBY_RC);
+	ClearIrqStatus(SX126X_IRQ_CAD_DONE | SX126X_IRQ_CAD_DETECTED);
+	SetRx(0xFFFFFF);
+}
+
+
+bool LoRaChannelActive(uint8_t cadSymbolNum, uint8_t cadDetPeak, uint8_t cadDetMin)
+{
+	if (!LoRaCadStart(cadSymbolNum, cadDetPeak, cadDetMin)) return true;
+
+	// CAD takes a few symbols; wait a tick at a time for up to 1 second (16
+	// symbols at SF12).
+	int64_t deadline = hal_time_us() + 1000000;
+	bool active;
+	while (!LoRaCadDone(&active)) {
+		if (hal_time_us() >= deadline) {
+			ESP_LOGE(TAG, "CAD timeout");
+			LoRaCadAbort();
+			return true;
+		}
+		hal_delay_ticks(1);
+	}
+	return active;
+}
+
+
 void LoRaDebugPrint(bool enable) 
 {
 	debugPrint = enable;
@@ -355,6 +428,8 @@ bool LoRaSend(uint8_t *pData, int16_t len, uint8_t mode)
 				}
 			}
 			txActive = false;
+			// Let DIO1 drop so the next RX_DONE raises it again.
+			ClearIrqStatus(SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT);
 	
 			SetRx(0xFFFFFF);
 	
@@ -375,6 +450,38 @@ bool LoRaSend(uint8_t *pData, int16_t len, uint8_t mode)
 }
 
 
+bool LoRaSendDone(bool *sent)
+{
+	uint16_t irqStatus = GetIrqStatus();
+	if ( !(irqStatus & (SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT)) )
+	{
+		return false;
+	}
+	if (debugPrint) {
+		ESP_LOGI(TAG, "irqStatus=0x%x", irqStatus);
+	}
+	ClearIrqStatus(SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT);
+	txActive = false;
+	SetRx(0xFFFFFF);
+
+	*sent = (irqStatus & SX126X_IRQ_TX_DONE) != 0;
+	if (!*sent) txLost++;
+	return true;
+}
+
+
+void LoRaSendAbort(void)
+{
+	if ( txActive == false ) return;
+
+	SetStandby(SX126X_STANDBY_RC);
+	ClearIrqStatus(SX126X_IRQ_TX_DONE | SX126X_IRQ_TIMEOUT);
+	txActive = false;
+	SetRx(0xFFFFFF);
+	txLost++;
+}
+
+
 bool ReceiveMode(void)
 {
 	uint16_t irq;
@@ -417,9 +524,9 @@ void SetTxPower(int8_t txPowerInDbm)
 void Reset(void)
 {
 	delay(10);
-	gpio_set_level(SX126x_RESET,0);
+	hal_gpio_set_level(SX126x_RESET,0);
 	delay(20);
-	gpio_set_level(SX126x_RESET,1);
+	hal_gpio_set_level(SX126x_RESET,1);
 	delay(10);
 	// ensure BUSY is low (state meachine ready)
 	WaitForIdle(BUSY_WAIT, "Reset", true);
@@ -729,8 +836,8 @@ void SetRxEnable(void)
 		ESP_LOGI(TAG, "SetRxEnable:SX126x_TXEN=%d SX126x_RXEN=%d", SX126x_TXEN, SX126x_RXEN);
 	}
 	if ((SX126x_TXEN != -1) && (SX126x_RXEN != -1)) {
-		gpio_set_level(SX126x_RXEN, HIGH);
-		gpio_set_level(SX126x_TXEN, LOW);
+		hal_gpio_set_level(SX126x_RXEN, HIGH);
+		hal_gpio_set_level(SX126x_TXEN, LOW);
 	}
 }
 
@@ -748,6 +855,11 @@ void SetTx(uint32_t timeoutInMs)
 		uint32_t timeoutInUs = timeoutInMs * 1000;
 		tout = (uint32_t)(timeoutInUs / 0.015625);
 	}
+	// The timeout is 24 bits (262 ms). Longer ones would wrap and cut long
+	// packets short, so run without a timeout instead.
+	if (tout > 0xFFFFFF) {
+		tout = 0;
+	}
 	if (debugPrint) {
 		ESP_LOGI(TAG, "SetTx timeoutInMs=%"PRIu32" tout=%"PRIu32, timeoutInMs, tout);
 	}
@@ -758,7 +870,7 @@ void SetTx(uint32_t timeoutInMs)
 	
 	for(int retry=0;retry<10;retry++) {
 		if ((GetStatus() & 0x70) == 0x60) break;
-		vTaskDelay(1);
+		hal_delay_ticks(1);
 	}
 	if ((GetStatus() & 0x70) != 0x60) {
 		ESP_LOGE(TAG, "SetTx Illegal Status");
@@ -773,8 +885,8 @@ void SetTxEnable(void)
 		ESP_LOGI(TAG, "SetTxEnable:SX126x_TXEN=%d SX126x_RXEN=%d", SX126x_TXEN, SX126x_RXEN);
 	}
 	if ((SX126x_TXEN != -1) && (SX126x_RXEN != -1)){
-		gpio_set_level(SX126x_RXEN, LOW);
-		gpio_set_level(SX126x_TXEN, HIGH);
+		hal_gpio_set_level(SX126x_RXEN, LOW);
+		hal_gpio_set_level(SX126x_TXEN, HIGH);
 	}
 }
 
@@ -810,7 +922,7 @@ void WaitForIdleBegin(unsigned long timeout, char *text) {
 		bool ret = WaitForIdle(BUSY_WAIT, text, stop);
 		if (ret == true) break;
 		ESP_LOGW(TAG, "WaitForIdle fail retry=%d", retry);
-		vTaskDelay(1);
+		hal_delay_ticks(1);
 	}
 }
 
@@ -818,15 +930,15 @@ void WaitForIdleBegin(unsigned long timeout, char *text) {
 bool WaitForIdle(unsigned long timeout, char *text, bool stop)
 {
 	bool ret = true;
-	TickType_t start = xTaskGetTickCount();
+	hal_tick_t start = hal_tick_count();
 	//delayMicroseconds(1);
-	while(xTaskGetTickCount() - start < (timeout/portTICK_PERIOD_MS)) {
-		if (gpio_get_level(SX126x_BUSY) == 0) break;
+	while(hal_tick_count() - start < (timeout/HAL_TICK_PERIOD_MS)) {
+		if (hal_gpio_get_level(SX126x_BUSY) == 0) break;
 		//delayMicroseconds(1);
 		// Give up CPU execution rights
-		vTaskDelay(1);
+		hal_delay_ticks(1);
 	}
-	if (gpio_get_level(SX126x_BUSY)) {
+	if (hal_gpio_get_level(SX126x_BUSY)) {
 		if (stop) {
 			ESP_LOGE(TAG, "WaitForIdle Timeout text=%s timeout=%lu start=%"PRIu32, text, timeout, start);
 			LoRaError(ERR_IDLE_TIMEOUT);
@@ -854,20 +966,13 @@ uint8_t ReadBuffer(uint8_t *rxData, int16_t rxDataLen)
 	WaitForIdle(BUSY_WAIT, "start ReadBuffer", true);
 
 	// start transfer
-	uint8_t *buf;
-	buf = malloc(payloadLength+3);
-	if (buf != NULL) {
-		buf[0] = SX126X_CMD_READ_BUFFER; // 0x1E
-		buf[1] = offset; // offset in rx fifo
-		buf[2] = SX126X_CMD_NOP;
-		memset(&buf[3], SX126X_CMD_NOP, payloadLength);
-		spi_read_byte(buf, buf, payloadLength+3);
-		memcpy(rxData, &buf[3], payloadLength);
-		free(buf);
-	} else {
-		ESP_LOGE(TAG, "ReadBuffer malloc fail");
-		payloadLength = 0;
-	}
+	uint8_t *buf = BufferTransfer;
+	buf[0] = SX126X_CMD_READ_BUFFER; // 0x1E
+	buf[1] = offset; // offset in rx fifo
+	buf[2] = SX126X_CMD_NOP;
+	memset(&buf[3], SX126X_CMD_NOP, payloadLength);
+	spi_read_byte(buf, buf, payloadLength+3);
+	memcpy(rxData, &buf[3], payloadLength);
 
 	// wait for BUSY to go low
 	WaitForIdle(BUSY_WAIT, "end ReadBuffer", false);
@@ -882,16 +987,14 @@ void WriteBuffer(uint8_t *txData, int16_t txDataLen)
 	WaitForIdle(BUSY_WAIT, "start WriteBuffer", true);
 
 	// start transfer
-	uint8_t *buf;
-	buf = malloc(txDataLen+2);
-	if (buf != NULL) {
+	if (txDataLen < 0 || (size_t)txDataLen > sizeof(BufferTransfer)-2) {
+		ESP_LOGE(TAG, "WriteBuffer txDataLen too large. txDataLen=%d", txDataLen);
+	} else {
+		uint8_t *buf = BufferTransfer;
 		buf[0] = SX126X_CMD_WRITE_BUFFER; // 0x0E
 		buf[1] = 0; // offset in tx fifo
 		memcpy(&buf[2], txData, txDataLen);
 		spi_write_byte(buf, txDataLen+2);
-		free(buf);
-	} else {
-		ESP_LOGE(TAG, "WriteBuffer malloc fail");
 	}
 
 	// wait for BUSY to go low
@@ -979,20 +1082,23 @@ uint8_t WriteCommand2(uint8_t cmd, uint8_t* data, uint8_t numBytes) {
 	spi_read_byte(buf, buf, numBytes + 1);
 
 	uint8_t status = 0;
-	uint8_t cmd_status = buf[1] & 0xe;
-
-	switch(cmd_status){
-		case SX126X_STATUS_CMD_TIMEOUT:
-		case SX126X_STATUS_CMD_INVALID:
-		case SX126X_STATUS_CMD_FAILED:
-			status = cmd_status;
-			break;
-
-		case 0:
-		case 7:
-			status = SX126X_STATUS_SPI_FAILED;
-			break;
-			// default: break; // success
+	// Commands without parameters (SetCad) clock out no status byte to check.
+	if (numBytes > 0) {
+		uint8_t cmd_status = buf[1] & 0xe;
+
+		switch(cmd_status){
+			case SX126X_STATUS_CMD_TIMEOUT:
+			case SX126X_STATUS_CMD_INVALID:
+			case SX126X_STATUS_CMD_FAILED:
+				status = cmd_status;
+				break;
+
+			case 0:
+			case 7:
+				status = SX126X_STATUS_SPI_FAILED;
+				break;
+				// default: break; // success
+		}
 	}
 
 	// wait for BUSY to go low
@@ -1017,7 +1123,8 @@ void ReadCommand(uint8_t cmd, uint8_t* data, uint8_t numBytes) {
 	if (data != NULL && numBytes)
 		memcpy(data, &buf[1], numBytes);
 
-	// wait for BUSY to go low
-	vTaskDelay(1);
+	// wait for BUSY to go low. WaitForIdle only yields while BUSY is high, so
+	// reading status does not cost a full RTOS tick.
+	delayMicroseconds(1);
 	WaitForIdle(BUSY_WAIT, "end ReadCommand", false);
 }
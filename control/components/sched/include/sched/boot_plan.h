@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Ordering of initialization phases with explicit dependencies. Phase i's
+// dependencies are a bit mask of phase indices, `depends_on[i]`, so a plan
+// has at most BOOT_PLAN_MAX_PHASES phases.
+
+constexpr size_t BOOT_PLAN_MAX_PHASES = 32;
+
+constexpr uint32_t boot_plan_all(size_t count) {
+  return count >= 32 ? UINT32_MAX : (1u << count) - 1;
+}
+
+// Phases that haven't started and whose dependencies are all done.
+uint32_t boot_plan_ready(const uint32_t* depends_on, size_t count,
+                         uint32_t started, uint32_t done);
+
+// Whether every phase can run: dependencies name existing phases, and none
+// depends on itself, directly or not.
+bool boot_plan_valid(const uint32_t* depends_on, size_t count);
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+
+// Timing accounting for periodic tasks, kept apart from the RTOS so it runs
+// the same on the host. Times are microseconds on one monotonic clock.
+
+struct DeadlineStats {
+  uint32_t runs;
+  // Runs that ended more than the deadline after their release.
+  uint32_t misses;
+  // Start jitter: how long after its release a run started.
+  uint64_t jitter_total_us;
+  uint32_t jitter_max_us;
+  // Execution time, from start to end of a run.
+  uint64_t exec_total_us;
+  uint32_t exec_max_us;
+
+  uint32_t jitter_mean_us() const;
+  uint32_t exec_mean_us() const;
+};
+
+// Start jitter, execution time and deadline misses of one periodic task. A
+// task releases a run every period; each run must end within the deadline of
+// its release.
+class DeadlineMonitor {
+ public:
+  DeadlineMonitor(uint32_t period_us, uint32_t deadline_us)
+      : period_us_(period_us), deadline_us_(deadline_us) {}
+
+  // A run released at `release_us` started at `start_us`.
+  void begin(int64_t release_us, int64_t start_us);
+  // The run ended. Returns whether it missed its deadline.
+  bool end(int64_t end_us);
+
+  const DeadlineStats& stats() const { return stats_; }
+  void reset() { stats_ = {}; }
+  uint32_t period_us() const { return period_us_; }
+  uint32_t deadline_us() const { return deadline_us_; }
+
+ private:
+  uint32_t period_us_;
+  uint32_t deadline_us_;
+  int64_t release_us_ = 0;
+  int64_t start_us_ = 0;
+  DeadlineStats stats_ = {};
+};
+
+// Load of a core from the time its idle task ran, which is a wrapping
+// microsecond counter.
+class CpuLoadMeter {
+ public:
+  // Feeds the idle counter read at `now_us`. Returns the fraction of the time
+  // since the previous call the core spent outside idle, 0 on the first call.
+  float update(uint32_t idle_us, int64_t now_us);
+  float load() const { return load_; }
+
+ private:
+  bool started_ = false;
+  uint32_t idle_us_ = 0;
+  int64_t now_us_ = 0;
+  float load_ = 0;
+};
+
+struct DegradePolicy {
+  // Deadline misses, over every task, within one evaluation that trip
+  // degraded mode.
+  uint32_t max_misses;
+  // Load of any core above which degraded mode trips.
+  float max_cpu_load;
+  // How long evaluations must stay clean before degraded mode clears.
+  uint32_t recovery_us;
+};
+
+// Decides when the stand is falling behind: trips on too many deadline
+// misses or too high a load in one evaluation, and clears once evaluations
+// stayed clean for `recovery_us`.
+class DegradeMonitor {
+ public:
+  explicit DegradeMonitor(const DegradePolicy& policy) : policy_(policy) {}
+
+  // Evaluates `misses` deadline misses since the previous call and the
+  // highest core load `max_load`. Returns whether the stand is degraded.
+  bool update(int64_t now_us, uint32_t misses, float max_load);
+
+  bool degraded() const { return degraded_; }
+  // Times degraded mode was entered.
+  uint32_t trips() const { return trips_; }
+
+ private:
+  DegradePolicy policy_;
+  bool degraded_ = false;
+  int64_t clean_since_us_ = 0;
+  uint32_t trips_ = 0;
+};
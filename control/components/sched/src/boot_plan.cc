@@ -0,0 +1,38 @@
+#include "sched/boot_plan.h"
+
+#include <cstddef>
+#include <cstdint>
+
+uint32_t boot_plan_ready(const uint32_t* depends_on, size_t count,
+                         uint32_t started, uint32_t done) {
+  uint32_t ready = 0;
+  for (size_t i = 0; i < count && i < BOOT_PLAN_MAX_PHASES; i++) {
+    if (!(started & 1u << i) && (depends_on[i] & ~done) == 0) {
+      ready |= 1u << i;
+    }
+  }
+  return ready;
+}
+
+bool boot_plan_valid(const uint32_t* depends_on, size_t count) {
+  if (count > BOOT_PLAN_MAX_PHASES) {
+    return false;
+  }
+  const uint32_t all = boot_plan_all(count);
+  for (size_t i = 0; i < count; i++) {
+    if (depends_on[i] & ~all) {
+      return false;
+    }
+  }
+  // Run the plan as if every phase finished as soon as it started: a cycle
+  // leaves phases that never become ready.
+  uint32_t done = 0;
+  while (done != all) {
+    uint32_t ready = boot_plan_ready(depends_on, count, done, done);
+    if (ready == 0) {
+      return false;
+    }
+    done |= ready;
+  }
+  return true;
+}
@@ -0,0 +1,58 @@
+#include "sched/monitor.h"
+
+#include <algorithm>
+#include <cstdint>
+
+uint32_t DeadlineStats::jitter_mean_us() const {
+  return runs == 0 ? 0 : jitter_total_us / runs;
+}
+
+uint32_t DeadlineStats::exec_mean_us() const {
+  return runs == 0 ? 0 : exec_total_us / runs;
+}
+
+void DeadlineMonitor::begin(int64_t release_us, int64_t start_us) {
+  release_us_ = release_us;
+  start_us_ = start_us;
+  // A run may start before its release by the clock's granularity.
+  uint32_t jitter_us = std::max<int64_t>(0, start_us - release_us);
+  stats_.jitter_total_us += jitter_us;
+  stats_.jitter_max_us = std::max(stats_.jitter_max_us, jitter_us);
+}
+
+bool DeadlineMonitor::end(int64_t end_us) {
+  uint32_t exec_us = std::max<int64_t>(0, end_us - start_us_);
+  stats_.runs++;
+  stats_.exec_total_us += exec_us;
+  stats_.exec_max_us = std::max(stats_.exec_max_us, exec_us);
+  bool missed = end_us - release_us_ > deadline_us_;
+  stats_.misses += missed;
+  return missed;
+}
+
+float CpuLoadMeter::update(uint32_t idle_us, int64_t now_us) {
+  if (started_ && now_us > now_us_) {
+    // Unsigned, so a wrap of the idle counter still gives the difference.
+    uint32_t idle_delta_us = idle_us - idle_us_;
+    float idle = static_cast<float>(idle_delta_us) / (now_us - now_us_);
+    load_ = std::clamp(1.0f - idle, 0.0f, 1.0f);
+  }
+  started_ = true;
+  idle_us_ = idle_us;
+  now_us_ = now_us;
+  return load_;
+}
+
+bool DegradeMonitor::update(int64_t now_us, uint32_t misses, float max_load) {
+  bool clean = misses < policy_.max_misses && max_load <= policy_.max_cpu_load;
+  if (!clean) {
+    if (!degraded_) {
+      trips_++;
+    }
+    degraded_ = true;
+    clean_since_us_ = now_us;
+  } else if (degraded_ && now_us - clean_since_us_ >= policy_.recovery_us) {
+    degraded_ = false;
+  }
+  return degraded_;
+}
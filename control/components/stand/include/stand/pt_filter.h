@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+struct PtFilterConfig {
+  // Median of the last three readings first, to reject single-sample spikes
+  // (e.g. SPI glitches) before they reach the low-pass.
+  bool median;
+  // Cutoff of the one-pole low-pass, in Hz. 0 disables it.
+  float cutoff_hz;
+};
+
+// Smooths one transducer's readings. The low-pass uses the actual time
+// between readings, so jittery or irregular sampling keeps its cutoff.
+class PtFilter {
+ public:
+  PtFilter() = default;
+  explicit PtFilter(const PtFilterConfig& config) : config_(config) {}
+
+  // Adds a reading taken at `t_us`. Returns the filtered pressure.
+  float update(uint64_t t_us, float psi);
+
+  float value() const { return value_; }
+  bool primed() const { return count_ > 0; }
+
+ private:
+  PtFilterConfig config_ = {};
+  float history_[3] = {};
+  uint32_t count_ = 0;
+  uint64_t last_t_us_ = 0;
+  float value_ = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+// Linear transfer function of a pressure transducer.
+struct PtScale {
+  // Voltage range representing 0 to max pressure.
+  std::pair<float, float> voltage_range;
+  // Max pressure represented by voltage_range[1].
+  uint16_t max_pressure;
+};
+
+// Pressure in psi for a transducer output voltage. Voltages below the range
+// read 0 psi.
+float voltage_to_psi(const PtScale& scale, float voltage);
+
+// Inverse of voltage_to_psi(), for re-converting recorded pressures with a
+// different scale.
+float psi_to_voltage(const PtScale& scale, float psi);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <telemetry/stand_state.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Bit of a StandState in Redline::states.
+constexpr uint8_t stand_state_bit(StandState state) {
+  return 1 << static_cast<int>(state);
+}
+
+// Abort rule: a filtered pressure out of [min_psi, max_psi] for at least
+// `persist_us` while the stand is in one of `states`.
+struct Redline {
+  // Pt the rule watches.
+  uint8_t pt;
+  // stand_state_bit() of every state the rule is active in.
+  uint8_t states;
+  float min_psi;
+  float max_psi;
+  uint32_t persist_us;
+};
+
+// Tracks how long each redline has been exceeded.
+class RedlineMonitor {
+ public:
+  static constexpr size_t kMaxRedlines = 32;
+
+  // `redlines` must outlive the monitor; at most kMaxRedlines are checked.
+  RedlineMonitor(const Redline* redlines, size_t count);
+
+  // Checks the rules watching `pt` against a filtered reading taken at
+  // `t_us`. Returns the index of the first rule that trips, or -1.
+  int update(uint8_t pt, uint64_t t_us, float psi, StandState state);
+
+  // Forgets how long rules have been exceeded, e.g. on a state change.
+  void reset();
+
+ private:
+  const Redline* redlines_;
+  size_t count_;
+  // Whether each rule is exceeded, and since when.
+  bool exceeded_[kMaxRedlines] = {};
+  uint64_t exceeded_since_us_[kMaxRedlines] = {};
+};
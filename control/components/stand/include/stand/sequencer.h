@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+enum class SequenceAction : uint8_t {
+  kOpenValve,   // arg: Valve.
+  kCloseValve,  // arg: Valve.
+  kIgnitionOn,
+  kIgnitionOff,
+};
+
+// One timed step of the firing sequence.
+struct SequenceStep {
+  // Time after the start of the sequence. Steps must be in time order.
+  uint32_t t_ms;
+  SequenceAction action;
+  uint8_t arg;
+};
+
+// Releases the steps of a sequence as they come due.
+class Sequencer {
+ public:
+  // `steps` must outlive the sequencer.
+  Sequencer(const SequenceStep* steps, size_t count)
+      : steps_(steps), count_(count) {}
+
+  // Starts the sequence from its first step at `t_us`.
+  void start(uint64_t t_us);
+  // Abandons the rest of the sequence.
+  void stop() { running_ = false; }
+
+  // Returns the index of the next step due by `t_us`, or -1 if none is. Call
+  // until it returns -1 to release every overdue step in order.
+  int poll(uint64_t t_us);
+
+  bool running() const { return running_; }
+  size_t next_step() const { return next_; }
+
+ private:
+  const SequenceStep* steps_;
+  size_t count_;
+  bool running_ = false;
+  uint64_t start_us_ = 0;
+  size_t next_ = 0;
+};
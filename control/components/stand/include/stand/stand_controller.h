@@ -0,0 +1,65 @@
+#pragma once
+
+#include <telemetry/stand_state.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "stand/pt_filter.h"
+#include "stand/redline.h"
+#include "stand/sequencer.h"
+
+// Everything the stand decides on its own, independent of the hardware, so
+// the board and the ground replay (ground/src/replay.h) run the same code:
+// PT readings are filtered and checked against the redlines, and the firing
+// sequence is released step by step. The caller carries out the decisions.
+
+constexpr size_t STAND_MAX_PTS = 16;
+
+struct StandLogicConfig {
+  PtFilterConfig filter;
+  const Redline* redlines;
+  size_t redline_count;
+  const SequenceStep* sequence;
+  size_t sequence_count;
+};
+
+enum class DecisionType : uint8_t {
+  kAbort,         // index: Redline that tripped.
+  kSequenceStep,  // index: SequenceStep to carry out.
+};
+
+struct StandDecision {
+  uint64_t t_us;
+  DecisionType type;
+  uint8_t index;
+};
+
+class StandController {
+ public:
+  explicit StandController(const StandLogicConfig& config);
+
+  // Follows a state change made elsewhere (e.g. a ground command). Entering
+  // kFiring starts the sequence; leaving it abandons the rest.
+  void set_state(StandState state, uint64_t t_us);
+  StandState state() const { return state_; }
+
+  // Filters a reading of `pt` taken at `t_us` and checks the redlines.
+  // Returns true, with the decision, if one tripped; the controller is then
+  // in kAbort.
+  bool on_pt(uint8_t pt, uint64_t t_us, float psi, StandDecision* decision);
+
+  // Returns true, with the decision, for the next sequence step due by
+  // `t_us`. Call until it returns false.
+  bool poll_sequence(uint64_t t_us, StandDecision* decision);
+
+  // Latest filtered pressure of `pt`.
+  float filtered(uint8_t pt) const;
+
+ private:
+  StandLogicConfig config_;
+  StandState state_ = StandState::kSafe;
+  PtFilter filters_[STAND_MAX_PTS];
+  RedlineMonitor redlines_;
+  Sequencer sequencer_;
+};
@@ -0,0 +1,34 @@
+#include "stand/pt_filter.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+constexpr float PI = 3.14159265f;
+
+float median3(float a, float b, float c) {
+  return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+}  // namespace
+
+float PtFilter::update(uint64_t t_us, float psi) {
+  history_[count_ % 3] = psi;
+  float input = psi;
+  // Until three readings are in, the median would favor the initial zeros.
+  if (config_.median && count_ >= 2) {
+    input = median3(history_[0], history_[1], history_[2]);
+  }
+
+  if (count_ == 0 || config_.cutoff_hz <= 0) {
+    value_ = input;
+  } else {
+    float dt_s = (t_us - last_t_us_) * 1e-6f;
+    float rc_s = 1 / (2 * PI * config_.cutoff_hz);
+    value_ += (input - value_) * (dt_s / (rc_s + dt_s));
+  }
+  last_t_us_ = t_us;
+  count_++;
+  return value_;
+}
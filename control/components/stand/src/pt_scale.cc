@@ -0,0 +1,15 @@
+#include "stand/pt_scale.h"
+
+#include <algorithm>
+
+float voltage_to_psi(const PtScale& scale, float voltage) {
+  return scale.max_pressure *
+         (std::max(0.0f, voltage - scale.voltage_range.first) /
+          (scale.voltage_range.second - scale.voltage_range.first));
+}
+
+float psi_to_voltage(const PtScale& scale, float psi) {
+  return scale.voltage_range.first +
+         psi / scale.max_pressure *
+             (scale.voltage_range.second - scale.voltage_range.first);
+}
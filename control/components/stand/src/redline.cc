@@ -0,0 +1,38 @@
+#include "stand/redline.h"
+
+#include <telemetry/stand_state.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+RedlineMonitor::RedlineMonitor(const Redline* redlines, size_t count)
+    : redlines_(redlines), count_(std::min(count, kMaxRedlines)) {}
+
+int RedlineMonitor::update(uint8_t pt, uint64_t t_us, float psi,
+                           StandState state) {
+  for (size_t i = 0; i < count_; i++) {
+    const Redline& redline = redlines_[i];
+    if (redline.pt != pt) {
+      continue;
+    }
+    if (!(redline.states & stand_state_bit(state)) ||
+        (psi >= redline.min_psi && psi <= redline.max_psi)) {
+      exceeded_[i] = false;
+      continue;
+    }
+    if (!exceeded_[i]) {
+      exceeded_[i] = true;
+      exceeded_since_us_[i] = t_us;
+    }
+    if (t_us - exceeded_since_us_[i] >= redline.persist_us) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void RedlineMonitor::reset() {
+  std::fill(std::begin(exceeded_), std::end(exceeded_), false);
+}
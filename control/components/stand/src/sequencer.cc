@@ -0,0 +1,22 @@
+#include "stand/sequencer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+void Sequencer::start(uint64_t t_us) {
+  running_ = count_ > 0;
+  start_us_ = t_us;
+  next_ = 0;
+}
+
+int Sequencer::poll(uint64_t t_us) {
+  if (!running_ ||
+      t_us < start_us_ + uint64_t{steps_[next_].t_ms} * 1000) {
+    return -1;
+  }
+  int step = next_++;
+  if (next_ == count_) {
+    running_ = false;
+  }
+  return step;
+}
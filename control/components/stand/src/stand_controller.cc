@@ -0,0 +1,64 @@
+#include "stand/stand_controller.h"
+
+#include <telemetry/stand_state.h>
+
+#include <cstddef>
+#include <cstdint>
+
+StandController::StandController(const StandLogicConfig& config)
+    : config_(config),
+      redlines_(config.redlines, config.redline_count),
+      sequencer_(config.sequence, config.sequence_count) {
+  for (PtFilter& filter : filters_) {
+    filter = PtFilter(config.filter);
+  }
+}
+
+void StandController::set_state(StandState state, uint64_t t_us) {
+  if (state == state_) {
+    return;
+  }
+  if (state == StandState::kFiring) {
+    sequencer_.start(t_us);
+  } else {
+    sequencer_.stop();
+  }
+  redlines_.reset();
+  state_ = state;
+}
+
+bool StandController::on_pt(uint8_t pt, uint64_t t_us, float psi,
+                            StandDecision* decision) {
+  if (pt >= STAND_MAX_PTS) {
+    return false;
+  }
+  float filtered = filters_[pt].update(t_us, psi);
+  int redline = redlines_.update(pt, t_us, filtered, state_);
+  if (redline < 0) {
+    return false;
+  }
+  set_state(StandState::kAbort, t_us);
+  *decision = {
+      .t_us = t_us,
+      .type = DecisionType::kAbort,
+      .index = static_cast<uint8_t>(redline),
+  };
+  return true;
+}
+
+bool StandController::poll_sequence(uint64_t t_us, StandDecision* decision) {
+  int step = sequencer_.poll(t_us);
+  if (step < 0) {
+    return false;
+  }
+  *decision = {
+      .t_us = t_us,
+      .type = DecisionType::kSequenceStep,
+      .index = static_cast<uint8_t>(step),
+  };
+  return true;
+}
+
+float StandController::filtered(uint8_t pt) const {
+  return pt < STAND_MAX_PTS ? filters_[pt].value() : 0;
+}
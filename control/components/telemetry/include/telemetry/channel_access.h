@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+
+// Medium access for several nodes (stands, relays) sharing one LoRa channel.
+//
+// kAloha transmits blindly, as LoRaSend() does on its own. kListenBeforeTalk
+// runs a channel activity detection (CAD) before every transmission and backs
+// off for a random number of slots while the channel is busy, doubling the
+// backoff window each time (binary exponential backoff). kTdma gives each node
+// a fixed slot in a repeating frame, keyed by node id, and needs no CAD. The
+// slots only line up if every node counts them from the same epoch, so kTdma
+// runs listen-before-talk until set_shared_time() gives it one.
+
+enum class AccessMode : uint8_t {
+  kAloha,
+  kListenBeforeTalk,
+  kTdma,
+};
+
+struct ChannelAccessConfig {
+  AccessMode mode;
+
+  // kListenBeforeTalk. Backoff is a random number of slots in
+  // [0, 2^exponent), with exponent growing from min to max while busy.
+  uint32_t backoff_slot_us;
+  uint8_t min_backoff_exponent;
+  uint8_t max_backoff_exponent;
+  // CADs that find the channel busy before the frame is dropped.
+  uint8_t max_attempts;
+
+  // kTdma. Node `node_id` (0 based) owns [node_id * slot_us, (node_id + 1) *
+  // slot_us) of every node_count * slot_us cycle of shared time, and stops
+  // transmitting guard_us before the end of its slot.
+  uint8_t node_id;
+  uint8_t node_count;
+  uint32_t slot_us;
+  uint32_t guard_us;
+};
+
+enum class AccessDecision {
+  kTransmit,  // Send now.
+  kWait,      // Try again at next_attempt_us().
+  kDrop,      // Give up on this frame.
+};
+
+class ChannelAccess {
+ public:
+  ChannelAccess(const ChannelAccessConfig& config, uint32_t seed);
+
+  // Starts access for a new frame with the given time on air.
+  void begin(uint64_t now_us, uint32_t airtime_us);
+
+  // Sets the shared time base TDMA slots are counted in, as the offset from
+  // the caller's clock (the `now_us` passed in) to it. Until then, and after
+  // clear_shared_time(), kTdma falls back to listen-before-talk.
+  void set_shared_time(int64_t offset_us) {
+    shared_time_ = true;
+    shared_offset_us_ = offset_us;
+  }
+  void clear_shared_time() { shared_time_ = false; }
+
+  // The policy in effect: kTdma without a shared time base runs as
+  // kListenBeforeTalk.
+  AccessMode mode() const {
+    return config_.mode == AccessMode::kTdma && !shared_time_
+               ? AccessMode::kListenBeforeTalk
+               : config_.mode;
+  }
+
+  // Whether the caller must run a CAD before calling on_attempt().
+  bool needs_cad() const { return mode() == AccessMode::kListenBeforeTalk; }
+
+  // Earliest time for the next attempt.
+  uint64_t next_attempt_us() const { return next_attempt_us_; }
+
+  // Decides at an attempt. `channel_busy` is the CAD result, ignored unless
+  // needs_cad().
+  AccessDecision on_attempt(uint64_t now_us, bool channel_busy);
+
+  uint32_t busy_count() const { return busy_count_; }
+  uint32_t drop_count() const { return drop_count_; }
+
+ private:
+  uint32_t random();
+  uint64_t next_tdma_start(uint64_t now_us) const;
+
+  ChannelAccessConfig config_;
+  bool shared_time_ = false;
+  int64_t shared_offset_us_ = 0;
+  uint32_t rng_state_;
+  uint32_t airtime_us_ = 0;
+  uint64_t next_attempt_us_ = 0;
+  uint8_t attempts_ = 0;
+  uint32_t busy_count_ = 0;
+  uint32_t drop_count_ = 0;
+};
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+#include "telemetry/lora_airtime.h"
+
+// Reliable command uplink.
+//
+// The ground (CommandSender) sends each command in a kCommand frame with a
+// fresh uplink sequence number. The board (CommandReceiver) acknowledges
+// sequence numbers selectively through the AckField that starts every downlink
+// frame, so acknowledgements ride along with telemetry for free. Commands that
+// are not acknowledged within the retransmit timeout are resent, with the same
+// sequence number, up to `max_retries` times.
+//
+// Every command also carries an operator-chosen `id`. The board executes a
+// given id at most once, so a retransmit whose acknowledgement was lost is
+// acknowledged again but not re-executed.
+//
+// Each CommandSender also has a session byte, drawn at random when the ground
+// station starts. A restarted sender starts over with sequence number 1 and
+// may reuse ids; the board drops its acknowledgement state and remembered ids
+// when the session changes, so those commands run instead of being taken for
+// duplicates.
+//
+// The board may refuse a command it received (e.g. one that is unsafe in the
+// stand's state). The acknowledgement says so (AckField::refused), and the
+// ground reports the command as refused rather than executed.
+//
+// Each board has its own node id (see frame.h), and the ground runs one
+// CommandSender per board, so sequence spaces and windows are per node.
+
+enum class CommandType : uint8_t {
+  kOpenValve = 0x01,   // arg: Valve.
+  kCloseValve = 0x02,  // arg: Valve.
+  kArm = 0x03,
+  kDisarm = 0x04,
+  kAbort = 0x05,
+  kEraseLog = 0x06,  // Erase the flight-data log. Only when safe.
+  kMark = 0x07,      // arg: operator tag. Captures data around this moment.
+  // 0x08 is reserved for starting the firing sequence.
+  kTrace = 0x09,   // arg: TraceRequest, see trace_report.h.
+  kMemory = 0x0A,  // Logs heap and stack usage.
+};
+
+struct Command {
+  uint16_t id;
+  CommandType type;
+  uint8_t arg;
+};
+
+// Command frame payload: id (u16), type (u8), arg (u8), session (u8).
+constexpr size_t COMMAND_PAYLOAD_SIZE = 5;
+constexpr size_t COMMAND_FRAME_SIZE = COMMAND_PAYLOAD_SIZE + FRAME_OVERHEAD;
+
+// Maximum span of sequence numbers in flight, from the oldest unacknowledged
+// command to the next one sent. Must not exceed the reach of AckField (the
+// newest sequence number plus 32 older ones).
+constexpr size_t COMMAND_WINDOW = 16;
+
+struct CommandLinkConfig {
+  // How long to wait for an acknowledgement before retransmitting.
+  uint32_t retransmit_timeout_us;
+  // Retransmissions before a command is declared lost.
+  uint8_t max_retries;
+};
+
+// Smallest useful retransmit timeout for the given modulation: the command
+// frame and an acknowledgement frame back to back, plus `turnaround_us` for
+// the radios to switch between TX and RX and for the board to react.
+uint32_t command_round_trip_us(const LoRaModulation& modulation,
+                               uint32_t turnaround_us);
+
+struct CommandLinkStats {
+  uint32_t commands_sent;  // Unique commands queued.
+  uint32_t commands_acked;
+  uint32_t commands_refused;  // Acknowledged, but refused by the board.
+  uint32_t commands_lost;  // Dropped after exhausting retries.
+  uint32_t transmissions;  // Including retransmissions.
+  uint32_t retransmissions;
+  // End-to-end latency, first transmission to acknowledgement.
+  uint64_t latency_total_us;
+  uint32_t latency_min_us;
+  uint32_t latency_max_us;
+
+  float loss_rate() const;
+  uint32_t latency_mean_us() const;
+};
+
+enum class CommandStatus : uint8_t {
+  kExecuted,
+  kRefused,  // Received, but the board refused to execute it.
+  kLost,     // Never acknowledged, after max_retries.
+};
+
+// A command the ground is done with.
+struct CommandOutcome {
+  Command command;
+  CommandStatus status;
+  // First transmission to acknowledgement, or to giving up.
+  uint32_t latency_us;
+};
+
+// Ground side of the command link.
+class CommandSender {
+ public:
+  // Sends to, and accepts acknowledgements from, board `node`. `session`
+  // must differ from the previous sender's, e.g. be random.
+  CommandSender(const CommandLinkConfig& config, uint8_t node,
+                uint8_t session);
+
+  uint8_t node() const { return node_; }
+
+  // Queues a command for transmission. Returns false if the window is full,
+  // i.e. the oldest unacknowledged command is COMMAND_WINDOW sequence numbers
+  // behind.
+  bool send(const Command& command);
+
+  // Encodes the next frame that is due for (re)transmission into `out`.
+  // Returns its size, or 0 if nothing is due. Call whenever the radio is free
+  // to transmit.
+  size_t poll(uint64_t now_us, uint8_t* out, size_t out_cap);
+
+  // Feeds a decoded downlink frame. Frames from other nodes or without an
+  // AckField are ignored.
+  void on_downlink(const Frame& frame, uint64_t now_us);
+
+  void on_ack(const AckField& ack, uint64_t now_us);
+
+  // Number of commands waiting for an acknowledgement.
+  size_t in_flight() const;
+
+  // Takes the oldest outcome of a command not taken yet. Returns false if
+  // there is none. Only the last COMMAND_WINDOW outcomes are kept.
+  bool pop_outcome(CommandOutcome* outcome);
+
+  const CommandLinkStats& stats() const { return stats_; }
+
+ private:
+  struct Slot {
+    bool in_use;
+    Command command;
+    uint16_t seq;
+    uint8_t tx_count;
+    uint64_t first_tx_us;
+    uint64_t last_tx_us;
+  };
+
+  void finish(Slot* slot, CommandStatus status, uint64_t now_us);
+
+  CommandLinkConfig config_;
+  uint8_t node_;
+  uint8_t session_;
+  std::array<Slot, COMMAND_WINDOW> slots_{};
+  uint16_t next_seq_ = 1;
+  std::array<CommandOutcome, COMMAND_WINDOW> outcomes_{};
+  size_t outcome_count_ = 0;
+  size_t outcome_next_ = 0;
+  CommandLinkStats stats_{};
+};
+
+enum class CommandResult {
+  kExecute,    // New command; `command` is valid and must be executed.
+  kDuplicate,  // Already executed; acknowledged again.
+  kInvalid,    // Not a valid command frame.
+  kOtherNode,  // Valid, but addressed to another board.
+};
+
+struct CommandReceiverStats {
+  uint32_t frames;
+  uint32_t invalid;
+  uint32_t other_node;
+  uint32_t duplicates;
+  uint32_t executed;  // Returned as kExecute, including those refused.
+  uint32_t refused;
+  // Sender sessions seen, i.e. ground station (re)starts.
+  uint32_t sessions;
+};
+
+// Board side of the command link.
+class CommandReceiver {
+ public:
+  // Accepts commands addressed to board `node`.
+  explicit CommandReceiver(uint8_t node) : node_(node) {}
+
+  uint8_t node() const { return node_; }
+
+  // Decodes an uplink packet and updates the acknowledgement state.
+  CommandResult on_packet(const uint8_t* data, size_t len, Command* command);
+
+  // Marks the command on_packet() last returned kExecute for as refused, in
+  // the acknowledgement and for its duplicates. Call before reading ack().
+  void refuse();
+
+  // Acknowledgement to place in the next downlink frame.
+  const AckField& ack() const { return ack_; }
+
+  // True if a command arrived since the last call to ack_sent(). Send a
+  // downlink frame promptly to keep the round trip short.
+  bool ack_pending() const { return ack_pending_; }
+  void ack_sent() { ack_pending_ = false; }
+
+  const CommandReceiverStats& stats() const { return stats_; }
+
+ private:
+  // Number of recently executed command ids remembered for deduplication.
+  static constexpr size_t kRecentIds = 32;
+
+  void start_session(uint8_t session);
+  void record_seq(uint16_t seq);
+  void refuse_seq(uint16_t seq);
+  // Index of `id` in recent_ids_, or -1.
+  int find_id(uint16_t id) const;
+
+  uint8_t node_;
+  // The session of the last command, once one arrived.
+  bool session_known_ = false;
+  uint8_t session_ = 0;
+  AckField ack_{};
+  bool ack_pending_ = false;
+  std::array<uint16_t, kRecentIds> recent_ids_{};
+  // Whether the command with the same index in recent_ids_ was refused.
+  std::array<bool, kRecentIds> recent_refused_{};
+  size_t recent_count_ = 0;
+  size_t recent_next_ = 0;
+  // Sequence number of the last command returned as kExecute.
+  uint16_t executed_seq_ = 0;
+  CommandReceiverStats stats_{};
+};
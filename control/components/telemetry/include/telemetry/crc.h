@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). Pass a previous result as
+// `crc` to continue a running checksum.
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc = 0xFFFF);
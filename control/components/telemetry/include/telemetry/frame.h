@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Every frame exchanged with the ground looks like:
+//
+//   0      1      2      3      5        6                  6+LENGTH
+//   +------+------+------+------+--------+------------------+-------+
+//   | SYNC | TYPE | NODE | SEQ  | LENGTH | PAYLOAD          | CRC16 |
+//   +------+------+------+------+--------+------------------+-------+
+//
+// Multi-byte fields are little-endian. The CRC (see crc.h) covers SYNC through
+// the end of PAYLOAD. Several boards share one ground link; NODE is the board
+// a downlink frame comes from, or the board an uplink frame is addressed to.
+// SEQ is per direction and per node, so every board has its own sequence
+// spaces. Downlink kTelemetry and kSamples frames are numbered apart from the
+// other frames, so the ground can count the ones lost.
+
+constexpr uint8_t FRAME_SYNC = 0xA5;
+constexpr size_t FRAME_HEADER_SIZE = 6;
+constexpr size_t FRAME_CRC_SIZE = 2;
+constexpr size_t FRAME_OVERHEAD = FRAME_HEADER_SIZE + FRAME_CRC_SIZE;
+// Node ids 0 through FRAME_MAX_NODE are valid.
+constexpr uint8_t FRAME_MAX_NODE = 0xFE;
+// A LoRa packet carries at most 255 bytes.
+constexpr size_t FRAME_MAX_SIZE = 255;
+constexpr size_t FRAME_MAX_PAYLOAD = FRAME_MAX_SIZE - FRAME_OVERHEAD;
+
+enum class FrameType : uint8_t {
+  kCommand = 0x01,    // Ground -> board. Payload: see command_link.h.
+  kAck = 0x02,        // Board -> ground. Payload: AckField.
+  kTelemetry = 0x03,  // Board -> ground. Payload: AckField + samples.
+  // Board -> ground over the wired link. Payload: AckField + full-rate
+  // samples, see sample_stream.h. Numbered apart from the other downlink
+  // frames, since the link has its own sender.
+  kSamples = 0x04,
+  // Ground -> board over the wired link, to show a host is listening. No
+  // payload; NODE is ignored, since a cable reaches a single board.
+  kHeartbeat = 0x05,
+  // Clock synchronization over the wired link, see time_sync.h. Numbered like
+  // kHeartbeat: NODE is ignored.
+  kTimeRequest = 0x06,  // Board -> ground.
+  kTimeReply = 0x07,    // Ground -> board.
+  // Board -> ground. Payload: AckField + the trace table, see trace_report.h.
+  kTrace = 0x08,
+};
+
+enum class FrameError {
+  kOk,
+  kTooShort,
+  kBadSync,
+  kBadLength,
+  kBadCrc,
+};
+
+struct Frame {
+  FrameType type;
+  uint8_t node;
+  uint16_t seq;
+  // Points into the buffer that was decoded.
+  const uint8_t* payload;
+  uint8_t payload_len;
+};
+
+// Selective acknowledgement of uplink sequence numbers, carried at the start of
+// every downlink frame. `seq` is the newest sequence number received, and bit i
+// of `bitmap` is set when `seq - 1 - i` was received as well. Sequence number 0
+// is never sent, so `seq == 0` means nothing has been received yet.
+//
+// Bit i of `refused` is set when the command with sequence number `seq - i`
+// was received but the board refused to execute it (e.g. a valve command
+// while armed). Received commands without the bit were executed.
+struct AckField {
+  uint16_t seq;
+  uint32_t bitmap;
+  uint32_t refused;
+};
+
+// seq (u16), bitmap (u32), refused (u32).
+constexpr size_t ACK_FIELD_SIZE = 10;
+
+// Encodes a frame into `out`. Returns the number of bytes written, or 0 when
+// `payload_len` exceeds FRAME_MAX_PAYLOAD, `out_cap` is too small or `node`
+// exceeds FRAME_MAX_NODE.
+size_t encode_frame(FrameType type, uint8_t node, uint16_t seq,
+                    const uint8_t* payload, size_t payload_len, uint8_t* out,
+                    size_t out_cap);
+
+// Validates and decodes a frame. On success `frame->payload` points into
+// `data`.
+FrameError decode_frame(const uint8_t* data, size_t len, Frame* frame);
+
+// Downlink helpers. The acknowledgement is always the first ACK_FIELD_SIZE
+// bytes of the payload so that any downlink frame can acknowledge commands.
+size_t encode_ack_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                        uint8_t* out, size_t out_cap);
+size_t encode_telemetry_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                              const uint8_t* body, size_t body_len,
+                              uint8_t* out, size_t out_cap);
+
+// Writes `ack` to the first ACK_FIELD_SIZE bytes of a downlink payload.
+void put_ack(uint8_t* out, const AckField& ack);
+
+// Extracts the acknowledgement from a kAck, kTelemetry, kSamples or kTrace
+// frame.
+// Returns false for other frame types or truncated payloads.
+bool decode_ack(const Frame& frame, AckField* ack);
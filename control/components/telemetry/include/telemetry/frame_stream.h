@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+
+// Finds frames in a byte stream, e.g. a serial link, where they are sent back
+// to back with nothing to mark their boundaries but FRAME_SYNC. Bytes that
+// don't start a valid frame are skipped one at a time, so the parser
+// resynchronizes on its own after noise, dropped bytes or a mid-frame start.
+
+struct FrameStreamStats {
+  uint32_t frames;
+  // Candidate frames with a bad CRC or an impossible length.
+  uint32_t bad_crc;
+  uint32_t bad_length;
+  // Bytes skipped while looking for a frame, including the SYNC byte of
+  // every rejected candidate.
+  uint32_t skipped_bytes;
+};
+
+class FrameStreamParser {
+ public:
+  // Consumes `len` bytes, calling `on_frame(const Frame&)` for every frame
+  // completed by them. The frame's payload is only valid during the call.
+  template <typename Callback>
+  void push(const uint8_t* data, size_t len, Callback on_frame) {
+    while (len > 0) {
+      size_t n = fill(data, len);
+      data += n;
+      len -= n;
+      Frame frame;
+      while (next(&frame)) {
+        on_frame(frame);
+      }
+      compact();
+    }
+  }
+
+  // Drops a partially received frame, e.g. when the link is reopened.
+  void reset() { start_ = end_ = 0; }
+
+  const FrameStreamStats& stats() const { return stats_; }
+
+ private:
+  size_t fill(const uint8_t* data, size_t len);
+  bool next(Frame* frame);
+  void compact();
+
+  // Room for a whole frame wherever it starts in the first half.
+  uint8_t buffer_[2 * FRAME_MAX_SIZE];
+  size_t start_ = 0;
+  size_t end_ = 0;
+  FrameStreamStats stats_ = {};
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LoRa modulation and packet parameters that determine time on air. These
+// mirror the arguments of LoRaConfig() in the ra01s driver, but with the
+// bandwidth in Hz instead of an SX126X_LORA_BW_* register code.
+struct LoRaModulation {
+  uint8_t spreading_factor;  // 5-12.
+  uint32_t bandwidth_hz;
+  uint8_t coding_rate;  // 1-4, meaning 4/5 to 4/8.
+  uint16_t preamble_length;
+  bool explicit_header;
+  bool crc_on;
+  bool low_data_rate_optimize;
+};
+
+// Time on air of a packet with `payload_len` bytes, in microseconds. See
+// section 6.1.4 "LoRa Time-on-Air" of the SX1261/2 datasheet. Constexpr so
+// configs can size slots and timeouts from the modulation.
+constexpr uint32_t lora_time_on_air_us(const LoRaModulation& modulation,
+                                       size_t payload_len) {
+  const int sf = modulation.spreading_factor;
+  const int crc_bits = modulation.crc_on ? 16 : 0;
+  const int header_bits = modulation.explicit_header ? 20 : 0;
+
+  // Symbol counts are kept in quarter symbols, as the preamble ends in one.
+  // SF5 and SF6 use a longer sync sequence and no extra header symbols.
+  int64_t preamble_quarters = 4 * int64_t{modulation.preamble_length};
+  int64_t payload_bits = 8 * static_cast<int64_t>(payload_len) + crc_bits -
+                         4 * sf + header_bits;
+  if (sf < 7) {
+    preamble_quarters += 25;
+  } else {
+    preamble_quarters += 17;
+    payload_bits += 8;
+  }
+  const int bits_per_block =
+      4 * (modulation.low_data_rate_optimize && sf >= 7 ? sf - 2 : sf);
+  const int64_t blocks =
+      ((payload_bits > 0 ? payload_bits : 0) + bits_per_block - 1) /
+      bits_per_block;
+  const int64_t quarters =
+      preamble_quarters + 4 * (8 + blocks * (modulation.coding_rate + 4));
+
+  // One symbol lasts 2^sf / bandwidth seconds.
+  const uint64_t numerator = static_cast<uint64_t>(quarters) * (1u << sf) *
+                             1000000;
+  const uint64_t denominator = 4 * uint64_t{modulation.bandwidth_hz};
+  return static_cast<uint32_t>((numerator + denominator - 1) / denominator);
+}
+
+// Duration of one LoRa symbol, 2^sf / bandwidth, in microseconds, rounded
+// up. Channel activity detection lasts a whole number of them.
+constexpr uint32_t lora_symbol_time_us(const LoRaModulation& modulation) {
+  const uint64_t numerator = (uint64_t{1} << modulation.spreading_factor) *
+                             1000000;
+  return static_cast<uint32_t>((numerator + modulation.bandwidth_hz - 1) /
+                               modulation.bandwidth_hz);
+}
+
+// Converts an SX126X_LORA_BW_* register code to Hz. Returns 0 for unknown
+// codes.
+constexpr uint32_t lora_bandwidth_hz(uint8_t bandwidth_code) {
+  // Register codes are not monotonic in bandwidth; see SX126X_LORA_BW_* in
+  // ra01s.h.
+  switch (bandwidth_code) {
+    case 0x00:
+      return 7810;
+    case 0x08:
+      return 10420;
+    case 0x01:
+      return 15630;
+    case 0x09:
+      return 20830;
+    case 0x02:
+      return 31250;
+    case 0x0A:
+      return 41670;
+    case 0x03:
+      return 62500;
+    case 0x04:
+      return 125000;
+    case 0x05:
+      return 250000;
+    case 0x06:
+      return 500000;
+    default:
+      return 0;
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+
+// Full-rate samples, for links with the bandwidth to carry every sample
+// instead of the scheduler's summaries (e.g. the wired link). The body of a
+// kSamples frame, after the AckField:
+//
+//   T_US (u64) | CLOCK (u8) | COUNT (u8) |
+//       COUNT x (CHANNEL (u8) | DT_US (u16) | VALUE (f32))
+//
+// T_US is the time of the first sample, on the clock CLOCK names, and DT_US
+// the time of each sample after it. Channels are TelemetryChannel ids.
+
+struct RawSample {
+  uint64_t t_us;
+  uint8_t channel;
+  float value;
+};
+
+enum class SampleClock : uint8_t {
+  kBoard = 0,  // esp_timer_get_time() of the board.
+  kHost = 1,   // Host Unix time, once synchronized (see time_sync.h).
+};
+
+constexpr size_t SAMPLE_BODY_HEADER_SIZE = 10;
+constexpr size_t SAMPLE_SIZE = 7;
+constexpr size_t SAMPLES_PER_FRAME =
+    (FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE - SAMPLE_BODY_HEADER_SIZE) /
+    SAMPLE_SIZE;
+// Samples of one frame span at most this long.
+constexpr uint64_t SAMPLE_BODY_MAX_SPAN_US = UINT16_MAX;
+
+// Encodes as many of `samples` as fit in one body, from the first, and
+// writes their number to `consumed`. Stops early at a sample older than the
+// first or more than SAMPLE_BODY_MAX_SPAN_US after it. Returns the body size,
+// or 0 if `count` is 0 or `out_cap` is too small for one sample.
+size_t encode_sample_body(const RawSample* samples, size_t count,
+                          SampleClock clock, size_t* consumed, uint8_t* out,
+                          size_t out_cap);
+
+// Encodes a kSamples frame holding as many of `samples` as fit, like
+// encode_sample_body(). Returns the frame size, or 0 if `count` is 0 or
+// `out_cap` is too small.
+size_t encode_samples_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                            const RawSample* samples, size_t count,
+                            SampleClock clock, size_t* consumed, uint8_t* out,
+                            size_t out_cap);
+
+// Decodes a body built by encode_sample_body(). Writes up to `cap` samples to
+// `out`, their number to `count` and the clock of their timestamps to
+// `clock`. Returns false if the body is malformed.
+bool decode_sample_body(const uint8_t* body, size_t len, RawSample* out,
+                        size_t cap, size_t* count, SampleClock* clock);
+
+// Decodes the samples of a kSamples frame. Returns false for other frame
+// types or malformed payloads.
+bool decode_samples_frame(const Frame& frame, RawSample* out, size_t cap,
+                          size_t* count, SampleClock* clock);
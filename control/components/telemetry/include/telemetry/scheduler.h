@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/stand_state.h"
+
+// Telemetry downlink scheduler.
+//
+// Channels are sampled at acquisition rate but the radio can only carry a
+// fraction of that. Instead of dropping samples, every channel accumulates a
+// min/max/mean summary between downlinks. When a frame is built, channels are
+// emitted by priority and lateness until the packet is full. Channels that do
+// not fit keep accumulating for the next frame. Critical channels are emitted
+// in every frame in which they have new samples, whatever their rate.
+//
+// Frame body layout (little-endian), following the AckField:
+//
+//   T_MS (u32) | STATE (u8) | record...
+//
+// A summary of several samples is
+//   CHANNEL (u8) | DT_MS (u16) | COUNT (u16) | MIN (f32) | MAX (f32) | MEAN (f32)
+// and a single sample is sent compactly, with bit 7 of CHANNEL set, as
+//   CHANNEL | 0x80 (u8) | DT_MS (u16) | VALUE (f32)
+// DT_MS is how long before T_MS the newest sample was taken.
+
+enum class ChannelPriority : uint8_t {
+  kCritical,  // Always in the next frame, e.g. chamber pressure, abort status.
+  kHigh,
+  kNormal,
+  kLow,
+};
+
+struct ChannelSpec {
+  // On-wire channel id, below 0x80.
+  uint8_t id;
+  ChannelPriority priority;
+  // Downlink rate in each StandState, in Hz. 0 disables a non-critical channel
+  // in that state.
+  std::array<float, STAND_STATE_COUNT> rate_hz;
+};
+
+constexpr size_t TELEMETRY_MAX_CHANNELS = 32;
+constexpr size_t TELEMETRY_HEADER_SIZE = 5;
+constexpr size_t TELEMETRY_SUMMARY_SIZE = 17;
+constexpr size_t TELEMETRY_SAMPLE_SIZE = 7;
+constexpr uint8_t TELEMETRY_SINGLE_SAMPLE = 0x80;
+
+struct ChannelReport {
+  uint8_t id;
+  uint32_t samples;  // Samples recorded.
+  uint32_t records;  // Summaries (or single samples) downlinked.
+  float achieved_rate_hz;
+};
+
+class TelemetryScheduler {
+ public:
+  // `specs` must outlive the scheduler. At most TELEMETRY_MAX_CHANNELS.
+  TelemetryScheduler(const ChannelSpec* specs, size_t count);
+
+  void set_state(StandState state, uint64_t now_us);
+  StandState state() const { return state_; }
+
+  // Holds back channels of lower priority than `priority`, e.g. to free the
+  // link and CPU while the board is overloaded. Their samples keep
+  // accumulating until they are allowed again. kLow (the default) sends all.
+  void set_min_priority(ChannelPriority priority) { min_priority_ = priority; }
+
+  // Adds a sample to channel `index` (its position in `specs`).
+  void record(size_t index, float value, uint64_t now_us);
+
+  // Writes the next frame body into `out`. Returns the number of bytes
+  // written, or 0 if no channel is due.
+  size_t build(uint64_t now_us, uint8_t* out, size_t out_cap);
+
+  // Per-channel statistics since construction or reset_stats().
+  ChannelReport report(size_t index, uint64_t now_us) const;
+  // Fraction of the offered frame capacity that was filled.
+  float fill_ratio() const;
+  size_t channel_count() const { return count_; }
+  void reset_stats(uint64_t now_us);
+
+ private:
+  struct Channel {
+    uint16_t count;
+    float min;
+    float max;
+    float sum;
+    uint64_t last_us;
+    uint64_t next_due_us;
+    uint32_t samples;
+    uint32_t records;
+  };
+
+  bool is_due(size_t index, uint64_t now_us) const;
+  uint64_t period_us(size_t index) const;
+
+  const ChannelSpec* specs_;
+  size_t count_;
+  StandState state_ = StandState::kSafe;
+  ChannelPriority min_priority_ = ChannelPriority::kLow;
+  std::array<Channel, TELEMETRY_MAX_CHANNELS> channels_{};
+  uint64_t stats_since_us_ = 0;
+  uint64_t bytes_offered_ = 0;
+  uint64_t bytes_filled_ = 0;
+};
+
+struct TelemetryHeader {
+  uint32_t t_ms;
+  StandState state;
+};
+
+struct ChannelSummary {
+  uint8_t id;
+  uint16_t count;
+  // Board time of the newest sample, in ms.
+  uint32_t t_ms;
+  float min;
+  float max;
+  float mean;
+};
+
+// Decodes a frame body built by TelemetryScheduler::build(). Writes up to
+// `cap` summaries to `out` and their number to `count`. Returns false if the
+// body is malformed.
+bool decode_telemetry_body(const uint8_t* body, size_t len,
+                           TelemetryHeader* header, ChannelSummary* out,
+                           size_t cap, size_t* count);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed-capacity, lock-free ring for exactly one producer and one consumer
+// (e.g. an ISR-woken task and a worker task). Slots are preallocated and
+// filled in place, so large elements such as radio packets are never copied.
+//
+// Producer:  if (T* slot = ring.claim()) { fill(*slot); ring.publish(); }
+// Consumer:  while (T* slot = ring.front()) { use(*slot); ring.pop(); }
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+ public:
+  // Returns the slot to fill next, or nullptr (and counts a drop) if full.
+  T* claim() {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == N) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return nullptr;
+    }
+    return &slots_[head & (N - 1)];
+  }
+
+  // Makes the slot returned by claim() visible to the consumer.
+  void publish() {
+    size_t head = head_.load(std::memory_order_relaxed) + 1;
+    head_.store(head, std::memory_order_release);
+    size_t used = head - tail_.load(std::memory_order_relaxed);
+    if (used > high_water_.load(std::memory_order_relaxed)) {
+      high_water_.store(used, std::memory_order_relaxed);
+    }
+  }
+
+  bool push(const T& value) {
+    T* slot = claim();
+    if (slot == nullptr) {
+      return false;
+    }
+    *slot = value;
+    publish();
+    return true;
+  }
+
+  // Oldest published element, or nullptr if empty.
+  T* front() {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots_[tail & (N - 1)];
+  }
+
+  // Releases the slot returned by front() back to the producer.
+  void pop() {
+    tail_.store(tail_.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  bool pop(T* value) {
+    T* slot = front();
+    if (slot == nullptr) {
+      return false;
+    }
+    *value = *slot;
+    pop();
+    return true;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) -
+           tail_.load(std::memory_order_acquire);
+  }
+  static constexpr size_t capacity() { return N; }
+  uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  size_t high_water() const {
+    return high_water_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  T slots_[N];
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint32_t> dropped_{0};
+  std::atomic<size_t> high_water_{0};
+};
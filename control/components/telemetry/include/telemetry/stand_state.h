@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Operating state of the test stand. Reported in every telemetry frame and
+// used to pick per-channel downlink rates.
+enum class StandState : uint8_t {
+  kSafe,
+  kArmed,
+  kFiring,
+  kAbort,
+  kStandStateMax  // Not a valid state, used for bounds checking.
+};
+
+constexpr int STAND_STATE_COUNT = static_cast<int>(StandState::kStandStateMax);
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+
+// NTP-style clock synchronization between a board and the host on the other
+// end of its wired link. The board sends a kTimeRequest carrying its send
+// time T1; the host answers with a kTimeReply carrying T1 back with its own
+// receive and send times T2 and T3 (Unix time, in us); the board notes when
+// the reply arrived, T4. From one exchange:
+//
+//   offset = ((T2 - T1) + (T3 - T4)) / 2   host time minus board time
+//   delay  = (T4 - T1) - (T3 - T2)         time spent on the wire, both ways
+//
+// assuming both directions take as long. ClockSync keeps the last exchanges,
+// drops the ones delayed much more than the fastest (queued behind other
+// traffic, so asymmetric) and fits offset and drift to the rest.
+//
+// Payloads, little-endian:
+//
+//   kTimeRequest: T1 (u64)
+//   kTimeReply:   T1 (u64) | T2 (u64) | T3 (u64)
+
+constexpr size_t TIME_REQUEST_PAYLOAD_SIZE = 8;
+constexpr size_t TIME_REPLY_PAYLOAD_SIZE = 24;
+
+struct TimeReply {
+  // Board time the request was sent, echoed back.
+  uint64_t t1_us;
+  // Host time the request arrived and the reply left.
+  uint64_t t2_us;
+  uint64_t t3_us;
+};
+
+size_t encode_time_request(uint16_t seq, uint64_t t1_us, uint8_t* out,
+                           size_t out_cap);
+// Returns false for other frame types or malformed payloads.
+bool decode_time_request(const Frame& frame, uint64_t* t1_us);
+
+size_t encode_time_reply(uint16_t seq, const TimeReply& reply, uint8_t* out,
+                         size_t out_cap);
+// Returns false for other frame types or malformed payloads.
+bool decode_time_reply(const Frame& frame, TimeReply* reply);
+
+struct ClockSyncStats {
+  uint32_t exchanges;
+  // Exchanges left out of the fit for being delayed too much.
+  uint32_t rejected;
+  // Round trip of the accepted exchanges; half of it is the one-way latency
+  // of the link.
+  uint32_t delay_min_us;
+  uint32_t delay_max_us;
+  uint32_t delay_last_us;
+  uint64_t delay_total_us;
+  // Host time minus board time as of the newest accepted exchange, and how
+  // fast it changes.
+  int64_t offset_us;
+  float drift_ppm;
+
+  uint32_t delay_mean_us() const;
+};
+
+class ClockSync {
+ public:
+  // Exchanges the fit is made over.
+  static constexpr size_t kWindow = 32;
+  // Accepted exchanges needed before synced().
+  static constexpr uint32_t kMinExchanges = 4;
+
+  // Exchanges delayed more than `delay_slack_us` beyond the fastest in the
+  // window are left out of the fit.
+  explicit ClockSync(uint32_t delay_slack_us = 2000);
+
+  // Feeds a completed exchange, T4 being the board time the reply arrived.
+  // Returns false if it was left out.
+  bool on_exchange(const TimeReply& reply, uint64_t t4_us);
+
+  bool synced() const { return accepted_ >= kMinExchanges; }
+  // Host time minus board time at board time `local_us`.
+  int64_t offset_us(uint64_t local_us) const;
+  // Host time of board time `local_us`.
+  uint64_t to_host(uint64_t local_us) const {
+    return local_us + offset_us(local_us);
+  }
+
+  ClockSyncStats stats() const;
+
+ private:
+  struct Point {
+    // Board time halfway through the exchange.
+    uint64_t local_us;
+    int64_t offset_us;
+    uint32_t delay_us;
+  };
+
+  // Refits anchor_*_ and drift_ to the fast exchanges of the window.
+  void fit();
+
+  uint32_t delay_slack_us_;
+  Point window_[kWindow] = {};
+  size_t size_ = 0;
+  size_t next_ = 0;
+  uint32_t accepted_ = 0;
+  // offset(t) = anchor_offset_us_ + drift_ * (t - anchor_local_us_)
+  uint64_t anchor_local_us_ = 0;
+  int64_t anchor_offset_us_ = 0;
+  double drift_ = 0;
+  ClockSyncStats stats_ = {};
+};
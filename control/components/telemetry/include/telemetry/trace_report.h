@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+
+// The board's trace table (see control/src/trace.h): per code zone, how often
+// it ran and for how many CPU cycles. The body of a kTrace frame, after the
+// AckField:
+//
+//   CYCLES_PER_US (u16) | COUNT (u8) |
+//       COUNT x (ZONE (u8) | CALLS (u32) | TOTAL_CYCLES (u64) |
+//                MAX_CYCLES (u32))
+//
+// A table that doesn't fit one frame is split across several, each with its
+// own zones. Zone ids are TraceZone values.
+
+struct TraceZoneStats {
+  uint8_t zone;
+  uint32_t calls;
+  uint64_t total_cycles;
+  uint32_t max_cycles;
+};
+
+// What the kTrace command (see command_link.h) asks of the board.
+enum class TraceRequest : uint8_t {
+  kLog = 0,    // Print the table on the console.
+  kSend = 1,   // Downlink the table once.
+  kReset = 2,  // Clear the table.
+};
+
+constexpr size_t TRACE_BODY_HEADER_SIZE = 3;
+constexpr size_t TRACE_ZONE_SIZE = 17;
+constexpr size_t TRACE_ZONES_PER_FRAME =
+    (FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE - TRACE_BODY_HEADER_SIZE) /
+    TRACE_ZONE_SIZE;
+
+// Encodes a kTrace frame holding as many of `zones` as fit, from the first,
+// and writes their number to `consumed`. Returns the frame size, or 0 if
+// `count` is 0 or `out_cap` is too small for one zone.
+size_t encode_trace_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                          uint16_t cycles_per_us, const TraceZoneStats* zones,
+                          size_t count, size_t* consumed, uint8_t* out,
+                          size_t out_cap);
+
+// Decodes the zones of a kTrace frame. Writes up to `cap` zones to `out`,
+// their number to `count` and the board's cycles per microsecond to
+// `cycles_per_us`. Returns false for other frame types or malformed payloads.
+bool decode_trace_frame(const Frame& frame, uint16_t* cycles_per_us,
+                        TraceZoneStats* out, size_t cap, size_t* count);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Little-endian field accessors used by every on-wire format in this
+// component. They do not assume any alignment of `p`.
+
+inline void put_u16(uint8_t* p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+  put_u16(p, v & 0xFFFF);
+  put_u16(p + 2, v >> 16);
+}
+
+inline void put_u64(uint8_t* p, uint64_t v) {
+  put_u32(p, v & 0xFFFFFFFF);
+  put_u32(p + 4, v >> 32);
+}
+
+inline void put_f32(uint8_t* p, float v) {
+  uint32_t bits;
+  std::memcpy(&bits, &v, sizeof(bits));
+  put_u32(p, bits);
+}
+
+inline uint16_t get_u16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+inline uint32_t get_u32(const uint8_t* p) {
+  return get_u16(p) | (static_cast<uint32_t>(get_u16(p + 2)) << 16);
+}
+
+inline uint64_t get_u64(const uint8_t* p) {
+  return get_u32(p) | (static_cast<uint64_t>(get_u32(p + 4)) << 32);
+}
+
+inline float get_f32(const uint8_t* p) {
+  uint32_t bits = get_u32(p);
+  float v;
+  std::memcpy(&v, &bits, sizeof(v));
+  return v;
+}
@@ -0,0 +1,73 @@
+#include "telemetry/channel_access.h"
+
+#include <algorithm>
+#include <cstdint>
+
+ChannelAccess::ChannelAccess(const ChannelAccessConfig& config, uint32_t seed)
+    : config_(config), rng_state_(seed != 0 ? seed : 0x9E3779B9) {}
+
+uint32_t ChannelAccess::random() {
+  // xorshift32: cheap and good enough to decorrelate nodes.
+  rng_state_ ^= rng_state_ << 13;
+  rng_state_ ^= rng_state_ >> 17;
+  rng_state_ ^= rng_state_ << 5;
+  return rng_state_;
+}
+
+uint64_t ChannelAccess::next_tdma_start(uint64_t now_us) const {
+  const uint64_t cycle_us =
+      static_cast<uint64_t>(config_.slot_us) * config_.node_count;
+  const uint64_t offset_us =
+      static_cast<uint64_t>(config_.slot_us) * config_.node_id;
+  // Slots are counted in shared time, the result is in the caller's.
+  const uint64_t shared_us = now_us + shared_offset_us_;
+  const uint64_t cycle_start = shared_us - shared_us % cycle_us;
+  const uint64_t slot_start = cycle_start + offset_us;
+  // Still inside our slot with room for the frame: go now.
+  if (shared_us >= slot_start &&
+      shared_us + airtime_us_ + config_.guard_us <=
+          slot_start + config_.slot_us) {
+    return now_us;
+  }
+  const uint64_t start_us =
+      slot_start > shared_us ? slot_start : slot_start + cycle_us;
+  return start_us - shared_offset_us_;
+}
+
+void ChannelAccess::begin(uint64_t now_us, uint32_t airtime_us) {
+  airtime_us_ = airtime_us;
+  attempts_ = 0;
+  next_attempt_us_ =
+      mode() == AccessMode::kTdma ? next_tdma_start(now_us) : now_us;
+}
+
+AccessDecision ChannelAccess::on_attempt(uint64_t now_us, bool channel_busy) {
+  switch (mode()) {
+    case AccessMode::kAloha:
+      return AccessDecision::kTransmit;
+
+    case AccessMode::kTdma:
+      next_attempt_us_ = next_tdma_start(now_us);
+      return next_attempt_us_ == now_us ? AccessDecision::kTransmit
+                                        : AccessDecision::kWait;
+
+    case AccessMode::kListenBeforeTalk:
+      if (!channel_busy) {
+        return AccessDecision::kTransmit;
+      }
+      busy_count_++;
+      if (++attempts_ >= config_.max_attempts) {
+        drop_count_++;
+        return AccessDecision::kDrop;
+      }
+      uint8_t exponent =
+          std::min<int>(config_.min_backoff_exponent + attempts_ - 1,
+                        config_.max_backoff_exponent);
+      uint32_t slots = random() & ((1u << exponent) - 1);
+      // At least one slot, so a busy channel is never probed back to back.
+      next_attempt_us_ =
+          now_us + static_cast<uint64_t>(slots + 1) * config_.backoff_slot_us;
+      return AccessDecision::kWait;
+  }
+  return AccessDecision::kTransmit;
+}
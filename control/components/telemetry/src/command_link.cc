@@ -0,0 +1,294 @@
+#include "telemetry/command_link.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "telemetry/frame.h"
+#include "telemetry/lora_airtime.h"
+#include "telemetry/wire.h"
+
+namespace {
+
+// Whether `ack` covers uplink sequence number `seq`.
+bool is_acked(const AckField& ack, uint16_t seq) {
+  if (ack.seq == 0) {
+    return false;
+  }
+  uint16_t behind = ack.seq - seq;
+  if (behind == 0) {
+    return true;
+  }
+  return behind <= 32 && (ack.bitmap & (1u << (behind - 1)));
+}
+
+// Whether `ack` reports uplink sequence number `seq` as refused.
+bool is_refused(const AckField& ack, uint16_t seq) {
+  uint16_t behind = ack.seq - seq;
+  return behind < 32 && (ack.refused & (1u << behind));
+}
+
+}  // namespace
+
+uint32_t command_round_trip_us(const LoRaModulation& modulation,
+                               uint32_t turnaround_us) {
+  return lora_time_on_air_us(modulation, COMMAND_FRAME_SIZE) +
+         lora_time_on_air_us(modulation, ACK_FIELD_SIZE + FRAME_OVERHEAD) +
+         2 * turnaround_us;
+}
+
+float CommandLinkStats::loss_rate() const {
+  uint32_t finished = commands_acked + commands_lost;
+  return finished == 0 ? 0.0f : static_cast<float>(commands_lost) / finished;
+}
+
+uint32_t CommandLinkStats::latency_mean_us() const {
+  return commands_acked == 0 ? 0 : latency_total_us / commands_acked;
+}
+
+CommandSender::CommandSender(const CommandLinkConfig& config, uint8_t node,
+                             uint8_t session)
+    : config_(config), node_(node), session_(session) {
+  stats_.latency_min_us = std::numeric_limits<uint32_t>::max();
+}
+
+bool CommandSender::send(const Command& command) {
+  // Bound the span of sequence numbers in flight, not just their count, so
+  // the oldest one always stays within reach of AckField.
+  for (const Slot& slot : slots_) {
+    if (slot.in_use &&
+        static_cast<uint16_t>(next_seq_ - slot.seq) >= COMMAND_WINDOW) {
+      return false;
+    }
+  }
+
+  for (Slot& slot : slots_) {
+    if (slot.in_use) {
+      continue;
+    }
+    slot = Slot{
+        .in_use = true,
+        .command = command,
+        .seq = next_seq_,
+        .tx_count = 0,
+        .first_tx_us = 0,
+        .last_tx_us = 0,
+    };
+    // Sequence number 0 means "nothing received" in AckField.
+    next_seq_ = next_seq_ == UINT16_MAX ? 1 : next_seq_ + 1;
+    stats_.commands_sent++;
+    return true;
+  }
+  return false;
+}
+
+size_t CommandSender::poll(uint64_t now_us, uint8_t* out, size_t out_cap) {
+  // Prefer commands that were never sent, then the oldest overdue one.
+  Slot* next = nullptr;
+  for (Slot& slot : slots_) {
+    if (!slot.in_use) {
+      continue;
+    }
+    if (slot.tx_count == 0) {
+      if (next == nullptr || next->tx_count != 0 ||
+          static_cast<uint16_t>(slot.seq - next->seq) > UINT16_MAX / 2) {
+        next = &slot;
+      }
+      continue;
+    }
+    if (now_us - slot.last_tx_us < config_.retransmit_timeout_us) {
+      continue;
+    }
+    if (slot.tx_count > config_.max_retries) {
+      stats_.commands_lost++;
+      finish(&slot, CommandStatus::kLost, now_us);
+      continue;
+    }
+    if (next == nullptr ||
+        (next->tx_count != 0 && slot.last_tx_us < next->last_tx_us)) {
+      next = &slot;
+    }
+  }
+  if (next == nullptr) {
+    return 0;
+  }
+
+  uint8_t payload[COMMAND_PAYLOAD_SIZE];
+  put_u16(&payload[0], next->command.id);
+  payload[2] = static_cast<uint8_t>(next->command.type);
+  payload[3] = next->command.arg;
+  payload[4] = session_;
+  size_t size = encode_frame(FrameType::kCommand, node_, next->seq, payload,
+                             sizeof(payload), out, out_cap);
+  if (size == 0) {
+    return 0;
+  }
+
+  if (next->tx_count == 0) {
+    next->first_tx_us = now_us;
+  } else {
+    stats_.retransmissions++;
+  }
+  next->tx_count++;
+  next->last_tx_us = now_us;
+  stats_.transmissions++;
+  return size;
+}
+
+void CommandSender::on_downlink(const Frame& frame, uint64_t now_us) {
+  AckField ack;
+  if (frame.node == node_ && decode_ack(frame, &ack)) {
+    on_ack(ack, now_us);
+  }
+}
+
+void CommandSender::on_ack(const AckField& ack, uint64_t now_us) {
+  for (Slot& slot : slots_) {
+    if (!slot.in_use || slot.tx_count == 0 || !is_acked(ack, slot.seq)) {
+      continue;
+    }
+    uint32_t latency_us = now_us - slot.first_tx_us;
+    stats_.commands_acked++;
+    stats_.latency_total_us += latency_us;
+    stats_.latency_min_us = std::min(stats_.latency_min_us, latency_us);
+    stats_.latency_max_us = std::max(stats_.latency_max_us, latency_us);
+    if (is_refused(ack, slot.seq)) {
+      stats_.commands_refused++;
+      finish(&slot, CommandStatus::kRefused, now_us);
+    } else {
+      finish(&slot, CommandStatus::kExecuted, now_us);
+    }
+  }
+}
+
+size_t CommandSender::in_flight() const {
+  return std::count_if(slots_.begin(), slots_.end(),
+                       [](const Slot& slot) { return slot.in_use; });
+}
+
+bool CommandSender::pop_outcome(CommandOutcome* outcome) {
+  if (outcome_count_ == 0) {
+    return false;
+  }
+  *outcome = outcomes_[(outcome_next_ + COMMAND_WINDOW - outcome_count_) %
+                       COMMAND_WINDOW];
+  outcome_count_--;
+  return true;
+}
+
+void CommandSender::finish(Slot* slot, CommandStatus status, uint64_t now_us) {
+  slot->in_use = false;
+  outcomes_[outcome_next_] = CommandOutcome{
+      .command = slot->command,
+      .status = status,
+      .latency_us = static_cast<uint32_t>(now_us - slot->first_tx_us),
+  };
+  outcome_next_ = (outcome_next_ + 1) % COMMAND_WINDOW;
+  outcome_count_ = std::min(outcome_count_ + 1, COMMAND_WINDOW);
+}
+
+CommandResult CommandReceiver::on_packet(const uint8_t* data, size_t len,
+                                         Command* command) {
+  stats_.frames++;
+
+  Frame frame;
+  if (decode_frame(data, len, &frame) != FrameError::kOk ||
+      frame.type != FrameType::kCommand ||
+      frame.payload_len != COMMAND_PAYLOAD_SIZE || frame.seq == 0) {
+    stats_.invalid++;
+    return CommandResult::kInvalid;
+  }
+  if (frame.node != node_) {
+    stats_.other_node++;
+    return CommandResult::kOtherNode;
+  }
+
+  const uint8_t session = frame.payload[4];
+  if (!session_known_ || session != session_) {
+    start_session(session);
+  }
+  // Acknowledge duplicates too: the ground only resends when it missed our
+  // previous acknowledgement.
+  record_seq(frame.seq);
+  ack_pending_ = true;
+
+  Command decoded = {
+      .id = get_u16(&frame.payload[0]),
+      .type = static_cast<CommandType>(frame.payload[2]),
+      .arg = frame.payload[3],
+  };
+  int recent = find_id(decoded.id);
+  if (recent >= 0) {
+    stats_.duplicates++;
+    if (recent_refused_[recent]) {
+      refuse_seq(frame.seq);
+    }
+    return CommandResult::kDuplicate;
+  }
+
+  recent_ids_[recent_next_] = decoded.id;
+  recent_refused_[recent_next_] = false;
+  recent_next_ = (recent_next_ + 1) % kRecentIds;
+  recent_count_ = std::min(recent_count_ + 1, kRecentIds);
+  executed_seq_ = frame.seq;
+  stats_.executed++;
+  *command = decoded;
+  return CommandResult::kExecute;
+}
+
+void CommandReceiver::refuse() {
+  if (executed_seq_ == 0) {
+    return;
+  }
+  recent_refused_[(recent_next_ + kRecentIds - 1) % kRecentIds] = true;
+  refuse_seq(executed_seq_);
+  stats_.refused++;
+}
+
+void CommandReceiver::refuse_seq(uint16_t seq) {
+  uint16_t behind = ack_.seq - seq;
+  if (behind < 32) {
+    ack_.refused |= 1u << behind;
+  }
+}
+
+// A new sender numbers its commands from 1 again, and picks ids afresh.
+void CommandReceiver::start_session(uint8_t session) {
+  session_known_ = true;
+  session_ = session;
+  ack_ = {};
+  recent_count_ = 0;
+  recent_next_ = 0;
+  executed_seq_ = 0;
+  stats_.sessions++;
+}
+
+void CommandReceiver::record_seq(uint16_t seq) {
+  if (ack_.seq == 0) {
+    ack_.seq = seq;
+    return;
+  }
+
+  int16_t ahead = static_cast<int16_t>(seq - ack_.seq);
+  if (ahead > 0) {
+    // `seq` becomes the newest; everything slides `ahead` bits older.
+    ack_.refused = ahead >= 32 ? 0 : ack_.refused << ahead;
+    if (ahead > 32) {
+      ack_.bitmap = 0;
+    } else {
+      uint64_t bitmap = (static_cast<uint64_t>(ack_.bitmap) << 1 | 1)
+                        << (ahead - 1);
+      ack_.bitmap = static_cast<uint32_t>(bitmap);
+    }
+    ack_.seq = seq;
+  } else if (ahead < 0 && ahead >= -32) {
+    ack_.bitmap |= 1u << (-ahead - 1);
+  }
+}
+
+int CommandReceiver::find_id(uint16_t id) const {
+  auto end = recent_ids_.begin() + recent_count_;
+  auto found = std::find(recent_ids_.begin(), end, id);
+  return found == end ? -1 : static_cast<int>(found - recent_ids_.begin());
+}
@@ -0,0 +1,28 @@
+#include "telemetry/crc.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace {
+
+constexpr std::array<uint16_t, 256> CRC16_TABLE = [] {
+  std::array<uint16_t, 256> table{};
+  for (int i = 0; i < 256; i++) {
+    uint16_t crc = i << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    table[i] = crc;
+  }
+  return table;
+}();
+
+}  // namespace
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t len, uint16_t crc) {
+  for (size_t i = 0; i < len; i++) {
+    crc = (crc << 8) ^ CRC16_TABLE[((crc >> 8) ^ data[i]) & 0xFF];
+  }
+  return crc;
+}
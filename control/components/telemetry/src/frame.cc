@@ -0,0 +1,97 @@
+#include "telemetry/frame.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "telemetry/crc.h"
+#include "telemetry/wire.h"
+
+size_t encode_frame(FrameType type, uint8_t node, uint16_t seq,
+                    const uint8_t* payload, size_t payload_len, uint8_t* out,
+                    size_t out_cap) {
+  size_t size = payload_len + FRAME_OVERHEAD;
+  if (payload_len > FRAME_MAX_PAYLOAD || size > out_cap ||
+      node > FRAME_MAX_NODE) {
+    return 0;
+  }
+
+  out[0] = FRAME_SYNC;
+  out[1] = static_cast<uint8_t>(type);
+  out[2] = node;
+  put_u16(&out[3], seq);
+  out[5] = payload_len;
+  if (payload_len > 0) {
+    std::memmove(&out[FRAME_HEADER_SIZE], payload, payload_len);
+  }
+  put_u16(&out[FRAME_HEADER_SIZE + payload_len],
+          crc16_ccitt(out, FRAME_HEADER_SIZE + payload_len));
+  return size;
+}
+
+FrameError decode_frame(const uint8_t* data, size_t len, Frame* frame) {
+  if (len < FRAME_OVERHEAD) {
+    return FrameError::kTooShort;
+  }
+  if (data[0] != FRAME_SYNC) {
+    return FrameError::kBadSync;
+  }
+  uint8_t payload_len = data[5];
+  if (payload_len + FRAME_OVERHEAD != len) {
+    return FrameError::kBadLength;
+  }
+  if (crc16_ccitt(data, FRAME_HEADER_SIZE + payload_len) !=
+      get_u16(&data[FRAME_HEADER_SIZE + payload_len])) {
+    return FrameError::kBadCrc;
+  }
+
+  frame->type = static_cast<FrameType>(data[1]);
+  frame->node = data[2];
+  frame->seq = get_u16(&data[3]);
+  frame->payload = &data[FRAME_HEADER_SIZE];
+  frame->payload_len = payload_len;
+  return FrameError::kOk;
+}
+
+size_t encode_ack_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                        uint8_t* out, size_t out_cap) {
+  return encode_telemetry_frame(node, seq, ack, nullptr, 0, out, out_cap);
+}
+
+size_t encode_telemetry_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                              const uint8_t* body, size_t body_len,
+                              uint8_t* out, size_t out_cap) {
+  if (body_len > FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE ||
+      body_len + ACK_FIELD_SIZE + FRAME_OVERHEAD > out_cap) {
+    return 0;
+  }
+
+  // Build the payload in place so the body is copied only once.
+  uint8_t* payload = &out[FRAME_HEADER_SIZE];
+  if (body_len > 0) {
+    std::memmove(&payload[ACK_FIELD_SIZE], body, body_len);
+  }
+  put_ack(payload, ack);
+  FrameType type = body_len > 0 ? FrameType::kTelemetry : FrameType::kAck;
+  return encode_frame(type, node, seq, payload, body_len + ACK_FIELD_SIZE,
+                      out, out_cap);
+}
+
+void put_ack(uint8_t* out, const AckField& ack) {
+  put_u16(&out[0], ack.seq);
+  put_u32(&out[2], ack.bitmap);
+  put_u32(&out[6], ack.refused);
+}
+
+bool decode_ack(const Frame& frame, AckField* ack) {
+  if ((frame.type != FrameType::kAck && frame.type != FrameType::kTelemetry &&
+       frame.type != FrameType::kSamples &&
+       frame.type != FrameType::kTrace) ||
+      frame.payload_len < ACK_FIELD_SIZE) {
+    return false;
+  }
+  ack->seq = get_u16(&frame.payload[0]);
+  ack->bitmap = get_u32(&frame.payload[2]);
+  ack->refused = get_u32(&frame.payload[6]);
+  return true;
+}
@@ -0,0 +1,57 @@
+#include "telemetry/frame_stream.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "telemetry/frame.h"
+
+size_t FrameStreamParser::fill(const uint8_t* data, size_t len) {
+  size_t n = std::min(len, sizeof(buffer_) - end_);
+  std::memcpy(&buffer_[end_], data, n);
+  end_ += n;
+  return n;
+}
+
+bool FrameStreamParser::next(Frame* frame) {
+  while (true) {
+    const uint8_t* sync = static_cast<const uint8_t*>(
+        std::memchr(&buffer_[start_], FRAME_SYNC, end_ - start_));
+    size_t at = sync == nullptr ? end_ : sync - buffer_;
+    stats_.skipped_bytes += at - start_;
+    start_ = at;
+    if (end_ - start_ < FRAME_HEADER_SIZE) {
+      return false;
+    }
+
+    uint8_t payload_len = buffer_[start_ + 5];
+    if (payload_len > FRAME_MAX_PAYLOAD) {
+      stats_.bad_length++;
+      stats_.skipped_bytes++;
+      start_++;
+      continue;
+    }
+    size_t size = payload_len + FRAME_OVERHEAD;
+    if (end_ - start_ < size) {
+      return false;
+    }
+    if (decode_frame(&buffer_[start_], size, frame) != FrameError::kOk) {
+      stats_.bad_crc++;
+      stats_.skipped_bytes++;
+      start_++;
+      continue;
+    }
+    stats_.frames++;
+    start_ += size;
+    return true;
+  }
+}
+
+void FrameStreamParser::compact() {
+  // At most one partial frame is left; move it to the front so the next
+  // fill() has room for the rest.
+  std::memmove(buffer_, &buffer_[start_], end_ - start_);
+  end_ -= start_;
+  start_ = 0;
+}
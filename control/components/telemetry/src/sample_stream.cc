@@ -0,0 +1,90 @@
+#include "telemetry/sample_stream.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+#include "telemetry/wire.h"
+
+size_t encode_sample_body(const RawSample* samples, size_t count,
+                          SampleClock clock, size_t* consumed, uint8_t* out,
+                          size_t out_cap) {
+  *consumed = 0;
+  if (count == 0 || out_cap < SAMPLE_BODY_HEADER_SIZE + SAMPLE_SIZE) {
+    return 0;
+  }
+  const uint64_t t0_us = samples[0].t_us;
+  size_t n = 0;
+  size_t pos = SAMPLE_BODY_HEADER_SIZE;
+  while (n < count && n < UINT8_MAX && pos + SAMPLE_SIZE <= out_cap) {
+    const RawSample& sample = samples[n];
+    if (sample.t_us < t0_us || sample.t_us - t0_us > SAMPLE_BODY_MAX_SPAN_US) {
+      break;
+    }
+    out[pos] = sample.channel;
+    put_u16(&out[pos + 1], sample.t_us - t0_us);
+    put_f32(&out[pos + 3], sample.value);
+    pos += SAMPLE_SIZE;
+    n++;
+  }
+  put_u64(&out[0], t0_us);
+  out[8] = static_cast<uint8_t>(clock);
+  out[9] = n;
+  *consumed = n;
+  return pos;
+}
+
+bool decode_sample_body(const uint8_t* body, size_t len, RawSample* out,
+                        size_t cap, size_t* count, SampleClock* clock) {
+  if (len < SAMPLE_BODY_HEADER_SIZE ||
+      len != SAMPLE_BODY_HEADER_SIZE + body[9] * SAMPLE_SIZE ||
+      body[8] > static_cast<uint8_t>(SampleClock::kHost)) {
+    return false;
+  }
+  const uint64_t t0_us = get_u64(&body[0]);
+  *clock = static_cast<SampleClock>(body[8]);
+  *count = 0;
+  for (size_t i = 0; i < body[9] && *count < cap; i++) {
+    const uint8_t* p = &body[SAMPLE_BODY_HEADER_SIZE + i * SAMPLE_SIZE];
+    out[(*count)++] = {
+        .t_us = t0_us + get_u16(&p[1]),
+        .channel = p[0],
+        .value = get_f32(&p[3]),
+    };
+  }
+  return true;
+}
+
+size_t encode_samples_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                            const RawSample* samples, size_t count,
+                            SampleClock clock, size_t* consumed, uint8_t* out,
+                            size_t out_cap) {
+  *consumed = 0;
+  if (out_cap < FRAME_OVERHEAD + ACK_FIELD_SIZE) {
+    return 0;
+  }
+  // Build the payload in place, like encode_telemetry_frame().
+  uint8_t* payload = &out[FRAME_HEADER_SIZE];
+  size_t body_cap = std::min(out_cap - FRAME_OVERHEAD, FRAME_MAX_PAYLOAD) -
+                    ACK_FIELD_SIZE;
+  size_t body_len = encode_sample_body(samples, count, clock, consumed,
+                                       &payload[ACK_FIELD_SIZE], body_cap);
+  if (body_len == 0) {
+    return 0;
+  }
+  put_ack(payload, ack);
+  return encode_frame(FrameType::kSamples, node, seq, payload,
+                      body_len + ACK_FIELD_SIZE, out, out_cap);
+}
+
+bool decode_samples_frame(const Frame& frame, RawSample* out, size_t cap,
+                          size_t* count, SampleClock* clock) {
+  if (frame.type != FrameType::kSamples ||
+      frame.payload_len < ACK_FIELD_SIZE) {
+    return false;
+  }
+  return decode_sample_body(&frame.payload[ACK_FIELD_SIZE],
+                            frame.payload_len - ACK_FIELD_SIZE, out, cap,
+                            count, clock);
+}
@@ -0,0 +1,203 @@
+#include "telemetry/scheduler.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "telemetry/stand_state.h"
+#include "telemetry/wire.h"
+
+TelemetryScheduler::TelemetryScheduler(const ChannelSpec* specs, size_t count)
+    : specs_(specs), count_(std::min(count, TELEMETRY_MAX_CHANNELS)) {
+  assert(count <= TELEMETRY_MAX_CHANNELS && "Too many telemetry channels");
+}
+
+void TelemetryScheduler::set_state(StandState state, uint64_t now_us) {
+  if (state == state_) {
+    return;
+  }
+  state_ = state;
+  // Apply the new rates right away rather than after the old period.
+  for (size_t i = 0; i < count_; i++) {
+    channels_[i].next_due_us = now_us;
+  }
+}
+
+void TelemetryScheduler::record(size_t index, float value, uint64_t now_us) {
+  Channel& channel = channels_[index];
+  if (channel.count == 0) {
+    channel.min = value;
+    channel.max = value;
+    channel.sum = 0;
+  } else {
+    channel.min = std::min(channel.min, value);
+    channel.max = std::max(channel.max, value);
+  }
+  channel.sum += value;
+  if (channel.count < UINT16_MAX) {
+    channel.count++;
+  }
+  channel.last_us = now_us;
+  channel.samples++;
+}
+
+uint64_t TelemetryScheduler::period_us(size_t index) const {
+  float rate_hz = specs_[index].rate_hz[static_cast<int>(state_)];
+  return rate_hz > 0 ? static_cast<uint64_t>(1e6f / rate_hz)
+                     : std::numeric_limits<uint64_t>::max();
+}
+
+bool TelemetryScheduler::is_due(size_t index, uint64_t now_us) const {
+  const Channel& channel = channels_[index];
+  if (channel.count == 0) {
+    return false;
+  }
+  if (specs_[index].priority == ChannelPriority::kCritical) {
+    return true;
+  }
+  if (specs_[index].priority > min_priority_) {
+    return false;
+  }
+  return specs_[index].rate_hz[static_cast<int>(state_)] > 0 &&
+         now_us >= channel.next_due_us;
+}
+
+size_t TelemetryScheduler::build(uint64_t now_us, uint8_t* out,
+                                 size_t out_cap) {
+  if (out_cap < TELEMETRY_HEADER_SIZE) {
+    return 0;
+  }
+
+  // Due channels, most important and then most overdue first.
+  std::array<uint8_t, TELEMETRY_MAX_CHANNELS> order;
+  size_t due = 0;
+  for (size_t i = 0; i < count_; i++) {
+    if (is_due(i, now_us)) {
+      order[due++] = i;
+    }
+  }
+  if (due == 0) {
+    return 0;
+  }
+  std::sort(order.begin(), order.begin() + due, [&](uint8_t a, uint8_t b) {
+    if (specs_[a].priority != specs_[b].priority) {
+      return specs_[a].priority < specs_[b].priority;
+    }
+    return channels_[a].next_due_us < channels_[b].next_due_us;
+  });
+
+  const uint32_t t_ms = now_us / 1000;
+  put_u32(&out[0], t_ms);
+  out[4] = static_cast<uint8_t>(state_);
+  size_t len = TELEMETRY_HEADER_SIZE;
+
+  for (size_t n = 0; n < due; n++) {
+    size_t i = order[n];
+    Channel& channel = channels_[i];
+    size_t size =
+        channel.count == 1 ? TELEMETRY_SAMPLE_SIZE : TELEMETRY_SUMMARY_SIZE;
+    if (len + size > out_cap) {
+      // A smaller single sample may still fit.
+      continue;
+    }
+
+    uint8_t* p = &out[len];
+    uint64_t age_ms = (now_us - std::min(now_us, channel.last_us)) / 1000;
+    put_u16(&p[1], std::min<uint64_t>(age_ms, UINT16_MAX));
+    if (channel.count == 1) {
+      p[0] = specs_[i].id | TELEMETRY_SINGLE_SAMPLE;
+      put_f32(&p[3], channel.sum);
+    } else {
+      p[0] = specs_[i].id;
+      put_u16(&p[3], channel.count);
+      put_f32(&p[5], channel.min);
+      put_f32(&p[9], channel.max);
+      put_f32(&p[13], channel.sum / channel.count);
+    }
+    len += size;
+
+    channel.count = 0;
+    channel.records++;
+    // Keep the long-run rate, but don't burst to catch up after a backlog.
+    uint64_t period = period_us(i);
+    if (period == std::numeric_limits<uint64_t>::max()) {
+      channel.next_due_us = period;
+    } else {
+      channel.next_due_us =
+          std::max(channel.next_due_us + period, now_us + period / 2);
+    }
+  }
+
+  bytes_offered_ += out_cap;
+  bytes_filled_ += len;
+  return len;
+}
+
+ChannelReport TelemetryScheduler::report(size_t index, uint64_t now_us) const {
+  const Channel& channel = channels_[index];
+  float elapsed_s = (now_us - stats_since_us_) / 1e6f;
+  return {
+      .id = specs_[index].id,
+      .samples = channel.samples,
+      .records = channel.records,
+      .achieved_rate_hz = elapsed_s > 0 ? channel.records / elapsed_s : 0,
+  };
+}
+
+float TelemetryScheduler::fill_ratio() const {
+  return bytes_offered_ == 0
+             ? 0
+             : static_cast<float>(bytes_filled_) / bytes_offered_;
+}
+
+void TelemetryScheduler::reset_stats(uint64_t now_us) {
+  for (Channel& channel : channels_) {
+    channel.samples = 0;
+    channel.records = 0;
+  }
+  stats_since_us_ = now_us;
+  bytes_offered_ = 0;
+  bytes_filled_ = 0;
+}
+
+bool decode_telemetry_body(const uint8_t* body, size_t len,
+                           TelemetryHeader* header, ChannelSummary* out,
+                           size_t cap, size_t* count) {
+  if (len < TELEMETRY_HEADER_SIZE) {
+    return false;
+  }
+  header->t_ms = get_u32(&body[0]);
+  header->state = static_cast<StandState>(body[4]);
+
+  *count = 0;
+  size_t pos = TELEMETRY_HEADER_SIZE;
+  while (pos < len) {
+    const uint8_t* p = &body[pos];
+    bool single = p[0] & TELEMETRY_SINGLE_SAMPLE;
+    size_t size = single ? TELEMETRY_SAMPLE_SIZE : TELEMETRY_SUMMARY_SIZE;
+    if (pos + size > len) {
+      return false;
+    }
+    pos += size;
+    if (*count == cap) {
+      continue;
+    }
+
+    ChannelSummary& summary = out[(*count)++];
+    summary.id = p[0] & ~TELEMETRY_SINGLE_SAMPLE;
+    summary.t_ms = header->t_ms - get_u16(&p[1]);
+    if (single) {
+      summary.count = 1;
+      summary.min = summary.max = summary.mean = get_f32(&p[3]);
+    } else {
+      summary.count = get_u16(&p[3]);
+      summary.min = get_f32(&p[5]);
+      summary.max = get_f32(&p[9]);
+      summary.mean = get_f32(&p[13]);
+    }
+  }
+  return true;
+}
@@ -0,0 +1,164 @@
+#include "telemetry/time_sync.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "telemetry/frame.h"
+#include "telemetry/wire.h"
+
+size_t encode_time_request(uint16_t seq, uint64_t t1_us, uint8_t* out,
+                           size_t out_cap) {
+  uint8_t payload[TIME_REQUEST_PAYLOAD_SIZE];
+  put_u64(&payload[0], t1_us);
+  return encode_frame(FrameType::kTimeRequest, 0, seq, payload,
+                      sizeof(payload), out, out_cap);
+}
+
+bool decode_time_request(const Frame& frame, uint64_t* t1_us) {
+  if (frame.type != FrameType::kTimeRequest ||
+      frame.payload_len != TIME_REQUEST_PAYLOAD_SIZE) {
+    return false;
+  }
+  *t1_us = get_u64(&frame.payload[0]);
+  return true;
+}
+
+size_t encode_time_reply(uint16_t seq, const TimeReply& reply, uint8_t* out,
+                         size_t out_cap) {
+  uint8_t payload[TIME_REPLY_PAYLOAD_SIZE];
+  put_u64(&payload[0], reply.t1_us);
+  put_u64(&payload[8], reply.t2_us);
+  put_u64(&payload[16], reply.t3_us);
+  return encode_frame(FrameType::kTimeReply, 0, seq, payload, sizeof(payload),
+                      out, out_cap);
+}
+
+bool decode_time_reply(const Frame& frame, TimeReply* reply) {
+  if (frame.type != FrameType::kTimeReply ||
+      frame.payload_len != TIME_REPLY_PAYLOAD_SIZE) {
+    return false;
+  }
+  *reply = {
+      .t1_us = get_u64(&frame.payload[0]),
+      .t2_us = get_u64(&frame.payload[8]),
+      .t3_us = get_u64(&frame.payload[16]),
+  };
+  return true;
+}
+
+uint32_t ClockSyncStats::delay_mean_us() const {
+  uint32_t accepted = exchanges - rejected;
+  return accepted == 0 ? 0 : delay_total_us / accepted;
+}
+
+ClockSync::ClockSync(uint32_t delay_slack_us)
+    : delay_slack_us_(delay_slack_us) {
+  stats_.delay_min_us = std::numeric_limits<uint32_t>::max();
+}
+
+bool ClockSync::on_exchange(const TimeReply& reply, uint64_t t4_us) {
+  stats_.exchanges++;
+  uint64_t round_trip_us = t4_us - reply.t1_us;
+  uint64_t host_us = reply.t3_us - reply.t2_us;
+  // A reply to an older request than the last one sent still works, but not
+  // one whose times make no sense.
+  if (t4_us < reply.t1_us || reply.t3_us < reply.t2_us ||
+      host_us > round_trip_us ||
+      round_trip_us - host_us > std::numeric_limits<uint32_t>::max()) {
+    stats_.rejected++;
+    return false;
+  }
+  const uint32_t delay_us = round_trip_us - host_us;
+  // Both halves fit in an int64_t for any host time before 2262.
+  const int64_t offset_us =
+      ((static_cast<int64_t>(reply.t2_us) - static_cast<int64_t>(reply.t1_us)) +
+       (static_cast<int64_t>(reply.t3_us) - static_cast<int64_t>(t4_us))) /
+      2;
+
+  window_[next_] = {
+      .local_us = reply.t1_us + round_trip_us / 2,
+      .offset_us = offset_us,
+      .delay_us = delay_us,
+  };
+  next_ = (next_ + 1) % kWindow;
+  size_ = std::min(size_ + 1, kWindow);
+
+  uint32_t fastest_us = delay_us;
+  for (size_t i = 0; i < size_; i++) {
+    fastest_us = std::min(fastest_us, window_[i].delay_us);
+  }
+  if (delay_us > fastest_us + delay_slack_us_) {
+    stats_.rejected++;
+    return false;
+  }
+
+  accepted_++;
+  stats_.delay_min_us = std::min(stats_.delay_min_us, delay_us);
+  stats_.delay_max_us = std::max(stats_.delay_max_us, delay_us);
+  stats_.delay_last_us = delay_us;
+  stats_.delay_total_us += delay_us;
+  fit();
+  const Point& newest = window_[(next_ + kWindow - 1) % kWindow];
+  stats_.offset_us = this->offset_us(newest.local_us);
+  stats_.drift_ppm = drift_ * 1e6;
+  return true;
+}
+
+void ClockSync::fit() {
+  uint32_t fastest_us = std::numeric_limits<uint32_t>::max();
+  for (size_t i = 0; i < size_; i++) {
+    fastest_us = std::min(fastest_us, window_[i].delay_us);
+  }
+
+  // Least squares around the first point kept, in doubles: offsets are
+  // around 1e15 us but differ by far less between exchanges.
+  const Point* origin = nullptr;
+  size_t n = 0;
+  double sum_x = 0;
+  double sum_y = 0;
+  double sum_xx = 0;
+  double sum_xy = 0;
+  uint64_t first_us = UINT64_MAX;
+  uint64_t last_us = 0;
+  for (size_t i = 0; i < size_; i++) {
+    const Point& point = window_[i];
+    if (point.delay_us > fastest_us + delay_slack_us_) {
+      continue;
+    }
+    if (origin == nullptr) {
+      origin = &point;
+    }
+    double x = static_cast<double>(static_cast<int64_t>(point.local_us -
+                                                        origin->local_us));
+    double y = static_cast<double>(point.offset_us - origin->offset_us);
+    n++;
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+    first_us = std::min(first_us, point.local_us);
+    last_us = std::max(last_us, point.local_us);
+  }
+
+  double mean_x = sum_x / n;
+  double mean_y = sum_y / n;
+  double var_x = sum_xx / n - mean_x * mean_x;
+  // Exchanges less than a second apart say little about the drift; keep the
+  // previous estimate.
+  if (n >= 2 && last_us - first_us >= 1000000 && var_x > 0) {
+    drift_ = (sum_xy / n - mean_x * mean_y) / var_x;
+  }
+  anchor_local_us_ = origin->local_us + std::llround(mean_x);
+  anchor_offset_us_ = origin->offset_us + std::llround(mean_y);
+}
+
+int64_t ClockSync::offset_us(uint64_t local_us) const {
+  double elapsed_us =
+      static_cast<double>(static_cast<int64_t>(local_us - anchor_local_us_));
+  return anchor_offset_us_ + std::llround(drift_ * elapsed_us);
+}
+
+ClockSyncStats ClockSync::stats() const { return stats_; }
@@ -0,0 +1,67 @@
+#include "telemetry/trace_report.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+#include "telemetry/wire.h"
+
+size_t encode_trace_frame(uint8_t node, uint16_t seq, const AckField& ack,
+                          uint16_t cycles_per_us, const TraceZoneStats* zones,
+                          size_t count, size_t* consumed, uint8_t* out,
+                          size_t out_cap) {
+  *consumed = 0;
+  if (count == 0 || out_cap < FRAME_OVERHEAD + ACK_FIELD_SIZE +
+                                  TRACE_BODY_HEADER_SIZE + TRACE_ZONE_SIZE) {
+    return 0;
+  }
+  // Build the payload in place, like encode_telemetry_frame().
+  uint8_t* payload = &out[FRAME_HEADER_SIZE];
+  const size_t payload_cap =
+      std::min(out_cap - FRAME_OVERHEAD, FRAME_MAX_PAYLOAD);
+  put_ack(payload, ack);
+  uint8_t* body = &payload[ACK_FIELD_SIZE];
+  size_t n = 0;
+  size_t pos = TRACE_BODY_HEADER_SIZE;
+  while (n < count &&
+         ACK_FIELD_SIZE + pos + TRACE_ZONE_SIZE <= payload_cap) {
+    const TraceZoneStats& zone = zones[n];
+    body[pos] = zone.zone;
+    put_u32(&body[pos + 1], zone.calls);
+    put_u64(&body[pos + 5], zone.total_cycles);
+    put_u32(&body[pos + 13], zone.max_cycles);
+    pos += TRACE_ZONE_SIZE;
+    n++;
+  }
+  put_u16(&body[0], cycles_per_us);
+  body[2] = n;
+  *consumed = n;
+  return encode_frame(FrameType::kTrace, node, seq, payload,
+                      ACK_FIELD_SIZE + pos, out, out_cap);
+}
+
+bool decode_trace_frame(const Frame& frame, uint16_t* cycles_per_us,
+                        TraceZoneStats* out, size_t cap, size_t* count) {
+  if (frame.type != FrameType::kTrace ||
+      frame.payload_len < ACK_FIELD_SIZE + TRACE_BODY_HEADER_SIZE) {
+    return false;
+  }
+  const uint8_t* body = &frame.payload[ACK_FIELD_SIZE];
+  const size_t len = frame.payload_len - ACK_FIELD_SIZE;
+  if (len != TRACE_BODY_HEADER_SIZE + body[2] * TRACE_ZONE_SIZE) {
+    return false;
+  }
+  *cycles_per_us = get_u16(&body[0]);
+  *count = 0;
+  for (size_t i = 0; i < body[2] && *count < cap; i++) {
+    const uint8_t* p = &body[TRACE_BODY_HEADER_SIZE + i * TRACE_ZONE_SIZE];
+    out[(*count)++] = {
+        .zone = p[0],
+        .calls = get_u32(&p[1]),
+        .total_cycles = get_u64(&p[5]),
+        .max_cycles = get_u32(&p[13]),
+    };
+  }
+  return true;
+}
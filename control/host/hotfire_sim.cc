@@ -0,0 +1,457 @@
+// A hot fire of the stand logic against a model of the feed system
+// (sim/feed_plant.h), faster than real time:
+//
+//   hotfire_sim [--rate HZ] [--csv-period-ms MS] [--gox-regulator PSIA]
+//               [--expect-abort]
+//
+// Simulated MCP3204s read the model's pressures through each PT's transfer
+// function and a simulated HX711 its thrust through a load cell, while the
+// servo duties valve.cc sets and the igniter relay move the model. The rig
+// pressurizes the fuel tank, arms and fires, then steps the model and the
+// stand logic together in virtual time. Every cycle (--rate, 1 kHz by
+// default) reads each PT, checks the redlines, reads the load cell when a
+// conversion is due and releases due sequence steps, carrying out decisions
+// as stand_control.cc does. It prints the run as CSV every --csv-period-ms
+// and a summary on stderr. It exits nonzero unless the whole sequence ran,
+// or with --expect-abort unless a redline aborted it. --gox-regulator sets
+// the GOX regulator (430 psia by default), e.g. high enough to trip one.
+
+#include <esp32_driver_mcp320x/mcp320x.h>
+#include <hal/gpio.h>
+#include <hal/ledc.h>
+#include <hal/linux.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <stand/pt_scale.h>
+#include <stand/redline.h>
+#include <stand/sequencer.h>
+#include <stand/stand_controller.h>
+#include <telemetry/stand_state.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "configs/ignition_config.h"
+#include "configs/load_cell_config.h"
+#include "configs/pt_adc_config.h"
+#include "configs/pt_config.h"
+#include "configs/pt_scale_config.h"
+#include "configs/servo_config.h"
+#include "configs/stand_config.h"
+#include "configs/valve_config.h"
+#include "ignition.h"
+#include "load_cell.h"
+#include "pt.h"
+#include "pt_adc.h"
+#include "sim/feed_plant.h"
+#include "sim/hx711_sim.h"
+#include "sim/mcp320x_sim.h"
+#include "valve.h"
+
+static_assert(PLANT_VALVE_COUNT == static_cast<size_t>(Valve::kValveMax),
+              "PlantValve follows Valve");
+static_assert(PLANT_PT_COUNT == static_cast<size_t>(Pt::kPtMax),
+              "PlantPt follows Pt");
+
+namespace {
+
+constexpr double PT_NOISE_V = 0.002;
+// A 2 mV/V load cell, excited from the HX711's AVDD.
+constexpr double LOAD_CELL_CAPACITY_N = 2000;
+constexpr double LOAD_CELL_V_PER_V = 0.002;
+constexpr double HX711_AVDD_V = 3.3;
+constexpr double HX711_RATE_HZ = 80;
+constexpr int HX711_GAIN_A = 128;
+// Servos stop within this of the commanded angle.
+constexpr double SERVO_DEADBAND_DEG = 2;
+
+// The firing this simulation runs, with illustrative limits and timings: the
+// board has none until the stand owner signs off on them
+// (configs/stand_config.h).
+constexpr uint8_t ARMED_OR_FIRING = stand_state_bit(StandState::kArmed) |
+                                    stand_state_bit(StandState::kFiring);
+
+constexpr Redline SIM_REDLINES[] = {
+    // Chamber over-pressure.
+    {
+        .pt = static_cast<uint8_t>(Pt::kChamber),
+        .states = ARMED_OR_FIRING,
+        .min_psi = 0,
+        .max_psi = 400,
+        .persist_us = 5000,
+    },
+    // GOX regulator creep.
+    {
+        .pt = static_cast<uint8_t>(Pt::kGoxReg),
+        .states = ARMED_OR_FIRING,
+        .min_psi = 0,
+        .max_psi = 2500,
+        .persist_us = 20000,
+    },
+    // Injector over-pressure on either side.
+    {
+        .pt = static_cast<uint8_t>(Pt::kInjectorGox),
+        .states = ARMED_OR_FIRING,
+        .min_psi = 0,
+        .max_psi = 600,
+        .persist_us = 10000,
+    },
+    {
+        .pt = static_cast<uint8_t>(Pt::kInjectorEth),
+        .states = ARMED_OR_FIRING,
+        .min_psi = 0,
+        .max_psi = 600,
+        .persist_us = 10000,
+    },
+};
+
+// Times are from entering kFiring.
+constexpr SequenceStep SIM_FIRE_SEQUENCE[] = {
+    {
+        .t_ms = 0,
+        .action = SequenceAction::kIgnitionOn,
+        .arg = 0,
+    },
+    {
+        .t_ms = 1500,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kGoxRelease),
+    },
+    {
+        .t_ms = 1700,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kFuelRelease),
+    },
+    {
+        .t_ms = 2500,
+        .action = SequenceAction::kIgnitionOff,
+        .arg = 0,
+    },
+    {
+        .t_ms = 7000,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kFuelRelease),
+    },
+    {
+        .t_ms = 7100,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kGoxRelease),
+    },
+    {
+        .t_ms = 7200,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kN2PurgeGox),
+    },
+    {
+        .t_ms = 9200,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kN2PurgeGox),
+    },
+};
+
+constexpr StandLogicConfig SIM_STAND_LOGIC = {
+    .filter = STAND_PT_FILTER,
+    .redlines = SIM_REDLINES,
+    .redline_count = std::size(SIM_REDLINES),
+    .sequence = SIM_FIRE_SEQUENCE,
+    .sequence_count = std::size(SIM_FIRE_SEQUENCE),
+};
+// Time of the last step.
+constexpr double SEQUENCE_S =
+    SIM_FIRE_SEQUENCE[std::size(SIM_FIRE_SEQUENCE) - 1].t_ms / 1000.0;
+
+// From the start of the run.
+constexpr double ARM_S = 1;
+constexpr double FIRE_S = 1.5;
+// Kept running after the sequence or an abort.
+constexpr double SETTLE_S = 1;
+
+const char* PT_NAMES[] = {
+    "chamber", "injector_gox", "injector_eth", "eth_n2_reg",
+    "eth_line", "gox_reg", "gox_line",
+};
+
+bool installed(hal_gpio_t cs) {
+  for (const MP2304SpiConfig& config : MP2304_SPI_CONFIGS) {
+    if (config.cs == cs) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// PTs on an ADC init_pt_adc_spi() installs read through read_pt(). The rest
+// read the same way through a handle of the rig's own.
+uint16_t read_psi(Pt pt, const std::array<mcp320x_t*, HAL_GPIO_MAX>& handles) {
+  const PtConfig& config = get_pt_config(pt);
+  mcp320x_t* handle = handles[config.cs];
+  if (handle == nullptr) {
+    return read_pt(pt);
+  }
+  mcp320x_acquire(handle, HAL_WAIT_FOREVER);
+  uint16_t voltage_mv = 0;
+  mcp320x_sample_voltage(handle, config.channel, MCP320X_READ_MODE_SINGLE,
+                         PT_ADC_VOLTAGE_SAMPLE_COUNT, &voltage_mv);
+  mcp320x_release(handle);
+  return voltage_to_psi(get_pt_scale(pt), voltage_mv / 1000.0f);
+}
+
+// Moves the model's valves to where valve.cc put their servos.
+void follow_valves(FeedPlant* plant) {
+  for (int channel = 0; channel < HAL_LEDC_CHANNEL_MAX; channel++) {
+    const hal_gpio_t pin = hal_linux_ledc_pin(channel);
+    for (const ValveConfig& config : VALVE_CONFIGS) {
+      if (config.gpio_num != pin) {
+        continue;
+      }
+      const double pulse_us =
+          hal_linux_ledc_duty(channel) * SERVO_DUTY_PERIOD / 1023;
+      const double angle = (pulse_us - SERVO_MIN_PW) /
+                           (SERVO_MAX_PW - SERVO_MIN_PW) * config.max_angle;
+      double position = (config.close_angle - angle) /
+                        (config.close_angle - config.open_angle);
+      if (std::abs(angle - config.close_angle) < SERVO_DEADBAND_DEG) {
+        position = 0;
+      } else if (std::abs(angle - config.open_angle) < SERVO_DEADBAND_DEG) {
+        position = 1;
+      }
+      plant->set_valve(static_cast<PlantValve>(config.valve), position);
+    }
+  }
+}
+
+void on_igniter(void* ctx, hal_gpio_t pin, int level) {
+  static_cast<FeedPlant*>(ctx)->set_igniter(level);
+}
+
+double load_cell_volts(double thrust_n) {
+  return thrust_n / LOAD_CELL_CAPACITY_N * LOAD_CELL_V_PER_V * HX711_AVDD_V;
+}
+
+double load_cell_newtons(int32_t counts) {
+  const double full_scale_v = 0.5 * HX711_AVDD_V / HX711_GAIN_A;
+  return counts / 8388608.0 * full_scale_v / load_cell_volts(1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double rate_hz = 1000;
+  double csv_period_ms = 20;
+  bool expect_abort = false;
+  FeedPlantConfig plant_config;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--expect-abort") == 0) {
+      expect_abort = true;
+    } else if (i + 1 >= argc) {
+      break;
+    } else if (std::strcmp(argv[i], "--rate") == 0) {
+      rate_hz = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--csv-period-ms") == 0) {
+      csv_period_ms = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--gox-regulator") == 0) {
+      plant_config.gox_regulator_psia = std::atof(argv[++i]);
+    }
+  }
+  if (rate_hz <= 0 || csv_period_ms <= 0) {
+    std::fprintf(stderr, "need a positive rate and CSV period\n");
+    return 1;
+  }
+
+  FeedPlant plant(plant_config);
+  auto plant_time = [&plant] { return plant.now_s(); };
+
+  // One simulated ADC per chip select the PTs use, reading the model.
+  std::vector<std::unique_ptr<Mcp320xSim>> adcs;
+  std::array<Mcp320xSim*, HAL_GPIO_MAX> adc_for{};
+  for (int i = 0; i < static_cast<int>(Pt::kPtMax); i++) {
+    const Pt pt = static_cast<Pt>(i);
+    const PtConfig& config = get_pt_config(pt);
+    if (adc_for[config.cs] == nullptr) {
+      adcs.push_back(std::make_unique<Mcp320xSim>(
+          Mcp320xModel::kMcp3204, PT_ADC_MAX_VOLTAGE_MV / 1000.0));
+      adc_for[config.cs] = adcs.back().get();
+      adc_for[config.cs]->attach(ADC_SPI_HOST, config.cs);
+      adc_for[config.cs]->set_time_source(plant_time);
+    }
+    Mcp320xSim* adc = adc_for[config.cs];
+    adc->set_waveform(config.channel, AdcWaveform{.noise_v = PT_NOISE_V});
+    adc->set_input(config.channel, [&plant, pt](double) {
+      return psi_to_voltage(get_pt_scale(pt),
+                            plant.pressure_psig(static_cast<PlantPt>(pt)));
+    });
+  }
+  init_pt_adc_spi();
+  std::array<mcp320x_t*, HAL_GPIO_MAX> rig_handles{};
+  for (int i = 0; i < static_cast<int>(Pt::kPtMax); i++) {
+    const PtConfig& config = get_pt_config(static_cast<Pt>(i));
+    if (installed(config.cs) || rig_handles[config.cs] != nullptr) {
+      continue;
+    }
+    mcp320x_config_t mcp320x_cfg = {
+        .host = ADC_SPI_HOST,
+        .cs_io_num = config.cs,
+        .device_model = MCP3204_MODEL,
+        .clock_speed_hz = MP2304_SPI_CONFIGS[0].clock_speed_hz,
+        .reference_voltage = PT_ADC_MAX_VOLTAGE_MV,
+    };
+    rig_handles[config.cs] = mcp320x_install(&mcp320x_cfg);
+  }
+
+  Hx711Sim hx711(HX711_AVDD_V, HX711_RATE_HZ);
+  hx711.attach(HX711_DOUT_GPIO_NUM, HX711_PD_SCK_GPIO_NUM);
+  hx711.set_time_source(plant_time);
+  hx711.set_input(Hx711Input::kA, [&plant](double) {
+    return load_cell_volts(plant.thrust_n());
+  });
+  init_load_cell();
+
+  // The Linux HAL keeps LEDC channels apart from GPIO levels, so servos on
+  // the HX711's pins don't disturb it here and every valve is set up.
+  setup_valves(ALL_VALVES);
+  setup_ignition_relay();
+  hal_linux_gpio_watch(IGNITION_GPIO_NUM, on_igniter, &plant);
+  set_ignition_relay_low();
+  for (const ValveConfig& config : VALVE_CONFIGS) {
+    close_valve(config.valve);
+  }
+  // The operator pressurizes the fuel tank before arming.
+  open_valve(Valve::kPressurizeFuelTank);
+
+  StandController controller(SIM_STAND_LOGIC);
+  size_t steps_done = 0;
+  int redline = -1;
+  double end_s = FIRE_S + SEQUENCE_S + SETTLE_S;
+  // As stand_control.cc's carry_out().
+  auto carry_out = [&](const StandDecision& decision) {
+    if (decision.type == DecisionType::kAbort) {
+      redline = decision.index;
+      set_ignition_relay_low();
+      for (const ValveConfig& config : VALVE_CONFIGS) {
+        close_valve(config.valve);
+      }
+      end_s = std::min(end_s, plant.now_s() + SETTLE_S);
+      return;
+    }
+    const SequenceStep& step = SIM_FIRE_SEQUENCE[decision.index];
+    switch (step.action) {
+      case SequenceAction::kOpenValve:
+        open_valve(static_cast<Valve>(step.arg));
+        break;
+      case SequenceAction::kCloseValve:
+        close_valve(static_cast<Valve>(step.arg));
+        break;
+      case SequenceAction::kIgnitionOn:
+        set_ignition_relay_high();
+        break;
+      case SequenceAction::kIgnitionOff:
+        set_ignition_relay_low();
+        break;
+    }
+    steps_done++;
+  };
+
+  std::printf("t_s,state,igniter,ignited,gox_valve,fuel_valve,purge_valve");
+  for (const char* name : PT_NAMES) {
+    std::printf(",%s_psi", name);
+  }
+  std::printf(",gox_flow_kg_s,fuel_flow_kg_s,thrust_n,load_cell_n\n");
+
+  const double period_s = 1 / rate_hz;
+  double next_load_cell_s = 0;
+  double next_row_s = 0;
+  double load_cell_n = 0;
+  double peak_chamber_psi = 0;
+  double peak_thrust_n = 0;
+  double peak_load_cell_n = 0;
+  int cycles = 0;
+  uint16_t psi[static_cast<int>(Pt::kPtMax)] = {};
+  const uint64_t wall_start_us = hal_time_us();
+  while (plant.now_s() < end_s) {
+    follow_valves(&plant);
+    plant.step(period_s);
+    const double t_s = plant.now_s();
+    const uint64_t t_us = std::llround(t_s * 1e6);
+    cycles++;
+
+    if (controller.state() == StandState::kSafe && t_s >= ARM_S) {
+      controller.set_state(StandState::kArmed, t_us);
+    }
+    if (controller.state() == StandState::kArmed && t_s >= FIRE_S) {
+      controller.set_state(StandState::kFiring, t_us);
+    }
+
+    for (int i = 0; i < static_cast<int>(Pt::kPtMax); i++) {
+      const Pt pt = static_cast<Pt>(i);
+      psi[i] = read_psi(pt, rig_handles);
+      StandDecision decision;
+      if (controller.on_pt(i, t_us, psi[i], &decision)) {
+        carry_out(decision);
+      }
+    }
+    peak_chamber_psi = std::max<double>(peak_chamber_psi, psi[0]);
+
+    if (t_s >= next_load_cell_s) {
+      int32_t counts = 0;
+      if (read_raw_load_cell(&counts) == ESP_OK) {
+        load_cell_n = load_cell_newtons(counts);
+        peak_load_cell_n = std::max(peak_load_cell_n, load_cell_n);
+      }
+      next_load_cell_s += 1 / HX711_RATE_HZ;
+    }
+
+    StandDecision decision;
+    while (controller.poll_sequence(t_us, &decision)) {
+      carry_out(decision);
+    }
+
+    const FeedPlantState state = plant.state();
+    peak_thrust_n = std::max(peak_thrust_n, state.thrust_n);
+    if (t_s >= next_row_s) {
+      std::printf(
+          "%.3f,%d,%d,%d,%.2f,%.2f,%.2f", t_s,
+          static_cast<int>(controller.state()),
+          hal_gpio_get_level(IGNITION_GPIO_NUM), state.ignited,
+          state.valve_position[static_cast<int>(PlantValve::kGoxRelease)],
+          state.valve_position[static_cast<int>(PlantValve::kFuelRelease)],
+          state.valve_position[static_cast<int>(PlantValve::kN2PurgeGox)]);
+      for (uint16_t value : psi) {
+        std::printf(",%u", value);
+      }
+      std::printf(",%.4f,%.4f,%.1f,%.1f\n", state.gox_flow_kg_s,
+                  state.fuel_flow_kg_s, state.thrust_n, load_cell_n);
+      next_row_s += csv_period_ms / 1000;
+    }
+  }
+  const double wall_s = (hal_time_us() - wall_start_us) / 1e6;
+
+  const bool completed = steps_done == SIM_STAND_LOGIC.sequence_count;
+  std::fprintf(stderr,
+               "hotfire_sim: %zu/%zu sequence steps, %s; %.1f s simulated in "
+               "%.1f s at %.0f Hz\n",
+               steps_done, SIM_STAND_LOGIC.sequence_count,
+               redline < 0 ? "no redline" : "aborted", plant.now_s(), wall_s,
+               rate_hz);
+  if (redline >= 0) {
+    std::fprintf(stderr, "hotfire_sim: redline %d tripped on %s\n", redline,
+                 PT_NAMES[SIM_REDLINES[redline].pt]);
+  }
+  std::fprintf(stderr,
+               "hotfire_sim: peak chamber %.0f psi, thrust %.0f N (load cell "
+               "%.0f N), %.2f L of fuel left, %d cycles\n",
+               peak_chamber_psi, peak_thrust_n, peak_load_cell_n,
+               plant.state().fuel_liters, cycles);
+  std::fflush(stdout);
+  if (expect_abort) {
+    return redline >= 0 ? 0 : 1;
+  }
+  return completed && redline < 0 ? 0 : 1;
+}
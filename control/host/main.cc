@@ -0,0 +1,89 @@
+// Runs app_main() on the HAL's Linux backend:
+//
+//   control_host [--seconds S] [--pty]
+//
+// --pty attaches the wired link's UART to a new PTY and prints its path, so
+// ingestd can connect as if to a board on the cable. Without --seconds it
+// runs until interrupted.
+
+#include <fcntl.h>
+#include <hal/linux.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "configs/wired_config.h"
+
+extern "C" void app_main();
+
+namespace {
+
+// Sizes from partitions.csv.
+constexpr uint32_t DATALOG_PARTITION_SIZE = 0x78000;
+constexpr uint32_t COLUMNS_PARTITION_SIZE = 0x78000;
+
+int open_pty() {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  termios tty;
+  const char* name = nullptr;
+  if (grantpt(fd) != 0 || unlockpt(fd) != 0 ||
+      (name = ptsname(fd)) == nullptr || tcgetattr(fd, &tty) != 0) {
+    close(fd);
+    return -1;
+  }
+  cfmakeraw(&tty);
+  if (tcsetattr(fd, TCSANOW, &tty) != 0) {
+    close(fd);
+    return -1;
+  }
+  std::printf("%s\n", name);
+  std::fflush(stdout);
+  return fd;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  double seconds = 0;
+  bool pty = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--pty") == 0) {
+      pty = true;
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--seconds") == 0) {
+      seconds = std::atof(argv[++i]);
+    }
+  }
+
+  hal_linux_add_partition("datalog", DATALOG_PARTITION_SIZE);
+  hal_linux_add_partition("columns", COLUMNS_PARTITION_SIZE);
+  if (pty) {
+    int fd = open_pty();
+    if (fd < 0) {
+      std::fprintf(stderr, "can't create a PTY\n");
+      return 1;
+    }
+    hal_linux_uart_attach(WIRED_UART_PORT, fd);
+  }
+
+  // app_main() never returns on the board; the tasks it starts keep running.
+  std::thread(app_main).detach();
+  if (seconds > 0) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  } else {
+    while (1) {
+      std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+  }
+  std::fflush(stdout);
+  // Tasks are still running: skip static destructors.
+  std::_Exit(0);
+}
@@ -0,0 +1,56 @@
+// Microbenchmarks of the control loop's hot paths (see src/benchmarks.h) on
+// the Linux backend, with simulated MCP3204s on the ADC bus and a simulated
+// SX126x on the radio's:
+//
+//   micro_bench > results.csv
+//
+// Prints the same "bench," lines as a board booted with BENCH_AT_BOOT, in
+// nanoseconds instead of cycles. The simulators stand in for the SPI
+// transfers, so the ADC and radio rows measure the drivers, not the bus.
+
+#include <hal/spi.h>
+
+#include <memory>
+#include <vector>
+
+#include "benchmarks.h"
+#include "configs/pt_adc_config.h"
+#include "configs/radio_config.h"
+#include "sim/mcp320x_sim.h"
+#include "sim/sx126x_sim.h"
+
+namespace {
+
+#if CONFIG_SPI2_HOST
+constexpr hal_spi_host_t RADIO_SPI_HOST = 1;
+#else
+constexpr hal_spi_host_t RADIO_SPI_HOST = 2;
+#endif
+
+// Mid-range PT output.
+constexpr double PT_TEST_VOLTAGE = 2.5;
+
+}  // namespace
+
+int main() {
+  std::vector<std::unique_ptr<Mcp320xSim>> adcs;
+  for (const MP2304SpiConfig& config : MP2304_SPI_CONFIGS) {
+    auto adc = std::make_unique<Mcp320xSim>(Mcp320xModel::kMcp3204,
+                                            config.ref_voltage / 1000.0);
+    adc->attach(ADC_SPI_HOST, config.cs);
+    for (int channel = 0; channel < 4; channel++) {
+      adc->set_waveform(channel, AdcWaveform{.offset_v = PT_TEST_VOLTAGE});
+    }
+    adcs.push_back(std::move(adc));
+  }
+
+  LoraChannel channel;
+  Sx126xSim radio(&channel);
+  radio.attach(RADIO_SPI_HOST, CONFIG_NSS_GPIO,
+               Sx126xPins{.busy = CONFIG_BUSY_GPIO,
+                          .reset = CONFIG_RST_GPIO,
+                          .dio1 = CONFIG_DIO1_GPIO});
+
+  run_benchmarks();
+  return 0;
+}
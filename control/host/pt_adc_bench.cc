@@ -0,0 +1,104 @@
+// Cost of the PT read path (read_pt: mcp320x_sample() of
+// PT_ADC_VOLTAGE_SAMPLE_COUNT conversions, then the transfer function) with
+// simulated MCP3204s on the ADC bus:
+//
+//   pt_adc_bench [--reads N] [--paced]
+//
+// For every PT on an installed ADC it prints the host CPU time per read, the
+// bus time the same read takes on the board at the configured clock, and the
+// pressure read back. --paced makes each transfer take its bus time, so the
+// wall-clock time per read includes it.
+
+#include <hal/timer.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "configs/pt_adc_config.h"
+#include "configs/pt_config.h"
+#include "pt.h"
+#include "pt_adc.h"
+#include "sim/mcp320x_sim.h"
+
+namespace {
+
+// PT outputs are 0.5 to 4.5 V; read at mid-range with 2 mV RMS of noise.
+constexpr double PT_TEST_VOLTAGE = 2.5;
+constexpr double PT_TEST_NOISE_V = 0.002;
+
+const char* PT_NAMES[] = {
+    "chamber", "injector_gox", "injector_eth", "eth_n2_reg",
+    "eth_line", "gox_reg", "gox_line",
+};
+
+Mcp320xSim* sim_for(const std::vector<std::unique_ptr<Mcp320xSim>>& sims,
+                    hal_gpio_t cs) {
+  for (size_t i = 0; i < std::size(MP2304_SPI_CONFIGS); i++) {
+    if (MP2304_SPI_CONFIGS[i].cs == cs) {
+      return sims[i].get();
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int reads = 200;
+  bool paced = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--paced") == 0) {
+      paced = true;
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--reads") == 0) {
+      reads = std::atoi(argv[++i]);
+    }
+  }
+
+  std::vector<std::unique_ptr<Mcp320xSim>> sims;
+  for (const MP2304SpiConfig& config : MP2304_SPI_CONFIGS) {
+    auto sim = std::make_unique<Mcp320xSim>(Mcp320xModel::kMcp3204,
+                                            config.ref_voltage / 1000.0);
+    sim->attach(ADC_SPI_HOST, config.cs);
+    sim->set_paced(paced);
+    for (int channel = 0; channel < 4; channel++) {
+      sim->set_waveform(channel, AdcWaveform{.offset_v = PT_TEST_VOLTAGE,
+                                             .noise_v = PT_TEST_NOISE_V});
+    }
+    sims.push_back(std::move(sim));
+  }
+  init_pt_adc_spi();
+
+  std::printf("pt,reads,cpu_us_per_read,bus_us_per_read,wall_us_per_read,"
+              "psi\n");
+  for (int i = 0; i < static_cast<int>(Pt::kPtMax); i++) {
+    Pt pt = static_cast<Pt>(i);
+    Mcp320xSim* sim = sim_for(sims, get_pt_config(pt).cs);
+    if (sim == nullptr) {
+      // Wired to an ADC that init_pt_adc_spi() doesn't install.
+      std::printf("%s,0,,,,\n", PT_NAMES[i]);
+      continue;
+    }
+
+    Mcp320xSimStats before = sim->stats();
+    uint16_t psi = 0;
+    std::clock_t cpu_start = std::clock();
+    uint64_t wall_start_us = hal_time_us();
+    for (int read = 0; read < reads; read++) {
+      psi = read_pt(pt);
+    }
+    double wall_us = hal_time_us() - wall_start_us;
+    double cpu_us = (std::clock() - cpu_start) * 1e6 / CLOCKS_PER_SEC;
+    Mcp320xSimStats after = sim->stats();
+    double bus_us = (after.bus_time_ns - before.bus_time_ns) / 1e3;
+
+    std::printf("%s,%d,%.1f,%.1f,%.1f,%u\n", PT_NAMES[i], reads,
+                cpu_us / reads, bus_us / reads, wall_us / reads, psi);
+  }
+  return 0;
+}
@@ -0,0 +1,10 @@
+# The board's Kconfig choices, e.g. the radio pins, as compile definitions in
+# SDKCONFIG_DEFINITIONS. String options aren't used by the control logic and
+# are skipped.
+file(STRINGS ${CMAKE_CURRENT_LIST_DIR}/../sdkconfig.heltec_wifi_lora_32_V3
+     sdkconfig_lines REGEX "^CONFIG_[A-Z0-9_]+=(y|-?[0-9]+)$")
+set(SDKCONFIG_DEFINITIONS)
+foreach(line ${sdkconfig_lines})
+  string(REGEX REPLACE "=y$" "=1" definition ${line})
+  list(APPEND SDKCONFIG_DEFINITIONS ${definition})
+endforeach()
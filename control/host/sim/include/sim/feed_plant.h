@@ -0,0 +1,215 @@
+#pragma once
+
+#include <cstddef>
+
+// Lumped model of the GOX/ethanol feed system and the chamber, for running
+// the stand logic closed loop on the host. Pure physics: the caller moves the
+// valves and the igniter, steps the model and reads its pressures.
+//
+// GOX: bottle -> regulator -> GOX line -> main valve and check valve ->
+//      injector manifold -> orifice -> chamber, with N2 purge into the
+//      manifold.
+// Fuel: N2 bottle -> regulator -> pressurize valve -> tank ullage, ethanol
+//       -> main valve and line -> injector manifold -> orifice -> chamber.
+//
+// Valves use the Cv relations of simulation_and_calculations/pressure_drop.py
+// and the injector the orifice equations of coaxial_injector_orifice_sizing.py.
+// Gases are ideal and everything is isothermal. Bottles, the regulated lines
+// and the ullage are volumes that fill and drain; the flows through the
+// injector are solved quasi-steadily against them each step. The chamber
+// pressure lags its steady value, mdot * c* / At when lit and the cold-flow
+// value of the gas otherwise.
+
+// Same order as control/src's Valve, which the model doesn't include so the
+// ground tests can use it. Preslug and fuel tank bypass valves don't change
+// any flow the model has.
+enum class PlantValve {
+  kPressurizeFuelTank,
+  kPreslugFuel,
+  kN2PurgeFuelTankBypass,
+  kN2PurgeGox,
+  kPreslugGox,
+  kGoxRelease,
+  kFuelRelease,
+  kValveMax
+};
+
+// Same order as control/src's Pt.
+enum class PlantPt {
+  kChamber,
+  kInjectorGox,
+  kInjectorEth,
+  kEthN2Reg,  // Fuel regulator outlet.
+  kEthLine,   // Fuel tank ullage, upstream of the fuel valve.
+  kGoxReg,    // GOX regulator inlet: the bottle.
+  kGoxLine,   // GOX regulator outlet, upstream of the GOX valve.
+  kPtMax
+};
+
+constexpr size_t PLANT_VALVE_COUNT = static_cast<size_t>(PlantValve::kValveMax);
+constexpr size_t PLANT_PT_COUNT = static_cast<size_t>(PlantPt::kPtMax);
+
+// An ideal gas, as pressure_drop.py describes it.
+struct Gas {
+  double molar_mass_kg;
+  // Relative to air.
+  double specific_gravity;
+  double gamma;
+};
+
+constexpr Gas OXYGEN = {.molar_mass_kg = 0.031999,
+                        .specific_gravity = 1.1044,
+                        .gamma = 1.4};
+constexpr Gas NITROGEN = {.molar_mass_kg = 0.028013,
+                          .specific_gravity = 0.967,
+                          .gamma = 1.4};
+
+// Density of `gas` at `pressure_pa` and `temperature_k`.
+double gas_density(const Gas& gas, double pressure_pa, double temperature_k);
+
+// Mass flow of `gas` through a valve of `cv` from `p_in_psia` to
+// `p_out_psia`, negative if it flows back. The relation of
+// pressure_drop.py's inlet_P_gas(), P_in^2 - P_out^2 = SG T_R (Q / 962 Cv)^2,
+// with Q in standard ft^3/h; the outlet is held at no less than half the
+// inlet, where the flow chokes.
+double gas_valve_flow_kg_s(double cv, const Gas& gas, double temperature_k,
+                           double p_in_psia, double p_out_psia);
+
+// Pressure drop of a liquid of `density` flowing at `mdot_kg_s` through a
+// valve of `cv`: pressure_drop.py's dP_liquid(), SG (Q / Cv)^2 with Q in gpm.
+double liquid_valve_dp_psi(double cv, double density, double mdot_kg_s);
+
+// Gas flow through an orifice of `area_m2` from `p1_pa` to `p2_pa`, choked or
+// not, as in coaxial_injector_orifice_sizing.py.
+double gas_orifice_flow_kg_s(double area_m2, double cd, const Gas& gas,
+                             double temperature_k, double p1_pa, double p2_pa);
+
+// Liquid flow through an orifice of `area_m2` for a pressure drop of `dp_pa`:
+// Cd A sqrt(2 rho dP).
+double liquid_orifice_flow_kg_s(double area_m2, double cd, double density,
+                                double dp_pa);
+
+// Defaults are the design point of simulation_and_calculations/: a 20 bar
+// chamber at 0.144 kg/s, 25% injector drop on the GOX side and 7% on the
+// fuel side, two coaxial elements.
+struct FeedPlantConfig {
+  double ambient_psia = 14.696;
+  double temperature_k = 300;
+
+  // GOX supply.
+  double gox_bottle_liters = 49;
+  double gox_bottle_psia = 2000;
+  double gox_regulator_psia = 430;
+  double gox_regulator_cv = 0.5;
+  // Regulators open fully this far below their setpoint.
+  double regulator_droop_psi = 50;
+  double gox_line_liters = 0.5;
+  double gox_valve_cv = 1.5;
+  double gox_check_valve_cv = 1.1;
+
+  // Fuel pressurization.
+  double n2_bottle_liters = 49;
+  double n2_bottle_psia = 2000;
+  double fuel_regulator_psia = 330;
+  double fuel_regulator_cv = 0.5;
+  double n2_line_liters = 0.5;
+  double pressurize_valve_cv = 0.5;
+  double fuel_tank_liters = 4;
+  double fuel_liters = 3;
+  double fuel_density = 789;
+  double fuel_valve_cv = 1.5;
+  // The rest of the fuel feed, so that it and the valve make the 0.404
+  // system Cv of pressure_drop.py.
+  double fuel_line_cv = 0.42;
+
+  // N2 purge into the GOX manifold.
+  double purge_psia = 200;
+  double purge_valve_cv = 0.3;
+
+  // Injector, both elements together.
+  double discharge_coefficient = 0.7;
+  double gox_orifice_m2 = 2.24e-5;
+  double fuel_orifice_m2 = 6.30e-6;
+
+  // Chamber and nozzle.
+  double throat_m2 = 1.082e-4;
+  double c_star_m_s = 1500;
+  double thrust_coefficient = 1.4;
+  double chamber_time_constant_s = 0.005;
+  // Combustion needs both propellants flowing at least this much, and the
+  // igniter to start.
+  double ignition_min_flow_kg_s = 0.005;
+
+  // Time for a valve to travel from closed to open.
+  double valve_stroke_s = 0.25;
+  // Integration step.
+  double step_s = 50e-6;
+};
+
+struct FeedPlantState {
+  double t_s;
+  // Gauge pressures, in PlantPt order.
+  double psig[PLANT_PT_COUNT];
+  // How far open each valve is, 0 to 1.
+  double valve_position[PLANT_VALVE_COUNT];
+  double gox_flow_kg_s;
+  double fuel_flow_kg_s;
+  double purge_flow_kg_s;
+  double thrust_n;
+  bool ignited;
+  double fuel_liters;
+};
+
+// Not thread-safe: step it and read it from one thread.
+class FeedPlant {
+ public:
+  explicit FeedPlant(const FeedPlantConfig& config = {});
+
+  // Commands `valve` to `position`, 0 closed to 1 open. It gets there at the
+  // valve's stroke rate.
+  void set_valve(PlantValve valve, double position);
+  void set_igniter(bool on);
+
+  // Advances the model by `dt_s`, in steps of at most config.step_s.
+  void step(double dt_s);
+
+  double now_s() const { return t_s_; }
+  double pressure_psig(PlantPt pt) const;
+  double thrust_n() const;
+  FeedPlantState state() const;
+
+ private:
+  void substep(double dt_s);
+  // Pressure of `mass_kg` of `gas` in `volume_m3`.
+  double pressure_pa(const Gas& gas, double mass_kg, double volume_m3) const;
+  double regulator_flow_kg_s(const Gas& gas, double cv, double set_pa,
+                             double bottle_pa, double outlet_pa) const;
+  // Solves the GOX manifold against the orifice; sets the flows.
+  void solve_gox_manifold(double line_pa, double purge_position,
+                          double gox_position);
+  void solve_fuel_feed(double ullage_pa, double fuel_position);
+
+  const FeedPlantConfig config_;
+  double t_s_ = 0;
+  double commanded_[PLANT_VALVE_COUNT] = {};
+  double position_[PLANT_VALVE_COUNT] = {};
+  bool igniter_ = false;
+  bool ignited_ = false;
+
+  double gox_bottle_kg_;
+  double gox_line_kg_;
+  double n2_bottle_kg_;
+  double n2_line_kg_;
+  double ullage_kg_;
+  double fuel_m3_;
+  double chamber_pa_;
+
+  // Results of the last step.
+  double gox_manifold_pa_;
+  double fuel_manifold_pa_;
+  double gox_flow_kg_s_ = 0;
+  double purge_flow_kg_s_ = 0;
+  double fuel_flow_kg_s_ = 0;
+  // Of the gas leaving the GOX manifold, from the last inflows.
+  double manifold_molar_mass_kg_ = OXYGEN.molar_mass_kg;
+};
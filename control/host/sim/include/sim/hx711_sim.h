@@ -0,0 +1,83 @@
+#pragma once
+
+#include <hal/gpio.h>
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Behavioral model of an HX711 load cell amplifier on the HAL's Linux GPIO
+// backend, so load_cell.cc runs without one.
+//
+// DOUT reads low when a conversion is ready. Each rising edge of PD_SCK then
+// shifts out one of its 24 bits, MSB first, in two's complement; the 25th to
+// 27th pulses select the input and gain of the next conversion (A at 128, B
+// at 32, A at 64), and DOUT reads high until that one is ready. A conversion
+// samples its input at the first read of DOUT that finds it ready.
+// Clock pulses of 60 us or more, which power the chip down, are counted but
+// not acted on: the host can't hold the firmware's timing that closely.
+
+enum class Hx711Input { kA, kB };
+
+struct Hx711SimStats {
+  // Conversions clocked out in full.
+  uint32_t conversions;
+  // Pulses on PD_SCK with no conversion to shift out.
+  uint32_t stray_pulses;
+  uint32_t long_pulses;
+};
+
+class Hx711Sim {
+ public:
+  // `avdd_v` sets the full-scale input, +-0.5 AVDD / gain. `rate_hz` is the
+  // output data rate (10 or 80 SPS on the chip), used when paced.
+  explicit Hx711Sim(double avdd_v = 3.3, double rate_hz = 80);
+  ~Hx711Sim();
+
+  Hx711Sim(const Hx711Sim&) = delete;
+  Hx711Sim& operator=(const Hx711Sim&) = delete;
+
+  // Drives `dout` and follows `pd_sck` until destroyed.
+  void attach(hal_gpio_t dout, hal_gpio_t pd_sck);
+
+  // Differential input voltage at `t_s` seconds of the time source.
+  void set_input(Hx711Input input, std::function<double(double t_s)> volts);
+
+  // Where `t_s` comes from: hal_time_us() by default.
+  void set_time_source(std::function<double()> now_s);
+
+  // Makes each conversion ready 1 / rate_hz after the last was read, on the
+  // time source. Otherwise one is always ready, for simulations that run
+  // faster than real time.
+  void set_paced(bool paced);
+
+  // Output code for a differential input of `volts` at `gain`.
+  int32_t code_for(double volts, int gain) const;
+
+  // PD_SCK and DOUT, as the GPIO hooks call them.
+  void clock(int level);
+  int dout();
+
+  Hx711SimStats stats() const;
+
+ private:
+  const double avdd_v_;
+  const double rate_hz_;
+  mutable std::mutex mutex_;
+  std::function<double(double)> inputs_[2];
+  std::function<double()> now_s_;
+  bool paced_ = false;
+  // Extra pulses after the data bits at the last conversion: 1 to 3.
+  int gain_pulses_ = 1;
+  // A conversion waiting to be clocked out.
+  bool latched_ = false;
+  // PD_SCK pulses since it was latched.
+  int pulses_ = 0;
+  uint32_t data_ = 0;
+  double ready_at_s_ = 0;
+  int sck_level_ = 0;
+  uint64_t rise_us_ = 0;
+  Hx711SimStats stats_ = {};
+  hal_gpio_t dout_ = HAL_GPIO_NC;
+  hal_gpio_t pd_sck_ = HAL_GPIO_NC;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <hal/gpio.h>
+#include <hal/spi.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <vector>
+
+// Behavioral model of an MCP3204/3208 on the HAL's Linux SPI backend, so the
+// mcp320x driver and everything above it run without an ADC.
+//
+// Every transfer is decoded bit by bit, MSB first, as the chip sees it on
+// DIN: leading zeros, the start bit, SGL/DIFF, D2 D1 D0, one clock to end
+// the sample period, then DOUT drives a null bit, B11..B0 and, if clocking
+// continues, B1..B11 again LSB first followed by zeros. Before the null bit
+// DOUT is high impedance and reads 1. The input is sampled on the falling
+// edge that ends the sample period, timed from the start of the transfer at
+// the bus clock, so a changing input reads as it would on the board.
+
+enum class Mcp320xModel { kMcp3204 = 4, kMcp3208 = 8 };
+
+// Input voltage of a channel: offset + amplitude * sin(2 pi f t), plus
+// Gaussian noise of standard deviation `noise_v` on every conversion.
+struct AdcWaveform {
+  double offset_v = 0;
+  double amplitude_v = 0;
+  double frequency_hz = 0;
+  double noise_v = 0;
+};
+
+struct Mcp320xSimStats {
+  uint32_t transfers;
+  // Transfers that clocked out a full result.
+  uint32_t conversions;
+  // Transfers that ended between the start bit and B0.
+  uint32_t truncated;
+  // Transfers clocked outside the datasheet's 10 kHz to f_max range. The
+  // result is still exact: only the count is kept.
+  uint32_t out_of_spec_clock;
+  // Time the bus was busy with this chip, at the clock of each transfer.
+  uint64_t bus_time_ns;
+};
+
+class Mcp320xSim {
+ public:
+  // `reference_v` is VREF and `supply_v` VDD, which sets the fastest clock
+  // the datasheet allows (1 MHz at 2.7 V to 2 MHz at 5 V).
+  Mcp320xSim(Mcp320xModel model, double reference_v, double supply_v = 5.0,
+             uint32_t seed = 1);
+  ~Mcp320xSim();
+
+  Mcp320xSim(const Mcp320xSim&) = delete;
+  Mcp320xSim& operator=(const Mcp320xSim&) = delete;
+
+  // Answers transfers to chip select `cs` on `host` until destroyed.
+  void attach(hal_spi_host_t host, hal_gpio_t cs);
+
+  void set_waveform(int channel, const AdcWaveform& waveform);
+  // Any input, as volts at `t_s` seconds of the time source.
+  void set_input(int channel, std::function<double(double t_s)> input);
+
+  // Where `t_s` comes from: hal_time_us() by default. A simulation running
+  // faster than real time passes its own clock.
+  void set_time_source(std::function<double()> now_s);
+
+  // Makes each transfer take its modeled bus time in wall-clock time, by
+  // spinning, so host timings include the bus as on the board.
+  void set_paced(bool paced);
+
+  // One assertion of chip select, as hal_linux_spi_attach() calls it.
+  void transfer(uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+                size_t len);
+
+  // Output code for a differential input of `volts`.
+  uint16_t code_for(double volts) const;
+  double max_clock_hz() const;
+
+  Mcp320xSimStats stats() const;
+
+ private:
+  double sample(int channel, double t_s);
+  uint16_t convert(bool single, int select, double t_s);
+
+  const Mcp320xModel model_;
+  const double reference_v_;
+  const double supply_v_;
+  mutable std::mutex mutex_;
+  std::vector<std::function<double(double)>> inputs_;
+  std::vector<double> noise_v_;
+  std::function<double()> now_s_;
+  bool paced_ = false;
+  std::mt19937 rng_;
+  std::normal_distribution<double> normal_;
+  Mcp320xSimStats stats_ = {};
+  hal_spi_host_t host_ = -1;
+  hal_gpio_t cs_ = HAL_GPIO_NC;
+};
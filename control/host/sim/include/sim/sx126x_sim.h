@@ -0,0 +1,253 @@
+#pragma once
+
+#include <hal/gpio.h>
+#include <hal/spi.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Behavioral model of SX126x LoRa radios sharing a virtual channel, so the
+// ra01s driver and the radio task run on Linux.
+//
+// A radio attached to the HAL's Linux SPI backend answers the command set
+// ra01s uses (see ra01s.h): register and buffer access, the mode, modulation,
+// packet and DIO/IRQ commands, status reads and CAD. Every command holds BUSY
+// high for roughly the datasheet's processing time, and IRQs routed to DIO1
+// drive that GPIO. A radio can also be operated directly, without SPI, to
+// stand in for the other end of the link (e.g. the ground station).
+//
+// Packets take their LoRa time on air (lora_time_on_air_us()) from the
+// sender's modulation and packet parameters. A radio receives a packet if it
+// listened with matching frequency, modulation, sync word and IQ setup from
+// the start of the transmission to its end, no other transmission overlapped
+// it, and the channel didn't drop it. Preamble, header and sync word IRQs are
+// not modeled: reception completes at the end of the packet.
+
+class Sx126xSim;
+
+struct LoraChannelConfig {
+  // Fraction of packets no radio receives.
+  double loss_rate = 0;
+  // Fraction of the remaining packets received with a flipped bit, which
+  // raises CRC_ERR along with RX_DONE when the CRC is on.
+  double corrupt_rate = 0;
+  // Reported by receivers in GetPacketStatus.
+  int rssi_dbm = -60;
+  int snr_db = 10;
+  uint32_t seed = 1;
+};
+
+struct LoraChannelStats {
+  uint32_t transmissions;
+  // Packets received intact, counted per receiver.
+  uint32_t delivered;
+  uint32_t lost;
+  uint32_t corrupted;
+  // Transmissions that overlapped another on the same frequency and
+  // modulation. Both are lost.
+  uint32_t collisions;
+};
+
+// The air between radios. Also runs their timed events (end of a packet, of
+// CAD, timeouts) on a thread of its own, in real time. Outlives its radios.
+class LoraChannel {
+ public:
+  explicit LoraChannel(const LoraChannelConfig& config = {});
+  ~LoraChannel();
+
+  LoraChannel(const LoraChannel&) = delete;
+  LoraChannel& operator=(const LoraChannel&) = delete;
+
+  LoraChannelStats stats() const;
+
+ private:
+  friend class Sx126xSim;
+
+  struct Event {
+    const Sx126xSim* owner;
+    std::function<void()> fn;
+  };
+
+  struct Transmission {
+    const Sx126xSim* sender;
+    uint64_t start_us;
+    uint64_t end_us;
+    bool aborted;
+  };
+
+  // All of these are called with `mutex_` held.
+  void add(Sx126xSim* radio);
+  void remove(Sx126xSim* radio);
+  void schedule(uint64_t at_us, const Sx126xSim* owner,
+                std::function<void()> fn);
+  // Runs `fn` after `mutex_` is released, e.g. user callbacks.
+  void defer(std::function<void()> fn);
+  Transmission* begin_transmission(const Sx126xSim* sender, uint64_t start_us,
+                                   uint64_t end_us);
+  void end_transmission(Transmission* transmission,
+                        const std::vector<uint8_t>& payload);
+  bool busy(const Sx126xSim* listener, uint64_t from_us, uint64_t to_us) const;
+
+  void run();
+
+  const LoraChannelConfig config_;
+  // Guards the channel and every radio on it.
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::multimap<uint64_t, Event> events_;
+  std::vector<std::function<void()>> deferred_;
+  std::vector<Sx126xSim*> radios_;
+  std::deque<Transmission> transmissions_;
+  std::mt19937 rng_;
+  std::uniform_real_distribution<double> chance_;
+  LoraChannelStats stats_ = {};
+  bool stop_ = false;
+  std::thread worker_;
+};
+
+// Radio settings as set through SetRfFrequency, SetPacketType,
+// SetModulationParams, SetPacketParams and the sync word registers. Codes are
+// the SX126X_* values of ra01s.h.
+struct Sx126xSettings {
+  uint32_t frequency_hz;
+  uint8_t packet_type;
+  uint8_t spreading_factor;
+  uint8_t bandwidth;
+  uint8_t coding_rate;
+  bool low_data_rate_optimize;
+  uint16_t preamble_length;
+  bool implicit_header;
+  uint8_t payload_length;
+  bool crc_on;
+  bool invert_iq;
+  uint16_t sync_word;
+};
+
+// GPIOs of a radio besides the SPI bus. HAL_GPIO_NC for unconnected ones.
+struct Sx126xPins {
+  hal_gpio_t busy;
+  hal_gpio_t reset;
+  hal_gpio_t dio1;
+};
+
+struct Sx126xSimStats {
+  uint32_t transfers;
+  uint32_t commands;
+  // Unknown opcodes or commands with too few parameters.
+  uint32_t invalid_commands;
+  // Transfers started while BUSY was high, which the chip ignores.
+  uint32_t busy_violations;
+  // BUSY reads that found it high.
+  uint32_t busy_reads;
+  uint64_t bus_time_ns;
+  uint32_t packets_sent;
+  uint32_t packets_received;
+  uint32_t crc_errors;
+  uint32_t cad_runs;
+  uint32_t cad_detections;
+};
+
+class Sx126xSim {
+ public:
+  explicit Sx126xSim(LoraChannel* channel);
+  ~Sx126xSim();
+
+  Sx126xSim(const Sx126xSim&) = delete;
+  Sx126xSim& operator=(const Sx126xSim&) = delete;
+
+  // Answers transfers to chip select `nss` on `host` and drives `pins`.
+  void attach(hal_spi_host_t host, hal_gpio_t nss, const Sx126xPins& pins);
+
+  // One assertion of NSS, as hal_linux_spi_attach() calls it.
+  void transfer(uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+                size_t len);
+
+  // Direct operation, in place of a driver.
+  void configure(const Sx126xSettings& settings);
+  Sx126xSettings settings() const;
+  // Enters continuous receive, and returns to it after every send().
+  void listen();
+  // Transmits `len` bytes. Returns false if a packet is still on air.
+  bool send(const uint8_t* data, size_t len);
+  bool transmitting() const;
+  // Called for every packet received, from the channel's thread.
+  using ReceiveFn =
+      std::function<void(const uint8_t* data, size_t len, bool crc_ok)>;
+  void on_receive(ReceiveFn fn);
+
+  // Time on air of a `len` byte packet with the current settings.
+  uint32_t time_on_air_us(size_t len) const;
+
+  Sx126xSimStats stats() const;
+
+ private:
+  friend class LoraChannel;
+
+  enum class Mode { kSleep, kStandbyRc, kStandbyXosc, kFs, kRx, kTx, kCad };
+
+  // All of these are called with the channel's mutex held.
+  void reset();
+  uint8_t status() const;
+  void execute(uint8_t opcode, const uint8_t* args, size_t arg_len,
+               uint8_t* rx, size_t rx_len, uint64_t now_us);
+  void set_mode(Mode mode, uint64_t now_us);
+  uint32_t airtime_us(size_t len) const;
+  void start_tx(uint32_t timeout, uint64_t now_us);
+  void start_rx(uint32_t timeout, uint64_t now_us);
+  void start_cad(uint64_t now_us);
+  void finish_tx(uint32_t epoch, bool timed_out,
+                 LoraChannel::Transmission* transmission);
+  void fall_back(uint64_t now_us);
+  void raise(uint16_t irq);
+  void update_dio1();
+  // Whether this radio hears `sender`'s packets.
+  bool hears(const Sx126xSim& sender) const;
+  // A packet from the channel, received while listening.
+  void deliver(const std::vector<uint8_t>& payload, bool crc_ok);
+  uint32_t symbol_time_us() const;
+
+  LoraChannel* const channel_;
+  hal_spi_host_t host_ = -1;
+  hal_gpio_t nss_ = HAL_GPIO_NC;
+  Sx126xPins pins_ = {HAL_GPIO_NC, HAL_GPIO_NC, HAL_GPIO_NC};
+  // Read by the BUSY line without the channel's mutex.
+  std::atomic<uint64_t> busy_until_us_{0};
+  std::atomic<bool> in_reset_{false};
+  std::atomic<uint32_t> busy_reads_{0};
+
+  Mode mode_ = Mode::kStandbyRc;
+  // Advances on every mode change, to drop stale timed events.
+  uint32_t epoch_ = 0;
+  uint64_t rx_since_us_ = 0;
+  bool rx_continuous_ = false;
+  bool listening_ = false;
+  uint8_t fallback_ = 0x20;
+  uint8_t last_command_status_ = 1;
+  std::vector<uint8_t> registers_;
+  uint8_t buffer_[256] = {};
+  uint8_t tx_base_ = 0;
+  uint8_t rx_base_ = 0;
+  Sx126xSettings settings_ = {};
+  uint16_t irq_ = 0;
+  uint16_t irq_mask_ = 0;
+  uint16_t dio1_mask_ = 0;
+  bool dio1_level_ = false;
+  uint8_t cad_symbols_ = 0;
+  uint8_t cad_exit_mode_ = 0;
+  uint32_t cad_timeout_ = 0;
+  uint8_t rx_length_ = 0;
+  uint8_t rx_start_ = 0;
+  uint16_t stat_received_ = 0;
+  uint16_t stat_crc_errors_ = 0;
+  ReceiveFn on_receive_;
+  Sx126xSimStats stats_ = {};
+};
@@ -0,0 +1,325 @@
+#include "sim/feed_plant.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+
+constexpr double GAS_CONSTANT = 8.314462618;
+constexpr double PA_PER_PSI = 6894.757293168;
+constexpr double FT3_PER_M3 = 35.3147;
+constexpr double GAL_PER_M3 = 264.17205234375;
+constexpr double LITERS_PER_M3 = 1000;
+// Standard conditions of standard cubic feet: 14.696 psia and 60 F.
+constexpr double STANDARD_PA = 101325;
+constexpr double STANDARD_K = 288.7056;
+// Water, for the specific gravity of liquids.
+constexpr double WATER_DENSITY = 999;
+// Bisection on the GOX manifold stops at this width.
+constexpr double MANIFOLD_TOLERANCE_PA = 10;
+
+double rankine(double kelvin) { return kelvin * 1.8; }
+
+double psia(double pa) { return pa / PA_PER_PSI; }
+
+double pa(double psia) { return psia * PA_PER_PSI; }
+
+}  // namespace
+
+double gas_density(const Gas& gas, double pressure_pa, double temperature_k) {
+  return pressure_pa * gas.molar_mass_kg / (GAS_CONSTANT * temperature_k);
+}
+
+double gas_valve_flow_kg_s(double cv, const Gas& gas, double temperature_k,
+                           double p_in_psia, double p_out_psia) {
+  if (cv <= 0 || p_in_psia == p_out_psia) {
+    return 0;
+  }
+  if (p_in_psia < p_out_psia) {
+    return -gas_valve_flow_kg_s(cv, gas, temperature_k, p_out_psia, p_in_psia);
+  }
+  const double p_out = std::max(p_out_psia, p_in_psia / 2);
+  const double scfh =
+      962 * cv *
+      std::sqrt((p_in_psia * p_in_psia - p_out * p_out) /
+                (gas.specific_gravity * rankine(temperature_k)));
+  return scfh / 3600 / FT3_PER_M3 * gas_density(gas, STANDARD_PA, STANDARD_K);
+}
+
+double liquid_valve_dp_psi(double cv, double density, double mdot_kg_s) {
+  const double gpm = mdot_kg_s / density * GAL_PER_M3 * 60;
+  return density / WATER_DENSITY * (gpm / cv) * (gpm / cv);
+}
+
+double gas_orifice_flow_kg_s(double area_m2, double cd, const Gas& gas,
+                             double temperature_k, double p1_pa,
+                             double p2_pa) {
+  if (area_m2 <= 0 || p1_pa <= p2_pa) {
+    return 0;
+  }
+  const double gamma = gas.gamma;
+  const double rho1 = gas_density(gas, p1_pa, temperature_k);
+  const double ratio = p2_pa / p1_pa;
+  if (ratio <= std::pow(2 / (gamma + 1), gamma / (gamma - 1))) {
+    return area_m2 * cd *
+           std::sqrt(gamma * rho1 * p1_pa *
+                     std::pow(2 / (gamma + 1), (gamma + 1) / (gamma - 1)));
+  }
+  return area_m2 * cd *
+         std::sqrt(2 * rho1 * p1_pa * (gamma / (gamma - 1)) *
+                   (std::pow(ratio, 2 / gamma) -
+                    std::pow(ratio, (gamma + 1) / gamma)));
+}
+
+double liquid_orifice_flow_kg_s(double area_m2, double cd, double density,
+                                double dp_pa) {
+  return dp_pa > 0 ? cd * area_m2 * std::sqrt(2 * density * dp_pa) : 0;
+}
+
+FeedPlant::FeedPlant(const FeedPlantConfig& config) : config_(config) {
+  const double t_k = config_.temperature_k;
+  const double ambient_pa = pa(config_.ambient_psia);
+  gox_bottle_kg_ = gas_density(OXYGEN, pa(config_.gox_bottle_psia), t_k) *
+                   config_.gox_bottle_liters / LITERS_PER_M3;
+  n2_bottle_kg_ = gas_density(NITROGEN, pa(config_.n2_bottle_psia), t_k) *
+                  config_.n2_bottle_liters / LITERS_PER_M3;
+  // Regulated lines start at their setpoints, the tank vented.
+  gox_line_kg_ = gas_density(OXYGEN, pa(config_.gox_regulator_psia), t_k) *
+                 config_.gox_line_liters / LITERS_PER_M3;
+  n2_line_kg_ = gas_density(NITROGEN, pa(config_.fuel_regulator_psia), t_k) *
+                config_.n2_line_liters / LITERS_PER_M3;
+  fuel_m3_ = config_.fuel_liters / LITERS_PER_M3;
+  ullage_kg_ = gas_density(NITROGEN, ambient_pa, t_k) *
+               (config_.fuel_tank_liters / LITERS_PER_M3 - fuel_m3_);
+  chamber_pa_ = ambient_pa;
+  gox_manifold_pa_ = ambient_pa;
+  fuel_manifold_pa_ = ambient_pa;
+}
+
+void FeedPlant::set_valve(PlantValve valve, double position) {
+  commanded_[static_cast<size_t>(valve)] = std::clamp(position, 0.0, 1.0);
+}
+
+void FeedPlant::set_igniter(bool on) { igniter_ = on; }
+
+void FeedPlant::step(double dt_s) {
+  if (dt_s <= 0) {
+    return;
+  }
+  const int steps = static_cast<int>(std::ceil(dt_s / config_.step_s));
+  for (int i = 0; i < steps; i++) {
+    substep(dt_s / steps);
+  }
+}
+
+double FeedPlant::pressure_psig(PlantPt pt) const {
+  double p_pa = 0;
+  switch (pt) {
+    case PlantPt::kChamber:
+      p_pa = chamber_pa_;
+      break;
+    case PlantPt::kInjectorGox:
+      p_pa = gox_manifold_pa_;
+      break;
+    case PlantPt::kInjectorEth:
+      p_pa = fuel_manifold_pa_;
+      break;
+    case PlantPt::kEthN2Reg:
+      p_pa = pressure_pa(NITROGEN, n2_line_kg_,
+                         config_.n2_line_liters / LITERS_PER_M3);
+      break;
+    case PlantPt::kEthLine:
+      p_pa = pressure_pa(NITROGEN, ullage_kg_,
+                         config_.fuel_tank_liters / LITERS_PER_M3 - fuel_m3_);
+      break;
+    case PlantPt::kGoxReg:
+      p_pa = pressure_pa(OXYGEN, gox_bottle_kg_,
+                         config_.gox_bottle_liters / LITERS_PER_M3);
+      break;
+    case PlantPt::kGoxLine:
+      p_pa = pressure_pa(OXYGEN, gox_line_kg_,
+                         config_.gox_line_liters / LITERS_PER_M3);
+      break;
+    case PlantPt::kPtMax:
+      break;
+  }
+  return psia(p_pa) - config_.ambient_psia;
+}
+
+double FeedPlant::thrust_n() const {
+  const double gauge_pa = chamber_pa_ - pa(config_.ambient_psia);
+  return std::max(0.0, config_.thrust_coefficient * gauge_pa *
+                           config_.throat_m2);
+}
+
+FeedPlantState FeedPlant::state() const {
+  FeedPlantState state = {};
+  state.t_s = t_s_;
+  for (size_t i = 0; i < PLANT_PT_COUNT; i++) {
+    state.psig[i] = pressure_psig(static_cast<PlantPt>(i));
+  }
+  std::copy(position_, position_ + PLANT_VALVE_COUNT, state.valve_position);
+  state.gox_flow_kg_s = gox_flow_kg_s_;
+  state.fuel_flow_kg_s = fuel_flow_kg_s_;
+  state.purge_flow_kg_s = purge_flow_kg_s_;
+  state.thrust_n = thrust_n();
+  state.ignited = ignited_;
+  state.fuel_liters = fuel_m3_ * LITERS_PER_M3;
+  return state;
+}
+
+double FeedPlant::pressure_pa(const Gas& gas, double mass_kg,
+                              double volume_m3) const {
+  return mass_kg * GAS_CONSTANT * config_.temperature_k /
+         (gas.molar_mass_kg * volume_m3);
+}
+
+double FeedPlant::regulator_flow_kg_s(const Gas& gas, double cv, double set_pa,
+                                      double bottle_pa,
+                                      double outlet_pa) const {
+  const double opening = std::clamp(
+      (set_pa - outlet_pa) / pa(config_.regulator_droop_psi), 0.0, 1.0);
+  // Regulators don't flow back.
+  return std::max(0.0, gas_valve_flow_kg_s(cv * opening, gas,
+                                           config_.temperature_k,
+                                           psia(bottle_pa), psia(outlet_pa)));
+}
+
+void FeedPlant::solve_gox_manifold(double line_pa, double purge_position,
+                                   double gox_position) {
+  const double t_k = config_.temperature_k;
+  // The main valve and the check valve in series: 1 / Cv^2 adds up.
+  const double gox_cv =
+      gox_position > 0
+          ? 1 / std::sqrt(1 / std::pow(config_.gox_valve_cv * gox_position, 2) +
+                          1 / std::pow(config_.gox_check_valve_cv, 2))
+          : 0;
+  const double purge_cv = config_.purge_valve_cv * purge_position;
+  const double purge_pa = pa(config_.purge_psia);
+  const Gas manifold_gas = {.molar_mass_kg = manifold_molar_mass_kg_,
+                            .specific_gravity = 0,
+                            .gamma = OXYGEN.gamma};
+
+  // Both inflows only go forward (check valves), so their sum falls and the
+  // orifice flow rises with the manifold pressure: bisect for the balance.
+  auto gox_in = [&](double p) {
+    return std::max(0.0, gas_valve_flow_kg_s(gox_cv, OXYGEN, t_k,
+                                             psia(line_pa), psia(p)));
+  };
+  auto purge_in = [&](double p) {
+    return std::max(0.0, gas_valve_flow_kg_s(purge_cv, NITROGEN, t_k,
+                                             psia(purge_pa), psia(p)));
+  };
+  double low = chamber_pa_;
+  double high = std::max({chamber_pa_, gox_cv > 0 ? line_pa : 0,
+                          purge_cv > 0 ? purge_pa : 0});
+  while (high - low > MANIFOLD_TOLERANCE_PA) {
+    const double p = (low + high) / 2;
+    const double out = gas_orifice_flow_kg_s(
+        config_.gox_orifice_m2, config_.discharge_coefficient, manifold_gas,
+        t_k, p, chamber_pa_);
+    if (gox_in(p) + purge_in(p) > out) {
+      low = p;
+    } else {
+      high = p;
+    }
+  }
+  gox_manifold_pa_ = (low + high) / 2;
+  gox_flow_kg_s_ = gox_in(gox_manifold_pa_);
+  purge_flow_kg_s_ = purge_in(gox_manifold_pa_);
+  const double total = gox_flow_kg_s_ + purge_flow_kg_s_;
+  if (total > 0) {
+    manifold_molar_mass_kg_ =
+        total / (gox_flow_kg_s_ / OXYGEN.molar_mass_kg +
+                 purge_flow_kg_s_ / NITROGEN.molar_mass_kg);
+  }
+}
+
+void FeedPlant::solve_fuel_feed(double ullage_pa, double fuel_position) {
+  const double rho = config_.fuel_density;
+  // Every drop goes as mdot^2, so with k = dP / mdot^2 of each, the flow is
+  // sqrt(dP / sum of k).
+  const double orifice_k =
+      1 / (2 * rho * std::pow(config_.discharge_coefficient *
+                                  config_.fuel_orifice_m2,
+                              2));
+  const double dp_pa = ullage_pa - chamber_pa_;
+  fuel_flow_kg_s_ = 0;
+  if (fuel_position > 0 && fuel_m3_ > 0 && dp_pa > 0) {
+    const double valves_k =
+        pa(liquid_valve_dp_psi(config_.fuel_valve_cv * fuel_position, rho, 1) +
+           liquid_valve_dp_psi(config_.fuel_line_cv, rho, 1));
+    fuel_flow_kg_s_ = std::sqrt(dp_pa / (valves_k + orifice_k));
+  }
+  fuel_manifold_pa_ = chamber_pa_ + orifice_k * fuel_flow_kg_s_ *
+                                        fuel_flow_kg_s_;
+}
+
+void FeedPlant::substep(double dt_s) {
+  const double t_k = config_.temperature_k;
+  const double slew = dt_s / config_.valve_stroke_s;
+  for (size_t i = 0; i < PLANT_VALVE_COUNT; i++) {
+    position_[i] += std::clamp(commanded_[i] - position_[i], -slew, slew);
+  }
+  auto position = [&](PlantValve valve) {
+    return position_[static_cast<size_t>(valve)];
+  };
+
+  const double gox_bottle_pa = pressure_pa(
+      OXYGEN, gox_bottle_kg_, config_.gox_bottle_liters / LITERS_PER_M3);
+  const double gox_line_pa = pressure_pa(
+      OXYGEN, gox_line_kg_, config_.gox_line_liters / LITERS_PER_M3);
+  const double n2_bottle_pa = pressure_pa(
+      NITROGEN, n2_bottle_kg_, config_.n2_bottle_liters / LITERS_PER_M3);
+  const double n2_line_pa = pressure_pa(
+      NITROGEN, n2_line_kg_, config_.n2_line_liters / LITERS_PER_M3);
+  const double ullage_m3 = config_.fuel_tank_liters / LITERS_PER_M3 - fuel_m3_;
+  const double ullage_pa = pressure_pa(NITROGEN, ullage_kg_, ullage_m3);
+
+  // Flows at the start of the step.
+  const double gox_regulator_kg_s = regulator_flow_kg_s(
+      OXYGEN, config_.gox_regulator_cv, pa(config_.gox_regulator_psia),
+      gox_bottle_pa, gox_line_pa);
+  const double fuel_regulator_kg_s = regulator_flow_kg_s(
+      NITROGEN, config_.fuel_regulator_cv, pa(config_.fuel_regulator_psia),
+      n2_bottle_pa, n2_line_pa);
+  const double pressurize_kg_s = gas_valve_flow_kg_s(
+      config_.pressurize_valve_cv * position(PlantValve::kPressurizeFuelTank),
+      NITROGEN, t_k, psia(n2_line_pa), psia(ullage_pa));
+  solve_gox_manifold(gox_line_pa, position(PlantValve::kN2PurgeGox),
+                     position(PlantValve::kGoxRelease));
+  solve_fuel_feed(ullage_pa, position(PlantValve::kFuelRelease));
+
+  gox_bottle_kg_ -= gox_regulator_kg_s * dt_s;
+  gox_line_kg_ += (gox_regulator_kg_s - gox_flow_kg_s_) * dt_s;
+  n2_bottle_kg_ -= fuel_regulator_kg_s * dt_s;
+  n2_line_kg_ += (fuel_regulator_kg_s - pressurize_kg_s) * dt_s;
+  ullage_kg_ += pressurize_kg_s * dt_s;
+  fuel_m3_ = std::max(0.0, fuel_m3_ - fuel_flow_kg_s_ / config_.fuel_density *
+                                          dt_s);
+
+  // Lit by the igniter, and burning for as long as both propellants flow.
+  const double min_flow = config_.ignition_min_flow_kg_s;
+  ignited_ = (ignited_ || igniter_) && gox_flow_kg_s_ >= min_flow &&
+             fuel_flow_kg_s_ >= min_flow;
+  double steady_pa;
+  if (ignited_) {
+    steady_pa = (gox_flow_kg_s_ + fuel_flow_kg_s_ + purge_flow_kg_s_) *
+                config_.c_star_m_s / config_.throat_m2;
+  } else {
+    // Cold gas through a choked throat: c* = sqrt(R T / M) / Gamma.
+    const double gamma = OXYGEN.gamma;
+    const double big_gamma =
+        std::sqrt(gamma) *
+        std::pow(2 / (gamma + 1), (gamma + 1) / (2 * (gamma - 1)));
+    const double cold_c_star =
+        std::sqrt(GAS_CONSTANT * t_k / manifold_molar_mass_kg_) / big_gamma;
+    steady_pa = (gox_flow_kg_s_ + purge_flow_kg_s_) * cold_c_star /
+                config_.throat_m2;
+  }
+  steady_pa = std::max(steady_pa, pa(config_.ambient_psia));
+  chamber_pa_ += (steady_pa - chamber_pa_) *
+                 std::min(1.0, dt_s / config_.chamber_time_constant_s);
+  t_s_ += dt_s;
+}
@@ -0,0 +1,123 @@
+#include "sim/hx711_sim.h"
+
+#include <hal/linux.h>
+#include <hal/timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+constexpr int HX711_BITS = 24;
+constexpr int32_t HX711_MAX_CODE = (1 << (HX711_BITS - 1)) - 1;
+constexpr int32_t HX711_MIN_CODE = -(1 << (HX711_BITS - 1));
+// PD_SCK high this long powers the chip down.
+constexpr uint64_t HX711_POWER_DOWN_US = 60;
+
+void on_clock(void* ctx, hal_gpio_t pin, int level) {
+  static_cast<Hx711Sim*>(ctx)->clock(level);
+}
+
+int sense_dout(void* ctx, hal_gpio_t pin) {
+  return static_cast<Hx711Sim*>(ctx)->dout();
+}
+
+}  // namespace
+
+Hx711Sim::Hx711Sim(double avdd_v, double rate_hz)
+    : avdd_v_(avdd_v),
+      rate_hz_(rate_hz),
+      inputs_{[](double) { return 0.0; }, [](double) { return 0.0; }},
+      now_s_([] { return hal_time_us() * 1e-6; }) {}
+
+Hx711Sim::~Hx711Sim() {
+  if (dout_ != HAL_GPIO_NC) {
+    hal_linux_gpio_sense(dout_, nullptr, nullptr);
+    hal_linux_gpio_watch(pd_sck_, nullptr, nullptr);
+  }
+}
+
+void Hx711Sim::attach(hal_gpio_t dout, hal_gpio_t pd_sck) {
+  dout_ = dout;
+  pd_sck_ = pd_sck;
+  hal_linux_gpio_sense(dout, sense_dout, this);
+  hal_linux_gpio_watch(pd_sck, on_clock, this);
+}
+
+void Hx711Sim::set_input(Hx711Input input,
+                         std::function<double(double t_s)> volts) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  inputs_[static_cast<int>(input)] = std::move(volts);
+}
+
+void Hx711Sim::set_time_source(std::function<double()> now_s) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  now_s_ = std::move(now_s);
+}
+
+void Hx711Sim::set_paced(bool paced) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  paced_ = paced;
+}
+
+int32_t Hx711Sim::code_for(double volts, int gain) const {
+  const double full_scale_v = 0.5 * avdd_v_ / gain;
+  const double code = std::floor(volts / full_scale_v * (HX711_MAX_CODE + 1));
+  return static_cast<int32_t>(
+      std::clamp<double>(code, HX711_MIN_CODE, HX711_MAX_CODE));
+}
+
+void Hx711Sim::clock(int level) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (level == sck_level_) {
+    return;
+  }
+  sck_level_ = level;
+  if (!level) {
+    if (hal_time_us() - rise_us_ >= HX711_POWER_DOWN_US) {
+      stats_.long_pulses++;
+    }
+    return;
+  }
+
+  rise_us_ = hal_time_us();
+  if (!latched_ || pulses_ == HX711_BITS + 3) {
+    stats_.stray_pulses++;
+    return;
+  }
+  if (++pulses_ == HX711_BITS + 1) {
+    // The data is out; the next conversion starts now.
+    stats_.conversions++;
+    ready_at_s_ = now_s_() + 1 / rate_hz_;
+  }
+}
+
+int Hx711Sim::dout() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (latched_ && pulses_ <= HX711_BITS) {
+    return pulses_ == 0 ? 0 : data_ >> (HX711_BITS - pulses_) & 1;
+  }
+  const double t_s = now_s_();
+  if (paced_ && t_s < ready_at_s_) {
+    return 1;
+  }
+  if (latched_) {
+    gain_pulses_ = pulses_ - HX711_BITS;
+  }
+  // Gain pulses: 1 for A at 128, 2 for B at 32, 3 for A at 64.
+  static constexpr int GAINS[] = {128, 32, 64};
+  const Hx711Input input = gain_pulses_ == 2 ? Hx711Input::kB : Hx711Input::kA;
+  const int32_t code = code_for(inputs_[static_cast<int>(input)](t_s),
+                                GAINS[gain_pulses_ - 1]);
+  data_ = static_cast<uint32_t>(code) & ((1u << HX711_BITS) - 1);
+  latched_ = true;
+  pulses_ = 0;
+  return 0;
+}
+
+Hx711SimStats Hx711Sim::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
@@ -0,0 +1,205 @@
+#include "sim/mcp320x_sim.h"
+
+#include <hal/linux.h>
+#include <hal/timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace {
+
+constexpr int MCP320X_BITS = 12;
+constexpr uint16_t MCP320X_MAX_CODE = (1 << MCP320X_BITS) - 1;
+constexpr double MCP320X_MIN_CLOCK_HZ = 10e3;
+
+// Where DIN and DOUT are within a transfer, clock by clock.
+enum class Phase {
+  kStart,
+  kMode,
+  kSelect,
+  kSample,
+  kNull,
+  kMsbFirst,
+  kLsbFirst,
+  kDone,
+};
+
+void answer(void* ctx, uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+            size_t len) {
+  static_cast<Mcp320xSim*>(ctx)->transfer(clock_hz, tx, rx, len);
+}
+
+}  // namespace
+
+Mcp320xSim::Mcp320xSim(Mcp320xModel model, double reference_v,
+                       double supply_v, uint32_t seed)
+    : model_(model),
+      reference_v_(reference_v),
+      supply_v_(supply_v),
+      inputs_(static_cast<int>(model), [](double) { return 0.0; }),
+      noise_v_(static_cast<int>(model), 0.0),
+      now_s_([] { return hal_time_us() * 1e-6; }),
+      rng_(seed) {}
+
+Mcp320xSim::~Mcp320xSim() {
+  if (cs_ != HAL_GPIO_NC) {
+    hal_linux_spi_attach(host_, cs_, nullptr, nullptr);
+  }
+}
+
+void Mcp320xSim::attach(hal_spi_host_t host, hal_gpio_t cs) {
+  host_ = host;
+  cs_ = cs;
+  hal_linux_spi_attach(host, cs, answer, this);
+}
+
+void Mcp320xSim::set_waveform(int channel, const AdcWaveform& waveform) {
+  set_input(channel, [waveform](double t_s) {
+    return waveform.offset_v +
+           waveform.amplitude_v *
+               std::sin(2 * M_PI * waveform.frequency_hz * t_s);
+  });
+  std::lock_guard<std::mutex> lock(mutex_);
+  noise_v_.at(channel) = waveform.noise_v;
+}
+
+void Mcp320xSim::set_input(int channel,
+                           std::function<double(double t_s)> input) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  inputs_.at(channel) = std::move(input);
+}
+
+void Mcp320xSim::set_time_source(std::function<double()> now_s) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  now_s_ = std::move(now_s);
+}
+
+void Mcp320xSim::set_paced(bool paced) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  paced_ = paced;
+}
+
+void Mcp320xSim::transfer(uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+                          size_t len) {
+  const int64_t start_us = hal_time_us();
+  std::unique_lock<std::mutex> lock(mutex_);
+  const double t0_s = now_s_();
+  const double bit_s = 1.0 / clock_hz;
+  const size_t bits = len * 8;
+  stats_.transfers++;
+  stats_.bus_time_ns += static_cast<uint64_t>(bits * bit_s * 1e9);
+  if (clock_hz < MCP320X_MIN_CLOCK_HZ || clock_hz > max_clock_hz()) {
+    stats_.out_of_spec_clock++;
+  }
+
+  Phase phase = Phase::kStart;
+  bool single = false;
+  int select = 0;
+  int select_bits = 0;
+  int bit = 0;
+  uint16_t code = 0;
+  std::fill(rx, rx + len, 0);
+  for (size_t i = 0; i < bits; i++) {
+    const bool din = tx[i / 8] & (0x80 >> (i % 8));
+    bool dout = true;  // High impedance.
+    switch (phase) {
+      case Phase::kStart:
+        if (din) {
+          phase = Phase::kMode;
+        }
+        break;
+      case Phase::kMode:
+        single = din;
+        phase = Phase::kSelect;
+        break;
+      case Phase::kSelect:
+        select = select << 1 | din;
+        if (++select_bits == 3) {
+          phase = Phase::kSample;
+        }
+        break;
+      case Phase::kSample:
+        // The sample period ends on this clock's falling edge.
+        code = convert(single, select, t0_s + (i + 0.5) * bit_s);
+        phase = Phase::kNull;
+        break;
+      case Phase::kNull:
+        dout = false;
+        bit = MCP320X_BITS - 1;
+        phase = Phase::kMsbFirst;
+        break;
+      case Phase::kMsbFirst:
+        dout = code >> bit & 1;
+        if (bit-- == 0) {
+          stats_.conversions++;
+          bit = 1;
+          phase = Phase::kLsbFirst;
+        }
+        break;
+      case Phase::kLsbFirst:
+        dout = code >> bit & 1;
+        if (++bit == MCP320X_BITS) {
+          phase = Phase::kDone;
+        }
+        break;
+      case Phase::kDone:
+        dout = false;
+        break;
+    }
+    if (dout) {
+      rx[i / 8] |= 0x80 >> (i % 8);
+    }
+  }
+  if (phase != Phase::kStart && phase != Phase::kLsbFirst &&
+      phase != Phase::kDone) {
+    stats_.truncated++;
+  }
+
+  const bool paced = paced_;
+  lock.unlock();
+  if (paced) {
+    const int64_t end_us =
+        start_us + static_cast<int64_t>(bits * bit_s * 1e6);
+    while (hal_time_us() < end_us) {
+    }
+  }
+}
+
+uint16_t Mcp320xSim::code_for(double volts) const {
+  double code = std::floor(volts / reference_v_ * (MCP320X_MAX_CODE + 1));
+  return static_cast<uint16_t>(std::clamp<double>(code, 0, MCP320X_MAX_CODE));
+}
+
+double Mcp320xSim::max_clock_hz() const {
+  // Datasheet: 2 MHz at VDD = 5 V and 1 MHz at 2.7 V, interpolated.
+  double fraction = std::clamp((supply_v_ - 2.7) / (5.0 - 2.7), 0.0, 1.0);
+  return 1e6 + fraction * 1e6;
+}
+
+Mcp320xSimStats Mcp320xSim::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+double Mcp320xSim::sample(int channel, double t_s) {
+  double noise = noise_v_[channel] > 0 ? noise_v_[channel] * normal_(rng_) : 0;
+  return inputs_[channel](t_s) + noise;
+}
+
+uint16_t Mcp320xSim::convert(bool single, int select, double t_s) {
+  const int channels = static_cast<int>(model_);
+  // D2 is "don't care" on the MCP3204.
+  select &= channels - 1;
+  if (single) {
+    return code_for(sample(select, t_s));
+  }
+  // Differential pairs: CH0/CH1, CH2/CH3, ... with the odd select bit
+  // swapping IN+ and IN-.
+  const int even = select & ~1;
+  const int positive = select & 1 ? even + 1 : even;
+  const int negative = select & 1 ? even : even + 1;
+  return code_for(sample(positive, t_s) - sample(negative, t_s));
+}
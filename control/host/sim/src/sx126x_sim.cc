@@ -0,0 +1,827 @@
+#include "sim/sx126x_sim.h"
+
+#include <hal/linux.h>
+#include <hal/timer.h>
+#include <ra01s.h>
+#include <telemetry/lora_airtime.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace {
+
+constexpr size_t SX126X_REGISTER_SPACE = 0x1000;
+// Units of the SetTx, SetRx and SetCadParams timeouts.
+constexpr double SX126X_TIMER_STEP_US = 15.625;
+// Noise floor reported by GetRssiInst when nothing is on air.
+constexpr int SX126X_NOISE_FLOOR_DBM = -120;
+
+// How long BUSY stays high after a command, roughly as in the datasheet's
+// switching times. Register, buffer and status access finish before a driver
+// can poll BUSY.
+constexpr uint64_t SX126X_MODE_SWITCH_BUSY_US = 50;
+constexpr uint64_t SX126X_CALIBRATE_BUSY_US = 3500;
+constexpr uint64_t SX126X_CALIBRATE_IMAGE_BUSY_US = 1000;
+// Cold start, after reset or sleep.
+constexpr uint64_t SX126X_STARTUP_BUSY_US = 3500;
+
+// Values of the status byte's command status field.
+constexpr uint8_t STATUS_OK = 1;
+constexpr uint8_t STATUS_DATA_AVAILABLE = 2;
+constexpr uint8_t STATUS_INVALID = 4;
+constexpr uint8_t STATUS_TX_DONE = 6;
+
+void answer(void* ctx, uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+            size_t len) {
+  static_cast<Sx126xSim*>(ctx)->transfer(clock_hz, tx, rx, len);
+}
+
+uint32_t be24(const uint8_t* bytes) {
+  return bytes[0] << 16 | bytes[1] << 8 | bytes[2];
+}
+
+// Parameter bytes each command needs; -1 for unknown opcodes.
+int parameter_count(uint8_t opcode) {
+  switch (opcode) {
+    case SX126X_CMD_GET_STATUS:
+    case SX126X_CMD_GET_IRQ_STATUS:
+    case SX126X_CMD_GET_RX_BUFFER_STATUS:
+    case SX126X_CMD_GET_PACKET_STATUS:
+    case SX126X_CMD_GET_RSSI_INST:
+    case SX126X_CMD_GET_PACKET_TYPE:
+    case SX126X_CMD_GET_DEVICE_ERRORS:
+    case SX126X_CMD_GET_STATS:
+    case SX126X_CMD_SET_FS:
+    case SX126X_CMD_SET_CAD:
+    case SX126X_CMD_SET_TX_CONTINUOUS_WAVE:
+    case SX126X_CMD_SET_TX_INFINITE_PREAMBLE:
+      return 0;
+    case SX126X_CMD_SET_SLEEP:
+    case SX126X_CMD_SET_STANDBY:
+    case SX126X_CMD_STOP_TIMER_ON_PREAMBLE:
+    case SX126X_CMD_SET_REGULATOR_MODE:
+    case SX126X_CMD_CALIBRATE:
+    case SX126X_CMD_SET_RX_TX_FALLBACK_MODE:
+    case SX126X_CMD_SET_DIO2_AS_RF_SWITCH_CTRL:
+    case SX126X_CMD_SET_PACKET_TYPE:
+    case SX126X_CMD_SET_LORA_SYMB_NUM_TIMEOUT:
+    case SX126X_CMD_READ_BUFFER:
+    case SX126X_CMD_WRITE_BUFFER:
+      return 1;
+    case SX126X_CMD_CALIBRATE_IMAGE:
+    case SX126X_CMD_CLEAR_IRQ_STATUS:
+    case SX126X_CMD_SET_TX_PARAMS:
+    case SX126X_CMD_SET_BUFFER_BASE_ADDRESS:
+    case SX126X_CMD_CLEAR_DEVICE_ERRORS:
+    case SX126X_CMD_READ_REGISTER:
+    case SX126X_CMD_WRITE_REGISTER:
+      return 2;
+    case SX126X_CMD_SET_TX:
+    case SX126X_CMD_SET_RX:
+      return 3;
+    case SX126X_CMD_SET_PA_CONFIG:
+    case SX126X_CMD_SET_DIO3_AS_TCXO_CTRL:
+    case SX126X_CMD_SET_RF_FREQUENCY:
+    case SX126X_CMD_SET_MODULATION_PARAMS:
+      return 4;
+    case SX126X_CMD_SET_RX_DUTY_CYCLE:
+    case SX126X_CMD_SET_PACKET_PARAMS:
+      return 6;
+    case SX126X_CMD_SET_CAD_PARAMS:
+      return 7;
+    case SX126X_CMD_SET_DIO_IRQ_PARAMS:
+      return 8;
+    default:
+      return -1;
+  }
+}
+
+uint64_t busy_time_us(uint8_t opcode) {
+  switch (opcode) {
+    case SX126X_CMD_SET_FS:
+    case SX126X_CMD_SET_TX:
+    case SX126X_CMD_SET_RX:
+    case SX126X_CMD_SET_CAD:
+      return SX126X_MODE_SWITCH_BUSY_US;
+    case SX126X_CMD_CALIBRATE:
+      return SX126X_CALIBRATE_BUSY_US;
+    case SX126X_CMD_CALIBRATE_IMAGE:
+      return SX126X_CALIBRATE_IMAGE_BUSY_US;
+    default:
+      return 0;
+  }
+}
+
+void put(uint8_t* rx, size_t rx_len, size_t index, uint8_t value) {
+  if (index < rx_len) {
+    rx[index] = value;
+  }
+}
+
+}  // namespace
+
+LoraChannel::LoraChannel(const LoraChannelConfig& config)
+    : config_(config),
+      rng_(config.seed),
+      chance_(0, 1),
+      worker_([this] { run(); }) {}
+
+LoraChannel::~LoraChannel() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  wake_.notify_all();
+  worker_.join();
+}
+
+LoraChannelStats LoraChannel::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void LoraChannel::add(Sx126xSim* radio) { radios_.push_back(radio); }
+
+void LoraChannel::remove(Sx126xSim* radio) {
+  radios_.erase(std::remove(radios_.begin(), radios_.end(), radio),
+                radios_.end());
+  for (Transmission& transmission : transmissions_) {
+    if (transmission.sender == radio) {
+      transmission.aborted = true;
+    }
+  }
+  for (auto it = events_.begin(); it != events_.end();) {
+    it = it->second.owner == radio ? events_.erase(it) : std::next(it);
+  }
+}
+
+void LoraChannel::schedule(uint64_t at_us, const Sx126xSim* owner,
+                           std::function<void()> fn) {
+  events_.emplace(at_us, Event{owner, std::move(fn)});
+  wake_.notify_all();
+}
+
+void LoraChannel::defer(std::function<void()> fn) {
+  deferred_.push_back(std::move(fn));
+}
+
+LoraChannel::Transmission* LoraChannel::begin_transmission(
+    const Sx126xSim* sender, uint64_t start_us, uint64_t end_us) {
+  // Forget transmissions that can no longer overlap anything: none lasts
+  // longer than a few seconds.
+  while (!transmissions_.empty() &&
+         transmissions_.front().end_us + 10 * 1000 * 1000 < start_us) {
+    transmissions_.pop_front();
+  }
+  stats_.transmissions++;
+  transmissions_.push_back(Transmission{sender, start_us, end_us, false});
+  return &transmissions_.back();
+}
+
+void LoraChannel::end_transmission(Transmission* transmission,
+                                   const std::vector<uint8_t>& payload) {
+  const Sx126xSim& sender = *transmission->sender;
+  bool collided = false;
+  for (const Transmission& other : transmissions_) {
+    if (&other != transmission && !other.aborted &&
+        other.start_us < transmission->end_us &&
+        transmission->start_us < other.end_us &&
+        sender.hears(*other.sender)) {
+      collided = true;
+    }
+  }
+  if (collided) {
+    stats_.collisions++;
+    return;
+  }
+  if (chance_(rng_) < config_.loss_rate) {
+    stats_.lost++;
+    return;
+  }
+  std::vector<uint8_t> received = payload;
+  bool corrupted = false;
+  if (!received.empty() && chance_(rng_) < config_.corrupt_rate) {
+    size_t bit = static_cast<size_t>(chance_(rng_) * received.size() * 8);
+    received[bit / 8] ^= 1 << bit % 8;
+    corrupted = true;
+    stats_.corrupted++;
+  }
+  for (Sx126xSim* radio : radios_) {
+    if (radio != &sender && radio->mode_ == Sx126xSim::Mode::kRx &&
+        radio->rx_since_us_ <= transmission->start_us && radio->hears(sender)) {
+      radio->deliver(received, !(corrupted && sender.settings_.crc_on));
+      if (!corrupted) {
+        stats_.delivered++;
+      }
+    }
+  }
+}
+
+bool LoraChannel::busy(const Sx126xSim* listener, uint64_t from_us,
+                       uint64_t to_us) const {
+  for (const Transmission& transmission : transmissions_) {
+    if (!transmission.aborted && transmission.sender != listener &&
+        transmission.start_us < to_us && from_us < transmission.end_us &&
+        listener->hears(*transmission.sender)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LoraChannel::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_) {
+    if (events_.empty()) {
+      wake_.wait(lock);
+      continue;
+    }
+    const uint64_t next_us = events_.begin()->first;
+    const uint64_t now_us = hal_time_us();
+    if (next_us > now_us) {
+      wake_.wait_for(lock, std::chrono::microseconds(next_us - now_us));
+      continue;
+    }
+    std::function<void()> event = std::move(events_.begin()->second.fn);
+    events_.erase(events_.begin());
+    event();
+    if (!deferred_.empty()) {
+      std::vector<std::function<void()>> deferred;
+      deferred.swap(deferred_);
+      lock.unlock();
+      for (std::function<void()>& fn : deferred) {
+        fn();
+      }
+      lock.lock();
+    }
+  }
+}
+
+Sx126xSim::Sx126xSim(LoraChannel* channel)
+    : channel_(channel), registers_(SX126X_REGISTER_SPACE) {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  reset();
+  channel_->add(this);
+}
+
+Sx126xSim::~Sx126xSim() {
+  if (nss_ != HAL_GPIO_NC) {
+    hal_linux_spi_attach(host_, nss_, nullptr, nullptr);
+  }
+  if (pins_.busy != HAL_GPIO_NC) {
+    hal_linux_gpio_sense(pins_.busy, nullptr, nullptr);
+  }
+  if (pins_.reset != HAL_GPIO_NC) {
+    hal_linux_gpio_watch(pins_.reset, nullptr, nullptr);
+  }
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  epoch_++;
+  channel_->remove(this);
+}
+
+void Sx126xSim::attach(hal_spi_host_t host, hal_gpio_t nss,
+                       const Sx126xPins& pins) {
+  host_ = host;
+  nss_ = nss;
+  pins_ = pins;
+  hal_linux_spi_attach(host, nss, answer, this);
+  if (pins.busy != HAL_GPIO_NC) {
+    hal_linux_gpio_sense(
+        pins.busy,
+        [](void* ctx, hal_gpio_t) {
+          auto* radio = static_cast<Sx126xSim*>(ctx);
+          const uint64_t now_us = hal_time_us();
+          bool busy =
+              radio->in_reset_ || now_us < radio->busy_until_us_.load();
+          if (busy) {
+            radio->busy_reads_++;
+          }
+          return busy ? 1 : 0;
+        },
+        this);
+  }
+  if (pins.reset != HAL_GPIO_NC) {
+    hal_linux_gpio_watch(
+        pins.reset,
+        [](void* ctx, hal_gpio_t, int level) {
+          auto* radio = static_cast<Sx126xSim*>(ctx);
+          if (level == 0) {
+            radio->in_reset_ = true;
+            return;
+          }
+          if (radio->in_reset_.exchange(false)) {
+            std::lock_guard<std::mutex> lock(radio->channel_->mutex_);
+            radio->reset();
+            radio->busy_until_us_ = hal_time_us() + SX126X_STARTUP_BUSY_US;
+          }
+        },
+        this);
+  }
+}
+
+void Sx126xSim::transfer(uint32_t clock_hz, const uint8_t* tx, uint8_t* rx,
+                         size_t len) {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  const uint64_t now_us = hal_time_us();
+  stats_.transfers++;
+  stats_.bus_time_ns += static_cast<uint64_t>(len * 8 * 1e9 / clock_hz);
+  std::fill(rx, rx + len, 0);
+  if (in_reset_ || now_us < busy_until_us_) {
+    stats_.busy_violations++;
+    return;
+  }
+  if (mode_ == Mode::kSleep) {
+    // NSS wakes the chip; the command itself is lost.
+    set_mode(Mode::kStandbyRc, now_us);
+    busy_until_us_ = now_us + SX126X_STARTUP_BUSY_US;
+    return;
+  }
+  if (len == 0) {
+    return;
+  }
+
+  // The status byte comes out on the opcode's second byte onwards, with the
+  // state from before the command.
+  rx[0] = 0;
+  std::fill(rx + 1, rx + len, status());
+  const uint8_t opcode = tx[0];
+  const int needed = parameter_count(opcode);
+  stats_.commands++;
+  if (needed < 0 || len - 1 < static_cast<size_t>(needed)) {
+    stats_.invalid_commands++;
+    last_command_status_ = STATUS_INVALID;
+    std::fill(rx + 1, rx + len, status());
+    return;
+  }
+  last_command_status_ = STATUS_OK;
+  execute(opcode, tx + 1, len - 1, rx, len, now_us);
+  busy_until_us_ = now_us + busy_time_us(opcode);
+}
+
+void Sx126xSim::configure(const Sx126xSettings& settings) {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  settings_ = settings;
+  registers_[SX126X_REG_LORA_SYNC_WORD_MSB] = settings.sync_word >> 8;
+  registers_[SX126X_REG_LORA_SYNC_WORD_LSB] = settings.sync_word & 0xFF;
+}
+
+Sx126xSettings Sx126xSim::settings() const {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  Sx126xSettings settings = settings_;
+  settings.sync_word = registers_[SX126X_REG_LORA_SYNC_WORD_MSB] << 8 |
+                       registers_[SX126X_REG_LORA_SYNC_WORD_LSB];
+  return settings;
+}
+
+void Sx126xSim::listen() {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  listening_ = true;
+  start_rx(SX126X_RX_TIMEOUT_INF, hal_time_us());
+}
+
+bool Sx126xSim::send(const uint8_t* data, size_t len) {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  if (mode_ == Mode::kTx || len > sizeof(buffer_)) {
+    return false;
+  }
+  for (size_t i = 0; i < len; i++) {
+    buffer_[(tx_base_ + i) & 0xFF] = data[i];
+  }
+  if (!settings_.implicit_header) {
+    settings_.payload_length = len;
+  }
+  start_tx(0, hal_time_us());
+  return true;
+}
+
+bool Sx126xSim::transmitting() const {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  return mode_ == Mode::kTx;
+}
+
+void Sx126xSim::on_receive(ReceiveFn fn) {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  on_receive_ = std::move(fn);
+}
+
+uint32_t Sx126xSim::time_on_air_us(size_t len) const {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  return airtime_us(len);
+}
+
+uint32_t Sx126xSim::airtime_us(size_t len) const {
+  const LoRaModulation modulation = {
+      .spreading_factor = settings_.spreading_factor,
+      .bandwidth_hz = lora_bandwidth_hz(settings_.bandwidth),
+      .coding_rate = settings_.coding_rate,
+      .preamble_length = settings_.preamble_length,
+      .explicit_header = !settings_.implicit_header,
+      .crc_on = settings_.crc_on,
+      .low_data_rate_optimize = settings_.low_data_rate_optimize,
+  };
+  return lora_time_on_air_us(modulation, len);
+}
+
+Sx126xSimStats Sx126xSim::stats() const {
+  std::lock_guard<std::mutex> lock(channel_->mutex_);
+  Sx126xSimStats stats = stats_;
+  stats.busy_reads = busy_reads_;
+  return stats;
+}
+
+void Sx126xSim::reset() {
+  epoch_++;
+  mode_ = Mode::kStandbyRc;
+  listening_ = false;
+  fallback_ = SX126X_RX_TX_FALLBACK_MODE_STDBY_RC;
+  last_command_status_ = STATUS_OK;
+  std::fill(registers_.begin(), registers_.end(), 0);
+  registers_[SX126X_REG_LORA_SYNC_WORD_MSB] = SX126X_SYNC_WORD_PRIVATE >> 8;
+  registers_[SX126X_REG_LORA_SYNC_WORD_LSB] = SX126X_SYNC_WORD_PRIVATE & 0xFF;
+  registers_[SX126X_REG_IQ_POLARITY_SETUP] = 0x0D;
+  registers_[SX126X_REG_OCP_CONFIGURATION] = 0x38;
+  std::fill(std::begin(buffer_), std::end(buffer_), 0);
+  tx_base_ = 0;
+  rx_base_ = 0;
+  // Power-on defaults: GFSK, 915 MHz, SF7 at 125 kHz once LoRa is selected.
+  settings_ = Sx126xSettings{
+      .frequency_hz = 915000000,
+      .packet_type = SX126X_PACKET_TYPE_GFSK,
+      .spreading_factor = 7,
+      .bandwidth = SX126X_LORA_BW_125_0,
+      .coding_rate = SX126X_LORA_CR_4_5,
+      .low_data_rate_optimize = false,
+      .preamble_length = 12,
+      .implicit_header = false,
+      .payload_length = 0xFF,
+      .crc_on = true,
+      .invert_iq = false,
+      .sync_word = SX126X_SYNC_WORD_PRIVATE,
+  };
+  irq_ = 0;
+  irq_mask_ = 0;
+  dio1_mask_ = 0;
+  update_dio1();
+  rx_length_ = 0;
+  rx_start_ = 0;
+  stat_received_ = 0;
+  stat_crc_errors_ = 0;
+}
+
+uint8_t Sx126xSim::status() const {
+  uint8_t mode = 0;
+  switch (mode_) {
+    case Mode::kSleep:
+      mode = 0;
+      break;
+    case Mode::kStandbyRc:
+      mode = 2;
+      break;
+    case Mode::kStandbyXosc:
+      mode = 3;
+      break;
+    case Mode::kFs:
+      mode = 4;
+      break;
+    case Mode::kRx:
+    case Mode::kCad:
+      mode = 5;
+      break;
+    case Mode::kTx:
+      mode = 6;
+      break;
+  }
+  uint8_t command_status = last_command_status_;
+  if (command_status == STATUS_OK) {
+    if (irq_ & SX126X_IRQ_RX_DONE) {
+      command_status = STATUS_DATA_AVAILABLE;
+    } else if (irq_ & SX126X_IRQ_TX_DONE) {
+      command_status = STATUS_TX_DONE;
+    }
+  }
+  return mode << 4 | command_status << 1;
+}
+
+void Sx126xSim::execute(uint8_t opcode, const uint8_t* args, size_t arg_len,
+                        uint8_t* rx, size_t rx_len, uint64_t now_us) {
+  switch (opcode) {
+    case SX126X_CMD_GET_STATUS:
+      break;
+    case SX126X_CMD_GET_IRQ_STATUS:
+      put(rx, rx_len, 2, irq_ >> 8);
+      put(rx, rx_len, 3, irq_ & 0xFF);
+      break;
+    case SX126X_CMD_GET_RX_BUFFER_STATUS:
+      put(rx, rx_len, 2, rx_length_);
+      put(rx, rx_len, 3, rx_start_);
+      break;
+    case SX126X_CMD_GET_PACKET_STATUS: {
+      const uint8_t rssi = -2 * channel_->config_.rssi_dbm;
+      put(rx, rx_len, 2, rssi);
+      put(rx, rx_len, 3, static_cast<uint8_t>(4 * channel_->config_.snr_db));
+      put(rx, rx_len, 4, rssi);
+      break;
+    }
+    case SX126X_CMD_GET_RSSI_INST: {
+      const bool on_air =
+          mode_ == Mode::kRx && channel_->busy(this, now_us, now_us + 1);
+      put(rx, rx_len, 2,
+          -2 * (on_air ? channel_->config_.rssi_dbm : SX126X_NOISE_FLOOR_DBM));
+      break;
+    }
+    case SX126X_CMD_GET_PACKET_TYPE:
+      put(rx, rx_len, 2, settings_.packet_type);
+      break;
+    case SX126X_CMD_GET_DEVICE_ERRORS:
+      put(rx, rx_len, 2, 0);
+      put(rx, rx_len, 3, 0);
+      break;
+    case SX126X_CMD_GET_STATS:
+      put(rx, rx_len, 2, stat_received_ >> 8);
+      put(rx, rx_len, 3, stat_received_ & 0xFF);
+      put(rx, rx_len, 4, stat_crc_errors_ >> 8);
+      put(rx, rx_len, 5, stat_crc_errors_ & 0xFF);
+      put(rx, rx_len, 6, 0);
+      put(rx, rx_len, 7, 0);
+      break;
+    case SX126X_CMD_READ_REGISTER: {
+      const uint16_t address = args[0] << 8 | args[1];
+      for (size_t i = 4; i < rx_len; i++) {
+        const size_t reg = address + i - 4;
+        rx[i] = reg < registers_.size() ? registers_[reg] : 0;
+      }
+      break;
+    }
+    case SX126X_CMD_WRITE_REGISTER: {
+      const uint16_t address = args[0] << 8 | args[1];
+      for (size_t i = 2; i < arg_len; i++) {
+        if (address + i - 2 < registers_.size()) {
+          registers_[address + i - 2] = args[i];
+        }
+      }
+      break;
+    }
+    case SX126X_CMD_READ_BUFFER:
+      for (size_t i = 3; i < rx_len; i++) {
+        rx[i] = buffer_[(args[0] + i - 3) & 0xFF];
+      }
+      break;
+    case SX126X_CMD_WRITE_BUFFER:
+      for (size_t i = 1; i < arg_len; i++) {
+        buffer_[(args[0] + i - 1) & 0xFF] = args[i];
+      }
+      break;
+    case SX126X_CMD_SET_SLEEP:
+      set_mode(Mode::kSleep, now_us);
+      break;
+    case SX126X_CMD_SET_STANDBY:
+      set_mode(args[0] == SX126X_STANDBY_XOSC ? Mode::kStandbyXosc
+                                              : Mode::kStandbyRc,
+               now_us);
+      break;
+    case SX126X_CMD_SET_FS:
+      set_mode(Mode::kFs, now_us);
+      break;
+    case SX126X_CMD_SET_TX:
+      listening_ = false;
+      start_tx(be24(args), now_us);
+      break;
+    case SX126X_CMD_SET_RX:
+      listening_ = false;
+      start_rx(be24(args), now_us);
+      break;
+    case SX126X_CMD_SET_RX_DUTY_CYCLE:
+      // Modeled as continuous receive: the sleep windows only save power.
+      start_rx(SX126X_RX_TIMEOUT_INF, now_us);
+      break;
+    case SX126X_CMD_SET_CAD:
+      start_cad(now_us);
+      break;
+    case SX126X_CMD_SET_TX_CONTINUOUS_WAVE:
+    case SX126X_CMD_SET_TX_INFINITE_PREAMBLE:
+      set_mode(Mode::kTx, now_us);
+      break;
+    case SX126X_CMD_SET_RX_TX_FALLBACK_MODE:
+      fallback_ = args[0];
+      break;
+    case SX126X_CMD_SET_DIO_IRQ_PARAMS:
+      irq_mask_ = args[0] << 8 | args[1];
+      dio1_mask_ = args[2] << 8 | args[3];
+      update_dio1();
+      break;
+    case SX126X_CMD_CLEAR_IRQ_STATUS:
+      irq_ &= ~(args[0] << 8 | args[1]);
+      update_dio1();
+      break;
+    case SX126X_CMD_SET_RF_FREQUENCY: {
+      const uint32_t steps =
+          args[0] << 24 | args[1] << 16 | args[2] << 8 | args[3];
+      settings_.frequency_hz = static_cast<uint32_t>(steps * FREQ_STEP + 0.5);
+      break;
+    }
+    case SX126X_CMD_SET_PACKET_TYPE:
+      settings_.packet_type = args[0];
+      break;
+    case SX126X_CMD_SET_MODULATION_PARAMS:
+      settings_.spreading_factor = args[0];
+      settings_.bandwidth = args[1];
+      settings_.coding_rate = args[2];
+      settings_.low_data_rate_optimize = args[3] != 0;
+      break;
+    case SX126X_CMD_SET_PACKET_PARAMS:
+      settings_.preamble_length = args[0] << 8 | args[1];
+      settings_.implicit_header = args[2] == SX126X_LORA_HEADER_IMPLICIT;
+      settings_.payload_length = args[3];
+      settings_.crc_on = args[4] == SX126X_LORA_CRC_ON;
+      settings_.invert_iq = args[5] == SX126X_LORA_IQ_INVERTED;
+      break;
+    case SX126X_CMD_SET_CAD_PARAMS:
+      cad_symbols_ = args[0];
+      cad_exit_mode_ = args[3];
+      cad_timeout_ = be24(args + 4);
+      break;
+    case SX126X_CMD_SET_BUFFER_BASE_ADDRESS:
+      tx_base_ = args[0];
+      rx_base_ = args[1];
+      break;
+    default:
+      // Accepted without effect on the model: regulator, calibration, PA,
+      // TX power, DIO2/DIO3 control, timers and device errors.
+      break;
+  }
+}
+
+void Sx126xSim::set_mode(Mode mode, uint64_t now_us) {
+  epoch_++;
+  mode_ = mode;
+  if (mode == Mode::kRx) {
+    rx_since_us_ = now_us;
+  }
+}
+
+void Sx126xSim::start_tx(uint32_t timeout, uint64_t now_us) {
+  set_mode(Mode::kTx, now_us);
+  stats_.packets_sent++;
+  const size_t len = settings_.payload_length;
+  std::vector<uint8_t> payload(len);
+  for (size_t i = 0; i < len; i++) {
+    payload[i] = buffer_[(tx_base_ + i) & 0xFF];
+  }
+  const uint64_t end_us = now_us + airtime_us(len);
+  LoraChannel::Transmission* transmission =
+      channel_->begin_transmission(this, now_us, end_us);
+  const uint32_t epoch = epoch_;
+  if (timeout != 0) {
+    const uint64_t timeout_us =
+        now_us + static_cast<uint64_t>(timeout * SX126X_TIMER_STEP_US);
+    if (timeout_us < end_us) {
+      channel_->schedule(timeout_us, this, [this, epoch, transmission] {
+        finish_tx(epoch, true, transmission);
+      });
+      return;
+    }
+  }
+  channel_->schedule(end_us, this, [this, epoch, transmission, payload] {
+    if (epoch == epoch_) {
+      channel_->end_transmission(transmission, payload);
+    }
+    finish_tx(epoch, false, transmission);
+  });
+}
+
+void Sx126xSim::finish_tx(uint32_t epoch,
+                          bool timed_out,
+                          LoraChannel::Transmission* transmission) {
+  if (epoch != epoch_) {
+    // Left TX early: the packet went out cut short.
+    transmission->aborted = true;
+    return;
+  }
+  if (timed_out) {
+    transmission->aborted = true;
+  }
+  const uint64_t now_us = hal_time_us();
+  raise(timed_out ? SX126X_IRQ_TIMEOUT : SX126X_IRQ_TX_DONE);
+  fall_back(now_us);
+}
+
+void Sx126xSim::start_rx(uint32_t timeout, uint64_t now_us) {
+  set_mode(Mode::kRx, now_us);
+  rx_continuous_ = timeout == SX126X_RX_TIMEOUT_INF;
+  if (timeout != SX126X_RX_TIMEOUT_NONE && !rx_continuous_) {
+    const uint32_t epoch = epoch_;
+    channel_->schedule(
+        now_us + static_cast<uint64_t>(timeout * SX126X_TIMER_STEP_US), this,
+        [this, epoch] {
+          if (epoch == epoch_) {
+            raise(SX126X_IRQ_TIMEOUT);
+            fall_back(hal_time_us());
+          }
+        });
+  }
+}
+
+void Sx126xSim::start_cad(uint64_t now_us) {
+  set_mode(Mode::kCad, now_us);
+  stats_.cad_runs++;
+  // 1, 2, 4, 8 or 16 symbols, plus about one more to process them.
+  const uint32_t symbols = (1u << std::min<uint8_t>(cad_symbols_, 4)) + 1;
+  const uint64_t end_us = now_us + symbols * symbol_time_us();
+  const uint32_t epoch = epoch_;
+  channel_->schedule(end_us, this, [this, epoch, now_us, end_us] {
+    if (epoch != epoch_) {
+      return;
+    }
+    const bool detected = channel_->busy(this, now_us, end_us);
+    if (detected) {
+      stats_.cad_detections++;
+    }
+    raise(SX126X_IRQ_CAD_DONE | (detected ? SX126X_IRQ_CAD_DETECTED : 0));
+    if (detected && cad_exit_mode_ == SX126X_CAD_GOTO_RX) {
+      start_rx(cad_timeout_, end_us);
+    } else {
+      set_mode(Mode::kStandbyRc, end_us);
+    }
+  });
+}
+
+void Sx126xSim::fall_back(uint64_t now_us) {
+  if (listening_) {
+    start_rx(SX126X_RX_TIMEOUT_INF, now_us);
+  } else if (fallback_ == SX126X_RX_TX_FALLBACK_MODE_FS) {
+    set_mode(Mode::kFs, now_us);
+  } else if (fallback_ == SX126X_RX_TX_FALLBACK_MODE_STDBY_XOSC) {
+    set_mode(Mode::kStandbyXosc, now_us);
+  } else {
+    set_mode(Mode::kStandbyRc, now_us);
+  }
+}
+
+void Sx126xSim::raise(uint16_t irq) {
+  irq_ |= irq & irq_mask_;
+  update_dio1();
+}
+
+void Sx126xSim::update_dio1() {
+  const bool level = (irq_ & dio1_mask_) != 0;
+  if (level != dio1_level_) {
+    dio1_level_ = level;
+    if (pins_.dio1 != HAL_GPIO_NC) {
+      hal_linux_gpio_drive(pins_.dio1, level);
+    }
+  }
+}
+
+bool Sx126xSim::hears(const Sx126xSim& sender) const {
+  const Sx126xSettings& a = settings_;
+  const Sx126xSettings& b = sender.settings_;
+  return a.packet_type == SX126X_PACKET_TYPE_LORA &&
+         b.packet_type == SX126X_PACKET_TYPE_LORA &&
+         a.frequency_hz == b.frequency_hz &&
+         a.spreading_factor == b.spreading_factor &&
+         a.bandwidth == b.bandwidth && a.invert_iq == b.invert_iq &&
+         a.implicit_header == b.implicit_header &&
+         (!a.implicit_header || a.payload_length == b.payload_length) &&
+         registers_[SX126X_REG_LORA_SYNC_WORD_MSB] ==
+             sender.registers_[SX126X_REG_LORA_SYNC_WORD_MSB] &&
+         registers_[SX126X_REG_LORA_SYNC_WORD_LSB] ==
+             sender.registers_[SX126X_REG_LORA_SYNC_WORD_LSB];
+}
+
+void Sx126xSim::deliver(const std::vector<uint8_t>& payload, bool crc_ok) {
+  for (size_t i = 0; i < payload.size(); i++) {
+    buffer_[(rx_base_ + i) & 0xFF] = payload[i];
+  }
+  rx_length_ = payload.size();
+  rx_start_ = rx_base_;
+  stat_received_++;
+  stats_.packets_received++;
+  if (!crc_ok) {
+    stat_crc_errors_++;
+    stats_.crc_errors++;
+  }
+  raise(SX126X_IRQ_RX_DONE | (crc_ok ? 0 : SX126X_IRQ_CRC_ERR));
+  if (!rx_continuous_) {
+    fall_back(hal_time_us());
+  }
+  if (on_receive_) {
+    channel_->defer(
+        [fn = on_receive_, payload, crc_ok] {
+          fn(payload.data(), payload.size(), crc_ok);
+        });
+  }
+}
+
+uint32_t Sx126xSim::symbol_time_us() const {
+  const uint32_t bandwidth_hz = lora_bandwidth_hz(settings_.bandwidth);
+  if (bandwidth_hz == 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>((1ull << settings_.spreading_factor) * 1000000 /
+                               bandwidth_hz);
+}
@@ -0,0 +1,57 @@
+#include "acquisition.h"
+
+#include <hal/timer.h>
+
+#include <cstdint>
+
+#include "boot.h"
+#include "configs/periodic_task_config.h"
+#include "datalog.h"
+#include "deferred_log.h"
+#include "load_cell.h"
+#include "periodic_task.h"
+#include "pt.h"
+#include "stand_control.h"
+#include "telemetry.h"
+#include "trace.h"
+
+// One pass of the acquisition loop.
+static void acquire(void* arg) {
+  TRACE_ZONE(kAcquisitionLoop);
+  // int64_t start = esp_timer_get_time();
+  float psi_chamber = read_pt(Pt::kChamber);
+  uint64_t t_us = hal_time_us();
+  // Same timestamp in both, so a replay of the log sees what the stand
+  // logic saw.
+  stand_control_pt(Pt::kChamber, psi_chamber, t_us);
+  {
+    TRACE_ZONE(kLogging);
+    dlog(LogFormat::kPtReading, static_cast<unsigned>(Pt::kChamber),
+         psi_chamber);
+    datalog_pt(Pt::kChamber, psi_chamber, t_us);
+    telemetry_record(pt_channel(Pt::kChamber), psi_chamber);
+  }
+  boot_milestone(BootMilestone::kFirstSample);
+  // The HX711 converts at 10 Hz, faster than this loop runs, so its latest
+  // conversion is taken rather than waited on; none until the kLoadCell boot
+  // phase sets it up.
+  int32_t load_cell;
+  if (poll_raw_load_cell(&load_cell) == ESP_OK) {
+    TRACE_ZONE(kLogging);
+    datalog_load_cell(load_cell);
+    telemetry_record(TelemetryChannel::kLoadCell, load_cell);
+  }
+  // float psi_eth_line = read_pt(Pt::kEthLine);
+  // float psi_eth_n2 = read_pt(Pt::kEthN2Reg);
+  // float psi_gox = read_pt(Pt::kGoxLine);
+  // float psi_gox_reg = read_pt(Pt::kGoxReg);
+  // float psi_ing_eth = read_pt(Pt::kInjectorEth);
+  // float psi_inj_gox = read_pt(Pt::kInjectorGox);
+  // int64_t end = esp_timer_get_time();
+  // int64_t elapsed_us = end - start;
+  // printf("Function took %lld us\n", elapsed_us);
+}
+
+void start_acquisition() {
+  start_periodic_task(ACQUISITION_TASK, acquire, nullptr);
+}
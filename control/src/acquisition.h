@@ -0,0 +1,7 @@
+#pragma once
+
+// Starts the task that reads the PTs and the load cell every ACQUISITION_TASK
+// period and feeds the stand logic, the logs and telemetry. Started by boot() as soon as the
+// PTs can be read and the stand is safe, without waiting on the flash log or
+// the radio.
+void start_acquisition();
@@ -0,0 +1,149 @@
+#include "benchmarks.h"
+
+#include <bench/bench.h>
+#include <esp32_driver_mcp320x/mcp320x.h>
+#include <hal/rtos.h>
+#include <ra01s.h>
+#include <stand/pt_scale.h>
+#include <telemetry/frame.h>
+#include <telemetry/sample_stream.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "configs/bench_config.h"
+#include "configs/pt_adc_config.h"
+#include "configs/pt_scale_config.h"
+#include "configs/radio_config.h"
+#include "configs/valve_config.h"
+#include "esp_log.h"
+#include "pt.h"
+#include "pt_adc.h"
+#include "servo.h"
+
+static const char* TAG = "BENCH";
+
+static void bench_adc() {
+  init_pt_adc_spi();
+  const hal_gpio_t chip_select = MP2304_SPI_CONFIGS[0].cs;
+  mcp320x_t* handle = pt_adc_handle(chip_select);
+  if (handle == nullptr) {
+    ESP_LOGW(TAG, "No ADC on CS %d, skipping ADC benchmarks", chip_select);
+    return;
+  }
+
+  mcp320x_acquire(handle, HAL_WAIT_FOREVER);
+  uint16_t value = 0;
+  bench_print(bench_run("mcp320x_read", BENCH_ADC_READ_ITERATIONS, [&] {
+    mcp320x_read(handle, MCP320X_CHANNEL_0, MCP320X_READ_MODE_SINGLE, &value);
+    bench_keep(value);
+  }));
+  bench_print(bench_run("mcp320x_sample", BENCH_ADC_SAMPLE_ITERATIONS, [&] {
+    mcp320x_sample(handle, MCP320X_CHANNEL_0, MCP320X_READ_MODE_SINGLE,
+                   PT_ADC_VOLTAGE_SAMPLE_COUNT, &value);
+    bench_keep(value);
+  }));
+  mcp320x_release(handle);
+
+  // read_pt() without the transfer function, since configs/pt_config.h may
+  // wire the PTs to ADCs that aren't installed.
+  bench_print(
+      bench_run("pt_adc_read_raw_voltage", BENCH_ADC_SAMPLE_ITERATIONS, [&] {
+        float voltage =
+            pt_adc_read_raw_voltage(chip_select, MCP320X_CHANNEL_0);
+        bench_keep(voltage);
+      }));
+}
+
+static void bench_compute() {
+  // Volatile, so the compiler can't hoist the computation out of the loop.
+  volatile float voltage = 2.5f;
+  const PtScale& scale = get_pt_scale(Pt::kChamber);
+  bench_print(bench_run("voltage_to_psi", BENCH_COMPUTE_ITERATIONS, [&] {
+    float psi = voltage_to_psi(scale, voltage);
+    bench_keep(psi);
+  }));
+
+  // set_servo_angle() minus the LEDC write, which would move the valve.
+  const ValveConfig& valve = VALVE_CONFIGS[0];
+  volatile int angle = valve.open_angle;
+  bench_print(bench_run("servo_duty", BENCH_COMPUTE_ITERATIONS, [&] {
+    int duty = servo_duty(servo_pulsewidth(angle, valve.max_angle));
+    bench_keep(duty);
+  }));
+}
+
+static void bench_radio() {
+  LoRaInit();
+  if (LoRaBegin(LORA_FREQUENCY_HZ, LORA_TX_POWER_DBM, LORA_TCXO_VOLTAGE,
+                LORA_USE_REGULATOR_LDO) != ERR_NONE) {
+    ESP_LOGW(TAG, "SX126x not found, skipping radio benchmarks");
+    return;
+  }
+
+  uint8_t buffer[FRAME_MAX_SIZE];
+  for (size_t i = 0; i < sizeof(buffer); i++) {
+    buffer[i] = i;
+  }
+  bench_print(
+      bench_run("ra01s_write_buffer", BENCH_RADIO_BUFFER_ITERATIONS,
+                [&] { WriteBuffer(buffer, sizeof(buffer)); }));
+  bench_print(bench_run("ra01s_read_buffer", BENCH_RADIO_BUFFER_ITERATIONS,
+                        [&] {
+                          uint8_t len = ReadBuffer(buffer, sizeof(buffer));
+                          bench_keep(len);
+                        }));
+}
+
+static void bench_frames() {
+  const AckField ack = {};
+  uint8_t body[FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE];
+  for (size_t i = 0; i < sizeof(body); i++) {
+    body[i] = i;
+  }
+  uint8_t frame_buffer[FRAME_MAX_SIZE];
+  size_t frame_len = 0;
+  bench_print(bench_run("encode_telemetry_frame", BENCH_FRAME_ITERATIONS, [&] {
+    frame_len = encode_telemetry_frame(0, 1, ack, body, sizeof(body),
+                                       frame_buffer, sizeof(frame_buffer));
+    bench_keep(frame_len);
+  }));
+  Frame frame;
+  bench_print(bench_run("decode_frame", BENCH_FRAME_ITERATIONS, [&] {
+    FrameError error = decode_frame(frame_buffer, frame_len, &frame);
+    bench_keep(error);
+  }));
+
+  RawSample samples[SAMPLES_PER_FRAME];
+  for (size_t i = 0; i < SAMPLES_PER_FRAME; i++) {
+    samples[i] = {.t_us = 1000 * i,
+                  .channel = static_cast<uint8_t>(i % 8),
+                  .value = 1.5f * i};
+  }
+  bench_print(bench_run("encode_samples_frame", BENCH_FRAME_ITERATIONS, [&] {
+    size_t consumed = 0;
+    frame_len = encode_samples_frame(0, 1, ack, samples, SAMPLES_PER_FRAME,
+                                     SampleClock::kBoard, &consumed,
+                                     frame_buffer, sizeof(frame_buffer));
+    bench_keep(frame_len);
+  }));
+  decode_frame(frame_buffer, frame_len, &frame);
+  bench_print(bench_run("decode_samples_frame", BENCH_FRAME_ITERATIONS, [&] {
+    size_t count = 0;
+    SampleClock clock;
+    bool ok = decode_samples_frame(frame, samples, SAMPLES_PER_FRAME, &count,
+                                   &clock);
+    bench_keep(ok);
+  }));
+}
+
+void run_benchmarks() {
+  ESP_LOGI(TAG, "Running microbenchmarks, %u cycles per us",
+           static_cast<unsigned>(hal_cycles_per_us()));
+  bench_print_header();
+  bench_adc();
+  bench_compute();
+  bench_radio();
+  bench_frames();
+  ESP_LOGI(TAG, "Microbenchmarks done");
+}
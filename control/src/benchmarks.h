@@ -0,0 +1,8 @@
+#pragma once
+
+// Microbenchmarks of the control loop's hot paths, timed with the cycle
+// counter (see bench/bench.h): the MCP3204 read and PT sampling, the PT
+// transfer function, the servo duty computation, the SX126x buffer I/O and
+// telemetry framing. Brings up the ADC bus and the radio itself, so run it in
+// place of the stand, not beside it. Touches no valve or servo.
+void run_benchmarks();
@@ -0,0 +1,487 @@
+#include "boot.h"
+
+#include <esp_err.h>
+#include <esp_log.h>
+#include <hal/gpio.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <sched/boot_plan.h>
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+
+#include "acquisition.h"
+#include "configs/boot_config.h"
+#include "configs/ignition_config.h"
+#include "configs/load_cell_config.h"
+#include "configs/log_format_config.h"
+#include "configs/pt_adc_config.h"
+#include "configs/valve_config.h"
+#include "datalog.h"
+#include "deferred_log.h"
+#include "ignition.h"
+#include "load_cell.h"
+#include "periodic_task.h"
+#include "pt_adc.h"
+#include "radio.h"
+#include "stand_control.h"
+#include "valve.h"
+#include "wired.h"
+
+static const char* TAG = "BOOT";
+
+enum class BootPhase : uint8_t {
+  kDeferredLog,
+  kValves,
+  kIgnition,
+  kDatalog,
+  kPtAdc,
+  kAcquisition,
+  kLoadCell,
+  kRadio,
+  kStandControl,
+  kRadioTasks,
+  kWired,
+  kTaskMonitor,
+  kBootPhaseMax  // Not a valid phase, used for bounds checking.
+};
+
+constexpr uint32_t phase_bit(BootPhase phase) {
+  return 1u << static_cast<int>(phase);
+}
+
+struct BootPhaseSpec {
+  const char* name;
+  void (*init)();
+  // phase_bit()s of the phases that must be done first.
+  uint32_t depends_on;
+  // Runs on its own task, alongside the other phases. For phases that
+  // mostly wait on hardware.
+  bool concurrent;
+  // A concurrent phase not done after this long counts as done, so the
+  // phases that depend on it still run and must cope without it. 0 waits
+  // forever.
+  uint32_t timeout_ms;
+};
+
+static void start_deferred_log() {
+  init_deferred_log();
+  if (DEFERRED_LOG_MEASURE_AT_BOOT) {
+    measure_deferred_log();
+  }
+}
+
+// Powers up the HX711 and logs a first reading, which averages several
+// conversions at its 10 Hz data rate.
+static void start_load_cell() {
+  init_load_cell();
+  int32_t value;
+  if (read_raw_load_cell(&value) == ESP_OK) {
+    datalog_load_cell(value);
+  } else {
+    ESP_LOGW(TAG, "Load cell not ready");
+  }
+}
+
+// Pins of the peripherals the phases bring up, other than the valves.
+constexpr hal_gpio_t PERIPHERAL_GPIOS[] = {
+    IGNITION_GPIO_NUM,
+    HX711_DOUT_GPIO_NUM,
+    HX711_PD_SCK_GPIO_NUM,
+    ADC_SPI_MOSI,
+    ADC_SPI_MISO,
+    ADC_SPI_CLK,
+    MP2304_SPI_CONFIGS[0].cs,
+    MP2304_SPI_CONFIGS[1].cs,
+    CONFIG_MISO_GPIO,
+    CONFIG_SCLK_GPIO,
+    CONFIG_MOSI_GPIO,
+    CONFIG_NSS_GPIO,
+    CONFIG_RST_GPIO,
+    CONFIG_BUSY_GPIO,
+    CONFIG_TXEN_GPIO,
+    CONFIG_RXEN_GPIO,
+    CONFIG_DIO1_GPIO,
+};
+static_assert(sizeof(MP2304_SPI_CONFIGS) / sizeof(MP2304_SPI_CONFIGS[0]) == 2,
+              "List every ADC chip select in PERIPHERAL_GPIOS");
+
+// Marks `gpio` as claimed. Returns false if it already was.
+constexpr bool claim_gpio(bool* claimed, hal_gpio_t gpio) {
+  if (gpio == HAL_GPIO_NC) {
+    return true;
+  }
+  if (claimed[gpio]) {
+    return false;
+  }
+  claimed[gpio] = true;
+  return true;
+}
+
+// Whether no two peripherals other than the valves share a GPIO. A shared
+// pin ends up driven by both.
+constexpr bool peripheral_gpios_distinct() {
+  bool claimed[HAL_GPIO_MAX] = {};
+  for (hal_gpio_t gpio : PERIPHERAL_GPIOS) {
+    if (!claim_gpio(claimed, gpio)) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(peripheral_gpios_distinct(),
+              "Peripherals share a GPIO, see configs/ and the sdkconfig");
+
+constexpr bool valve_gpios_distinct() {
+  bool claimed[HAL_GPIO_MAX] = {};
+  for (const ValveConfig& config : VALVE_CONFIGS) {
+    if (!claim_gpio(claimed, config.gpio_num)) {
+      return false;
+    }
+  }
+  return true;
+}
+static_assert(valve_gpios_distinct(), "Valves share a GPIO");
+
+constexpr bool peripheral_gpio(hal_gpio_t gpio) {
+  for (hal_gpio_t peripheral : PERIPHERAL_GPIOS) {
+    if (peripheral == gpio) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Valves the kValves phase sets up: those whose pin no other peripheral
+// uses. A servo on a shared pin would fight the other peripheral for it
+// (e.g. hal_gpio_output() detaches the LEDC channel), so it is left out until
+// the stand's wiring moves it.
+constexpr uint32_t boot_valves() {
+  uint32_t valves = 0;
+  for (const ValveConfig& config : VALVE_CONFIGS) {
+    if (!peripheral_gpio(config.gpio_num)) {
+      valves |= 1u << static_cast<int>(config.valve);
+    }
+  }
+  return valves;
+}
+constexpr uint32_t BOOT_VALVES = boot_valves();
+
+static void start_valves() {
+  for (const ValveConfig& config : VALVE_CONFIGS) {
+    if (!(BOOT_VALVES & 1u << static_cast<int>(config.valve))) {
+      ESP_LOGW(TAG, "Valve %d shares GPIO %d with another peripheral, left out",
+               static_cast<int>(config.valve), config.gpio_num);
+    }
+  }
+  init_valves(BOOT_VALVES);
+}
+
+// !!!! READ BEFORE MODIFYING !!!!
+// Ensure entries are in the same order as BootPhase variants.
+static const BootPhaseSpec BOOT_PHASES[] = {
+    // kDeferredLog
+    {
+        .name = "deferred_log",
+        .init = start_deferred_log,
+        .depends_on = 0,
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kValves
+    {
+        .name = "valves",
+        .init = start_valves,
+        .depends_on = 0,
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kIgnition
+    {
+        .name = "ignition",
+        .init = init_ignition,
+        .depends_on = 0,
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kDatalog: scans the flash for the end of the log.
+    {
+        .name = "datalog",
+        .init = init_datalog,
+        .depends_on = 0,
+        .concurrent = true,
+        .timeout_ms = 0,
+    },
+    // kPtAdc
+    {
+        .name = "pt_adc",
+        .init = init_pt_adc_spi,
+        .depends_on = 0,
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kAcquisition: reads the PTs and feeds the stand logic, which can abort
+    // on a redline, so only once the valves and igniter are safe. Samples
+    // before kDatalog opens the flash log stay in the capture ring.
+    {
+        .name = "acquisition",
+        .init = start_acquisition,
+        .depends_on = phase_bit(BootPhase::kDeferredLog) |
+                      phase_bit(BootPhase::kValves) |
+                      phase_bit(BootPhase::kIgnition) |
+                      phase_bit(BootPhase::kPtAdc),
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kLoadCell: logs its first reading.
+    {
+        .name = "load_cell",
+        .init = start_load_cell,
+        .depends_on = phase_bit(BootPhase::kDatalog),
+        .concurrent = true,
+        .timeout_ms = 0,
+    },
+    // kRadio: resets and calibrates the SX126x.
+    {
+        .name = "radio",
+        .init = init_radio,
+        .depends_on = 0,
+        .concurrent = true,
+        .timeout_ms = BOOT_RADIO_TIMEOUT_MS,
+    },
+    // kStandControl: carries out decisions on the valves and igniter, and
+    // logs them.
+    {
+        .name = "stand_control",
+        .init = init_stand_control,
+        .depends_on = phase_bit(BootPhase::kValves) |
+                      phase_bit(BootPhase::kIgnition) |
+                      phase_bit(BootPhase::kDatalog),
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kRadioTasks: ground commands drive the stand logic. Also runs when
+    // kRadio timed out, and marks the radio down.
+    {
+        .name = "radio_tasks",
+        .init = start_radio,
+        .depends_on = phase_bit(BootPhase::kRadio) |
+                      phase_bit(BootPhase::kStandControl),
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kWired: switches the console's baud rate, so only once the other
+    // phases are done logging.
+    {
+        .name = "wired",
+        .init = init_wired,
+        .depends_on = phase_bit(BootPhase::kDeferredLog) |
+                      phase_bit(BootPhase::kDatalog) |
+                      phase_bit(BootPhase::kPtAdc) |
+                      phase_bit(BootPhase::kLoadCell) |
+                      phase_bit(BootPhase::kRadioTasks),
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+    // kTaskMonitor: reads every task's stack, so only once the boot tasks
+    // are gone.
+    {
+        .name = "task_monitor",
+        .init = init_task_monitor,
+        .depends_on = phase_bit(BootPhase::kDatalog) |
+                      phase_bit(BootPhase::kLoadCell) |
+                      phase_bit(BootPhase::kRadio) |
+                      phase_bit(BootPhase::kWired),
+        .concurrent = false,
+        .timeout_ms = 0,
+    },
+};
+
+constexpr size_t BOOT_PHASE_COUNT = static_cast<size_t>(BootPhase::kBootPhaseMax);
+static_assert(sizeof(BOOT_PHASES) / sizeof(BOOT_PHASES[0]) == BOOT_PHASE_COUNT,
+              "Every BootPhase needs a BootPhaseSpec");
+static_assert(BOOT_PHASE_COUNT <= BOOT_PLAN_MAX_PHASES,
+              "Boot phases must fit a bit mask");
+
+// Done once these are.
+constexpr uint32_t SAFE_PHASES =
+    phase_bit(BootPhase::kValves) | phase_bit(BootPhase::kIgnition);
+
+static const char* const MILESTONE_NAMES[] = {
+    "Safe",
+    "First sample",
+};
+static_assert(sizeof(MILESTONE_NAMES) / sizeof(MILESTONE_NAMES[0]) ==
+                  static_cast<size_t>(BootMilestone::kBootMilestoneMax),
+              "Every BootMilestone needs a name");
+
+// Written by the task that runs a phase, read by the boot task once notified
+// that it is done.
+static BootPhaseReport REPORTS[BOOT_PHASE_COUNT] = {};
+static std::atomic<uint32_t> PHASES_DONE{0};
+// Phases boot() stopped waiting for. They aren't in PHASES_DONE.
+static std::atomic<uint32_t> PHASES_TIMED_OUT{0};
+static hal_task_t BOOT_TASK = nullptr;
+
+static std::atomic<int64_t>
+    MILESTONES_US[static_cast<size_t>(BootMilestone::kBootMilestoneMax)] = {};
+
+static void run_phase(size_t index) {
+  REPORTS[index].name = BOOT_PHASES[index].name;
+  REPORTS[index].start_us = hal_time_us();
+  BOOT_PHASES[index].init();
+  REPORTS[index].end_us = hal_time_us();
+}
+
+static void boot_worker(void* arg) {
+  const size_t index = reinterpret_cast<uintptr_t>(arg);
+  run_phase(index);
+  hal_task_notify(BOOT_TASK, 1u << index);
+  hal_task_exit();
+}
+
+// Ticks until the first of `deadlines_us` (hal_time_us(), 0 for none) among
+// the phases in `pending`, at least one. HAL_WAIT_FOREVER if they have none.
+static hal_tick_t ticks_to_deadline(const int64_t* deadlines_us,
+                                    uint32_t pending) {
+  const int64_t now_us = hal_time_us();
+  hal_tick_t ticks = HAL_WAIT_FOREVER;
+  for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if ((pending & 1u << i) && deadlines_us[i] != 0) {
+      const int64_t left_ms = (deadlines_us[i] - now_us + 999) / 1000;
+      const hal_tick_t left = left_ms > 0 ? HAL_MS_TO_TICKS(left_ms) + 1 : 1;
+      ticks = left < ticks ? left : ticks;
+    }
+  }
+  return ticks;
+}
+
+void boot() {
+  uint32_t depends_on[BOOT_PHASE_COUNT];
+  for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    depends_on[i] = BOOT_PHASES[i].depends_on;
+  }
+  assert(boot_plan_valid(depends_on, BOOT_PHASE_COUNT) &&
+         "Boot phases depend on each other");
+
+  BOOT_TASK = hal_task_current();
+  const uint32_t all = boot_plan_all(BOOT_PHASE_COUNT);
+  uint32_t started = 0;
+  uint32_t done = 0;
+  uint32_t timed_out = 0;
+  int64_t deadlines_us[BOOT_PHASE_COUNT] = {};
+  while (done != all) {
+    const uint32_t ready =
+        boot_plan_ready(depends_on, BOOT_PHASE_COUNT, started, done);
+    // Concurrent phases first, so they overlap with the next inline one.
+    for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+      if ((ready & 1u << i) && BOOT_PHASES[i].concurrent) {
+        started |= 1u << i;
+        if (BOOT_PHASES[i].timeout_ms != 0) {
+          deadlines_us[i] =
+              hal_time_us() + BOOT_PHASES[i].timeout_ms * int64_t{1000};
+        }
+        if (!hal_task_create(boot_worker, BOOT_PHASES[i].name,
+                             BOOT_WORKER_STACK_SIZE,
+                             reinterpret_cast<void*>(i), BOOT_WORKER_PRIORITY,
+                             nullptr)) {
+          ESP_LOGW(TAG, "Can't start a task for %s, running it inline",
+                   BOOT_PHASES[i].name);
+          run_phase(i);
+          done |= 1u << i;
+        }
+      }
+    }
+    // One inline phase at a time: each may let more start.
+    bool ran_inline = false;
+    for (size_t i = 0; i < BOOT_PHASE_COUNT && !ran_inline; i++) {
+      if ((ready & 1u << i) && !BOOT_PHASES[i].concurrent) {
+        started |= 1u << i;
+        run_phase(i);
+        done |= 1u << i;
+        ran_inline = true;
+      }
+    }
+    // Collect the concurrent phases that finished, waiting for one if
+    // nothing else can run, but no longer than the first timeout.
+    const bool waiting =
+        !ran_inline &&
+        boot_plan_ready(depends_on, BOOT_PHASE_COUNT, started, done) == 0;
+    done |= hal_task_notify_wait(
+        waiting ? ticks_to_deadline(deadlines_us, started & ~done) : 0);
+    const int64_t now_us = hal_time_us();
+    for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+      if ((started & ~done & 1u << i) && deadlines_us[i] != 0 &&
+          now_us >= deadlines_us[i]) {
+        ESP_LOGE(TAG, "%s not done after %" PRIu32 " ms, booting without it",
+                 BOOT_PHASES[i].name, BOOT_PHASES[i].timeout_ms);
+        done |= 1u << i;
+        timed_out |= 1u << i;
+      }
+    }
+    PHASES_DONE = done & ~timed_out;
+    PHASES_TIMED_OUT = timed_out;
+    if ((done & SAFE_PHASES) == SAFE_PHASES) {
+      boot_milestone(BootMilestone::kSafe);
+    }
+  }
+  boot_log_report();
+}
+
+void boot_milestone(BootMilestone milestone) {
+  std::atomic<int64_t>& reached_us =
+      MILESTONES_US[static_cast<size_t>(milestone)];
+  int64_t unset = 0;
+  if (reached_us.load(std::memory_order_relaxed) != 0 ||
+      !reached_us.compare_exchange_strong(unset, hal_time_us())) {
+    return;
+  }
+  ESP_LOGI(TAG, "%s %.1f ms after boot",
+           MILESTONE_NAMES[static_cast<size_t>(milestone)],
+           reached_us.load() / 1000.0);
+}
+
+int64_t get_boot_milestone_us(BootMilestone milestone) {
+  return MILESTONES_US[static_cast<size_t>(milestone)].load();
+}
+
+size_t get_boot_phases(BootPhaseReport* out, size_t cap) {
+  const uint32_t done = PHASES_DONE.load();
+  size_t count = 0;
+  for (size_t i = 0; i < BOOT_PHASE_COUNT && count < cap; i++) {
+    if (done & 1u << i) {
+      out[count++] = REPORTS[i];
+    }
+  }
+  return count;
+}
+
+void boot_log_report() {
+  BootPhaseReport phases[BOOT_PHASE_COUNT];
+  size_t count = get_boot_phases(phases, BOOT_PHASE_COUNT);
+  int64_t end_us = 0;
+  for (size_t i = 0; i < count; i++) {
+    ESP_LOGI(TAG, "%-14s %8.1f ms + %7.1f ms", phases[i].name,
+             phases[i].start_us / 1000.0,
+             (phases[i].end_us - phases[i].start_us) / 1000.0);
+    end_us = phases[i].end_us > end_us ? phases[i].end_us : end_us;
+  }
+  const uint32_t timed_out = PHASES_TIMED_OUT.load();
+  for (size_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (timed_out & 1u << i) {
+      ESP_LOGE(TAG, "%-14s timed out", BOOT_PHASES[i].name);
+    }
+  }
+  ESP_LOGI(TAG, "Booted in %.1f ms", end_us / 1000.0);
+  for (size_t i = 0; i < static_cast<size_t>(BootMilestone::kBootMilestoneMax);
+       i++) {
+    int64_t reached_us = MILESTONES_US[i].load();
+    if (reached_us != 0) {
+      ESP_LOGI(TAG, "%s %.1f ms after boot", MILESTONE_NAMES[i],
+               reached_us / 1000.0);
+    }
+  }
+}
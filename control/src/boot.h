@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Boot orchestration. Peripherals come up in phases with explicit
+// dependencies (see boot.cc): a phase starts as soon as the ones it depends
+// on are done, and phases that wait on hardware run concurrently on their own
+// tasks. Every phase is timestamped, and so are the milestones below, which
+// bound how long a board that rebooted (e.g. after a brownout) is unsafe or
+// blind.
+
+enum class BootMilestone : uint8_t {
+  kSafe,         // Valves closed and igniter off.
+  kFirstSample,  // First PT reading through the stand logic and the log.
+  kBootMilestoneMax  // Not a valid milestone, used for bounds checking.
+};
+
+struct BootPhaseReport {
+  const char* name;
+  // hal_time_us(), from reset.
+  int64_t start_us;
+  int64_t end_us;
+};
+
+// Runs every boot phase and returns once they are all done, or timed out
+// (see BootPhaseSpec::timeout_ms). Called by app_main.
+void boot();
+
+// Records the first time `milestone` is reached, and logs it.
+void boot_milestone(BootMilestone milestone);
+
+// Time `milestone` was first reached (hal_time_us()), or 0 if it wasn't yet.
+int64_t get_boot_milestone_us(BootMilestone milestone);
+
+// Copies the timestamps of the phases that ran to `out`, leaving out those
+// that timed out. Returns their number.
+size_t get_boot_phases(BootPhaseReport* out, size_t cap);
+
+// Logs each phase's start and duration, and the milestones reached.
+void boot_log_report();
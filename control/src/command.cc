@@ -0,0 +1,107 @@
+#include "command.h"
+
+#include <esp_log.h>
+#include <telemetry/command_link.h>
+#include <telemetry/stand_state.h>
+#include <telemetry/trace_report.h>
+
+#include <atomic>
+
+#include "configs/valve_config.h"
+#include "datalog.h"
+#include "ignition.h"
+#include "memory_usage.h"
+#include "stand_control.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "valve.h"
+
+static const char* TAG = "COMMAND";
+
+static std::atomic<StandState> STAND_STATE{StandState::kSafe};
+
+static void set_stand_state(StandState state) {
+  // The stand logic first: it gates the sequencer's steps.
+  stand_control_set_state(state);
+  STAND_STATE = state;
+  telemetry_set_state(state);
+}
+
+void abort_stand() {
+  // Stops the sequencer before anything is closed, so a step it already
+  // released can't reopen a valve (see stand_control.cc).
+  set_stand_state(StandState::kAbort);
+  set_ignition_relay_low();
+  for (const ValveConfig& valve_config : VALVE_CONFIGS) {
+    close_valve(valve_config.valve);
+  }
+}
+
+bool execute_command(const Command& command) {
+  switch (command.type) {
+    case CommandType::kOpenValve:
+    case CommandType::kCloseValve: {
+      if (command.arg >= static_cast<int>(Valve::kValveMax)) {
+        ESP_LOGW(TAG, "Invalid valve %d", command.arg);
+        return false;
+      }
+      Valve valve = static_cast<Valve>(command.arg);
+      bool moved = command.type == CommandType::kOpenValve
+                       ? open_valve(valve)
+                       : close_valve(valve);
+      if (!moved) {
+        ESP_LOGE(TAG, "Valve %d not set up", command.arg);
+      }
+      return moved;
+    }
+    case CommandType::kArm:
+      datalog_trigger(LogEvent::kArm);
+      set_stand_state(StandState::kArmed);
+      return true;
+    case CommandType::kDisarm:
+      datalog_event(LogEvent::kDisarm);
+      set_stand_state(StandState::kSafe);
+      return true;
+    case CommandType::kAbort:
+      datalog_trigger(LogEvent::kAbort);
+      abort_stand();
+      return true;
+    case CommandType::kMark:
+      datalog_trigger(LogEvent::kMark, command.arg);
+      return true;
+    case CommandType::kEraseLog:
+      if (get_stand_state() != StandState::kSafe) {
+        ESP_LOGW(TAG, "Refusing to erase the flight-data log unless safe");
+        return false;
+      }
+      datalog_request_erase();
+      return true;
+    case CommandType::kTrace:
+      switch (static_cast<TraceRequest>(command.arg)) {
+        case TraceRequest::kLog:
+          trace_log_report();
+          return true;
+        case TraceRequest::kSend:
+          trace_request_send();
+          return true;
+        case TraceRequest::kReset:
+          trace_reset();
+          return true;
+      }
+      ESP_LOGW(TAG, "Invalid trace request %d", command.arg);
+      return false;
+    case CommandType::kMemory:
+      memory_log_report();
+      return true;
+  }
+
+  ESP_LOGW(TAG, "Unknown command type %d", static_cast<int>(command.type));
+  return false;
+}
+
+bool is_armed() {
+  StandState state = STAND_STATE;
+  return state == StandState::kArmed || state == StandState::kFiring;
+}
+
+StandState get_stand_state() { return STAND_STATE; }
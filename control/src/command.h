@@ -0,0 +1,18 @@
+#pragma once
+
+#include <telemetry/command_link.h>
+#include <telemetry/stand_state.h>
+
+// Executes a ground command. Returns false if the command is malformed (e.g.
+// an unknown valve), not allowed in the current state, or couldn't be carried
+// out (e.g. the valves aren't set up).
+bool execute_command(const Command& command);
+
+// Puts the stand in a safe state: every valve closed and the igniter off.
+// Used by the abort command and by the redlines (see stand_control.h).
+void abort_stand();
+
+// Whether the stand has been armed from the ground and not aborted since.
+bool is_armed();
+
+StandState get_stand_state();
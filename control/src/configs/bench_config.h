@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// Runs the microbenchmarks of benchmarks.h at boot, in place of the stand,
+// and prints their results on the console.
+constexpr bool BENCH_AT_BOOT = false;
+
+// Calls per batch. Sized so a batch takes about a millisecond on the board:
+// long enough to dwarf reading the cycle counter, short enough that few
+// batches see a task switch.
+constexpr uint32_t BENCH_ADC_READ_ITERATIONS = 200;
+constexpr uint32_t BENCH_ADC_SAMPLE_ITERATIONS = 2;
+constexpr uint32_t BENCH_COMPUTE_ITERATIONS = 1000;
+constexpr uint32_t BENCH_RADIO_BUFFER_ITERATIONS = 20;
+constexpr uint32_t BENCH_FRAME_ITERATIONS = 100;
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// Boot phases that wait on hardware (see boot.cc) run on their own tasks,
+// concurrently. They exit once done.
+constexpr uint32_t BOOT_WORKER_STACK_SIZE = 4096;
+// app_main's.
+constexpr int BOOT_WORKER_PRIORITY = 1;
+
+// The radio phase (init_radio()) takes tens of milliseconds. An SX126x that
+// doesn't answer holds it for BUSY_WAIT (5 s) per command, or for good once
+// the driver gives up: boot carries on without the radio after this long.
+constexpr uint32_t BOOT_RADIO_TIMEOUT_MS = 1000;
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Raw data partition holding the flight-data log. See partitions.csv.
+constexpr const char* DATALOG_PARTITION_LABEL = "datalog";
+
+// Raw data partition holding the latest capture as a column file (see
+// datalog/column_file.h), written by the writer task from the flight-data log
+// once the post-trigger window closes. Each capture replaces the previous one.
+constexpr const char* COLUMNS_PARTITION_LABEL = "columns";
+
+// Full-rate samples always go to a RAM ring of the last
+// DATALOG_CAPTURE_RING_SIZE records (16 bytes each). When a trigger fires, the
+// ring is frozen and its last DATALOG_PRETRIGGER_MS are written to flash,
+// followed by every sample until DATALOG_POST_TRIGGER_MS after the latest
+// trigger, or for as long as the stand is not safe. Size the ring for the
+// pre-trigger window at the full acquisition rate. Must be a power of two.
+constexpr size_t DATALOG_CAPTURE_RING_SIZE = 4096;
+constexpr int DATALOG_PRETRIGGER_MS = 1000;
+constexpr int DATALOG_POST_TRIGGER_MS = 5000;
+
+// The writer programs full sectors as they fill up. Unless the stand is safe,
+// it also pads the current one at least this often so a reset loses at most
+// this much data.
+constexpr int DATALOG_FLUSH_PERIOD_MS = 1000;
+// How often the writer checks for full buffers. Two buffers of 255 records
+// hold about 50 ms at 10k records/s.
+constexpr int DATALOG_SERVICE_PERIOD_MS = 10;
+constexpr int DATALOG_REPORT_PERIOD_MS = 60000;
+// Writing the pre-trigger window services the flash log whenever both
+// buffers are full, up to this many times per record before dropping it.
+// Each service() frees a buffer, so more only helps against producers
+// filling the freed one first.
+constexpr int DATALOG_CAPTURE_APPEND_RETRIES = 4;
+
+// Each exported capture is also compressed channel by channel (see
+// compress/gorilla.h) into blocks of this size, a frame payload, and the
+// ratio and cost per sample are logged. The compressed blocks aren't kept.
+constexpr bool DATALOG_MEASURE_COMPRESSION = true;
+constexpr size_t DATALOG_COMPRESS_BLOCK_SIZE = 240;
+
+// Below acquisition, radio and command tasks: flash writes only ever use
+// otherwise idle time. Reading the log back for the column file takes a
+// sector-sized buffer on the stack.
+constexpr uint32_t DATALOG_TASK_STACK_SIZE = 8192;
+constexpr int DATALOG_TASK_PRIORITY = 2;
@@ -1,5 +1,5 @@
 #pragma once
 
-#include <driver/gpio.h>
+#include <hal/gpio.h>
 
-constexpr gpio_num_t IGNITION_GPIO_NUM = GPIO_NUM_1;
+constexpr hal_gpio_t IGNITION_GPIO_NUM = 1;
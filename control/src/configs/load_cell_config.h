@@ -1,15 +1,22 @@
 #pragma once
 
-#include <driver/gpio.h>
-#include <hx711.h>
+#include <hal/gpio.h>
 
 // Pin configuration for the HX711 load cell amplifier.
-constexpr gpio_num_t HX711_DOUT_GPIO_NUM = GPIO_NUM_48;
-constexpr gpio_num_t HX711_PD_SCK_GPIO_NUM = GPIO_NUM_47;
-constexpr hx711_gain_t HX711_GAIN = HX711_GAIN_A_128;
+constexpr hal_gpio_t HX711_DOUT_GPIO_NUM = 48;
+constexpr hal_gpio_t HX711_PD_SCK_GPIO_NUM = 47;
+
+// Input and gain of the HX711's next conversion, selected by the number of
+// extra clock pulses after the 24 data bits.
+enum class Hx711Gain {
+  kA128 = 1,
+  kB32 = 2,
+  kA64 = 3,
+};
+constexpr Hx711Gain HX711_GAIN = Hx711Gain::kA128;
 
 // How long to wait for the HX711 to become ready.
 constexpr int HX711_MAX_TIMEOUT_MS = 500;
 
 // Number of samples to average when reading from the HX711.
-constexpr int HX711_AVG_SAMPLE_COUNT = 5;
\ No newline at end of file
+constexpr int HX711_AVG_SAMPLE_COUNT = 5;
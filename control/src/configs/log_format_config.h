@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Formats for deferred logging (see deferred_log.h). The ground tool
+// binlog_expand uses this same table to turn records back into text, so keep
+// this header free of ESP-IDF includes.
+
+enum class LogFormat : uint16_t {
+  kPtReading,
+  kServoAngle,
+  kLogFormatMax  // Not a valid format, used for bounds checking.
+};
+
+enum class LogLevel : uint8_t {
+  kError,
+  kWarn,
+  kInfo,
+  kDebug,
+};
+
+struct LogFormatSpec {
+  LogLevel level;
+  const char* tag;
+  // printf format; see binlog/binlog.h for the supported conversions.
+  const char* format;
+};
+
+// !!!! READ BEFORE MODIFYING !!!!
+// Ensure entries are in the same order as LogFormat variants.
+// LogFormat variants are used to index this array. Never reuse or reorder
+// ids that old captures may still contain; append instead.
+constexpr LogFormatSpec LOG_FORMATS[] = {
+    // kPtReading
+    {
+        .level = LogLevel::kInfo,
+        .tag = "PT",
+        .format = "PT %u: %.2f psi",
+    },
+    // kServoAngle
+    {
+        .level = LogLevel::kInfo,
+        .tag = "SERVO",
+        .format = "Angle: %d -> Pulsewidth: %d us -> Duty: %d",
+    },
+};
+
+static_assert(sizeof(LOG_FORMATS) / sizeof(LOG_FORMATS[0]) ==
+                  static_cast<size_t>(LogFormat::kLogFormatMax),
+              "Every LogFormat needs a LogFormatSpec");
+
+// Records buffered per core before the drain task ships them. Must be a power
+// of two.
+constexpr size_t DEFERRED_LOG_RING_SIZE = 256;
+// How often the drain task writes buffered records to the console.
+constexpr int DEFERRED_LOG_DRAIN_PERIOD_MS = 20;
+constexpr uint32_t DEFERRED_LOG_TASK_STACK_SIZE = 3072;
+constexpr int DEFERRED_LOG_TASK_PRIORITY = 1;
+// Times ESP_LOGI against deferred logging at boot and logs the per-call cost.
+constexpr bool DEFERRED_LOG_MEASURE_AT_BOOT = false;
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Aborts on any heap allocation once app_main has initialized everything
+// (hal_heap_forbid_allocs()), to prove the stand doesn't allocate while it
+// runs. The panic's backtrace points at the allocation.
+constexpr bool ASSERT_NO_ALLOC_AFTER_INIT = false;
+
+// app_main's task, CONFIG_ESP_MAIN_TASK_STACK_SIZE in the board's sdkconfig.
+// boot() runs on it.
+constexpr uint32_t MAIN_TASK_STACK_SIZE = 3584;
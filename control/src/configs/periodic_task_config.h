@@ -0,0 +1,79 @@
+#pragma once
+
+#include <sched/monitor.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "configs/log_format_config.h"
+#include "configs/stand_config.h"
+#include "configs/telemetry_config.h"
+#include "configs/wired_config.h"
+#include "periodic_task.h"
+
+// Tasks that can be monitored at once.
+constexpr size_t PERIODIC_TASK_MAX = 8;
+
+// Period and deadline of every periodic task. Deadlines equal periods unless
+// a run is known to block longer.
+constexpr PeriodicTaskConfig ACQUISITION_TASK = {
+    .name = "acquisition",
+    .period_ms = 1500,
+    .deadline_ms = 1500,
+    // app_main's, which boot() runs on.
+    .stack_size = 3584,
+    .priority = 1,
+};
+
+constexpr PeriodicTaskConfig SEQUENCER_TASK = {
+    .name = "stand",
+    .period_ms = STAND_SEQUENCER_PERIOD_MS,
+    .deadline_ms = STAND_SEQUENCER_PERIOD_MS,
+    .stack_size = STAND_SEQUENCER_TASK_STACK_SIZE,
+    .priority = STAND_SEQUENCER_TASK_PRIORITY,
+};
+
+constexpr PeriodicTaskConfig WIRED_TASK = {
+    .name = "wired",
+    .period_ms = WIRED_TASK_PERIOD_MS,
+    // A clock synchronization exchange waits up to its timeout.
+    .deadline_ms = WIRED_TASK_PERIOD_MS + WIRED_TIME_SYNC_TIMEOUT_MS,
+    .stack_size = WIRED_TASK_STACK_SIZE,
+    .priority = WIRED_TASK_PRIORITY,
+};
+
+constexpr PeriodicTaskConfig DEFERRED_LOG_TASK = {
+    .name = "dlog",
+    .period_ms = DEFERRED_LOG_DRAIN_PERIOD_MS,
+    .deadline_ms = DEFERRED_LOG_DRAIN_PERIOD_MS,
+    .stack_size = DEFERRED_LOG_TASK_STACK_SIZE,
+    .priority = DEFERRED_LOG_TASK_PRIORITY,
+};
+
+// The radio task is woken by notifications, but builds a telemetry frame
+// every TELEMETRY_FRAME_PERIOD_MS; each must be on air before the next is
+// due.
+constexpr int TELEMETRY_FRAME_DEADLINE_MS = TELEMETRY_FRAME_PERIOD_MS;
+
+// The monitor task reads the load of each core, evaluates DEGRADE_POLICY and
+// records the kCpuLoad, kDeadlineMisses, kDegraded, kHeapMinFree and
+// kStackMinFree channels this often.
+constexpr PeriodicTaskConfig TASK_MONITOR_TASK = {
+    .name = "monitor",
+    .period_ms = 1000,
+    .deadline_ms = 1000,
+    .stack_size = 3072,
+    // Above the datalog writer, so a busy flash doesn't hide the load.
+    .priority = 3,
+};
+constexpr int TASK_MONITOR_REPORT_PERIOD_MS = 60 * 1000;
+
+// Degraded mode holds back kNormal and kLow telemetry channels and is logged
+// as a kDegraded event. It trips on this many deadline misses within one
+// monitor period, or when a core is busier than this, and clears after
+// recovery_us without either.
+constexpr DegradePolicy DEGRADE_POLICY = {
+    .max_misses = 3,
+    .max_cpu_load = 0.9f,
+    .recovery_us = 10 * 1000 * 1000,
+};
@@ -1,10 +1,8 @@
 #pragma once
 
-#include <driver/gpio.h>
+#include <hal/gpio.h>
 #include <esp32_driver_mcp320x/mcp320x.h>
 
-#include <utility>
-
 #include "pt.h"
 
 // Uncomment to enable pressure transducer debug logging.
@@ -12,68 +10,51 @@
 
 struct PtConfig {
   // Chip select which identifies which ADC to read from.
-  gpio_num_t cs;
+  hal_gpio_t cs;
   // Channel which identifies which channel to read on the ADC.
   mcp320x_channel_t channel;
-  // Voltage range representing 0 to max pressure.
-  std::pair<float, float> voltage_range;
-  // Max pressure represented by voltage_range[1];
-  uint16_t max_pressure;
 };
 
-// Configuration for various pressure transducers.
+// ADC wiring of the pressure transducers. Their transfer functions are in
+// configs/pt_scale_config.h.
 // !!!! READ BEFORE MODIFYING !!!!
 // Ensure the PT type is in the same order as Valve enum variants.
 // Pt enum variants are used to index this array. See `get_pt_config`.
 constexpr PtConfig PT_CONFIGS[] = {
     // kChamber
     {
-        .cs = GPIO_NUM_4,
+        .cs = 4,
         .channel = MCP320X_CHANNEL_0,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
     // kInjectorGox,
     {
-        .cs = GPIO_NUM_5,
+        .cs = 5,
         .channel = MCP320X_CHANNEL_1,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
     // kInjectorEth,
     {
-        .cs = GPIO_NUM_5,
+        .cs = 5,
         .channel = MCP320X_CHANNEL_2,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
     // kEthN2Reg,
     {
-        .cs = GPIO_NUM_5,
+        .cs = 5,
         .channel = MCP320X_CHANNEL_3,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
     // kEthLine,
     {
-        .cs = GPIO_NUM_7,
+        .cs = 7,
         .channel = MCP320X_CHANNEL_0,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
     // kGoxReg,
     {
-        .cs = GPIO_NUM_7,
+        .cs = 7,
         .channel = MCP320X_CHANNEL_1,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 3000,
     },
     // kGoxLine
     {
-        .cs = GPIO_NUM_7,
+        .cs = 7,
         .channel = MCP320X_CHANNEL_2,
-        .voltage_range = {0.5, 4.5},
-        .max_pressure = 1000,
     },
 };
 
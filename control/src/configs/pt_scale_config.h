@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stand/pt_scale.h>
+
+#include <cstddef>
+
+#include "pt.h"
+
+// Transfer function of each pressure transducer. Kept apart from the ADC
+// wiring (configs/pt_config.h) so the ground replay converts with the same
+// values.
+// !!!! READ BEFORE MODIFYING !!!!
+// Ensure entries are in the same order as Pt enum variants.
+// Pt enum variants are used to index this array. See `get_pt_scale`.
+constexpr PtScale PT_SCALES[] = {
+    // kChamber
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+    // kInjectorGox
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+    // kInjectorEth
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+    // kEthN2Reg
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+    // kEthLine
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+    // kGoxReg
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 3000,
+    },
+    // kGoxLine
+    {
+        .voltage_range = {0.5, 4.5},
+        .max_pressure = 1000,
+    },
+};
+
+static_assert(sizeof(PT_SCALES) / sizeof(PT_SCALES[0]) ==
+                  static_cast<size_t>(Pt::kPtMax),
+              "Every Pt needs a PtScale");
+
+constexpr const PtScale& get_pt_scale(Pt pt) {
+  return PT_SCALES[static_cast<int>(pt)];
+}
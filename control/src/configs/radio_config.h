@@ -0,0 +1,111 @@
+#pragma once
+
+#include <ra01s.h>
+#include <telemetry/channel_access.h>
+#include <telemetry/frame.h>
+#include <telemetry/lora_airtime.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Carrier frequency, selected under "SX126X Configuration" in menuconfig.
+#if CONFIG_433MHZ
+constexpr uint32_t LORA_FREQUENCY_HZ = 433000000;
+#elif CONFIG_866MHZ
+constexpr uint32_t LORA_FREQUENCY_HZ = 866000000;
+#elif CONFIG_915MHZ
+constexpr uint32_t LORA_FREQUENCY_HZ = 915000000;
+#else
+constexpr uint32_t LORA_FREQUENCY_HZ = CONFIG_OTHER_FREQUENCY * 1000000;
+#endif
+
+constexpr int8_t LORA_TX_POWER_DBM = 22;
+// The Heltec V3 SX1262 is clocked by a 1.8V TCXO powered from DIO3.
+#if CONFIG_USE_TCXO
+constexpr float LORA_TCXO_VOLTAGE = 1.8;
+#else
+constexpr float LORA_TCXO_VOLTAGE = 0.0;
+#endif
+constexpr bool LORA_USE_REGULATOR_LDO = false;
+
+// Modulation. Lower spreading factors shorten the command round trip at the
+// cost of range. Must match the ground station.
+constexpr uint8_t LORA_SPREADING_FACTOR = 7;
+constexpr uint8_t LORA_BANDWIDTH = SX126X_LORA_BW_125_0;
+constexpr uint8_t LORA_CODING_RATE = SX126X_LORA_CR_4_5;
+constexpr uint16_t LORA_PREAMBLE_LENGTH = 8;
+// 0 selects variable length packets (explicit header).
+constexpr uint8_t LORA_PAYLOAD_LENGTH = 0;
+constexpr bool LORA_CRC_ON = true;
+constexpr bool LORA_INVERT_IRQ = false;
+
+constexpr LoRaModulation LORA_MODULATION = {
+    .spreading_factor = LORA_SPREADING_FACTOR,
+    .bandwidth_hz = lora_bandwidth_hz(LORA_BANDWIDTH),
+    .coding_rate = LORA_CODING_RATE,
+    .preamble_length = LORA_PREAMBLE_LENGTH,
+    .explicit_header = LORA_PAYLOAD_LENGTH == 0,
+    .crc_on = LORA_CRC_ON,
+    // LoRaConfig() always turns low data rate optimization off.
+    .low_data_rate_optimize = false,
+};
+static_assert(LORA_MODULATION.bandwidth_hz != 0, "Unknown LORA_BANDWIDTH");
+
+// Address of this board on the ground link (see telemetry/frame.h). Every
+// board sharing a ground station (stand sensors, valve control, igniter box)
+// needs a unique id below RADIO_NODE_COUNT.
+constexpr uint8_t RADIO_NODE_ID = 0;
+constexpr uint8_t RADIO_NODE_COUNT = 1;
+static_assert(RADIO_NODE_ID < RADIO_NODE_COUNT);
+
+// Medium access when several boards share the channel. Listen-before-talk
+// runs a CAD before every downlink frame; TDMA instead gives each node a slot
+// of RADIO_TDMA_SLOT_US, counted in host time, so a board runs
+// listen-before-talk until its clock is synchronized over the wired link.
+// Time on air of a full frame at the modulation above.
+constexpr uint32_t LORA_MAX_FRAME_AIRTIME_US =
+    lora_time_on_air_us(LORA_MODULATION, FRAME_MAX_SIZE);
+// Longest downlink frame plus guard.
+constexpr uint32_t RADIO_TDMA_SLOT_US = LORA_MAX_FRAME_AIRTIME_US + 10000;
+constexpr ChannelAccessConfig RADIO_CHANNEL_ACCESS = {
+    .mode = AccessMode::kListenBeforeTalk,
+    // A quarter of a full frame: most busy channels clear within a few slots.
+    .backoff_slot_us = LORA_MAX_FRAME_AIRTIME_US / 4,
+    .min_backoff_exponent = 1,
+    .max_backoff_exponent = 4,
+    .max_attempts = 6,
+    .node_id = RADIO_NODE_ID,
+    .node_count = RADIO_NODE_COUNT,
+    .slot_us = RADIO_TDMA_SLOT_US,
+    // Covers the FreeRTOS tick the radio task may wake late by.
+    .guard_us = 10000,
+};
+// CAD over 4 symbols; detection thresholds from AN1200.48 for SF7.
+constexpr uint8_t LORA_CAD_SYMBOLS = SX126X_CAD_ON_4_SYMB;
+constexpr uint8_t LORA_CAD_DET_PEAK = LORA_SPREADING_FACTOR + 15;
+constexpr uint8_t LORA_CAD_DET_MIN = 10;
+// How long the radio task waits for CAD_DONE before counting the channel as
+// busy: the CAD's symbols, one more for the radio to process them
+// (AN1200.48), and a FreeRTOS tick the task may wake late by.
+constexpr int64_t LORA_CAD_TIMEOUT_US =
+    ((1 << LORA_CAD_SYMBOLS) + 1) * lora_symbol_time_us(LORA_MODULATION) +
+    10000;
+
+// Received packets waiting for the command task. Must be a power of two.
+constexpr size_t RADIO_RX_RING_SIZE = 8;
+// How often the radio task checks the receiver for uplink packets when DIO1
+// is not wired (CONFIG_DIO1_GPIO = -1). With DIO1 the task only wakes on
+// RX_DONE. The Heltec V3's sdkconfig describes an external Ra-01S whose DIO1
+// isn't wired, so the board polls; GPIO 14 is the onboard SX1262's DIO1, not
+// the Ra-01S's.
+constexpr int RADIO_POLL_PERIOD_MS = 10;
+// How long past its time on air a frame may take to raise TX_DONE before the
+// send is given up. Covers the FreeRTOS tick and the radio's ramp up.
+constexpr int64_t RADIO_TX_DONE_MARGIN_US = 20000;
+
+// Both tasks preempt acquisition so commands execute within a millisecond of
+// the packet arriving.
+constexpr uint32_t RADIO_TASK_STACK_SIZE = 4096;
+constexpr int RADIO_TASK_PRIORITY = 10;
+constexpr uint32_t COMMAND_TASK_STACK_SIZE = 4096;
+constexpr int COMMAND_TASK_PRIORITY = 9;
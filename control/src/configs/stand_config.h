@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stand/pt_filter.h>
+#include <stand/stand_controller.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Autonomous stand logic: PT filtering, redlines and the firing sequence.
+// Free of hardware dependencies, so the ground replay (`replay`) uses this
+// configuration as its default and reproduces the board's decisions.
+
+constexpr PtFilterConfig STAND_PT_FILTER = {
+    .median = true,
+    .cutoff_hz = 50,
+};
+
+// Redlines abort the stand (igniter off, every valve closed), and the firing
+// sequence is a timed list of valve and igniter steps. Both are left empty
+// until the stand owner signs off on limits and timings. A redline must
+// watch a PT that acquisition reads (main.cc), often enough for its
+// persist_us and STAND_PT_FILTER; the board has no command that starts a
+// sequence yet.
+constexpr StandLogicConfig STAND_LOGIC = {
+    .filter = STAND_PT_FILTER,
+    .redlines = nullptr,
+    .redline_count = 0,
+    .sequence = nullptr,
+    .sequence_count = 0,
+};
+
+// How often the sequencer task releases due steps; steps run up to this late.
+// One FreeRTOS tick at CONFIG_FREERTOS_HZ=100.
+constexpr int STAND_SEQUENCER_PERIOD_MS = 10;
+constexpr uint32_t STAND_SEQUENCER_TASK_STACK_SIZE = 4096;
+// Just below the radio and command tasks.
+constexpr int STAND_SEQUENCER_TASK_PRIORITY = 8;
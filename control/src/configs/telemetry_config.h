@@ -0,0 +1,158 @@
+#pragma once
+
+#include <telemetry/scheduler.h>
+
+#include <cstdint>
+
+#include "pt.h"
+
+// On-wire telemetry channel ids. Pressure transducers come first, in Pt
+// order, so a Pt converts directly to its channel.
+enum class TelemetryChannel : uint8_t {
+  kChamber,
+  kInjectorGox,
+  kInjectorEth,
+  kEthN2Reg,
+  kEthLine,
+  kGoxReg,
+  kGoxLine,
+  kLoadCell,  // Raw HX711 counts.
+  kValveStates,  // Bit n set when Valve n is open.
+  kHealth,       // Free heap, in bytes.
+  kAbortStatus,  // StandState.
+  kCpuLoadCore0,    // Percent.
+  kCpuLoadCore1,    // Percent.
+  kDeadlineMisses,  // Over every periodic task, since boot.
+  kDegraded,        // 1 in degraded mode.
+  kHeapMinFree,     // Least free heap since boot, in bytes.
+  kStackMinFree,    // Least free stack of any task since boot, in bytes.
+  kTelemetryChannelMax  // Not a valid channel, used for bounds checking.
+};
+
+static_assert(static_cast<int>(TelemetryChannel::kLoadCell) ==
+                  static_cast<int>(Pt::kPtMax),
+              "PT channels must mirror the Pt enum");
+
+constexpr TelemetryChannel pt_channel(Pt pt) {
+  return static_cast<TelemetryChannel>(pt);
+}
+
+// Downlink priority and rate of each channel.
+// !!!! READ BEFORE MODIFYING !!!!
+// Ensure entries are in the same order as TelemetryChannel variants.
+// TelemetryChannel variants are used to index this array.
+// `rate_hz` is given per StandState: {kSafe, kArmed, kFiring, kAbort}.
+constexpr ChannelSpec TELEMETRY_CHANNELS[] = {
+    // kChamber
+    {
+        .id = 0,
+        .priority = ChannelPriority::kCritical,
+        .rate_hz = {1.0, 5.0, 10.0, 10.0},
+    },
+    // kInjectorGox
+    {
+        .id = 1,
+        .priority = ChannelPriority::kHigh,
+        .rate_hz = {0.5, 2.0, 10.0, 5.0},
+    },
+    // kInjectorEth
+    {
+        .id = 2,
+        .priority = ChannelPriority::kHigh,
+        .rate_hz = {0.5, 2.0, 10.0, 5.0},
+    },
+    // kEthN2Reg
+    {
+        .id = 3,
+        .priority = ChannelPriority::kNormal,
+        .rate_hz = {0.5, 1.0, 2.0, 2.0},
+    },
+    // kEthLine
+    {
+        .id = 4,
+        .priority = ChannelPriority::kNormal,
+        .rate_hz = {0.5, 1.0, 5.0, 2.0},
+    },
+    // kGoxReg
+    {
+        .id = 5,
+        .priority = ChannelPriority::kNormal,
+        .rate_hz = {0.5, 1.0, 2.0, 2.0},
+    },
+    // kGoxLine
+    {
+        .id = 6,
+        .priority = ChannelPriority::kNormal,
+        .rate_hz = {0.5, 1.0, 5.0, 2.0},
+    },
+    // kLoadCell
+    {
+        .id = 7,
+        .priority = ChannelPriority::kHigh,
+        .rate_hz = {0.5, 2.0, 10.0, 5.0},
+    },
+    // kValveStates
+    {
+        .id = 8,
+        .priority = ChannelPriority::kHigh,
+        .rate_hz = {1.0, 1.0, 2.0, 2.0},
+    },
+    // kHealth
+    {
+        .id = 9,
+        .priority = ChannelPriority::kLow,
+        .rate_hz = {0.2, 0.2, 0.2, 0.2},
+    },
+    // kAbortStatus
+    {
+        .id = 10,
+        .priority = ChannelPriority::kCritical,
+        .rate_hz = {1.0, 1.0, 1.0, 1.0},
+    },
+    // kCpuLoadCore0
+    {
+        .id = 11,
+        .priority = ChannelPriority::kLow,
+        .rate_hz = {0.2, 0.2, 0.2, 0.2},
+    },
+    // kCpuLoadCore1
+    {
+        .id = 12,
+        .priority = ChannelPriority::kLow,
+        .rate_hz = {0.2, 0.2, 0.2, 0.2},
+    },
+    // kDeadlineMisses
+    {
+        .id = 13,
+        .priority = ChannelPriority::kHigh,
+        .rate_hz = {1.0, 1.0, 1.0, 1.0},
+    },
+    // kDegraded
+    {
+        .id = 14,
+        .priority = ChannelPriority::kCritical,
+        .rate_hz = {1.0, 1.0, 1.0, 1.0},
+    },
+    // kHeapMinFree
+    {
+        .id = 15,
+        .priority = ChannelPriority::kLow,
+        .rate_hz = {0.2, 0.2, 0.2, 0.2},
+    },
+    // kStackMinFree
+    {
+        .id = 16,
+        .priority = ChannelPriority::kLow,
+        .rate_hz = {0.2, 0.2, 0.2, 0.2},
+    },
+};
+
+static_assert(sizeof(TELEMETRY_CHANNELS) / sizeof(TELEMETRY_CHANNELS[0]) ==
+                  static_cast<size_t>(TelemetryChannel::kTelemetryChannelMax),
+              "Every TelemetryChannel needs a ChannelSpec");
+
+// How often the radio task builds and sends a telemetry frame. A full 255
+// byte frame is about 400 ms on air at SF7/125 kHz.
+constexpr int TELEMETRY_FRAME_PERIOD_MS = 500;
+// How often achieved rates and the frame fill ratio are logged.
+constexpr int TELEMETRY_REPORT_PERIOD_MS = 60 * 1000;
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Trace zones (see trace.h) are compiled in unless NDEBUG is defined, i.e.
+// unless assertions are disabled (CONFIG_COMPILER_OPTIMIZATION_ASSERTIONS_
+// DISABLE, or a host Release build). Define TRACE_ENABLED to 0 or 1 to
+// override.
+#ifndef TRACE_ENABLED
+#ifdef NDEBUG
+#define TRACE_ENABLED 0
+#else
+#define TRACE_ENABLED 1
+#endif
+#endif
+
+// Code zones timed by TRACE_ZONE(). On-wire ids, so only append.
+enum class TraceZone : uint8_t {
+  // One pass of the acquisition loop in main.cc, delay excluded. Split into:
+  kAcquisitionLoop,
+  kAdcSpi,        // Holding and clocking the ADC bus for a PT read.
+  kPtConvert,     // Voltage to PSI.
+  kStandControl,  // Redlines and sequencer on a new reading.
+  kLogging,       // dlog(), the flight-data log and telemetry_record().
+  kLoadCellRead,
+  kValveActuation,
+  kRadioTx,  // LoRaSend(), sleeping until TX_DONE.
+  kRadioRx,  // Reading a packet out of the SX126x.
+  kCommand,  // Decoding and executing an uplink command.
+  kTelemetryBuild,
+  kWiredTx,
+  kDeferredLogDrain,
+  kDatalogService,  // Writing buffered records to flash.
+  kTraceZoneMax     // Not a valid zone, used for bounds checking.
+};
+
+// Names of the zones, in TraceZone order.
+constexpr const char* TRACE_ZONE_NAMES[] = {
+    "acquisition_loop",
+    "adc_spi",
+    "pt_convert",
+    "stand_control",
+    "logging",
+    "load_cell_read",
+    "valve_actuation",
+    "radio_tx",
+    "radio_rx",
+    "command",
+    "telemetry_build",
+    "wired_tx",
+    "deferred_log_drain",
+    "datalog_service",
+};
+
+static_assert(sizeof(TRACE_ZONE_NAMES) / sizeof(TRACE_ZONE_NAMES[0]) ==
+                  static_cast<size_t>(TraceZone::kTraceZoneMax),
+              "Every TraceZone needs a name");
+
+// While the wired link is up the table is sent every
+// TRACE_STREAM_PERIOD_MS (0 to only send it on request). LoRa only carries
+// it on request, through the kTrace command.
+constexpr int TRACE_STREAM_PERIOD_MS = 5000;
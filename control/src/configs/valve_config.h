@@ -1,23 +1,12 @@
 #pragma once
 
-#include <driver/gpio.h>
+#include <hal/gpio.h>
 
 #include "valve.h"
 
-enum class Valve {
-  kPressurizeFuelTank,
-  kPreslugFuel,
-  kN2PurgeFuelTankBypass,
-  kN2PurgeGox,
-  kPreslugGox,
-  kGoxRelease,
-  kFuelRelease,
-  kValveMax
-};
-
 struct ValveConfig {
   Valve valve;
-  gpio_num_t gpio_num;
+  hal_gpio_t gpio_num;
   int max_angle;
   int close_angle;
   int open_angle;
@@ -27,53 +16,54 @@ struct ValveConfig {
 // !!!! READ BEFORE MODIFYING !!!!
 // Ensure the valve type is in the same order as Valve enum variants.
 // Valve enum variants are used to index this array. See get_servo_config.
+// A valve on a pin another peripheral uses is not set up at boot; see boot.cc.
 // 7, 5, 38, 39
 constexpr ValveConfig VALVE_CONFIGS[] = {
     ValveConfig{
         .valve = Valve::kPressurizeFuelTank,
-        .gpio_num = GPIO_NUM_19,
+        .gpio_num = 19,
         .max_angle = 180,
         .close_angle = 180,
         .open_angle = 90,
     },
     ValveConfig{
         .valve = Valve::kPreslugFuel,
-        .gpio_num = GPIO_NUM_20,
+        .gpio_num = 20,
         .max_angle = 180,
         .close_angle = 180,
         .open_angle = 85,
     },
     ValveConfig{
         .valve = Valve::kN2PurgeFuelTankBypass,
-        .gpio_num = GPIO_NUM_21,
+        .gpio_num = 21,
         .max_angle = 180,
         .close_angle = 180,
         .open_angle = 85,
     },
     ValveConfig{
         .valve = Valve::kN2PurgeGox,
-        .gpio_num = GPIO_NUM_26,
+        .gpio_num = 26,
         .max_angle = 180,
         .close_angle = 85,
         .open_angle = 0,
     },
     ValveConfig{
         .valve = Valve::kPreslugGox,
-        .gpio_num = GPIO_NUM_48,
+        .gpio_num = 48,
         .max_angle = 180,
         .close_angle = 85,
         .open_angle = 0,
     },
     ValveConfig{
         .valve = Valve::kGoxRelease,
-        .gpio_num = GPIO_NUM_47,
+        .gpio_num = 47,
         .max_angle = 180,
         .close_angle = 85,
         .open_angle = 0,
     },
     ValveConfig{
         .valve = Valve::kFuelRelease,
-        .gpio_num = GPIO_NUM_33,
+        .gpio_num = 33,
         .max_angle = 180,
         .close_angle = 85,
         .open_angle = 0,
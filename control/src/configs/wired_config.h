@@ -0,0 +1,47 @@
+#pragma once
+
+#include <hal/uart.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Wired telemetry shares the console UART: on the Heltec V3 the USB port is a
+// CP2102 bridge to UART0, so a host on the USB cable reads log lines and
+// frames from the same stream and skips whatever isn't a frame. The port is
+// switched to WIRED_BAUD_RATE at init; open the monitor at that rate
+// (`pio device monitor -b 921600`) to read the log after boot.
+constexpr hal_uart_port_t WIRED_UART_PORT = 0;  // UART0
+constexpr int WIRED_BAUD_RATE = 921600;
+
+// Driver buffers. Frames are only written when the TX buffer has room for a
+// whole one, so samples wait in the ring rather than blocking the task.
+constexpr int WIRED_TX_BUFFER_SIZE = 8192;
+constexpr int WIRED_RX_BUFFER_SIZE = 1024;
+
+// Samples waiting for the wired task, 16 bytes each. Sized for several task
+// periods at the full acquisition rate of every channel (8 channels at 1 kHz
+// fill 80 entries per period). Must be a power of two.
+constexpr size_t WIRED_SAMPLE_RING_SIZE = 1024;
+
+// The link is up while the host sends a kHeartbeat frame at least this often.
+// While it is up every telemetry sample goes over the wire and the LoRa
+// downlink only carries acknowledgements; when it drops, the LoRa telemetry
+// schedule takes over again.
+constexpr int WIRED_LINK_TIMEOUT_MS = 1000;
+
+// While the link is up the board synchronizes its clock with the host's
+// (telemetry/time_sync.h) and stamps wired samples in host time once synced.
+// The wired task waits up to WIRED_TIME_SYNC_TIMEOUT_MS for each reply, so
+// the arrival time is taken as it comes rather than at the next period.
+constexpr int WIRED_TIME_SYNC_PERIOD_MS = 1000;
+constexpr int WIRED_TIME_SYNC_TIMEOUT_MS = 20;
+// Exchanges slower than the fastest recent one by more than this are left
+// out; a 255-byte frame takes 2.8 ms at WIRED_BAUD_RATE.
+constexpr uint32_t WIRED_TIME_SYNC_DELAY_SLACK_US = 500;
+
+// One FreeRTOS tick at CONFIG_FREERTOS_HZ=100.
+constexpr int WIRED_TASK_PERIOD_MS = 10;
+constexpr int WIRED_REPORT_PERIOD_MS = 60 * 1000;
+constexpr uint32_t WIRED_TASK_STACK_SIZE = 4096;
+// Below the radio and command tasks, above the datalog writer.
+constexpr int WIRED_TASK_PRIORITY = 5;
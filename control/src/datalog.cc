@@ -0,0 +1,394 @@
+#include "datalog.h"
+
+#include <compress/gorilla.h>
+#include <datalog/capture_ring.h>
+#include <datalog/column_file.h>
+#include <datalog/flash_log.h>
+#include <datalog/flash_storage.h>
+#include <esp_log.h>
+#include <hal/flash.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstdint>
+
+#include "command.h"
+#include "configs/datalog_config.h"
+#include "trace.h"
+
+static const char* TAG = "DATALOG";
+
+// FlashStorage on a raw data partition.
+class PartitionStorage : public FlashStorage {
+ public:
+  explicit PartitionStorage(const hal_partition_t* partition)
+      : partition_(partition) {}
+
+  uint32_t size() const override {
+    return partition_ == nullptr ? 0 : hal_partition_size(partition_);
+  }
+  bool erase(uint32_t offset, uint32_t size) override {
+    return hal_partition_erase(partition_, offset, size);
+  }
+  bool write(uint32_t offset, const void* data, size_t size) override {
+    return hal_partition_write(partition_, offset, data, size);
+  }
+  bool read(uint32_t offset, void* data, size_t size) override {
+    return hal_partition_read(partition_, offset, data, size);
+  }
+
+ private:
+  const hal_partition_t* partition_;
+};
+
+static PartitionStorage STORAGE(nullptr);
+static FlashLog FLASH_LOG(&STORAGE);
+static std::atomic<bool> ERASE_REQUESTED{false};
+
+// Every PT, the load cell and every valve get a column.
+constexpr uint16_t COLUMN_CHANNEL_COUNT = static_cast<int>(Pt::kPtMax) + 1 +
+                                          static_cast<int>(Valve::kValveMax);
+static_assert(COLUMN_CHANNEL_COUNT <= COLUMN_MAX_CHANNELS,
+              "Too many column channels");
+static ColumnChannel COLUMN_CHANNELS[COLUMN_CHANNEL_COUNT];
+static PartitionStorage COLUMN_STORAGE(nullptr);
+static ColumnBlock COLUMN_BLOCKS[COLUMN_CHANNEL_COUNT];
+static ColumnWriter COLUMN_WRITER(&COLUMN_STORAGE, COLUMN_BLOCKS);
+
+// One encoder per column channel, for DATALOG_MEASURE_COMPRESSION.
+struct ChannelCompressor {
+  uint8_t block[DATALOG_COMPRESS_BLOCK_SIZE];
+  GorillaEncoder encoder{block, sizeof(block)};
+};
+static ChannelCompressor COMPRESSORS[COLUMN_CHANNEL_COUNT];
+
+struct CompressionStats {
+  uint32_t samples;
+  uint32_t bytes;
+  uint64_t cycles;
+};
+
+// Full-rate samples go to the ring until a trigger, then straight to flash
+// while STREAMING.
+static CaptureRing<DATALOG_CAPTURE_RING_SIZE> CAPTURE_RING;
+static std::atomic<bool> STREAMING{false};
+static std::atomic<int64_t> STREAM_UNTIL_US{0};
+static std::atomic<int64_t> TRIGGER_US{0};
+static std::atomic<uint32_t> TRIGGERS{0};
+static uint32_t CAPTURED = 0;
+// Set by the writer when a capture ends, until it is exported.
+static bool EXPORT_PENDING = false;
+
+// Owned by the writer task.
+static uint64_t WRITE_TIME_TOTAL_US = 0;
+static uint32_t WRITE_TIME_MAX_US = 0;
+
+static LogRecord make_record(RecordType type, uint8_t id, uint16_t aux,
+                             float value,
+                             uint64_t t_us = hal_time_us()) {
+  return {
+      .t_us = t_us,
+      .type = type,
+      .id = id,
+      .aux = aux,
+      .value = value,
+  };
+}
+
+// Full-rate samples. The ring refuses records once frozen, which can race
+// with STREAMING being set; those go to flash too.
+static void append_sample(const LogRecord& record) {
+  if (STREAMING || !CAPTURE_RING.push(record)) {
+    FLASH_LOG.append(record);
+  }
+}
+
+void datalog_pt(Pt pt, float psi) {
+  append_sample(make_record(RecordType::kPt, static_cast<uint8_t>(pt), 0, psi));
+}
+
+void datalog_pt(Pt pt, float psi, uint64_t t_us) {
+  append_sample(
+      make_record(RecordType::kPt, static_cast<uint8_t>(pt), 0, psi, t_us));
+}
+
+void datalog_load_cell(float raw) {
+  append_sample(make_record(RecordType::kLoadCell, 0, 0, raw));
+}
+
+// Valve changes and events are rare and always go to flash.
+void datalog_valve(Valve valve, bool open) {
+  FLASH_LOG.append(
+      make_record(RecordType::kValve, static_cast<uint8_t>(valve), open, 0));
+}
+
+void datalog_event(LogEvent event, uint16_t arg) {
+  FLASH_LOG.append(
+      make_record(RecordType::kEvent, static_cast<uint8_t>(event), arg, 0));
+}
+
+void datalog_trigger(LogEvent event, uint16_t arg) {
+  datalog_event(event, arg);
+  int64_t now_us = hal_time_us();
+  STREAM_UNTIL_US = now_us + DATALOG_POST_TRIGGER_MS * 1000;
+  TRIGGERS++;
+  // Only the first trigger of a capture freezes the ring; later ones extend
+  // the post-trigger window.
+  if (!STREAMING.exchange(true)) {
+    TRIGGER_US = now_us;
+    CAPTURE_RING.freeze();
+  }
+}
+
+void datalog_request_erase() { ERASE_REQUESTED = true; }
+
+static void log_report() {
+  DatalogStats stats = get_datalog_stats();
+  ESP_LOGI(TAG,
+           "session %" PRIu32 ": %" PRIu32 " records, %" PRIu32
+           " dropped, %" PRIu32 " sectors, high water %" PRIu32 ", %" PRIu32
+           " B/s, max write %" PRIu32 " us, %" PRIu32 " triggers, %" PRIu32
+           " captured%s",
+           stats.session, stats.log.records, stats.log.dropped,
+           stats.log.sectors_written, stats.log.high_water,
+           stats.write_bytes_per_s, stats.write_time_max_us, stats.triggers,
+           stats.captured, stats.log.full ? ", FULL" : "");
+}
+
+// Moves the pre-trigger window from the frozen ring into flash, servicing
+// the flash log whenever both of its buffers are full.
+static void write_capture() {
+  const int64_t from_us = TRIGGER_US - DATALOG_PRETRIGGER_MS * 1000;
+  for (size_t i = 0; i < CAPTURE_RING.size(); i++) {
+    const LogRecord& record = CAPTURE_RING.at(i);
+    if (static_cast<int64_t>(record.t_us) < from_us) {
+      continue;
+    }
+    bool appended = FLASH_LOG.try_append(record);
+    for (int retry = 0; !appended && retry < DATALOG_CAPTURE_APPEND_RETRIES;
+         retry++) {
+      if (!FLASH_LOG.service()) {
+        break;  // Log full or closed, or a producer holds the oldest buffer.
+      }
+      appended = FLASH_LOG.try_append(record);
+    }
+    if (appended) {
+      CAPTURED++;
+    } else {
+      FLASH_LOG.drop();
+    }
+  }
+}
+
+// Compresses a record exported to the column file into its channel's block.
+static void compress_record(const LogRecord& record, CompressionStats* stats) {
+  for (uint16_t i = 0; i < COLUMN_CHANNEL_COUNT; i++) {
+    if (COLUMN_CHANNELS[i].type != record.type ||
+        COLUMN_CHANNELS[i].id != record.id) {
+      continue;
+    }
+    float value = record.type == RecordType::kValve ? record.aux : record.value;
+    GorillaEncoder& encoder = COMPRESSORS[i].encoder;
+    uint32_t start = hal_cycle_count();
+    if (!encoder.append(record.t_us, value)) {
+      stats->bytes += encoder.finish();
+      encoder.reset();
+      encoder.append(record.t_us, value);
+    }
+    stats->cycles += hal_cycle_count() - start;
+    stats->samples++;
+    return;
+  }
+}
+
+static void log_compression(CompressionStats* stats) {
+  for (ChannelCompressor& compressor : COMPRESSORS) {
+    if (compressor.encoder.count() > 0) {
+      stats->bytes += compressor.encoder.finish();
+    }
+    compressor.encoder.reset();
+  }
+  if (stats->samples == 0) {
+    return;
+  }
+  // Against a 12-byte (u64 time, f32 value) sample.
+  const uint32_t cycles_per_us = hal_cycles_per_us();
+  ESP_LOGI(TAG,
+           "Capture compressed: %" PRIu32 " samples, %" PRIu32
+           " bytes, ratio %.2f, %.2f us per sample",
+           stats->samples, stats->bytes, stats->samples * 12.0f / stats->bytes,
+           static_cast<float>(stats->cycles) / stats->samples / cycles_per_us);
+}
+
+// Writes the latest capture to the column partition. Its records are read
+// back from the flight-data log, so flush that first.
+static void export_capture() {
+  if (COLUMN_STORAGE.size() == 0) {
+    return;
+  }
+  const uint32_t session = FLASH_LOG.session();
+  if (!COLUMN_WRITER.open(COLUMN_CHANNELS, COLUMN_CHANNEL_COUNT, session)) {
+    ESP_LOGE(TAG, "Can't write the column file");
+    return;
+  }
+  // The pre-trigger window reaches flash after the first streamed records, so
+  // read the log twice to keep every channel in time order.
+  const int64_t trigger_us = TRIGGER_US;
+  const int64_t from_us = trigger_us - DATALOG_PRETRIGGER_MS * 1000;
+  CompressionStats compression = {};
+  for (bool before_trigger : {true, false}) {
+    read_flash_log(&STORAGE, [&](uint32_t record_session,
+                                 const LogRecord& record) {
+      int64_t t_us = record.t_us;
+      if (record_session == session && t_us >= from_us &&
+          (t_us < trigger_us) == before_trigger &&
+          COLUMN_WRITER.append(record) && DATALOG_MEASURE_COMPRESSION) {
+        compress_record(record, &compression);
+      }
+    });
+  }
+  bool finished = COLUMN_WRITER.finish();
+  ColumnWriterStats stats = COLUMN_WRITER.stats();
+  ESP_LOGI(TAG,
+           "Capture exported%s: %" PRIu32 " samples, %" PRIu32
+           " blocks, %" PRIu32 " bytes, %" PRIu32 " out of order, %" PRIu32
+           " dropped",
+           finished ? "" : " (truncated)", stats.samples, stats.blocks,
+           COLUMN_WRITER.bytes_written(), stats.out_of_order, stats.dropped);
+  log_compression(&compression);
+}
+
+static void datalog_task(void* arg) {
+  const hal_tick_t service_period = HAL_MS_TO_TICKS(DATALOG_SERVICE_PERIOD_MS);
+  const hal_tick_t flush_period = HAL_MS_TO_TICKS(DATALOG_FLUSH_PERIOD_MS);
+  const hal_tick_t report_period = HAL_MS_TO_TICKS(DATALOG_REPORT_PERIOD_MS);
+  hal_tick_t last_write = hal_tick_count();
+  hal_tick_t next_report = hal_tick_count() + report_period;
+  while (1) {
+    if (ERASE_REQUESTED) {
+      // kBusy: a producer was mid-append; retry on the next pass.
+      switch (FLASH_LOG.erase_all()) {
+        case EraseResult::kErased:
+          ESP_LOGI(TAG, "Erased, session %" PRIu32, FLASH_LOG.session());
+          ERASE_REQUESTED = false;
+          break;
+        case EraseResult::kBusy:
+          break;
+        case EraseResult::kFailed:
+          ESP_LOGE(TAG, "Erase failed");
+          ERASE_REQUESTED = false;
+          break;
+      }
+    }
+
+    // The ring settles as soon as producers preempted mid-push run again.
+    if (CAPTURE_RING.frozen() && CAPTURE_RING.settled()) {
+      write_capture();
+      CAPTURE_RING.thaw();
+    }
+    if (STREAMING && hal_time_us() >= STREAM_UNTIL_US &&
+        get_stand_state() == StandState::kSafe && !CAPTURE_RING.frozen()) {
+      STREAMING = false;
+      EXPORT_PENDING = true;
+      FLASH_LOG.flush();
+    }
+
+    while (1) {
+      TRACE_ZONE(kDatalogService);
+      int64_t start = hal_time_us();
+      if (!FLASH_LOG.service()) {
+        break;
+      }
+      uint32_t elapsed_us = hal_time_us() - start;
+      WRITE_TIME_TOTAL_US += elapsed_us;
+      WRITE_TIME_MAX_US = std::max(WRITE_TIME_MAX_US, elapsed_us);
+      last_write = hal_tick_count();
+    }
+    if (EXPORT_PENDING) {
+      export_capture();
+      EXPORT_PENDING = false;
+    }
+
+    // Padding costs a sector per flush, so only bound the loss while the
+    // stand is live; when safe, sectors are written as they fill.
+    hal_tick_t now = hal_tick_count();
+    if ((STREAMING || get_stand_state() != StandState::kSafe) &&
+        now - last_write >= flush_period) {
+      FLASH_LOG.flush();
+      last_write = now;
+    }
+    if (static_cast<int32_t>(now - next_report) >= 0) {
+      log_report();
+      next_report = now + report_period;
+    }
+    hal_delay_ticks(service_period);
+  }
+}
+
+void init_datalog() {
+  const hal_partition_t* partition =
+      hal_partition_find(DATALOG_PARTITION_LABEL);
+  if (partition == nullptr) {
+    ESP_LOGE(TAG, "No \"%s\" partition, flight-data log disabled",
+             DATALOG_PARTITION_LABEL);
+    return;
+  }
+  STORAGE = PartitionStorage(partition);
+  if (!FLASH_LOG.open()) {
+    ESP_LOGE(TAG, "Can't open the flight-data log");
+    return;
+  }
+  ESP_LOGI(TAG, "Session %" PRIu32 ", %" PRIu32 " bytes free",
+           FLASH_LOG.session(), FLASH_LOG.free_bytes());
+
+  const hal_partition_t* columns = hal_partition_find(COLUMNS_PARTITION_LABEL);
+  if (columns == nullptr) {
+    ESP_LOGW(TAG, "No \"%s\" partition, captures won't be exported",
+             COLUMNS_PARTITION_LABEL);
+  } else {
+    COLUMN_STORAGE = PartitionStorage(columns);
+  }
+  uint16_t channel = 0;
+  for (int pt = 0; pt < static_cast<int>(Pt::kPtMax); pt++) {
+    COLUMN_CHANNELS[channel++] = {
+        .type = RecordType::kPt,
+        .id = static_cast<uint8_t>(pt),
+        .reserved = 0,
+    };
+  }
+  COLUMN_CHANNELS[channel++] = {
+      .type = RecordType::kLoadCell,
+      .id = 0,
+      .reserved = 0,
+  };
+  for (int valve = 0; valve < static_cast<int>(Valve::kValveMax); valve++) {
+    COLUMN_CHANNELS[channel++] = {
+        .type = RecordType::kValve,
+        .id = static_cast<uint8_t>(valve),
+        .reserved = 0,
+    };
+  }
+  datalog_event(LogEvent::kBoot);
+
+  hal_task_create(datalog_task, "datalog", DATALOG_TASK_STACK_SIZE, nullptr,
+                  DATALOG_TASK_PRIORITY, nullptr);
+}
+
+DatalogStats get_datalog_stats() {
+  FlashLogStats log = FLASH_LOG.stats();
+  return {
+      .log = log,
+      .session = FLASH_LOG.session(),
+      .write_bytes_per_s =
+          WRITE_TIME_TOTAL_US == 0
+              ? 0
+              : static_cast<uint32_t>(FLASH_LOG.bytes_written() * 1000000 /
+                                      WRITE_TIME_TOTAL_US),
+      .write_time_max_us = WRITE_TIME_MAX_US,
+      .triggers = TRIGGERS,
+      .captured = CAPTURED,
+  };
+}
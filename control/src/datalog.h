@@ -0,0 +1,47 @@
+#pragma once
+
+#include <datalog/flash_log.h>
+
+#include <cstdint>
+
+#include "pt.h"
+#include "valve.h"
+
+struct DatalogStats {
+  FlashLogStats log;
+  uint32_t session;
+  // Average flash programming rate while writing, in bytes/s.
+  uint32_t write_bytes_per_s;
+  uint32_t write_time_max_us;
+  uint32_t triggers;
+  // Pre-trigger records moved from the capture ring to flash.
+  uint32_t captured;
+};
+
+// Opens the flight-data log partition, starting a new session after the
+// previous ones, and starts the writer task. See configs/datalog_config.h.
+void init_datalog();
+
+// Timestamped records. Safe to call from any task; never blocks, and drops the
+// record (see DatalogStats) if the writer has fallen behind.
+//
+// PT and load cell samples are kept in the pre-trigger capture ring and only
+// reach flash around triggers; valve changes and events always do.
+void datalog_pt(Pt pt, float psi);
+// Same, for a reading taken at `t_us` (esp_timer_get_time()), so the record
+// matches what the stand logic saw. See stand_control.h.
+void datalog_pt(Pt pt, float psi, uint64_t t_us);
+void datalog_load_cell(float raw);
+void datalog_valve(Valve valve, bool open);
+void datalog_event(LogEvent event, uint16_t arg = 0);
+
+// Logs `event` and captures the samples around it: the last
+// DATALOG_PRETRIGGER_MS from the capture ring, then everything until
+// DATALOG_POST_TRIGGER_MS later. See configs/datalog_config.h.
+void datalog_trigger(LogEvent event, uint16_t arg = 0);
+
+// Erases every session in the partition. Takes a few seconds in the writer
+// task; records are dropped meanwhile.
+void datalog_request_erase();
+
+DatalogStats get_datalog_stats();
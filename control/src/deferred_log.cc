@@ -0,0 +1,94 @@
+#include "deferred_log.h"
+
+#include <binlog/binlog.h>
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <telemetry/spsc_ring.h>
+
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+
+#include "configs/log_format_config.h"
+#include "configs/periodic_task_config.h"
+#include "periodic_task.h"
+#include "trace.h"
+
+static const char* TAG = "DLOG";
+
+// One ring per core. With interrupts masked on its core a writer can't be
+// preempted, so each ring has a single producer at a time and needs no lock.
+static SpscRing<BinLogRecord, DEFERRED_LOG_RING_SIZE> RINGS[HAL_CORE_COUNT];
+
+void deferred_log_write(BinLogRecord& record) {
+  uint32_t mask = hal_mask_interrupts();
+  int core = hal_core_id();
+  record.core = core;
+  RINGS[core].push(record);
+  hal_unmask_interrupts(mask);
+}
+
+// Prints the buffered records of every core, oldest first.
+static void drain() {
+  TRACE_ZONE(kDeferredLogDrain);
+  char line[BINLOG_LINE_MAX_SIZE];
+  while (1) {
+    BinLogRecord* oldest = nullptr;
+    int oldest_core = 0;
+    for (int core = 0; core < HAL_CORE_COUNT; core++) {
+      BinLogRecord* record = RINGS[core].front();
+      if (record != nullptr &&
+          (oldest == nullptr || record->t_us < oldest->t_us)) {
+        oldest = record;
+        oldest_core = core;
+      }
+    }
+    if (oldest == nullptr) {
+      break;
+    }
+    size_t len = format_binlog_line(*oldest, line, sizeof(line));
+    RINGS[oldest_core].pop();
+    if (len > 0) {
+      std::puts(line);
+    }
+  }
+}
+
+static void drain_task(void* arg) { drain(); }
+
+void init_deferred_log() {
+  start_periodic_task(DEFERRED_LOG_TASK, drain_task, nullptr);
+}
+
+uint32_t get_deferred_log_dropped() {
+  uint32_t dropped = 0;
+  for (const auto& ring : RINGS) {
+    dropped += ring.dropped();
+  }
+  return dropped;
+}
+
+void measure_deferred_log() {
+  constexpr int kCalls = 100;
+  const float psi = 123.45f;
+
+  uint32_t start = hal_cycle_count();
+  for (int i = 0; i < kCalls; i++) {
+    ESP_LOGI("PT", "PT %u: %.2f psi", 0u, psi);
+  }
+  uint32_t esp_log_cycles = hal_cycle_count() - start;
+
+  start = hal_cycle_count();
+  for (int i = 0; i < kCalls; i++) {
+    dlog(LogFormat::kPtReading, 0u, psi);
+  }
+  uint32_t dlog_cycles = hal_cycle_count() - start;
+
+  const uint32_t cycles_per_us = hal_cycles_per_us();
+  ESP_LOGI(TAG,
+           "Per call: ESP_LOGI %" PRIu32 " cycles (%" PRIu32
+           " us), dlog %" PRIu32 " cycles (%" PRIu32 " us)",
+           esp_log_cycles / kCalls, esp_log_cycles / kCalls / cycles_per_us,
+           dlog_cycles / kCalls, dlog_cycles / kCalls / cycles_per_us);
+}
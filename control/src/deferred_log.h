@@ -0,0 +1,34 @@
+#pragma once
+
+#include <binlog/binlog.h>
+#include <hal/timer.h>
+
+#include <cstdint>
+
+#include "configs/log_format_config.h"
+
+// Writes a record to this core's deferred log buffer. Use dlog() instead.
+void deferred_log_write(BinLogRecord& record);
+
+// Deferred replacement for ESP_LOGx in timing-critical code: stores `format`
+// and the raw arguments; the drain task prints them later as binary lines
+// that `binlog_expand` on the ground turns back into text. Safe from any task
+// or ISR; never blocks, and drops the record if the buffer is full.
+//
+//   dlog(LogFormat::kPtReading, static_cast<unsigned>(pt), psi);
+template <typename... Args>
+void dlog(LogFormat format, Args... args) {
+  BinLogRecord record = make_binlog_record(
+      hal_time_us(), static_cast<uint16_t>(format), args...);
+  deferred_log_write(record);
+}
+
+// Starts the drain task. See configs/log_format_config.h.
+void init_deferred_log();
+
+// Records dropped because a core's buffer was full.
+uint32_t get_deferred_log_dropped();
+
+// Logs the average cost of an ESP_LOGI call and of a dlog() call with the
+// same arguments.
+void measure_deferred_log();
@@ -1,14 +1,16 @@
 #include "ignition.h"
 
-#include <driver/gpio.h>
+#include <hal/gpio.h>
 
 #include "configs/ignition_config.h"
 
-void setup_ignition_relay() {
-  gpio_reset_pin(IGNITION_GPIO_NUM);
-  gpio_set_direction(IGNITION_GPIO_NUM, GPIO_MODE_OUTPUT);
+void setup_ignition_relay() { hal_gpio_output(IGNITION_GPIO_NUM); }
+
+void init_ignition() {
+  setup_ignition_relay();
+  set_ignition_relay_low();
 }
 
-void set_ignition_relay_high() { gpio_set_level(IGNITION_GPIO_NUM, 1); }
+void set_ignition_relay_high() { hal_gpio_set_level(IGNITION_GPIO_NUM, 1); }
 
-void set_ignition_relay_low() { gpio_set_level(IGNITION_GPIO_NUM, 0); }
+void set_ignition_relay_low() { hal_gpio_set_level(IGNITION_GPIO_NUM, 0); }
@@ -3,6 +3,9 @@
 // Set up ignition relay GPIO pin.
 void setup_ignition_relay();
 
+// Sets up the ignition relay and leaves it low, the stand's safe state.
+void init_ignition();
+
 // Set ignition relay to high. This connects COM -> NO.
 void set_ignition_relay_high();
 
@@ -1,30 +1,136 @@
 #include "load_cell.h"
 
 #include <esp_err.h>
-#include <hx711.h>
 
+#include <atomic>
 #include <cstdint>
 
 #include "configs/load_cell_config.h"
+#include "trace.h"
+
+// Set once the pins are set up; the acquisition task may start polling
+// earlier.
+static std::atomic<bool> READY{false};
 
-hx711_t dev = {
-    .dout = HX711_DOUT_GPIO_NUM,
-    .pd_sck = HX711_PD_SCK_GPIO_NUM,
-    .gain = HX711_GAIN,
+#ifdef ESP_PLATFORM
+
+#include <hx711.h>
+
+// The board runs esp-idf-lib's driver (components/hx711), whose gains count
+// from 0 where Hx711Gain counts extra clock pulses.
+static hx711_t DEV = {
+    .dout = static_cast<gpio_num_t>(HX711_DOUT_GPIO_NUM),
+    .pd_sck = static_cast<gpio_num_t>(HX711_PD_SCK_GPIO_NUM),
+    .gain = static_cast<hx711_gain_t>(static_cast<int>(HX711_GAIN) - 1),
 };
 
-void init_load_cell() { ESP_ERROR_CHECK(hx711_init(&dev)); }
+void init_load_cell() {
+  ESP_ERROR_CHECK(hx711_init(&DEV));
+  READY = true;
+}
 
-esp_err_t read_raw_load_cell(int32_t* value) {
-  esp_err_t r = hx711_wait(&dev, HX711_MAX_TIMEOUT_MS);
+static esp_err_t read_average(int32_t* value) {
+  esp_err_t r = hx711_wait(&DEV, HX711_MAX_TIMEOUT_MS);
   if (r != ESP_OK) {
     return r;
   }
+  return hx711_read_average(&DEV, HX711_AVG_SAMPLE_COUNT, value);
+}
 
-  r = hx711_read_average(&dev, HX711_AVG_SAMPLE_COUNT, value);
+static esp_err_t read_if_ready(int32_t* value) {
+  bool ready = false;
+  esp_err_t r = hx711_is_ready(&DEV, &ready);
   if (r != ESP_OK) {
     return r;
   }
+  if (!ready) {
+    return ESP_ERR_NOT_FINISHED;
+  }
+  return hx711_read_data(&DEV, value);
+}
 
+#else
+
+#include <hal/gpio.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+
+// esp-idf-lib doesn't build on the host: the same protocol on the HAL's GPIO
+// calls, so the load cell runs against sim/hx711_sim.h.
+
+// The clock pulses of a conversion can't be interrupted: PD_SCK held high
+// for 60 us powers the HX711 down.
+static hal_spinlock_t READ_LOCK = HAL_SPINLOCK_INIT;
+
+void init_load_cell() {
+  hal_gpio_input(HX711_DOUT_GPIO_NUM);
+  hal_gpio_output(HX711_PD_SCK_GPIO_NUM);
+  hal_gpio_set_level(HX711_PD_SCK_GPIO_NUM, 0);
+  READY = true;
+}
+
+// DOUT goes low when a conversion is ready.
+static bool wait_ready() {
+  const int64_t deadline_us = hal_time_us() + HX711_MAX_TIMEOUT_MS * 1000LL;
+  while (hal_gpio_get_level(HX711_DOUT_GPIO_NUM)) {
+    if (hal_time_us() >= deadline_us) {
+      return false;
+    }
+    hal_delay_ticks(1);
+  }
+  return true;
+}
+
+// Shifts out a conversion, MSB first, and selects the gain of the next one.
+static int32_t read_conversion() {
+  const int pulses = 24 + static_cast<int>(HX711_GAIN);
+  uint32_t data = 0;
+  hal_enter_critical(&READ_LOCK);
+  for (int i = 0; i < pulses; i++) {
+    hal_gpio_set_level(HX711_PD_SCK_GPIO_NUM, 1);
+    hal_delay_us(1);
+    if (i < 24) {
+      data = data << 1 | hal_gpio_get_level(HX711_DOUT_GPIO_NUM);
+    }
+    hal_gpio_set_level(HX711_PD_SCK_GPIO_NUM, 0);
+    hal_delay_us(1);
+  }
+  hal_exit_critical(&READ_LOCK);
+  // 24-bit two's complement.
+  return static_cast<int32_t>(data << 8) >> 8;
+}
+
+static esp_err_t read_average(int32_t* value) {
+  int64_t sum = 0;
+  for (int i = 0; i < HX711_AVG_SAMPLE_COUNT; i++) {
+    if (!wait_ready()) {
+      return ESP_ERR_TIMEOUT;
+    }
+    sum += read_conversion();
+  }
+  *value = sum / HX711_AVG_SAMPLE_COUNT;
+  return ESP_OK;
+}
+
+static esp_err_t read_if_ready(int32_t* value) {
+  if (hal_gpio_get_level(HX711_DOUT_GPIO_NUM)) {
+    return ESP_ERR_NOT_FINISHED;
+  }
+  *value = read_conversion();
   return ESP_OK;
-}
\ No newline at end of file
+}
+
+#endif  // ESP_PLATFORM
+
+esp_err_t read_raw_load_cell(int32_t* value) {
+  TRACE_ZONE(kLoadCellRead);
+  return read_average(value);
+}
+
+esp_err_t poll_raw_load_cell(int32_t* value) {
+  if (!READY) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  TRACE_ZONE(kLoadCellRead);
+  return read_if_ready(value);
+}
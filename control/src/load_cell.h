@@ -4,6 +4,15 @@
 
 #include <cstdint>
 
+// Sets up the HX711's pins and powers it up.
 void init_load_cell();
 
-esp_err_t read_raw_load_cell(uint32_t* value);
\ No newline at end of file
+// Averages HX711_AVG_SAMPLE_COUNT conversions, as raw 24-bit counts. Returns
+// ESP_ERR_TIMEOUT if the HX711 doesn't become ready.
+esp_err_t read_raw_load_cell(int32_t* value);
+
+// Takes the HX711's latest conversion, as raw 24-bit counts, without waiting
+// for one. Returns ESP_ERR_NOT_FINISHED if no conversion is ready, and
+// ESP_ERR_INVALID_STATE before init_load_cell(). Safe to call from another
+// task than the one that set the load cell up.
+esp_err_t poll_raw_load_cell(int32_t* value);
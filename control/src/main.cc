@@ -1,57 +1,21 @@
-#include <hx711.h>
+#include <hal/rtos.h>
 
-#include <cstdint>
-
-#include "esp_log.h"
-#include "esp_timer.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
-#include "ignition.h"
-#include "load_cell.h"
-#include "pt.h"
-#include "pt_adc.h"
-#include "ra01s.h"
-#include "valve.h"
+#include "benchmarks.h"
+#include "boot.h"
+#include "configs/bench_config.h"
+#include "memory_usage.h"
 
 extern "C" void app_main() {
-  init_load_cell();
-  uint32_t value;
-  read_raw_load_cell(&value);
-  // LoRaInit();
-
-  // setup_ignition_relay();
-  // set_ignition_relay_high();
-  // vTaskDelay(pdMS_TO_TICKS(10000));  // Wait 10s
-  // set_ignition_relay_low();
-
-  // setup_valves();
-
-  // open_valve(Valve::kOxRelease);
-  // open_valve(Valve::kOxN2Purge);
-  // open_valve(Valve::kFuelRelease);
-
-  // vTaskDelay(pdMS_TO_TICKS(1000));  // Wait a second
-
-  // close_valve(Valve::kOxRelease);
-  // close_valve(Valve::kOxRelease);
-  // close_valve(Valve::kOxN2Purge);
-  // close_valve(Valve::kFuelRelease);
-
-  init_pt_adc_spi();
+  if (BENCH_AT_BOOT) {
+    run_benchmarks();
+    return;
+  }
+  boot();
+  memory_init_done();
+  // Everything runs on the tasks boot() started. This one stays, tracked by
+  // memory_init_done(), and only takes the notifications of boot phases that
+  // finish after their timeout.
   while (1) {
-    // int64_t start = esp_timer_get_time();
-    float psi_chamber = read_pt(Pt::kChamber);
-    ESP_LOGI("PT", "Chamber Pressure: %.2f psi", psi_chamber);
-    // float psi_eth_line = read_pt(Pt::kEthLine);
-    // float psi_eth_n2 = read_pt(Pt::kEthN2Reg);
-    // float psi_gox = read_pt(Pt::kGoxLine);
-    // float psi_gox_reg = read_pt(Pt::kGoxReg);
-    // float psi_ing_eth = read_pt(Pt::kInjectorEth);
-    // float psi_inj_gox = read_pt(Pt::kInjectorGox);
-    // int64_t end = esp_timer_get_time();
-    // int64_t elapsed_us = end - start;
-    // printf("Function took %lld us\n", elapsed_us);
-
-    vTaskDelay(pdMS_TO_TICKS(1500));
+    hal_task_notify_wait(HAL_WAIT_FOREVER);
   }
-}
\ No newline at end of file
+}
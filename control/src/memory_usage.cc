@@ -0,0 +1,83 @@
+#include "memory_usage.h"
+
+#include <esp_log.h>
+#include <hal/memory.h>
+#include <hal/rtos.h>
+#include <hal/system.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "configs/memory_config.h"
+#include "configs/telemetry_config.h"
+#include "telemetry.h"
+
+static const char* TAG = "MEMORY";
+
+// Allocations seen by memory_init_done().
+static uint32_t INIT_ALLOCS = 0;
+
+// __FILE__ is a full path on the board.
+static const char* file_name(const char* path) {
+  const char* slash = std::strrchr(path, '/');
+  return slash == nullptr ? path : slash + 1;
+}
+
+void memory_init_done() {
+  hal_task_track(hal_task_current(), "main", MAIN_TASK_STACK_SIZE);
+  INIT_ALLOCS = hal_heap_alloc_count();
+  memory_log_report();
+  if (ASSERT_NO_ALLOC_AFTER_INIT) {
+    ESP_LOGW(TAG, "Any further heap allocation aborts");
+    hal_heap_forbid_allocs();
+  }
+}
+
+void memory_record_telemetry() {
+  telemetry_record(TelemetryChannel::kHeapMinFree, hal_min_free_heap_size());
+  hal_task_stack_t stacks[HAL_TRACKED_TASK_MAX];
+  size_t count = hal_task_stacks(stacks, HAL_TRACKED_TASK_MAX);
+  uint32_t free_min = HAL_STACK_UNKNOWN;
+  for (size_t i = 0; i < count; i++) {
+    free_min = std::min(free_min, stacks[i].free_min);
+  }
+  if (free_min != HAL_STACK_UNKNOWN) {
+    telemetry_record(TelemetryChannel::kStackMinFree, free_min);
+  }
+}
+
+void memory_log_report() {
+  size_t size = hal_heap_size();
+  size_t min_free = hal_min_free_heap_size();
+  uint32_t allocs = hal_heap_alloc_count();
+  ESP_LOGI(TAG,
+           "Heap %zu bytes, %zu free, %zu at least (high-water %zu); %" PRIu32
+           " allocations, %" PRIu32 " since init",
+           size, hal_free_heap_size(), min_free,
+           size > min_free ? size - min_free : 0, allocs, allocs - INIT_ALLOCS);
+
+  hal_alloc_site_t sites[HAL_ALLOC_SITE_MAX];
+  size_t site_count = hal_alloc_sites(sites, HAL_ALLOC_SITE_MAX);
+  for (size_t i = 0; i < site_count; i++) {
+    ESP_LOGI(TAG, "%-24s %" PRIu32 " allocations, %" PRIu32 " bytes",
+             file_name(sites[i].site), sites[i].count, sites[i].bytes);
+  }
+
+  hal_task_stack_t stacks[HAL_TRACKED_TASK_MAX];
+  size_t task_count = hal_task_stacks(stacks, HAL_TRACKED_TASK_MAX);
+  for (size_t i = 0; i < task_count; i++) {
+    const hal_task_stack_t& stack = stacks[i];
+    if (stack.free_min == HAL_STACK_UNKNOWN) {
+      ESP_LOGI(TAG, "Task %-12s stack %" PRIu32 " bytes", stack.name,
+               stack.stack_size);
+    } else {
+      ESP_LOGI(TAG,
+               "Task %-12s stack %" PRIu32 " bytes, %" PRIu32
+               " never used",
+               stack.name, stack.stack_size, stack.free_min);
+    }
+  }
+}
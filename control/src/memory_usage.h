@@ -0,0 +1,16 @@
+#pragma once
+
+// Heap and stack usage of the firmware (see hal/memory.h).
+
+// Tracks app_main's task, logs the usage after initialization and, with
+// ASSERT_NO_ALLOC_AFTER_INIT (configs/memory_config.h), forbids allocations
+// from then on. Called by app_main once everything is initialized.
+void memory_init_done();
+
+// Samples the kHeapMinFree and kStackMinFree channels. Reading the stacks'
+// high-water marks scans them: called by the task monitor, not per frame.
+void memory_record_telemetry();
+
+// Logs the heap's size and high-water mark, the allocations per hal_malloc()
+// call site, and each task's stack size and least free stack.
+void memory_log_report();
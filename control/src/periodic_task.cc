@@ -0,0 +1,216 @@
+#include "periodic_task.h"
+
+#include <datalog/flash_log.h>
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <sched/monitor.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+
+#include "configs/periodic_task_config.h"
+#include "configs/telemetry_config.h"
+#include "datalog.h"
+#include "memory_usage.h"
+#include "telemetry.h"
+
+static const char* TAG = "TASKS";
+
+struct MonitoredTask {
+  const char* name;
+  DeadlineMonitor monitor;
+};
+
+// Slots are claimed once, at task creation, and then only updated by their
+// own task. The monitor task reads them under TASKS_LOCK.
+static MonitoredTask* TASKS[PERIODIC_TASK_MAX] = {};
+static std::atomic<int> TASK_COUNT{0};
+static hal_spinlock_t TASKS_LOCK = HAL_SPINLOCK_INIT;
+
+// Owned by the monitor task.
+static CpuLoadMeter CPU_LOAD[HAL_CORE_COUNT];
+static DegradeMonitor DEGRADE(DEGRADE_POLICY);
+static uint32_t MISSES_SEEN = 0;
+
+static std::atomic<bool> DEGRADED{false};
+// Per mille, for get_cpu_load() from other tasks.
+static std::atomic<uint16_t> CPU_LOAD_PERMILLE[HAL_CORE_COUNT] = {};
+
+int monitor_task(const char* name, int period_ms, int deadline_ms) {
+  int id = TASK_COUNT.fetch_add(1);
+  if (id >= static_cast<int>(PERIODIC_TASK_MAX)) {
+    ESP_LOGE(TAG, "Can't monitor task %s, raise PERIODIC_TASK_MAX", name);
+    return -1;
+  }
+  // Never freed: tasks run forever.
+  MonitoredTask* task = new MonitoredTask{
+      .name = name,
+      .monitor = DeadlineMonitor(period_ms * 1000, deadline_ms * 1000),
+  };
+  hal_enter_critical(&TASKS_LOCK);
+  TASKS[id] = task;
+  hal_exit_critical(&TASKS_LOCK);
+  return id;
+}
+
+void monitor_task_begin(int id, int64_t release_us) {
+  if (id < 0) {
+    return;
+  }
+  int64_t start_us = hal_time_us();
+  hal_enter_critical(&TASKS_LOCK);
+  TASKS[id]->monitor.begin(release_us, start_us);
+  hal_exit_critical(&TASKS_LOCK);
+}
+
+void monitor_task_end(int id) {
+  if (id < 0) {
+    return;
+  }
+  int64_t end_us = hal_time_us();
+  hal_enter_critical(&TASKS_LOCK);
+  TASKS[id]->monitor.end(end_us);
+  hal_exit_critical(&TASKS_LOCK);
+}
+
+void run_periodic_task(const PeriodicTaskConfig& config, hal_task_fn_t fn,
+                       void* arg) {
+  const hal_tick_t period = HAL_MS_TO_TICKS(config.period_ms);
+  const int64_t period_us = period * HAL_TICK_PERIOD_MS * 1000LL;
+  int id = monitor_task(config.name, config.period_ms, config.deadline_ms);
+  // Releases come on tick interrupts: start on one to take their phase.
+  hal_delay_ticks(1);
+  hal_tick_t last_wake = hal_tick_count();
+  int64_t release_us = hal_time_us();
+  while (1) {
+    monitor_task_begin(id, release_us);
+    fn(arg);
+    monitor_task_end(id);
+    // A run past the next release is followed right away by the next one,
+    // which is late by as much.
+    hal_delay_until(&last_wake, period);
+    release_us += period_us;
+  }
+}
+
+struct PeriodicTaskArgs {
+  const PeriodicTaskConfig* config;
+  hal_task_fn_t fn;
+  void* arg;
+};
+
+static void periodic_task(void* arg) {
+  const PeriodicTaskArgs* args = static_cast<PeriodicTaskArgs*>(arg);
+  run_periodic_task(*args->config, args->fn, args->arg);
+}
+
+bool start_periodic_task(const PeriodicTaskConfig& config, hal_task_fn_t fn,
+                         void* arg) {
+  // Never freed: the task runs forever.
+  PeriodicTaskArgs* args = new PeriodicTaskArgs{&config, fn, arg};
+  return hal_task_create(periodic_task, config.name, config.stack_size, args,
+                         config.priority, nullptr);
+}
+
+size_t get_periodic_task_reports(PeriodicTaskReport* out, size_t cap) {
+  size_t count = 0;
+  hal_enter_critical(&TASKS_LOCK);
+  for (size_t i = 0; i < PERIODIC_TASK_MAX && count < cap; i++) {
+    const MonitoredTask* task = TASKS[i];
+    if (task == nullptr) {
+      continue;
+    }
+    out[count++] = {
+        .name = task->name,
+        .period_us = task->monitor.period_us(),
+        .deadline_us = task->monitor.deadline_us(),
+        .stats = task->monitor.stats(),
+    };
+  }
+  hal_exit_critical(&TASKS_LOCK);
+  return count;
+}
+
+float get_cpu_load(int core) {
+  return CPU_LOAD_PERMILLE[core].load(std::memory_order_relaxed) / 1000.0f;
+}
+
+bool is_degraded() { return DEGRADED.load(std::memory_order_relaxed); }
+
+static void set_degraded(bool degraded) {
+  DEGRADED = degraded;
+  telemetry_set_degraded(degraded);
+  datalog_event(LogEvent::kDegraded, degraded);
+  if (degraded) {
+    ESP_LOGW(TAG, "Falling behind, entering degraded mode");
+    task_monitor_log_report();
+  } else {
+    ESP_LOGI(TAG, "Caught up, leaving degraded mode");
+  }
+}
+
+static void monitor(void* arg) {
+  const int64_t now_us = hal_time_us();
+  float max_load = 0;
+  for (int core = 0; core < HAL_CORE_COUNT; core++) {
+    float load = CPU_LOAD[core].update(hal_idle_time_us(core), now_us);
+    CPU_LOAD_PERMILLE[core] = static_cast<uint16_t>(load * 1000);
+    max_load = std::max(max_load, load);
+  }
+
+  PeriodicTaskReport reports[PERIODIC_TASK_MAX];
+  size_t count = get_periodic_task_reports(reports, PERIODIC_TASK_MAX);
+  uint32_t misses = 0;
+  for (size_t i = 0; i < count; i++) {
+    misses += reports[i].stats.misses;
+  }
+  bool was_degraded = DEGRADE.degraded();
+  bool degraded = DEGRADE.update(now_us, misses - MISSES_SEEN, max_load);
+  MISSES_SEEN = misses;
+  if (degraded != was_degraded) {
+    set_degraded(degraded);
+  }
+
+  telemetry_record(TelemetryChannel::kCpuLoadCore0, 100 * get_cpu_load(0));
+  if (HAL_CORE_COUNT > 1) {
+    telemetry_record(TelemetryChannel::kCpuLoadCore1, 100 * get_cpu_load(1));
+  }
+  telemetry_record(TelemetryChannel::kDeadlineMisses, misses);
+  telemetry_record(TelemetryChannel::kDegraded, degraded);
+  memory_record_telemetry();
+
+  static hal_tick_t next_report =
+      hal_tick_count() + HAL_MS_TO_TICKS(TASK_MONITOR_REPORT_PERIOD_MS);
+  hal_tick_t now = hal_tick_count();
+  if (static_cast<int32_t>(now - next_report) >= 0) {
+    task_monitor_log_report();
+    next_report = now + HAL_MS_TO_TICKS(TASK_MONITOR_REPORT_PERIOD_MS);
+  }
+}
+
+void init_task_monitor() {
+  start_periodic_task(TASK_MONITOR_TASK, monitor, nullptr);
+}
+
+void task_monitor_log_report() {
+  PeriodicTaskReport reports[PERIODIC_TASK_MAX];
+  size_t count = get_periodic_task_reports(reports, PERIODIC_TASK_MAX);
+  for (size_t i = 0; i < count; i++) {
+    const PeriodicTaskReport& report = reports[i];
+    const DeadlineStats& stats = report.stats;
+    ESP_LOGI(TAG,
+             "%-12s period %" PRIu32 " us, deadline %" PRIu32 " us: %" PRIu32
+             " runs, %" PRIu32 " missed, jitter mean/max %" PRIu32
+             "/%" PRIu32 " us, execution mean/max %" PRIu32 "/%" PRIu32 " us",
+             report.name, report.period_us, report.deadline_us, stats.runs,
+             stats.misses, stats.jitter_mean_us(), stats.jitter_max_us,
+             stats.exec_mean_us(), stats.exec_max_us);
+  }
+  for (int core = 0; core < HAL_CORE_COUNT; core++) {
+    ESP_LOGI(TAG, "Core %d load %.1f%%", core, 100 * get_cpu_load(core));
+  }
+}
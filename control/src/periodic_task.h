@@ -0,0 +1,65 @@
+#pragma once
+
+#include <hal/rtos.h>
+#include <sched/monitor.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// Periodic tasks with deadlines. Every run is released a period after the
+// previous release by hal_delay_until(), so a task doesn't drift by its own
+// run time, and is monitored: start jitter, execution time and deadline
+// misses per task (see sched/monitor.h). The monitor task turns the misses
+// and the load of each core into telemetry, and into degraded mode when the
+// board falls behind (configs/periodic_task_config.h).
+
+struct PeriodicTaskConfig {
+  const char* name;
+  // A multiple of HAL_TICK_PERIOD_MS.
+  int period_ms;
+  // Each run must end this long after its release.
+  int deadline_ms;
+  uint32_t stack_size;
+  int priority;
+};
+
+// Starts a task that calls `fn(arg)` once per period.
+bool start_periodic_task(const PeriodicTaskConfig& config, hal_task_fn_t fn,
+                         void* arg);
+
+// Calls `fn(arg)` once per period on the calling task, e.g. app_main's.
+// `stack_size` and `priority` are ignored. Never returns.
+void run_periodic_task(const PeriodicTaskConfig& config, hal_task_fn_t fn,
+                       void* arg);
+
+// Monitors a task released some other way, e.g. by notifications. Returns
+// the id to pass to monitor_task_begin() and monitor_task_end(), or -1 if
+// PERIODIC_TASK_MAX tasks are already monitored.
+int monitor_task(const char* name, int period_ms, int deadline_ms);
+// A run released at `release_us` (hal_time_us()) starts now.
+void monitor_task_begin(int id, int64_t release_us);
+void monitor_task_end(int id);
+
+struct PeriodicTaskReport {
+  const char* name;
+  uint32_t period_us;
+  uint32_t deadline_us;
+  DeadlineStats stats;
+};
+
+// Copies the statistics of every monitored task to `out`. Returns their
+// number.
+size_t get_periodic_task_reports(PeriodicTaskReport* out, size_t cap);
+
+// Load of `core` over the last monitor period, 0 to 1.
+float get_cpu_load(int core);
+
+// Whether the board is in degraded mode: some task missed too many
+// deadlines, or a core was too busy, recently.
+bool is_degraded();
+
+// Starts the monitor task.
+void init_task_monitor();
+
+// Logs each task's statistics and the load of each core.
+void task_monitor_log_report();
@@ -1,17 +1,12 @@
 #include "pt.h"
 
-#include <algorithm>
-#include <array>
+#include <stand/pt_scale.h>
 
 #include "configs/pt_config.h"
+#include "configs/pt_scale_config.h"
 #include "esp_log.h"
 #include "pt_adc.h"
-
-float voltage_to_psi(const PtConfig& pt_config, float voltage) {
-  return pt_config.max_pressure *
-         (std::max(0.0f, voltage - pt_config.voltage_range.first) /
-          (pt_config.voltage_range.second - pt_config.voltage_range.first));
-}
+#include "trace.h"
 
 uint16_t read_pt(Pt pt) {
   const PtConfig& pt_config = get_pt_config(pt);
@@ -21,5 +16,6 @@ uint16_t read_pt(Pt pt) {
   ESP_LOGI("PT", "Raw voltage for PT %d: %.3f V", static_cast<int>(pt),
            raw_voltage);
 #endif
-  return voltage_to_psi(pt_config, raw_voltage);
+  TRACE_ZONE(kPtConvert);
+  return voltage_to_psi(get_pt_scale(pt), raw_voltage);
 }
@@ -1,32 +1,30 @@
 #include "pt_adc.h"
 
-#include <driver/gpio.h>
-#include <driver/spi_master.h>
 #include <esp32_driver_mcp320x/mcp320x.h>
+#include <hal/gpio.h>
+#include <hal/rtos.h>
+#include <hal/spi.h>
 
 #include <array>
+#include <cassert>
 #include <cstdint>
 #include <string>
 
 #include "configs/pt_adc_config.h"
+#include "trace.h"
+
+// Map of chip select GPIO to MCP3204 handle, filled by init_pt_adc_spi().
+static std::array<mcp320x_t*, HAL_GPIO_MAX> MP2304_HANDLES{};
 
 void init_pt_adc_spi() {
-  spi_bus_config_t bus_cfg = {
-      .mosi_io_num = ADC_SPI_MOSI,
-      .miso_io_num = ADC_SPI_MISO,
-      .sclk_io_num = ADC_SPI_CLK,
-      .quadwp_io_num = GPIO_NUM_NC,
-      .quadhd_io_num = GPIO_NUM_NC,
-      .data4_io_num = GPIO_NUM_NC,
-      .data5_io_num = GPIO_NUM_NC,
-      .data6_io_num = GPIO_NUM_NC,
-      .data7_io_num = GPIO_NUM_NC,
-      .max_transfer_sz = 3,  // 24 bits.
-      .flags = SPICOMMON_BUSFLAG_MASTER,
-      .isr_cpu_id = ESP_INTR_CPU_AFFINITY_AUTO,
-      .intr_flags = ESP_INTR_FLAG_LEVEL3,
+  hal_spi_bus_config_t bus_cfg = {
+      .host = ADC_SPI_HOST,
+      .mosi = ADC_SPI_MOSI,
+      .miso = ADC_SPI_MISO,
+      .sclk = ADC_SPI_CLK,
+      .max_transfer_size = 3,  // 24 bits.
   };
-  spi_bus_initialize(ADC_SPI_HOST, &bus_cfg, 0);
+  hal_spi_bus_init(&bus_cfg);
 
   for (const MP2304SpiConfig& spi_config : MP2304_SPI_CONFIGS) {
     mcp320x_config_t mcp320x_cfg = {
@@ -40,23 +38,30 @@ void init_pt_adc_spi() {
   }
 }
 
-float pt_adc_read_raw_voltage(gpio_num_t chip_select,
+float pt_adc_read_raw_voltage(hal_gpio_t chip_select,
                               mcp320x_channel_t channel) {
   mcp320x_t* handle = MP2304_HANDLES[chip_select];
   assert(handle != nullptr &&
          "Attempting to read from ADC without initializing first");
 
-  // Occupy the SPI bus for multiple transactions.
-  mcp320x_acquire(handle, portMAX_DELAY);
-
   // Sampled voltages are returned in mV.
   uint16_t voltage_mv = 0;
-  mcp320x_sample_voltage(handle, channel, MCP320X_READ_MODE_SINGLE,
-                         PT_ADC_VOLTAGE_SAMPLE_COUNT, &voltage_mv);
+  {
+    TRACE_ZONE(kAdcSpi);
+    // Occupy the SPI bus for multiple transactions.
+    mcp320x_acquire(handle, HAL_WAIT_FOREVER);
+
+    mcp320x_sample_voltage(handle, channel, MCP320X_READ_MODE_SINGLE,
+                           PT_ADC_VOLTAGE_SAMPLE_COUNT, &voltage_mv);
 
-  // Unoccupy the SPI bus.
-  mcp320x_release(handle);
+    // Unoccupy the SPI bus.
+    mcp320x_release(handle);
+  }
 
   // Return voltage in V.
   return voltage_mv / 1000.0f;
 }
+
+mcp320x_t* pt_adc_handle(hal_gpio_t chip_select) {
+  return MP2304_HANDLES[chip_select];
+}
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <driver/gpio.h>
 #include <esp32_driver_mcp320x/mcp320x.h>
+#include <hal/gpio.h>
 
 #include <cstdint>
 
@@ -10,5 +10,9 @@
 void init_pt_adc_spi();
 
 // Reads a voltage from the ADC specified by chip_select and channel.
-float pt_adc_read_raw_voltage(gpio_num_t chip_select,
+float pt_adc_read_raw_voltage(hal_gpio_t chip_select,
                               mcp320x_channel_t channel);
+
+// Handle of the ADC on `chip_select`, or nullptr if init_pt_adc_spi() didn't
+// install one.
+mcp320x_t* pt_adc_handle(hal_gpio_t chip_select);
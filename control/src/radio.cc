@@ -0,0 +1,429 @@
+#include "radio.h"
+
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/system.h>
+#include <hal/timer.h>
+#include <ra01s.h>
+#include <telemetry/channel_access.h>
+#include <telemetry/command_link.h>
+#include <telemetry/frame.h>
+#include <telemetry/lora_airtime.h>
+#include <telemetry/spsc_ring.h>
+#include <telemetry/trace_report.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+
+#include "command.h"
+#include "configs/periodic_task_config.h"
+#include "configs/radio_config.h"
+#include "configs/telemetry_config.h"
+#include "periodic_task.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "wired.h"
+
+static const char* TAG = "RADIO";
+
+// Notification bits for the radio task.
+constexpr uint32_t NOTIFY_DIO1 = 1 << 0;
+constexpr uint32_t NOTIFY_SEND_ACK = 1 << 1;
+// Notification bit for the command task.
+constexpr uint32_t NOTIFY_RX_PACKET = 1 << 0;
+
+struct RxPacket {
+  uint8_t data[FRAME_MAX_SIZE];
+  uint8_t len;
+  int8_t rssi;
+  int8_t snr;
+  // hal_time_us() time of the RX_DONE interrupt.
+  int64_t timestamp_us;
+};
+
+// Filled by the radio task, drained by the command task.
+static SpscRing<RxPacket, RADIO_RX_RING_SIZE> RX_RING;
+
+static hal_task_t RADIO_TASK = nullptr;
+static hal_task_t COMMAND_TASK = nullptr;
+
+enum class RadioState : uint8_t {
+  kInit,  // init_radio() not done yet.
+  kUp,
+  kDown,  // Not found, too slow to come up at boot, or failed since.
+};
+// Set by init_radio() on a boot task, start_radio() and LoRaError().
+static std::atomic<RadioState> RADIO_STATE{RadioState::kInit};
+static bool DIO1_ENABLED = false;
+static volatile int64_t RX_DONE_US = 0;
+
+// Owned by the command task. The radio task only reads the acknowledgement,
+// through ACK_LOCK.
+static CommandReceiver COMMAND_RECEIVER(RADIO_NODE_ID);
+static hal_spinlock_t ACK_LOCK = HAL_SPINLOCK_INIT;
+static AckField PENDING_ACK = {};
+
+// Owned by the radio task.
+static ChannelAccess CHANNEL_ACCESS(RADIO_CHANNEL_ACCESS, 1);
+
+// kTelemetry frames are numbered on their own, so the ground counts the ones
+// lost without the acknowledgements and trace frames in between.
+static uint16_t DOWNLINK_SEQ = 0;
+static uint16_t TELEMETRY_SEQ = 0;
+static uint32_t RX_PACKETS = 0;
+static uint32_t HANDLE_LATENCY_MAX_US = 0;
+static uint64_t HANDLE_LATENCY_TOTAL_US = 0;
+
+// DIO1 rises on RX_DONE, TX_DONE and CAD_DONE.
+static void IRAM_ATTR on_dio1(void* arg) {
+  RX_DONE_US = hal_time_us();
+  hal_task_notify_from_isr(RADIO_TASK, NOTIFY_DIO1);
+}
+
+// Moves a received packet, if any, into the RX ring. Returns false if the
+// radio had nothing to read.
+static bool drain_packet() {
+  TRACE_ZONE(kRadioRx);
+  RxPacket* slot = RX_RING.claim();
+  if (slot == nullptr) {
+    // Still read the packet so the radio's IRQ is cleared.
+    uint8_t discard[FRAME_MAX_SIZE];
+    return LoRaReceive(discard, sizeof(discard)) > 0;
+  }
+
+  slot->len = LoRaReceive(slot->data, sizeof(slot->data));
+  if (slot->len == 0) {
+    return false;
+  }
+  GetPacketStatus(&slot->rssi, &slot->snr);
+  slot->timestamp_us =
+      DIO1_ENABLED ? RX_DONE_US : hal_time_us();
+  RX_RING.publish();
+  RX_PACKETS++;
+  hal_task_notify(COMMAND_TASK, NOTIFY_RX_PACKET);
+  return true;
+}
+
+static AckField pending_ack() {
+  hal_enter_critical(&ACK_LOCK);
+  AckField ack = PENDING_ACK;
+  hal_exit_critical(&ACK_LOCK);
+  return ack;
+}
+
+// Sleeps until `done()`, which polls the radio, returns true: on DIO1, or a
+// tick at a time without it. Returns false if `deadline_us` (hal_time_us())
+// passed first. Other events arriving meanwhile are handed back to
+// radio_task().
+template <typename Done>
+static bool wait_for_dio1(int64_t deadline_us, Done done) {
+  uint32_t deferred = 0;
+  bool finished;
+  while (!(finished = done())) {
+    const int64_t left_us = deadline_us - hal_time_us();
+    if (left_us <= 0) {
+      break;
+    }
+    const hal_tick_t wait =
+        DIO1_ENABLED ? HAL_MS_TO_TICKS(left_us / 1000) + 1 : 1;
+    deferred |= hal_task_notify_wait(wait) & ~NOTIFY_DIO1;
+  }
+  if (deferred != 0) {
+    hal_task_notify(RADIO_TASK, deferred);
+  }
+  return finished;
+}
+
+// Runs a channel activity detection and sleeps until CAD_DONE raises DIO1.
+// Returns whether the channel is busy; a CAD that doesn't finish counts as
+// busy.
+static bool channel_active() {
+  if (!LoRaCadStart(LORA_CAD_SYMBOLS, LORA_CAD_DET_PEAK, LORA_CAD_DET_MIN)) {
+    return true;
+  }
+  bool active = true;
+  if (!wait_for_dio1(hal_time_us() + LORA_CAD_TIMEOUT_US,
+                     [&] { return LoRaCadDone(&active); })) {
+    ESP_LOGE(TAG, "No CAD_DONE");
+    LoRaCadAbort();
+    return true;
+  }
+  return active;
+}
+
+// Waits until the channel access policy allows a frame of `size` bytes on
+// air. Returns false if the channel stayed busy and the frame should be
+// dropped.
+static bool wait_for_channel(size_t size) {
+  // Boards share no clock of their own; TDMA slots are counted in host time
+  // once the wired link has synchronized to it.
+  int64_t offset_us;
+  if (wired_clock_offset(&offset_us)) {
+    CHANNEL_ACCESS.set_shared_time(offset_us);
+  } else {
+    CHANNEL_ACCESS.clear_shared_time();
+  }
+  CHANNEL_ACCESS.begin(hal_time_us(),
+                       lora_time_on_air_us(LORA_MODULATION, size));
+  while (1) {
+    int64_t wait_us = CHANNEL_ACCESS.next_attempt_us() - hal_time_us();
+    if (wait_us > 0) {
+      hal_delay_ticks(std::max<hal_tick_t>(1, HAL_MS_TO_TICKS(wait_us / 1000)));
+      // Whatever kept the channel busy may have been a packet for us.
+      drain_packet();
+    }
+    bool busy = CHANNEL_ACCESS.needs_cad() && channel_active();
+    switch (CHANNEL_ACCESS.on_attempt(hal_time_us(), busy)) {
+      case AccessDecision::kTransmit:
+        return true;
+      case AccessDecision::kWait:
+        break;
+      case AccessDecision::kDrop:
+        return false;
+    }
+  }
+}
+
+// Sends a frame and sleeps until TX_DONE raises DIO1, so the core stays free
+// while the frame is on air. Without DIO1 the task polls every tick instead.
+// Returns true if the frame went out.
+static bool transmit(uint8_t* frame, size_t size) {
+  if (!LoRaSend(frame, size, SX126x_TXMODE_ASYNC)) {
+    return false;
+  }
+  const int64_t deadline_us = hal_time_us() +
+                              lora_time_on_air_us(LORA_MODULATION, size) +
+                              RADIO_TX_DONE_MARGIN_US;
+  bool sent = false;
+  if (!wait_for_dio1(deadline_us, [&] { return LoRaSendDone(&sent); })) {
+    ESP_LOGE(TAG, "No TX_DONE after %u bytes", static_cast<unsigned>(size));
+    LoRaSendAbort();
+  }
+  return sent;
+}
+
+// Sends a frame numbered `*seq`, and moves on to the next number if it went
+// out.
+static void send_frame(uint8_t* frame, size_t size, uint16_t* seq) {
+  if (size == 0 || !wait_for_channel(size)) {
+    return;
+  }
+  TRACE_ZONE(kRadioTx);
+  if (transmit(frame, size)) {
+    (*seq)++;
+  }
+}
+
+// Sends the pending acknowledgement right away, without waiting for the next
+// telemetry frame, so the command round trip is two packets on air.
+static void send_ack() {
+  uint8_t frame[FRAME_MAX_SIZE];
+  send_frame(frame,
+             encode_ack_frame(RADIO_NODE_ID, DOWNLINK_SEQ, pending_ack(), frame,
+                              sizeof(frame)),
+             &DOWNLINK_SEQ);
+}
+
+// Sends the trace table, in as many frames as it takes.
+static void send_trace() {
+  TraceZoneStats zones[static_cast<size_t>(TraceZone::kTraceZoneMax)];
+  const size_t count = get_trace_stats(zones, std::size(zones));
+  size_t offset = 0;
+  while (offset < count) {
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t consumed;
+    size_t size = encode_trace_frame(
+        RADIO_NODE_ID, DOWNLINK_SEQ, pending_ack(), hal_cycles_per_us(),
+        &zones[offset], count - offset, &consumed, frame, sizeof(frame));
+    if (size == 0) {
+      break;
+    }
+    send_frame(frame, size, &DOWNLINK_SEQ);
+    offset += consumed;
+  }
+}
+
+// Sends the next scheduled telemetry, which also repeats the latest
+// acknowledgement in case the dedicated one was lost, or the trace table in
+// its place when the ground asked for it. Nothing is sent while the wired
+// link carries telemetry.
+static void send_telemetry() {
+  if (wired_link_up()) {
+    return;
+  }
+  if (trace_take_send_request()) {
+    send_trace();
+    return;
+  }
+  uint8_t body[FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE];
+  size_t body_len = telemetry_build_body(body, sizeof(body));
+  if (body_len == 0) {
+    return;
+  }
+  uint8_t frame[FRAME_MAX_SIZE];
+  send_frame(frame,
+             encode_telemetry_frame(RADIO_NODE_ID, TELEMETRY_SEQ, pending_ack(),
+                                    body, body_len, frame, sizeof(frame)),
+             &TELEMETRY_SEQ);
+}
+
+// Sole owner of the SX126x. Sleeps until DIO1 signals a packet, the command
+// task asks for an acknowledgement, or the next telemetry frame is due.
+static void radio_task(void* arg) {
+  const hal_tick_t frame_period = HAL_MS_TO_TICKS(TELEMETRY_FRAME_PERIOD_MS);
+  const hal_tick_t report_period = HAL_MS_TO_TICKS(TELEMETRY_REPORT_PERIOD_MS);
+  hal_tick_t next_frame = hal_tick_count() + frame_period;
+  hal_tick_t next_report = hal_tick_count() + report_period;
+  const int monitor_id = monitor_task("telemetry", TELEMETRY_FRAME_PERIOD_MS,
+                                      TELEMETRY_FRAME_DEADLINE_MS);
+  while (1) {
+    hal_tick_t now = hal_tick_count();
+    hal_tick_t wait = static_cast<int32_t>(next_frame - now) > 0
+                          ? next_frame - now
+                          : 0;
+    // Without DIO1 fall back to polling the IRQ status register.
+    if (!DIO1_ENABLED) {
+      wait = std::min(wait, HAL_MS_TO_TICKS(RADIO_POLL_PERIOD_MS));
+    }
+
+    uint32_t events = hal_task_notify_wait(wait);
+    if (!DIO1_ENABLED || (events & NOTIFY_DIO1)) {
+      drain_packet();
+    }
+    if (events & NOTIFY_SEND_ACK) {
+      send_ack();
+    }
+
+    now = hal_tick_count();
+    if (static_cast<int32_t>(now - next_frame) >= 0) {
+      // The frame was due at the start of tick `next_frame`.
+      monitor_task_begin(monitor_id,
+                         hal_time_us() - static_cast<int64_t>(now - next_frame) *
+                                             HAL_TICK_PERIOD_MS * 1000);
+      send_telemetry();
+      monitor_task_end(monitor_id);
+      next_frame += frame_period;
+      // Don't send a burst of frames to catch up after a stall.
+      if (static_cast<int32_t>(now - next_frame) >= 0) {
+        next_frame = now + frame_period;
+      }
+    }
+    if (static_cast<int32_t>(now - next_report) >= 0) {
+      telemetry_log_report();
+      next_report = now + report_period;
+    }
+  }
+}
+
+static void handle_packet(const RxPacket& packet) {
+  TRACE_ZONE(kCommand);
+  Command command;
+  CommandResult result =
+      COMMAND_RECEIVER.on_packet(packet.data, packet.len, &command);
+  if (result == CommandResult::kExecute) {
+    if (!execute_command(command)) {
+      ESP_LOGW(TAG, "Refused command %u (type %d)", command.id,
+               static_cast<int>(command.type));
+      COMMAND_RECEIVER.refuse();
+    }
+    uint32_t latency_us = hal_time_us() - packet.timestamp_us;
+    HANDLE_LATENCY_MAX_US = std::max(HANDLE_LATENCY_MAX_US, latency_us);
+    HANDLE_LATENCY_TOTAL_US += latency_us;
+  } else if (result == CommandResult::kInvalid) {
+    ESP_LOGW(TAG, "Dropped invalid uplink packet (%u bytes, RSSI %d dBm)",
+             packet.len, packet.rssi);
+  }
+
+  if (COMMAND_RECEIVER.ack_pending()) {
+    hal_enter_critical(&ACK_LOCK);
+    PENDING_ACK = COMMAND_RECEIVER.ack();
+    hal_exit_critical(&ACK_LOCK);
+    COMMAND_RECEIVER.ack_sent();
+    hal_task_notify(RADIO_TASK, NOTIFY_SEND_ACK);
+  }
+}
+
+static void command_task(void* arg) {
+  while (1) {
+    hal_task_notify_wait(HAL_WAIT_FOREVER);
+    while (RxPacket* packet = RX_RING.front()) {
+      handle_packet(*packet);
+      RX_RING.pop();
+    }
+  }
+}
+
+// Overrides the ra01s driver's, which spins forever on a command the SX126x
+// never takes. Marks the radio down and parks the calling task (a boot task
+// or the radio task) instead, leaving the core to the rest of the stand.
+void LoRaError(int error) {
+  ESP_LOGE(TAG, "SX126x error %d, radio down", error);
+  RADIO_STATE = RadioState::kDown;
+  while (1) {
+    hal_task_notify_wait(HAL_WAIT_FOREVER);
+  }
+}
+
+void init_radio() {
+  LoRaInit();
+  if (LoRaBegin(LORA_FREQUENCY_HZ, LORA_TX_POWER_DBM, LORA_TCXO_VOLTAGE,
+                LORA_USE_REGULATOR_LDO) != ERR_NONE) {
+    ESP_LOGE(TAG, "SX126x not found, command uplink disabled");
+    RADIO_STATE = RadioState::kDown;
+    return;
+  }
+  LoRaConfig(LORA_SPREADING_FACTOR, LORA_BANDWIDTH, LORA_CODING_RATE,
+             LORA_PREAMBLE_LENGTH, LORA_PAYLOAD_LENGTH, LORA_CRC_ON,
+             LORA_INVERT_IRQ);
+  RadioState init = RadioState::kInit;
+  if (!RADIO_STATE.compare_exchange_strong(init, RadioState::kUp)) {
+    ESP_LOGW(TAG, "SX126x came up after boot gave up on it, left down");
+  }
+}
+
+void start_radio() {
+  // Boot stopped waiting for init_radio(): a late one leaves the radio down.
+  RadioState init = RadioState::kInit;
+  if (RADIO_STATE.compare_exchange_strong(init, RadioState::kDown)) {
+    ESP_LOGE(TAG, "SX126x not up in time, command uplink disabled");
+  }
+  if (RADIO_STATE != RadioState::kUp) {
+    return;
+  }
+  // Decorrelate backoff between stands that boot together.
+  CHANNEL_ACCESS = ChannelAccess(RADIO_CHANNEL_ACCESS, hal_random());
+
+  hal_task_create(command_task, "command", COMMAND_TASK_STACK_SIZE, nullptr,
+                  COMMAND_TASK_PRIORITY, &COMMAND_TASK);
+  hal_task_create(radio_task, "radio", RADIO_TASK_STACK_SIZE, nullptr,
+                  RADIO_TASK_PRIORITY, &RADIO_TASK);
+
+  // Enable the interrupt last: the ISR notifies RADIO_TASK.
+  DIO1_ENABLED = LoRaEnableRxInterrupt(on_dio1, nullptr);
+  if (!DIO1_ENABLED) {
+    ESP_LOGW(TAG, "DIO1 not configured, polling every %d ms",
+             RADIO_POLL_PERIOD_MS);
+  }
+}
+
+RadioStats get_radio_stats() {
+  const CommandReceiverStats& commands = COMMAND_RECEIVER.stats();
+  return {
+      .rx_packets = RX_PACKETS,
+      .rx_dropped = RX_RING.dropped(),
+      .rx_ring_high_water = static_cast<uint32_t>(RX_RING.high_water()),
+      .handle_latency_max_us = HANDLE_LATENCY_MAX_US,
+      .handle_latency_mean_us =
+          commands.executed == 0
+              ? 0
+              : static_cast<uint32_t>(HANDLE_LATENCY_TOTAL_US /
+                                      commands.executed),
+      .tx_channel_busy = CHANNEL_ACCESS.busy_count(),
+      .tx_dropped = CHANNEL_ACCESS.drop_count(),
+      .commands = commands,
+      .up = RADIO_STATE == RadioState::kUp,
+  };
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <telemetry/command_link.h>
+
+#include <cstdint>
+
+struct RadioStats {
+  uint32_t rx_packets;
+  // Packets lost because the RX ring was full.
+  uint32_t rx_dropped;
+  uint32_t rx_ring_high_water;
+  // Time from the DIO1 RX_DONE edge until the command was executed.
+  uint32_t handle_latency_max_us;
+  uint32_t handle_latency_mean_us;
+  // Downlink frames that found the channel busy, and those given up on.
+  uint32_t tx_channel_busy;
+  uint32_t tx_dropped;
+  // commands.refused counts those execute_command() refused. Their
+  // acknowledgement tells the ground so.
+  CommandReceiverStats commands;
+  // Up since boot. Down if the SX126x wasn't found or up by
+  // BOOT_RADIO_TIMEOUT_MS, or the driver failed since (see LoRaError()).
+  bool up;
+};
+
+// Brings up and configures the LoRa radio. Waits on the SX126x for tens of
+// milliseconds, so it runs alongside the rest of the boot. See
+// configs/radio_config.h.
+void init_radio();
+
+// Starts the tasks that downlink telemetry and receive and execute ground
+// commands, once init_radio() found the radio and the stand logic they
+// command is up. Does nothing without a radio, and marks it down if
+// init_radio() isn't done yet.
+void start_radio();
+
+// Statistics of the radio and command uplink, for telemetry and debugging.
+RadioStats get_radio_stats();
@@ -1,13 +1,19 @@
 #pragma once
 
-#include <driver/gpio.h>
+#include <hal/gpio.h>
 
 // Configures LEDC timer, used for pwm.
 void setup_servo_pwm_timer();
 
 // Sets up GPIO pin for servo and maps the pin to a channel.
-void setup_servo_pin(gpio_num_t gpio_num);
+void setup_servo_pin(hal_gpio_t gpio_num);
+
+// Pulse width in microseconds that turns a servo to `angle`, and the LEDC
+// duty that produces it.
+int servo_pulsewidth(int angle, int max_angle);
+int servo_duty(int pulsewidth);
 
 // Set the angle on a given servo. `max_angle` is used to calculate
-// the pulse width, because not all servos have the same max angle.
-void set_servo_angle(gpio_num_t gpio_num, int angle, int max_angle);
\ No newline at end of file
+// the pulse width, because not all servos have the same max angle. Returns
+// false if `gpio_num` wasn't set up with setup_servo_pin().
+bool set_servo_angle(hal_gpio_t gpio_num, int angle, int max_angle);
@@ -0,0 +1,135 @@
+#include "stand_control.h"
+
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <stand/stand_controller.h>
+#include <telemetry/stand_state.h>
+
+#include <cstdint>
+
+#include "command.h"
+#include "configs/periodic_task_config.h"
+#include "configs/stand_config.h"
+#include "datalog.h"
+#include "ignition.h"
+#include "periodic_task.h"
+#include "pt.h"
+#include "trace.h"
+#include "valve.h"
+
+static const char* TAG = "STAND";
+
+// Shared by the acquisition, command and sequencer tasks.
+static StandController CONTROLLER(STAND_LOGIC);
+static hal_spinlock_t CONTROLLER_LOCK = HAL_SPINLOCK_INIT;
+
+// Drives the outputs for `step`, or with `undo`, takes back what opening a
+// valve or raising the relay did. Closing needs no undoing.
+static void actuate(const SequenceStep& step, bool undo) {
+  switch (step.action) {
+    case SequenceAction::kOpenValve:
+      if (undo) {
+        close_valve(static_cast<Valve>(step.arg));
+      } else {
+        open_valve(static_cast<Valve>(step.arg));
+      }
+      break;
+    case SequenceAction::kCloseValve:
+      if (!undo) {
+        close_valve(static_cast<Valve>(step.arg));
+      }
+      break;
+    case SequenceAction::kIgnitionOn:
+      if (undo) {
+        set_ignition_relay_low();
+      } else {
+        set_ignition_relay_high();
+      }
+      break;
+    case SequenceAction::kIgnitionOff:
+      if (!undo) {
+        set_ignition_relay_low();
+      }
+      break;
+  }
+}
+
+// Carries out a sequence step, unless the stand left kFiring since the step
+// was released. The outputs are driven outside CONTROLLER_LOCK, so a step can
+// race abort_stand() on another task or core; the state is checked again
+// afterwards, under the lock. abort_stand() leaves kFiring under the same lock
+// before closing the valves, so either its closes come after the step, or
+// this sees the abort and takes the step back.
+static void carry_out_step(const StandDecision& decision) {
+  hal_enter_critical(&CONTROLLER_LOCK);
+  bool firing = CONTROLLER.state() == StandState::kFiring;
+  hal_exit_critical(&CONTROLLER_LOCK);
+  if (!firing) {
+    return;
+  }
+  const SequenceStep& step = STAND_LOGIC.sequence[decision.index];
+  actuate(step, false);
+  hal_enter_critical(&CONTROLLER_LOCK);
+  firing = CONTROLLER.state() == StandState::kFiring;
+  hal_exit_critical(&CONTROLLER_LOCK);
+  if (!firing) {
+    ESP_LOGW(TAG, "Stand left firing during step %d, taking it back",
+             decision.index);
+    actuate(step, true);
+    return;
+  }
+  datalog_event(LogEvent::kSequencerStep, decision.index);
+}
+
+// Carries out a decision. Called outside CONTROLLER_LOCK: aborting takes the
+// lock again through stand_control_set_state().
+static void carry_out(const StandDecision& decision) {
+  if (decision.type == DecisionType::kAbort) {
+    const Redline& redline = STAND_LOGIC.redlines[decision.index];
+    ESP_LOGW(TAG, "Redline %d tripped on PT %d, aborting", decision.index,
+             redline.pt);
+    datalog_trigger(LogEvent::kRedline, decision.index);
+    abort_stand();
+    return;
+  }
+  carry_out_step(decision);
+}
+
+void stand_control_pt(Pt pt, float psi, uint64_t t_us) {
+  TRACE_ZONE(kStandControl);
+  StandDecision decision;
+  hal_enter_critical(&CONTROLLER_LOCK);
+  bool decided =
+      CONTROLLER.on_pt(static_cast<uint8_t>(pt), t_us, psi, &decision);
+  hal_exit_critical(&CONTROLLER_LOCK);
+  if (decided) {
+    carry_out(decision);
+  }
+}
+
+void stand_control_set_state(StandState state) {
+  uint64_t t_us = hal_time_us();
+  hal_enter_critical(&CONTROLLER_LOCK);
+  CONTROLLER.set_state(state, t_us);
+  hal_exit_critical(&CONTROLLER_LOCK);
+}
+
+// Carries out the sequence steps that came due since the previous run.
+static void sequence(void* arg) {
+  uint64_t t_us = hal_time_us();
+  StandDecision decision;
+  while (1) {
+    hal_enter_critical(&CONTROLLER_LOCK);
+    bool decided = CONTROLLER.poll_sequence(t_us, &decision);
+    hal_exit_critical(&CONTROLLER_LOCK);
+    if (!decided) {
+      break;
+    }
+    carry_out(decision);
+  }
+}
+
+void init_stand_control() {
+  start_periodic_task(SEQUENCER_TASK, sequence, nullptr);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <telemetry/stand_state.h>
+
+#include <cstdint>
+
+#include "pt.h"
+
+// Runs the stand logic (components/stand) on the board: PT readings are
+// filtered and checked against the redlines, and the firing sequence is
+// carried out in kFiring. See configs/stand_config.h.
+
+// Starts the task that releases the sequence steps.
+void init_stand_control();
+
+// Feeds a reading of `pt` taken at `t_us` (esp_timer_get_time()). Aborts the
+// stand if a redline trips. Safe to call from any task.
+void stand_control_pt(Pt pt, float psi, uint64_t t_us);
+
+// Follows a stand state change made by a command.
+void stand_control_set_state(StandState state);
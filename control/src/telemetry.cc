@@ -0,0 +1,88 @@
+#include "telemetry.h"
+
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/system.h>
+#include <hal/timer.h>
+#include <telemetry/scheduler.h>
+#include <telemetry/stand_state.h>
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+
+#include "command.h"
+#include "configs/telemetry_config.h"
+#include "trace.h"
+#include "valve.h"
+#include "wired.h"
+
+static const char* TAG = "TELEMETRY";
+
+static TelemetryScheduler SCHEDULER(
+    TELEMETRY_CHANNELS,
+    sizeof(TELEMETRY_CHANNELS) / sizeof(TELEMETRY_CHANNELS[0]));
+// record() is called from acquisition tasks and build() from the radio task.
+static hal_spinlock_t SCHEDULER_LOCK = HAL_SPINLOCK_INIT;
+
+void telemetry_record(TelemetryChannel channel, float value) {
+  uint64_t now_us = hal_time_us();
+  hal_enter_critical(&SCHEDULER_LOCK);
+  SCHEDULER.record(static_cast<size_t>(channel), value, now_us);
+  hal_exit_critical(&SCHEDULER_LOCK);
+  wired_record(channel, value, now_us);
+}
+
+void telemetry_record_housekeeping() {
+  telemetry_record(TelemetryChannel::kValveStates, get_valve_states());
+  telemetry_record(TelemetryChannel::kHealth, hal_free_heap_size());
+  telemetry_record(TelemetryChannel::kAbortStatus,
+                   static_cast<float>(get_stand_state()));
+}
+
+void telemetry_set_state(StandState state) {
+  uint64_t now_us = hal_time_us();
+  hal_enter_critical(&SCHEDULER_LOCK);
+  SCHEDULER.set_state(state, now_us);
+  hal_exit_critical(&SCHEDULER_LOCK);
+}
+
+void telemetry_set_degraded(bool degraded) {
+  hal_enter_critical(&SCHEDULER_LOCK);
+  SCHEDULER.set_min_priority(degraded ? ChannelPriority::kHigh
+                                      : ChannelPriority::kLow);
+  hal_exit_critical(&SCHEDULER_LOCK);
+}
+
+size_t telemetry_build_body(uint8_t* out, size_t out_cap) {
+  TRACE_ZONE(kTelemetryBuild);
+  // Housekeeping channels are sampled when a frame is built.
+  telemetry_record_housekeeping();
+
+  uint64_t now_us = hal_time_us();
+  hal_enter_critical(&SCHEDULER_LOCK);
+  size_t len = SCHEDULER.build(now_us, out, out_cap);
+  hal_exit_critical(&SCHEDULER_LOCK);
+  return len;
+}
+
+void telemetry_log_report() {
+  uint64_t now_us = hal_time_us();
+  ChannelReport reports[TELEMETRY_MAX_CHANNELS];
+  hal_enter_critical(&SCHEDULER_LOCK);
+  size_t count = SCHEDULER.channel_count();
+  for (size_t i = 0; i < count; i++) {
+    reports[i] = SCHEDULER.report(i, now_us);
+  }
+  float fill_ratio = SCHEDULER.fill_ratio();
+  SCHEDULER.reset_stats(now_us);
+  hal_exit_critical(&SCHEDULER_LOCK);
+
+  for (size_t i = 0; i < count; i++) {
+    ESP_LOGI(TAG,
+             "Channel %u: %" PRIu32 " samples, %" PRIu32 " records, %.2f Hz",
+             reports[i].id, reports[i].samples, reports[i].records,
+             reports[i].achieved_rate_hz);
+  }
+  ESP_LOGI(TAG, "Frame fill ratio: %.2f", fill_ratio);
+}
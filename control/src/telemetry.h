@@ -0,0 +1,32 @@
+#pragma once
+
+#include <telemetry/stand_state.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "configs/telemetry_config.h"
+
+// Adds a sample to a telemetry channel. Samples are summarized until the
+// channel's next downlink slot, and sent as they are while the wired link is
+// up. Safe to call from any task.
+void telemetry_record(TelemetryChannel channel, float value);
+
+// Samples the housekeeping channels (valve states, health, abort status).
+// Called whenever a frame is built, on either link.
+void telemetry_record_housekeeping();
+
+// Switches the per-channel downlink rates. See configs/telemetry_config.h.
+void telemetry_set_state(StandState state);
+
+// In degraded mode only kCritical and kHigh channels are downlinked; the
+// others keep their samples until it clears.
+void telemetry_set_degraded(bool degraded);
+
+// Builds the next telemetry frame body (without the AckField). Returns its
+// size, or 0 if no channel is due. Called by the radio task.
+size_t telemetry_build_body(uint8_t* out, size_t out_cap);
+
+// Logs the achieved rate of each channel and the frame fill ratio since the
+// previous report.
+void telemetry_log_report();
@@ -0,0 +1,116 @@
+#include "trace.h"
+
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <telemetry/trace_report.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "configs/trace_config.h"
+
+static const char* TAG = "TRACE";
+
+static std::atomic<bool> SEND_REQUESTED{false};
+
+#if TRACE_ENABLED
+
+struct ZoneEntry {
+  uint32_t calls;
+  uint64_t total_cycles;
+  uint32_t max_cycles;
+};
+
+// One table per core. With interrupts masked on its core an update can't be
+// preempted, so like the deferred log rings the tables need no lock.
+static ZoneEntry
+    TABLES[HAL_CORE_COUNT][static_cast<size_t>(TraceZone::kTraceZoneMax)];
+
+void trace_record(TraceZone zone, uint32_t cycles) {
+  uint32_t mask = hal_mask_interrupts();
+  ZoneEntry& entry = TABLES[hal_core_id()][static_cast<size_t>(zone)];
+  entry.calls++;
+  entry.total_cycles += cycles;
+  entry.max_cycles = std::max(entry.max_cycles, cycles);
+  hal_unmask_interrupts(mask);
+}
+
+size_t get_trace_stats(TraceZoneStats* out, size_t cap) {
+  size_t count = 0;
+  for (size_t zone = 0; zone < static_cast<size_t>(TraceZone::kTraceZoneMax) &&
+                        count < cap;
+       zone++) {
+    TraceZoneStats stats = {.zone = static_cast<uint8_t>(zone)};
+    for (int core = 0; core < HAL_CORE_COUNT; core++) {
+      // A torn read of an entry another core is updating is off by one call
+      // at most.
+      const ZoneEntry& entry = TABLES[core][zone];
+      stats.calls += entry.calls;
+      stats.total_cycles += entry.total_cycles;
+      stats.max_cycles = std::max(stats.max_cycles, entry.max_cycles);
+    }
+    if (stats.calls > 0) {
+      out[count++] = stats;
+    }
+  }
+  return count;
+}
+
+void trace_reset() {
+  for (int core = 0; core < HAL_CORE_COUNT; core++) {
+    uint32_t mask = hal_mask_interrupts();
+    std::fill(std::begin(TABLES[core]), std::end(TABLES[core]), ZoneEntry{});
+    hal_unmask_interrupts(mask);
+  }
+}
+
+#else
+
+size_t get_trace_stats(TraceZoneStats*, size_t) { return 0; }
+
+void trace_reset() {}
+
+#endif
+
+void trace_log_report() {
+  if (!TRACE_ENABLED) {
+    ESP_LOGW(TAG, "Tracing is compiled out (TRACE_ENABLED is 0)");
+    return;
+  }
+  TraceZoneStats zones[static_cast<size_t>(TraceZone::kTraceZoneMax)];
+  const size_t count = get_trace_stats(zones, std::size(zones));
+  const double cycles_per_us = hal_cycles_per_us();
+  uint64_t totals[static_cast<size_t>(TraceZone::kTraceZoneMax)] = {};
+  for (size_t i = 0; i < count; i++) {
+    const TraceZoneStats& zone = zones[i];
+    totals[zone.zone] = zone.total_cycles;
+    ESP_LOGI(TAG,
+             "%-18s %8" PRIu32 " calls, mean %8.1f us, max %8.1f us, total "
+             "%10.1f ms",
+             TRACE_ZONE_NAMES[zone.zone], zone.calls,
+             zone.total_cycles / cycles_per_us / zone.calls,
+             zone.max_cycles / cycles_per_us,
+             zone.total_cycles / cycles_per_us / 1000);
+  }
+
+  // The loop's split: waiting on the ADC bus, logging, and the rest.
+  const double loop = totals[static_cast<size_t>(TraceZone::kAcquisitionLoop)];
+  if (loop > 0) {
+    const double spi = totals[static_cast<size_t>(TraceZone::kAdcSpi)];
+    const double logging = totals[static_cast<size_t>(TraceZone::kLogging)];
+    ESP_LOGI(TAG,
+             "Acquisition loop: %.1f%% ADC SPI, %.1f%% compute, %.1f%% "
+             "logging",
+             100 * spi / loop, 100 * (loop - spi - logging) / loop,
+             100 * logging / loop);
+  }
+}
+
+void trace_request_send() { SEND_REQUESTED = true; }
+
+bool trace_take_send_request() { return SEND_REQUESTED.exchange(false); }
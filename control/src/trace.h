@@ -0,0 +1,70 @@
+#pragma once
+
+#include <hal/timer.h>
+#include <telemetry/trace_report.h>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "configs/trace_config.h"
+
+// Cycle-counter profiling of code zones. TRACE_ZONE(kName) at the top of a
+// scope times the rest of the scope and adds it to the zone's entry in a
+// static table (calls, total and max cycles), one table per core:
+//
+//   {
+//     TRACE_ZONE(kAdcSpi);
+//     mcp320x_sample_voltage(...);
+//   }
+//
+// A zone costs two cycle counter reads and a few adds with interrupts masked.
+// Time the task spends preempted inside a zone counts towards it. With
+// TRACE_ENABLED at 0 (configs/trace_config.h) zones compile to nothing and the
+// table is always empty.
+
+#if TRACE_ENABLED
+
+// Adds `cycles` to `zone` on the calling core. Use TRACE_ZONE() instead.
+void trace_record(TraceZone zone, uint32_t cycles);
+
+class TraceScope {
+ public:
+  explicit TraceScope(TraceZone zone)
+      : zone_(zone), start_(hal_cycle_count()) {}
+  ~TraceScope() { trace_record(zone_, hal_cycle_count() - start_); }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  TraceZone zone_;
+  uint32_t start_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(zone) \
+  TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(TraceZone::zone)
+
+#else
+
+#define TRACE_ZONE(zone) static_cast<void>(0)
+
+#endif
+
+// Copies the zones that ran at least once, summed over both cores, to `out`.
+// Returns their number.
+size_t get_trace_stats(TraceZoneStats* out, size_t cap);
+
+// Clears the table.
+void trace_reset();
+
+// Logs the table (calls, mean, max and total time of each zone), then how the
+// acquisition loop splits between ADC SPI, compute and logging.
+void trace_log_report();
+
+// Asks the link that carries telemetry to downlink the table once.
+void trace_request_send();
+
+// Whether a downlink of the table was asked for since the last call.
+bool trace_take_send_request();
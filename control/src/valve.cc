@@ -1,21 +1,60 @@
 #include "valve.h"
 
+#include <atomic>
+#include <cstdint>
+
 #include "configs/valve_config.h"
+#include "datalog.h"
 #include "servo.h"
+#include "trace.h"
+
+static std::atomic<uint32_t> VALVE_STATES{0};
+
+static bool in(uint32_t valves, Valve valve) {
+  return (valves & 1u << static_cast<int>(valve)) != 0;
+}
 
-void setup_valves() {
+void setup_valves(uint32_t valves) {
   setup_servo_pwm_timer();
   for (const ValveConfig& valve_config : VALVE_CONFIGS) {
-    setup_servo_pin(valve_config.gpio_num);
+    if (in(valves, valve_config.valve)) {
+      setup_servo_pin(valve_config.gpio_num);
+    }
+  }
+}
+
+void init_valves(uint32_t valves) {
+  setup_valves(valves);
+  for (const ValveConfig& valve_config : VALVE_CONFIGS) {
+    if (in(valves, valve_config.valve)) {
+      set_servo_angle(valve_config.gpio_num, valve_config.close_angle,
+                      valve_config.max_angle);
+    }
   }
+  VALVE_STATES = 0;
 }
 
-void open_valve(Valve valve) {
+bool open_valve(Valve valve) {
+  TRACE_ZONE(kValveActuation);
   const ValveConfig& config = get_valve_config(valve);
-  set_servo_angle(config.gpio_num, config.open_angle, config.max_angle);
+  if (!set_servo_angle(config.gpio_num, config.open_angle, config.max_angle)) {
+    return false;
+  }
+  VALVE_STATES |= 1u << static_cast<int>(valve);
+  datalog_valve(valve, true);
+  return true;
 }
 
-void close_valve(Valve valve) {
+bool close_valve(Valve valve) {
+  TRACE_ZONE(kValveActuation);
   const ValveConfig& config = get_valve_config(valve);
-  set_servo_angle(config.gpio_num, config.close_angle, config.max_angle);
-}
\ No newline at end of file
+  if (!set_servo_angle(config.gpio_num, config.close_angle,
+                       config.max_angle)) {
+    return false;
+  }
+  VALVE_STATES &= ~(1u << static_cast<int>(valve));
+  datalog_valve(valve, false);
+  return true;
+}
+
+uint32_t get_valve_states() { return VALVE_STATES; }
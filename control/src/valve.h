@@ -1,12 +1,37 @@
 #pragma once
 
-#include "configs/valve_config.h"
+#include <cstdint>
 
-// Set up underlying valve GPIO pins, pwm timer, GPIO -> channel mapping.
-void setup_valves();
+enum class Valve {
+  kPressurizeFuelTank,
+  kPreslugFuel,
+  kN2PurgeFuelTankBypass,
+  kN2PurgeGox,
+  kPreslugGox,
+  kGoxRelease,
+  kFuelRelease,
+  kValveMax
+};
 
-// Open valve to configured `open_angle`. See configs/valve_config.h.
-void open_valve(Valve valve);
+// Bit n stands for Valve n.
+constexpr uint32_t ALL_VALVES = (1u << static_cast<int>(Valve::kValveMax)) - 1;
 
-// Close valve to configured `close_angle`. See configs/valve_config.h.
-void close_valve(Valve valve);
+// Set up underlying valve GPIO pins, pwm timer, GPIO -> channel mapping, for
+// the valves in `valves`.
+void setup_valves(uint32_t valves);
+
+// Sets up the valves in `valves` and drives them closed, the stand's safe
+// state. The others stay unusable: open_valve() and close_valve() refuse
+// them. Not logged: at boot the flight-data log may not be open yet.
+void init_valves(uint32_t valves);
+
+// Open valve to configured `open_angle`. See configs/valve_config.h. Returns
+// false, leaving the valve as it was, if the valves aren't set up.
+bool open_valve(Valve valve);
+
+// Close valve to configured `close_angle`. See configs/valve_config.h. Returns
+// false, leaving the valve as it was, if the valves aren't set up.
+bool close_valve(Valve valve);
+
+// Bitmask of commanded valve positions; bit n is set when Valve n is open.
+uint32_t get_valve_states();
@@ -0,0 +1,336 @@
+#include "wired.h"
+
+#include <esp_log.h>
+#include <hal/rtos.h>
+#include <hal/timer.h>
+#include <hal/uart.h>
+#include <telemetry/frame.h>
+#include <telemetry/frame_stream.h>
+#include <telemetry/sample_stream.h>
+#include <telemetry/spsc_ring.h>
+#include <telemetry/time_sync.h>
+#include <telemetry/trace_report.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "configs/periodic_task_config.h"
+#include "configs/radio_config.h"
+#include "configs/telemetry_config.h"
+#include "configs/trace_config.h"
+#include "configs/wired_config.h"
+#include "periodic_task.h"
+#include "telemetry.h"
+#include "trace.h"
+
+static const char* TAG = "WIRED";
+
+// Filled by acquisition tasks under RING_LOCK, drained by the wired task.
+static SpscRing<RawSample, WIRED_SAMPLE_RING_SIZE> RING;
+static hal_spinlock_t RING_LOCK = HAL_SPINLOCK_INIT;
+
+// Owned by the wired task.
+static FrameStreamParser PARSER;
+// kSamples frames are numbered on their own, so the ground counts the ones
+// lost without the trace frames in between.
+static uint16_t SAMPLES_SEQ = 0;
+static uint16_t TRACE_SEQ = 0;
+static int64_t LAST_HEARTBEAT_US = 0;
+static uint32_t FRAMES_SENT = 0;
+static uint32_t SAMPLES_SENT = 0;
+static uint32_t BYTES_SENT = 0;
+static uint32_t TX_STALLS = 0;
+static uint32_t HEARTBEATS = 0;
+static ClockSync CLOCK_SYNC(WIRED_TIME_SYNC_DELAY_SLACK_US);
+static uint16_t TIME_SEQ = 0;
+// Set by on_host_frame() when the reply to the pending request arrives.
+static bool TIME_REPLIED = false;
+static uint32_t TIME_SYNC_TIMEOUTS = 0;
+// Copy of the clock sync state for get_wired_stats().
+static ClockSyncStats CLOCK_STATS = {};
+static bool CLOCK_SYNCED = false;
+static hal_spinlock_t CLOCK_STATS_LOCK = HAL_SPINLOCK_INIT;
+static hal_tick_t NEXT_HOUSEKEEPING = 0;
+static hal_tick_t NEXT_SYNC = 0;
+static hal_tick_t NEXT_REPORT = 0;
+static hal_tick_t NEXT_TRACE = 0;
+static bool TRACE_PENDING = false;
+
+static std::atomic<bool> LINK_UP{false};
+
+void wired_record(TelemetryChannel channel, float value, uint64_t t_us) {
+  if (!LINK_UP.load(std::memory_order_relaxed)) {
+    return;
+  }
+  RawSample sample = {
+      .t_us = t_us,
+      .channel = static_cast<uint8_t>(channel),
+      .value = value,
+  };
+  hal_enter_critical(&RING_LOCK);
+  RING.push(sample);
+  hal_exit_critical(&RING_LOCK);
+}
+
+bool wired_link_up() { return LINK_UP.load(std::memory_order_relaxed); }
+
+static void on_host_frame(const Frame& frame) {
+  if (frame.type == FrameType::kHeartbeat) {
+    LAST_HEARTBEAT_US = hal_time_us();
+    HEARTBEATS++;
+    return;
+  }
+  TimeReply reply;
+  if (decode_time_reply(frame, &reply)) {
+    uint64_t t4_us = hal_time_us();
+    CLOCK_SYNC.on_exchange(reply, t4_us);
+    TIME_REPLIED = true;
+    hal_enter_critical(&CLOCK_STATS_LOCK);
+    CLOCK_STATS = CLOCK_SYNC.stats();
+    CLOCK_SYNCED = CLOCK_SYNC.synced();
+    hal_exit_critical(&CLOCK_STATS_LOCK);
+  }
+}
+
+// Reads whatever the host sent and refreshes the link on heartbeats.
+static void receive() {
+  uint8_t data[128];
+  int len;
+  while ((len = hal_uart_read(WIRED_UART_PORT, data, sizeof(data), 0)) > 0) {
+    PARSER.push(data, len, on_host_frame);
+  }
+}
+
+// Runs one clock synchronization exchange. Blocks until the reply arrives,
+// a byte at a time, so its arrival time isn't held up by the task period.
+static void sync_clock() {
+  uint8_t frame[FRAME_OVERHEAD + TIME_REQUEST_PAYLOAD_SIZE];
+  TIME_REPLIED = false;
+  uint64_t t1_us = hal_time_us();
+  size_t size = encode_time_request(++TIME_SEQ, t1_us, frame, sizeof(frame));
+  hal_uart_write(WIRED_UART_PORT, frame, size);
+
+  const int64_t deadline_us = t1_us + WIRED_TIME_SYNC_TIMEOUT_MS * 1000LL;
+  while (!TIME_REPLIED && hal_time_us() < deadline_us) {
+    uint8_t data[128];
+    int len = hal_uart_read(WIRED_UART_PORT, data, 1,
+                            HAL_MS_TO_TICKS(WIRED_TIME_SYNC_TIMEOUT_MS));
+    if (len <= 0) {
+      break;
+    }
+    int more = hal_uart_read(WIRED_UART_PORT, &data[1], sizeof(data) - 1, 0);
+    PARSER.push(data, len + (more > 0 ? more : 0), on_host_frame);
+  }
+  if (!TIME_REPLIED) {
+    TIME_SYNC_TIMEOUTS++;
+  }
+}
+
+static void update_link() {
+  bool up = HEARTBEATS > 0 && hal_time_us() - LAST_HEARTBEAT_US <
+                                  WIRED_LINK_TIMEOUT_MS * 1000LL;
+  if (up == LINK_UP.load(std::memory_order_relaxed)) {
+    return;
+  }
+  LINK_UP.store(up, std::memory_order_relaxed);
+  if (up) {
+    ESP_LOGI(TAG, "Host connected, telemetry switched to the wire");
+  } else {
+    ESP_LOGW(TAG, "Host lost, telemetry switched to LoRa");
+    // Whatever is left would only be sent once the host is back, with a gap
+    // before it.
+    while (RING.front() != nullptr) {
+      RING.pop();
+    }
+  }
+}
+
+// Sends the queued samples, a frame at a time, while the TX buffer has room
+// for a whole frame. The rest wait in the ring for the next period.
+static void send_samples() {
+  TRACE_ZONE(kWiredTx);
+  RawSample batch[SAMPLES_PER_FRAME];
+  uint8_t frame[FRAME_MAX_SIZE];
+  while (RING.front() != nullptr) {
+    if (hal_uart_tx_free(WIRED_UART_PORT) < sizeof(frame)) {
+      TX_STALLS++;
+      return;
+    }
+
+    size_t count = 0;
+    while (count < SAMPLES_PER_FRAME) {
+      RawSample* sample = RING.front();
+      if (sample == nullptr) {
+        break;
+      }
+      batch[count++] = *sample;
+      RING.pop();
+    }
+    // The whole batch with the same fit, so it stays in time order.
+    SampleClock clock = SampleClock::kBoard;
+    if (CLOCK_SYNC.synced()) {
+      clock = SampleClock::kHost;
+      for (size_t i = 0; i < count; i++) {
+        batch[i].t_us = CLOCK_SYNC.to_host(batch[i].t_us);
+      }
+    }
+    size_t offset = 0;
+    while (offset < count) {
+      size_t consumed;
+      // Commands still travel over LoRa, so there is nothing to acknowledge.
+      size_t size = encode_samples_frame(RADIO_NODE_ID, ++SAMPLES_SEQ, AckField{},
+                                         &batch[offset], count - offset, clock,
+                                         &consumed, frame, sizeof(frame));
+      if (size == 0) {
+        break;
+      }
+      hal_uart_write(WIRED_UART_PORT, frame, size);
+      offset += consumed;
+      FRAMES_SENT++;
+      SAMPLES_SENT += consumed;
+      BYTES_SENT += size;
+    }
+  }
+}
+
+// Sends the trace table, in as many frames as it takes, if the TX buffer has
+// room for all of them. Returns false if it didn't.
+static bool send_trace() {
+  TraceZoneStats zones[static_cast<size_t>(TraceZone::kTraceZoneMax)];
+  const size_t count = get_trace_stats(zones, std::size(zones));
+  const size_t frames =
+      (count + TRACE_ZONES_PER_FRAME - 1) / TRACE_ZONES_PER_FRAME;
+  if (hal_uart_tx_free(WIRED_UART_PORT) < frames * FRAME_MAX_SIZE) {
+    TX_STALLS++;
+    return false;
+  }
+  size_t offset = 0;
+  while (offset < count) {
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t consumed;
+    size_t size = encode_trace_frame(
+        RADIO_NODE_ID, ++TRACE_SEQ, AckField{}, hal_cycles_per_us(),
+        &zones[offset], count - offset, &consumed, frame, sizeof(frame));
+    if (size == 0) {
+      break;
+    }
+    hal_uart_write(WIRED_UART_PORT, frame, size);
+    offset += consumed;
+    FRAMES_SENT++;
+    BYTES_SENT += size;
+  }
+  return true;
+}
+
+static void log_report() {
+  WiredStats stats = get_wired_stats();
+  ESP_LOGI(TAG,
+           "Link %s: %" PRIu32 " frames, %" PRIu32 " samples, %" PRIu32
+           " bytes sent, %" PRIu32 " samples dropped, ring high water %" PRIu32
+           ", %" PRIu32 " TX stalls",
+           stats.link_up ? "up" : "down", stats.frames_sent,
+           stats.samples_sent, stats.bytes_sent, stats.samples_dropped,
+           stats.ring_high_water, stats.tx_stalls);
+  const ClockSyncStats& clock = stats.clock;
+  if (clock.exchanges > 0) {
+    ESP_LOGI(TAG,
+             "Clock %s: offset %" PRId64 " us, drift %.2f ppm, %" PRIu32
+             " exchanges, %" PRIu32 " rejected, %" PRIu32
+             " timed out, one-way latency min/mean/max %" PRIu32 "/%" PRIu32
+             "/%" PRIu32 " us",
+             stats.clock_synced ? "synced" : "not synced", clock.offset_us,
+             clock.drift_ppm, clock.exchanges, clock.rejected,
+             stats.time_sync_timeouts, clock.delay_min_us / 2,
+             clock.delay_mean_us() / 2, clock.delay_max_us / 2);
+  }
+}
+
+// One period of the wired task.
+static void serve(void* arg) {
+  receive();
+  update_link();
+
+  hal_tick_t now = hal_tick_count();
+  if (LINK_UP.load(std::memory_order_relaxed)) {
+    // The radio task samples these when it builds a frame, which it no
+    // longer does.
+    if (static_cast<int32_t>(now - NEXT_HOUSEKEEPING) >= 0) {
+      telemetry_record_housekeeping();
+      NEXT_HOUSEKEEPING = now + HAL_MS_TO_TICKS(TELEMETRY_FRAME_PERIOD_MS);
+    }
+    // Before this period's samples, so the request isn't queued behind
+    // them.
+    if (static_cast<int32_t>(now - NEXT_SYNC) >= 0) {
+      sync_clock();
+      NEXT_SYNC = now + HAL_MS_TO_TICKS(WIRED_TIME_SYNC_PERIOD_MS);
+    }
+    send_samples();
+    // Streamed while the link is up, and sent on request.
+    if (TRACE_STREAM_PERIOD_MS > 0 &&
+        static_cast<int32_t>(now - NEXT_TRACE) >= 0) {
+      TRACE_PENDING = true;
+      NEXT_TRACE = now + HAL_MS_TO_TICKS(TRACE_STREAM_PERIOD_MS);
+    }
+    TRACE_PENDING |= trace_take_send_request();
+    if (TRACE_PENDING && send_trace()) {
+      TRACE_PENDING = false;
+    }
+  }
+  if (static_cast<int32_t>(now - NEXT_REPORT) >= 0) {
+    log_report();
+    NEXT_REPORT = now + HAL_MS_TO_TICKS(WIRED_REPORT_PERIOD_MS);
+  }
+}
+
+void init_wired() {
+  if (!hal_uart_install(WIRED_UART_PORT, WIRED_RX_BUFFER_SIZE,
+                        WIRED_TX_BUFFER_SIZE)) {
+    ESP_LOGE(TAG, "UART driver install failed, wired telemetry disabled");
+    return;
+  }
+  ESP_LOGI(TAG, "Switching the console to %d baud", WIRED_BAUD_RATE);
+  hal_uart_wait_tx_idle(WIRED_UART_PORT);
+  hal_uart_set_baud_rate(WIRED_UART_PORT, WIRED_BAUD_RATE);
+  // Route stdout (log lines) through the driver too, so they are queued
+  // between frames instead of written into the middle of one.
+  hal_uart_route_stdout(WIRED_UART_PORT);
+
+  hal_tick_t now = hal_tick_count();
+  NEXT_HOUSEKEEPING = now;
+  NEXT_SYNC = now;
+  NEXT_REPORT = now + HAL_MS_TO_TICKS(WIRED_REPORT_PERIOD_MS);
+  NEXT_TRACE = now;
+  start_periodic_task(WIRED_TASK, serve, nullptr);
+}
+
+bool wired_clock_offset(int64_t* offset_us) {
+  hal_enter_critical(&CLOCK_STATS_LOCK);
+  *offset_us = CLOCK_STATS.offset_us;
+  bool clock_synced = CLOCK_SYNCED;
+  hal_exit_critical(&CLOCK_STATS_LOCK);
+  return clock_synced;
+}
+
+WiredStats get_wired_stats() {
+  hal_enter_critical(&CLOCK_STATS_LOCK);
+  ClockSyncStats clock = CLOCK_STATS;
+  bool clock_synced = CLOCK_SYNCED;
+  hal_exit_critical(&CLOCK_STATS_LOCK);
+  return {
+      .link_up = LINK_UP.load(std::memory_order_relaxed),
+      .frames_sent = FRAMES_SENT,
+      .samples_sent = SAMPLES_SENT,
+      .bytes_sent = BYTES_SENT,
+      .samples_dropped = RING.dropped(),
+      .ring_high_water = static_cast<uint32_t>(RING.high_water()),
+      .tx_stalls = TX_STALLS,
+      .heartbeats = HEARTBEATS,
+      .rx_skipped_bytes = PARSER.stats().skipped_bytes,
+      .clock_synced = clock_synced,
+      .clock = clock,
+      .time_sync_timeouts = TIME_SYNC_TIMEOUTS,
+  };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <telemetry/time_sync.h>
+
+#include <cstdint>
+
+#include "configs/telemetry_config.h"
+
+struct WiredStats {
+  bool link_up;
+  uint32_t frames_sent;
+  uint32_t samples_sent;
+  uint32_t bytes_sent;
+  // Samples lost because the ring was full, i.e. the UART couldn't keep up.
+  uint32_t samples_dropped;
+  uint32_t ring_high_water;
+  // Task periods that left samples in the ring because the TX buffer was
+  // full.
+  uint32_t tx_stalls;
+  uint32_t heartbeats;
+  // Bytes received that weren't part of a valid frame.
+  uint32_t rx_skipped_bytes;
+  // Clock synchronization with the host. One-way latency is taken as half
+  // the round trip of each exchange.
+  bool clock_synced;
+  ClockSyncStats clock;
+  // Exchanges the host didn't answer in time.
+  uint32_t time_sync_timeouts;
+};
+
+// Installs the UART driver on the console port and starts the task that
+// streams full-rate samples while a host is connected. See
+// configs/wired_config.h.
+void init_wired();
+
+// Queues a sample for the wired link. Does nothing while the link is down.
+// Safe to call from any task. `t_us` is board time; it is sent in host time
+// once the clocks are synchronized.
+void wired_record(TelemetryChannel channel, float value, uint64_t t_us);
+
+// Whether a host has sent a heartbeat recently, in which case telemetry goes
+// over the wire instead of LoRa.
+bool wired_link_up();
+
+// Sets `offset_us` to host time minus board time and returns true once the
+// clocks are synchronized. Safe to call from any task.
+bool wired_clock_offset(int64_t* offset_us);
+
+WiredStats get_wired_stats();
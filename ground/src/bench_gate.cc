@@ -0,0 +1,214 @@
+#include "bench_gate.h"
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr char PREFIX[] = "bench,";
+constexpr char HEADER[] =
+    "bench,name,iterations,batches,cycles_min,cycles_p25,cycles_median,"
+    "cycles_p75,cycles_max,ns_median";
+
+// Width of the notch each side of the median, in IQRs times sqrt(n).
+constexpr double NOTCH = 1.57;
+
+double notch(const BenchRecord& record) {
+  if (record.batches == 0) {
+    return 0;
+  }
+  return NOTCH * (record.cycles_p75 - record.cycles_p25) /
+         std::sqrt(static_cast<double>(record.batches));
+}
+
+const BenchRecord* find(const std::vector<BenchRecord>& records,
+                        const std::string& name) {
+  for (const BenchRecord& record : records) {
+    if (record.name == name) {
+      return &record;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+double BenchRecord::median_low() const { return cycles_median - notch(*this); }
+
+double BenchRecord::median_high() const {
+  return cycles_median + notch(*this);
+}
+
+bool parse_bench_line(const std::string& line, BenchRecord* record) {
+  // Console lines may carry a carriage return.
+  std::string fields = line;
+  while (!fields.empty() && (fields.back() == '\n' || fields.back() == '\r')) {
+    fields.pop_back();
+  }
+  if (fields.compare(0, sizeof(PREFIX) - 1, PREFIX) != 0) {
+    return false;
+  }
+  size_t name_end = fields.find(',', sizeof(PREFIX) - 1);
+  if (name_end == std::string::npos) {
+    return false;
+  }
+  BenchRecord parsed;
+  parsed.name = fields.substr(sizeof(PREFIX) - 1, name_end - sizeof(PREFIX) + 1);
+  unsigned iterations = 0;
+  unsigned batches = 0;
+  int consumed = 0;
+  // The header's numeric fields don't parse.
+  if (std::sscanf(fields.c_str() + name_end + 1,
+                  "%u,%u,%lf,%lf,%lf,%lf,%lf,%lf%n", &iterations, &batches,
+                  &parsed.cycles_min, &parsed.cycles_p25, &parsed.cycles_median,
+                  &parsed.cycles_p75, &parsed.cycles_max, &parsed.ns_median,
+                  &consumed) != 8 ||
+      fields[name_end + 1 + consumed] != '\0') {
+    return false;
+  }
+  parsed.iterations = iterations;
+  parsed.batches = batches;
+  *record = parsed;
+  return true;
+}
+
+std::string format_bench_line(const BenchRecord& record) {
+  char numbers[160];
+  std::snprintf(numbers, sizeof(numbers),
+                ",%" PRIu32 ",%" PRIu32 ",%.1f,%.1f,%.1f,%.1f,%.1f,%.1f",
+                record.iterations, record.batches, record.cycles_min,
+                record.cycles_p25, record.cycles_median, record.cycles_p75,
+                record.cycles_max, record.ns_median);
+  return PREFIX + record.name + numbers;
+}
+
+void merge_bench_result(const BenchRecord& record,
+                        std::vector<BenchRecord>* records) {
+  for (BenchRecord& existing : *records) {
+    if (existing.name == record.name) {
+      if (record.cycles_median < existing.cycles_median) {
+        existing = record;
+      }
+      return;
+    }
+  }
+  records->push_back(record);
+}
+
+std::vector<BenchRecord> parse_bench_lines(const std::string& text) {
+  std::vector<BenchRecord> records;
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find('\n', start);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    BenchRecord record;
+    if (parse_bench_line(text.substr(start, end - start), &record)) {
+      merge_bench_result(record, &records);
+    }
+    start = end + 1;
+  }
+  return records;
+}
+
+bool load_bench_results(const std::string& path,
+                        std::vector<BenchRecord>* records) {
+  std::FILE* file = path == "-" ? stdin : std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::string text;
+  char buffer[4096];
+  size_t len;
+  while ((len = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    text.append(buffer, len);
+  }
+  bool ok = !std::ferror(file);
+  if (file != stdin) {
+    std::fclose(file);
+  }
+  for (const BenchRecord& record : parse_bench_lines(text)) {
+    merge_bench_result(record, records);
+  }
+  return ok;
+}
+
+bool save_bench_results(const std::string& path,
+                        const std::vector<BenchRecord>& records) {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  std::fprintf(file, "%s\n", HEADER);
+  for (const BenchRecord& record : records) {
+    std::fprintf(file, "%s\n", format_bench_line(record).c_str());
+  }
+  return std::fclose(file) == 0;
+}
+
+const char* bench_verdict_name(BenchVerdict verdict) {
+  switch (verdict) {
+    case BenchVerdict::kSame:
+      return "same";
+    case BenchVerdict::kFaster:
+      return "faster";
+    case BenchVerdict::kSlower:
+      return "SLOWER";
+    case BenchVerdict::kMissing:
+      return "MISSING";
+    case BenchVerdict::kNew:
+      return "new";
+  }
+  return "?";
+}
+
+std::vector<BenchComparison> compare_bench_results(
+    const std::vector<BenchRecord>& baseline,
+    const std::vector<BenchRecord>& run, double tolerance) {
+  std::vector<BenchComparison> comparisons;
+  for (const BenchRecord& before : baseline) {
+    BenchComparison comparison = {
+        .name = before.name,
+        .verdict = BenchVerdict::kMissing,
+        .baseline_median = before.cycles_median,
+        .median = 0,
+        .delta = 0,
+    };
+    const BenchRecord* after = find(run, before.name);
+    if (after != nullptr) {
+      comparison.median = after->cycles_median;
+      comparison.delta =
+          before.cycles_median > 0
+              ? (after->cycles_median - before.cycles_median) /
+                    before.cycles_median
+              : 0;
+      if (after->median_low() > before.median_high() &&
+          comparison.delta > tolerance) {
+        comparison.verdict = BenchVerdict::kSlower;
+      } else if (after->median_high() < before.median_low() &&
+                 comparison.delta < -tolerance) {
+        comparison.verdict = BenchVerdict::kFaster;
+      } else {
+        comparison.verdict = BenchVerdict::kSame;
+      }
+    }
+    comparisons.push_back(comparison);
+  }
+  for (const BenchRecord& after : run) {
+    if (find(baseline, after.name) == nullptr) {
+      comparisons.push_back({
+          .name = after.name,
+          .verdict = BenchVerdict::kNew,
+          .baseline_median = 0,
+          .median = after.cycles_median,
+          .delta = 0,
+      });
+    }
+  }
+  return comparisons;
+}
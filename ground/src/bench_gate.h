@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Regression gate for the microbenchmarks (control/components/bench): reads
+// the "bench," CSV lines a board booted with BENCH_AT_BOOT or the host's
+// micro_bench prints, and compares a run with a stored baseline.
+//
+// Each result is quantiles over a benchmark's batches. A median is taken as
+// known to within the notch of a box plot, median +- 1.57 IQR / sqrt(n), an
+// approximate 95% confidence interval. A benchmark is slower (or faster) when
+// the intervals of both runs don't overlap and its median moved by more than
+// a tolerance, so neither noise nor a real but negligible change fails it.
+
+struct BenchRecord {
+  std::string name;
+  uint32_t iterations = 0;
+  uint32_t batches = 0;
+  // Cycles per call (nanoseconds on the host).
+  double cycles_min = 0;
+  double cycles_p25 = 0;
+  double cycles_median = 0;
+  double cycles_p75 = 0;
+  double cycles_max = 0;
+  double ns_median = 0;
+
+  // Confidence interval of the median.
+  double median_low() const;
+  double median_high() const;
+};
+
+// Parses one "bench," result line. Returns false for anything else,
+// including the header.
+bool parse_bench_line(const std::string& line, BenchRecord* record);
+// The line parse_bench_line() reads back, without a newline.
+std::string format_bench_line(const BenchRecord& record);
+// Results in the order of their first line. A benchmark printed more than
+// once, by several runs, keeps its fastest result: interference from the
+// rest of the machine only ever slows a run down.
+std::vector<BenchRecord> parse_bench_lines(const std::string& text);
+
+// Adds `record` to `records`, or replaces its result if this one is faster.
+void merge_bench_result(const BenchRecord& record,
+                        std::vector<BenchRecord>* records);
+
+// Merges the result lines of a file, e.g. a console capture, or of stdin if
+// `path` is "-", into `records`. Returns false if it can't be read.
+bool load_bench_results(const std::string& path,
+                        std::vector<BenchRecord>* records);
+// Writes results with a header line, in the format they print in.
+bool save_bench_results(const std::string& path,
+                        const std::vector<BenchRecord>& records);
+
+enum class BenchVerdict {
+  kSame,
+  kFaster,
+  kSlower,
+  kMissing,  // In the baseline but not in the run.
+  kNew,      // In the run but not in the baseline.
+};
+
+const char* bench_verdict_name(BenchVerdict verdict);
+
+struct BenchComparison {
+  std::string name;
+  BenchVerdict verdict;
+  // Cycles per call, 0 where a run doesn't have the benchmark.
+  double baseline_median;
+  double median;
+  // (median - baseline_median) / baseline_median.
+  double delta;
+
+  // Regressions, and benchmarks the run lost, fail the gate.
+  bool failed() const {
+    return verdict == BenchVerdict::kSlower ||
+           verdict == BenchVerdict::kMissing;
+  }
+};
+
+// Compares `run` with `baseline`, benchmark by benchmark: the baseline's
+// first, then the run's new ones. `tolerance` is the relative change of the
+// median below which a benchmark counts as the same.
+std::vector<BenchComparison> compare_bench_results(
+    const std::vector<BenchRecord>& baseline,
+    const std::vector<BenchRecord>& run, double tolerance);
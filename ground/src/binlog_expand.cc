@@ -0,0 +1,122 @@
+#include "binlog_expand.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "binlog/binlog.h"
+#include "configs/log_format_config.h"
+
+namespace {
+
+constexpr char LEVEL_LETTERS[] = {'E', 'W', 'I', 'D'};
+
+float as_float(uint32_t word) {
+  float value;
+  std::memcpy(&value, &word, sizeof(value));
+  return value;
+}
+
+}  // namespace
+
+std::string expand_binlog_format(const char* format, const uint32_t* args,
+                                 uint8_t arg_count) {
+  std::string out;
+  uint8_t next_arg = 0;
+  const char* p = format;
+  while (*p != '\0') {
+    if (*p != '%') {
+      out += *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out += '%';
+      p += 2;
+      continue;
+    }
+
+    // Copy the flags, width and precision; drop length modifiers, since every
+    // argument was stored as a 32-bit word.
+    std::string spec = "%";
+    const char* start = p++;
+    while (*p != '\0' && std::strchr("-+ #0", *p) != nullptr) {
+      spec += *p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+      spec += *p++;
+    }
+    if (*p == '.') {
+      spec += *p++;
+      while (*p >= '0' && *p <= '9') {
+        spec += *p++;
+      }
+    }
+    while (*p != '\0' && std::strchr("hlLqjzt", *p) != nullptr) {
+      p++;
+    }
+    char conversion = *p;
+    if (conversion == '\0') {
+      out.append(start);
+      break;
+    }
+    p++;
+    spec += conversion;
+
+    if (next_arg >= arg_count) {
+      out += '?';
+      continue;
+    }
+    uint32_t word = args[next_arg++];
+    char text[64];
+    int len;
+    if (std::strchr("di", conversion) != nullptr) {
+      len = std::snprintf(text, sizeof(text), spec.c_str(),
+                          static_cast<int32_t>(word));
+    } else if (std::strchr("uoxXc", conversion) != nullptr) {
+      len = std::snprintf(text, sizeof(text), spec.c_str(), word);
+    } else if (std::strchr("fFeEgGaA", conversion) != nullptr) {
+      len = std::snprintf(text, sizeof(text), spec.c_str(),
+                          static_cast<double>(as_float(word)));
+    } else {
+      // Unsupported conversion (e.g. %s): show the raw word.
+      len = std::snprintf(text, sizeof(text), "<0x%08x>", word);
+    }
+    if (len > 0) {
+      out.append(text, std::min<size_t>(len, sizeof(text) - 1));
+    }
+  }
+  return out;
+}
+
+std::string BinLogExpander::expand(const BinLogRecord& record) {
+  // The wire only carries the low 32 bits of the timestamp.
+  uint64_t t_us = (last_t_us_ & ~uint64_t{UINT32_MAX}) |
+                  static_cast<uint32_t>(record.t_us);
+  if (t_us < last_t_us_) {
+    t_us += uint64_t{1} << 32;
+  }
+  last_t_us_ = t_us;
+
+  char prefix[64];
+  std::string message;
+  if (record.format < static_cast<uint16_t>(LogFormat::kLogFormatMax)) {
+    const LogFormatSpec& spec = LOG_FORMATS[record.format];
+    std::snprintf(prefix, sizeof(prefix), "%c (%llu) %s: ",
+                  LEVEL_LETTERS[static_cast<int>(spec.level)],
+                  static_cast<unsigned long long>(t_us / 1000), spec.tag);
+    message = expand_binlog_format(spec.format, record.args, record.arg_count);
+  } else {
+    // Firmware newer than this table.
+    std::snprintf(prefix, sizeof(prefix), "? (%llu) format %u:",
+                  static_cast<unsigned long long>(t_us / 1000),
+                  record.format);
+    for (uint8_t i = 0; i < record.arg_count; i++) {
+      char word[16];
+      std::snprintf(word, sizeof(word), " 0x%08x", record.args[i]);
+      message += word;
+    }
+  }
+  return prefix + message;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "binlog/binlog.h"
+
+// Turns deferred log records back into the lines ESP_LOGx would have
+// printed, using the firmware's format table
+// (control/src/configs/log_format_config.h):
+//
+//   I (1234) PT: PT 0: 14.70 psi
+class BinLogExpander {
+ public:
+  // Expands `record`. Records are expected in the order the board sent them;
+  // their 32-bit timestamps are unwrapped against the previous one.
+  std::string expand(const BinLogRecord& record);
+
+  // Microseconds since boot of the last expanded record.
+  uint64_t last_t_us() const { return last_t_us_; }
+
+ private:
+  uint64_t last_t_us_ = 0;
+};
+
+// Formats `args` according to `format`. Conversions without a matching
+// argument print "?".
+std::string expand_binlog_format(const char* format, const uint32_t* args,
+                                 uint8_t arg_count);
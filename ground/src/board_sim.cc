@@ -0,0 +1,125 @@
+#include "board_sim.h"
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/command_link.h"
+#include "telemetry/frame.h"
+#include "telemetry/sample_stream.h"
+#include "telemetry/scheduler.h"
+#include "telemetry/stand_state.h"
+
+namespace {
+
+constexpr ChannelSpec spec(uint8_t id) {
+  return {
+      .id = id,
+      .priority = ChannelPriority::kHigh,
+      .rate_hz = {BOARD_SIM_FRAME_RATE_HZ, BOARD_SIM_FRAME_RATE_HZ,
+                  BOARD_SIM_FRAME_RATE_HZ, BOARD_SIM_FRAME_RATE_HZ},
+  };
+}
+
+constexpr std::array<ChannelSpec, BOARD_SIM_CHANNELS> SPECS = {
+    spec(0), spec(1), spec(2), spec(3), spec(4), spec(5), spec(6), spec(7),
+};
+
+}  // namespace
+
+SimulatedBoard::SimulatedBoard(uint8_t node, uint64_t clock_ahead_us)
+    : node_(node),
+      clock_ahead_us_(clock_ahead_us),
+      scheduler_(SPECS.data(), SPECS.size()),
+      receiver_(node) {}
+
+void SimulatedBoard::sample(uint64_t now_us) {
+  uint64_t board_us = board_time_us(now_us);
+  for (size_t i = 0; i < SPECS.size(); i++) {
+    float value = std::sin(board_us * 1e-6 + i) * 100 + node_;
+    scheduler_.record(i, value, board_us);
+    if (wired_) {
+      raw_.push_back({
+          .t_us = board_us,
+          .channel = SPECS[i].id,
+          .value = value,
+      });
+    }
+  }
+}
+
+size_t SimulatedBoard::frame(uint64_t now_us, uint8_t* out, size_t out_cap) {
+  uint8_t body[FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE];
+  size_t body_len = scheduler_.build(board_time_us(now_us), body, sizeof(body));
+  if (body_len == 0) {
+    return 0;
+  }
+  size_t size = encode_telemetry_frame(node_, ++seq_, receiver_.ack(), body,
+                                       body_len, out, out_cap);
+  receiver_.ack_sent();
+  return size;
+}
+
+void SimulatedBoard::set_wired(bool wired) {
+  wired_ = wired;
+  if (!wired) {
+    raw_.clear();
+    raw_sent_ = 0;
+  }
+}
+
+size_t SimulatedBoard::samples_frame(uint8_t* out, size_t out_cap) {
+  size_t consumed;
+  size_t size = encode_samples_frame(node_, ++samples_seq_, AckField{},
+                                     raw_.data() + raw_sent_,
+                                     raw_.size() - raw_sent_,
+                                     SampleClock::kBoard, &consumed, out,
+                                     out_cap);
+  if (size == 0) {
+    samples_seq_--;
+    return 0;
+  }
+  raw_sent_ += consumed;
+  if (raw_sent_ == raw_.size()) {
+    raw_.clear();
+    raw_sent_ = 0;
+  }
+  return size;
+}
+
+void SimulatedBoard::on_uplink(const uint8_t* data, size_t len) {
+  Command command;
+  if (receiver_.on_packet(data, len, &command) != CommandResult::kExecute) {
+    return;
+  }
+  // The stand state part of execute_command() in control/src/command.cc.
+  switch (command.type) {
+    case CommandType::kArm:
+      state_ = StandState::kArmed;
+      break;
+    case CommandType::kDisarm:
+      state_ = StandState::kSafe;
+      break;
+    case CommandType::kAbort:
+      state_ = StandState::kAbort;
+      break;
+    case CommandType::kEraseLog:
+      if (state_ != StandState::kSafe) {
+        receiver_.refuse();
+        return;
+      }
+      break;
+    default:
+      break;
+  }
+  executed_.push_back(command);
+}
+
+size_t SimulatedBoard::ack_frame(uint8_t* out, size_t out_cap) {
+  if (!receiver_.ack_pending()) {
+    return 0;
+  }
+  receiver_.ack_sent();
+  return encode_ack_frame(node_, ++seq_, receiver_.ack(), out, out_cap);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "telemetry/command_link.h"
+#include "telemetry/sample_stream.h"
+#include "telemetry/scheduler.h"
+#include "telemetry/stand_state.h"
+
+// A board for host simulations. Samples BOARD_SIM_CHANNELS channels through a
+// TelemetryScheduler and encodes downlink frames exactly as the firmware does.
+// The board's clock reads `clock_ahead_us` more than ground time, as if it had
+// booted that long before the ground station started counting.
+//
+// While wired, the board also queues every sample for kSamples frames, like
+// the firmware does while a host is on the cable.
+//
+// Uplink commands are acknowledged in the next frame. The board follows the
+// stand state they set, and refuses to erase its log unless safe, like the
+// firmware.
+
+constexpr size_t BOARD_SIM_CHANNELS = 8;
+// Each channel is summarized in every frame up to this frame rate.
+constexpr float BOARD_SIM_FRAME_RATE_HZ = 20;
+
+class SimulatedBoard {
+ public:
+  SimulatedBoard(uint8_t node, uint64_t clock_ahead_us);
+
+  uint8_t node() const { return node_; }
+  uint64_t board_time_us(uint64_t ground_us) const {
+    return ground_us + clock_ahead_us_;
+  }
+
+  // Records one sample on every channel at ground time `now_us`.
+  void sample(uint64_t now_us);
+  // Encodes the next telemetry frame into `out`. Returns its size, or 0 if
+  // nothing was due.
+  size_t frame(uint64_t now_us, uint8_t* out, size_t out_cap);
+
+  // Starts or stops queueing samples for samples_frame(). Stopping drops the
+  // queue.
+  void set_wired(bool wired);
+  bool wired() const { return wired_; }
+  // Encodes the oldest queued samples into a kSamples frame. Returns its
+  // size, or 0 if none were queued.
+  size_t samples_frame(uint8_t* out, size_t out_cap);
+  size_t queued_samples() const { return raw_.size() - raw_sent_; }
+
+  // Takes an uplink packet. Commands addressed to this board are executed
+  // or refused.
+  void on_uplink(const uint8_t* data, size_t len);
+  // Encodes a kAck frame if a command arrived since the last frame. Returns
+  // its size, or 0.
+  size_t ack_frame(uint8_t* out, size_t out_cap);
+  // Commands executed, in order, not counting those refused.
+  const std::vector<Command>& executed() const { return executed_; }
+
+ private:
+  uint8_t node_;
+  uint64_t clock_ahead_us_;
+  uint16_t seq_ = 0;
+  TelemetryScheduler scheduler_;
+  bool wired_ = false;
+  uint16_t samples_seq_ = 0;
+  std::vector<RawSample> raw_;
+  // Entries of raw_ already sent.
+  size_t raw_sent_ = 0;
+  CommandReceiver receiver_;
+  StandState state_ = StandState::kSafe;
+  std::vector<Command> executed_;
+};
@@ -0,0 +1,138 @@
+#include "column_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "datalog/column_file.h"
+#include "datalog/flash_storage.h"
+
+namespace {
+
+// FlashStorage over the mapping, so scan_column_file() can walk it.
+class MappedStorage : public FlashStorage {
+ public:
+  MappedStorage(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  uint32_t size() const override { return size_; }
+  bool erase(uint32_t offset, uint32_t size) override { return false; }
+  bool write(uint32_t offset, const void* data, size_t size) override {
+    return false;
+  }
+  bool read(uint32_t offset, void* data, size_t size) override {
+    if (offset + size > size_) {
+      return false;
+    }
+    std::memcpy(data, data_ + offset, size);
+    return true;
+  }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+};
+
+}  // namespace
+
+ColumnFileReader::~ColumnFileReader() { close(); }
+
+bool ColumnFileReader::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return fail("can't open " + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(ColumnFileHeader)) {
+    ::close(fd);
+    return fail(path + " is too small");
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return fail("can't map " + path);
+  }
+  data_ = static_cast<const uint8_t*>(data);
+  size_ = st.st_size;
+
+  // The index is copied out; it is a few bytes per thousand samples.
+  MappedStorage storage(data_, size_);
+  ColumnFileHeader header;
+  bool in_bounds = true;
+  if (!scan_column_file(&storage, &header,
+                        [&](const ColumnIndexEntry& entry) {
+                          in_bounds &= entry.offset + sizeof(ColumnBlock) <=
+                                           size_ &&
+                                       entry.offset % 8 == 0 &&
+                                       entry.count <= COLUMN_BLOCK_SAMPLES;
+                          index_.push_back(entry);
+                        })) {
+    return fail(path + " is not a column file");
+  }
+  if (!in_bounds) {
+    return fail(path + " has a corrupt index");
+  }
+  header_ = reinterpret_cast<const ColumnFileHeader*>(data_);
+
+  channel_blocks_.resize(header_->channel_count);
+  for (uint32_t i = 0; i < index_.size(); i++) {
+    if (index_[i].channel < header_->channel_count) {
+      channel_blocks_[index_[i].channel].push_back(i);
+    }
+  }
+  return true;
+}
+
+void ColumnFileReader::close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<uint8_t*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  index_.clear();
+  channel_blocks_.clear();
+}
+
+std::vector<ColumnBlockView> ColumnFileReader::blocks(uint16_t channel) const {
+  std::vector<ColumnBlockView> views;
+  if (channel >= channel_blocks_.size()) {
+    return views;
+  }
+  views.reserve(channel_blocks_[channel].size());
+  for (uint32_t i : channel_blocks_[channel]) {
+    const ColumnIndexEntry& entry = index_[i];
+    const auto* block =
+        reinterpret_cast<const ColumnBlock*>(data_ + entry.offset);
+    views.push_back({
+        .entry = &entry,
+        .t_us = {block->t_us, entry.count},
+        .value = {block->value, entry.count},
+    });
+  }
+  return views;
+}
+
+uint64_t ColumnFileReader::sample_count(uint16_t channel) const {
+  uint64_t count = 0;
+  if (channel < channel_blocks_.size()) {
+    for (uint32_t i : channel_blocks_[channel]) {
+      count += index_[i].count;
+    }
+  }
+  return count;
+}
+
+bool ColumnFileReader::fail(const std::string& error) {
+  close();
+  error_ = error;
+  return false;
+}
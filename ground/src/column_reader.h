@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "datalog/column_file.h"
+
+// Read-only view of `size` contiguous T, pointing into a mapped file.
+template <typename T>
+struct ColumnSpan {
+  const T* data = nullptr;
+  size_t size = 0;
+
+  const T* begin() const { return data; }
+  const T* end() const { return data + size; }
+  const T& operator[](size_t i) const { return data[i]; }
+  bool empty() const { return size == 0; }
+};
+
+// One block of a channel: matching timestamp and value columns plus the
+// block's summary.
+struct ColumnBlockView {
+  const ColumnIndexEntry* entry;
+  ColumnSpan<uint64_t> t_us;
+  ColumnSpan<float> value;
+};
+
+// Memory-maps a column file (see datalog/column_file.h) and exposes each
+// channel as spans into the mapping; nothing is copied or parsed beyond the
+// index. Also reads the column partition image dumped with
+// `esptool.py read_flash`, and files that were never finished.
+class ColumnFileReader {
+ public:
+  ColumnFileReader() = default;
+  ~ColumnFileReader();
+  ColumnFileReader(const ColumnFileReader&) = delete;
+  ColumnFileReader& operator=(const ColumnFileReader&) = delete;
+
+  // Returns false, with a reason in error(), if `path` is not a column file.
+  bool open(const std::string& path);
+  void close();
+  const std::string& error() const { return error_; }
+
+  const ColumnFileHeader& header() const { return *header_; }
+  uint16_t channel_count() const { return header_->channel_count; }
+  // Whether the writer got to write the index.
+  bool finished() const {
+    return header_->index_offset != COLUMN_UNFINISHED;
+  }
+
+  // Every block, in file order.
+  const std::vector<ColumnIndexEntry>& index() const { return index_; }
+  // The blocks of `channel`, oldest first.
+  std::vector<ColumnBlockView> blocks(uint16_t channel) const;
+  // Samples in `channel`.
+  uint64_t sample_count(uint16_t channel) const;
+
+ private:
+  bool fail(const std::string& error);
+
+  const uint8_t* data_ = nullptr;
+  size_t size_ = 0;
+  const ColumnFileHeader* header_ = nullptr;
+  std::vector<ColumnIndexEntry> index_;
+  // Positions in index_ per channel.
+  std::vector<std::vector<uint32_t>> channel_blocks_;
+  std::string error_;
+};
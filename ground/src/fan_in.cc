@@ -0,0 +1,199 @@
+#include "fan_in.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "telemetry/frame.h"
+#include "telemetry/sample_stream.h"
+#include "telemetry/scheduler.h"
+
+int64_t NodeStats::latency_mean_us() const {
+  return synced_frames == 0 ? 0 : latency_total_us / synced_frames;
+}
+
+bool FanIn::on_frame(const Frame& frame, uint64_t rx_us) {
+  if (frame.payload_len < ACK_FIELD_SIZE) {
+    return false;
+  }
+  switch (frame.type) {
+    case FrameType::kTelemetry:
+      return on_telemetry(frame, rx_us);
+    case FrameType::kSamples:
+      return on_samples(frame, rx_us);
+    default:
+      return false;
+  }
+}
+
+bool FanIn::check_seq(const Frame& frame, uint64_t t_us, SeqTracker* tracker) {
+  NodeStats& node = nodes_[frame.node];
+  if (tracker->seen[frame.node]) {
+    int16_t ahead = static_cast<int16_t>(frame.seq - tracker->last[frame.node]);
+    // The clock is checked whichever way the sequence number moved: one that
+    // was close to wrapping when the board restarted lands just ahead.
+    const bool restarted =
+        ahead <= -kRestartSeqGap ||
+        t_us + kRestartTimeGapUs <= tracker->last_t_us[frame.node];
+    if (restarted) {
+      // Both sequence spaces and the clock start over.
+      node.restarts++;
+      telemetry_seq_.seen[frame.node] = false;
+      samples_seq_.seen[frame.node] = false;
+      offset_known_[frame.node] = false;
+    } else if (ahead <= 0) {
+      node.duplicates++;
+      return false;
+    } else {
+      node.lost += ahead - 1;
+    }
+  }
+  tracker->seen[frame.node] = true;
+  tracker->last[frame.node] = frame.seq;
+  tracker->last_t_us[frame.node] = t_us;
+  return true;
+}
+
+void FanIn::update_offset(uint8_t id, uint64_t t_us, uint64_t rx_us) {
+  NodeStats& node = nodes_[id];
+  int64_t offset_us =
+      static_cast<int64_t>(rx_us) - static_cast<int64_t>(t_us);
+  if (!offset_known_[id] || offset_us < node.offset_us) {
+    node.offset_us = offset_us;
+  }
+  offset_known_[id] = true;
+  node.seen = true;
+  node.frames++;
+}
+
+void FanIn::update_latency(NodeStats* node, uint64_t t_us, uint64_t rx_us) {
+  int64_t latency_us =
+      static_cast<int64_t>(rx_us) - static_cast<int64_t>(t_us);
+  if (node->synced_frames == 0) {
+    node->latency_min_us = latency_us;
+    node->latency_max_us = latency_us;
+  }
+  node->latency_min_us = std::min(node->latency_min_us, latency_us);
+  node->latency_max_us = std::max(node->latency_max_us, latency_us);
+  node->latency_total_us += latency_us;
+  node->synced_frames++;
+  node->seen = true;
+  node->frames++;
+}
+
+void FanIn::push(NodeStats* node, MergedSample sample, uint64_t t_us,
+                 int64_t offset_us) {
+  int64_t ground_us = static_cast<int64_t>(t_us) + offset_us;
+  if (ground_us < 0 || static_cast<uint64_t>(ground_us) < released_us_) {
+    node->late++;
+    return;
+  }
+  sample.t_us = ground_us;
+  pending_.push(sample);
+  node->samples++;
+}
+
+bool FanIn::on_telemetry(const Frame& frame, uint64_t rx_us) {
+  NodeStats& node = nodes_[frame.node];
+
+  TelemetryHeader header;
+  ChannelSummary summaries[TELEMETRY_MAX_CHANNELS];
+  size_t count;
+  if (!decode_telemetry_body(&frame.payload[ACK_FIELD_SIZE],
+                             frame.payload_len - ACK_FIELD_SIZE, &header,
+                             summaries, TELEMETRY_MAX_CHANNELS, &count)) {
+    node.malformed++;
+    return false;
+  }
+  const uint64_t t_us = static_cast<uint64_t>(header.t_ms) * 1000;
+  if (!check_seq(frame, t_us, &telemetry_seq_)) {
+    return false;
+  }
+  update_offset(frame.node, t_us, rx_us);
+
+  for (size_t i = 0; i < count; i++) {
+    const ChannelSummary& summary = summaries[i];
+    push(&node,
+         {
+             .node = frame.node,
+             .channel = summary.id,
+             .t_us = 0,
+             .count = summary.count,
+             .min = summary.min,
+             .max = summary.max,
+             .mean = summary.mean,
+         },
+         static_cast<uint64_t>(summary.t_ms) * 1000, node.offset_us);
+  }
+  return true;
+}
+
+bool FanIn::on_samples(const Frame& frame, uint64_t rx_us) {
+  NodeStats& node = nodes_[frame.node];
+
+  RawSample samples[SAMPLES_PER_FRAME];
+  size_t count;
+  SampleClock clock;
+  if (!decode_samples_frame(frame, samples, SAMPLES_PER_FRAME, &count,
+                            &clock) ||
+      count == 0) {
+    node.malformed++;
+    return false;
+  }
+  // The newest sample left the board last, so it was delayed the least.
+  uint64_t newest_us = 0;
+  for (size_t i = 0; i < count; i++) {
+    newest_us = std::max(newest_us, samples[i].t_us);
+  }
+  // Host time never steps back, but a restarted board sends in its own time
+  // until it synchronizes again.
+  if (!check_seq(frame, newest_us, &samples_seq_)) {
+    return false;
+  }
+  int64_t offset_us = 0;
+  if (clock == SampleClock::kHost) {
+    update_latency(&node, newest_us, rx_us);
+  } else {
+    update_offset(frame.node, newest_us, rx_us);
+    offset_us = node.offset_us;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    const RawSample& sample = samples[i];
+    push(&node,
+         {
+             .node = frame.node,
+             .channel = sample.channel,
+             .t_us = 0,
+             .count = 1,
+             .min = sample.value,
+             .max = sample.value,
+             .mean = sample.value,
+         },
+         sample.t_us, offset_us);
+  }
+  return true;
+}
+
+size_t FanIn::release(uint64_t until_us, std::vector<MergedSample>* out) {
+  size_t released = 0;
+  while (!pending_.empty() && pending_.top().t_us <= until_us) {
+    released_us_ = pending_.top().t_us;
+    out->push_back(pending_.top());
+    pending_.pop();
+    released++;
+  }
+  return released;
+}
+
+size_t FanIn::drain(uint64_t now_us, std::vector<MergedSample>* out) {
+  if (now_us < reorder_window_us_) {
+    return 0;
+  }
+  return release(now_us - reorder_window_us_, out);
+}
+
+size_t FanIn::flush(std::vector<MergedSample>* out) {
+  return release(UINT64_MAX, out);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <vector>
+
+#include "telemetry/frame.h"
+#include "telemetry/scheduler.h"
+
+// Merges the telemetry streams of several boards into one time-ordered feed.
+//
+// Each board stamps its frames with its own millisecond clock. The fan-in maps
+// board time to ground time with a per-node offset, taken as the smallest
+// (receive time - board time) seen since the board started, i.e. the frame
+// that had the least delay. Samples are held for `reorder_window_us` so that
+// slower boards can catch up, then released in ground time order. A sample
+// that arrives after samples newer than it were released is counted as late
+// and dropped.
+//
+// A board that restarts numbers its frames and counts its clock from zero
+// again. A frame whose sequence number falls far behind the last one, or
+// whose board time does, marks a restart: the node's sequence tracking and
+// clock offset start over instead of the frames being taken for duplicates
+// and their samples for late ones.
+//
+// Full-rate kSamples frames from the wired link are merged the same way, one
+// MergedSample per sample (count 1, min = max = mean). They are numbered apart
+// from kTelemetry frames, so each kind has its own sequence tracking. Once the
+// board has synchronized its clock with the host (telemetry/time_sync.h) they
+// are stamped in host time, which needs no offset, provided ground time is
+// the host's Unix time too; their one-way latency is then measured directly.
+
+struct MergedSample {
+  uint8_t node;
+  uint8_t channel;
+  // Ground time of the newest sample in the summary.
+  uint64_t t_us;
+  uint16_t count;
+  float min;
+  float max;
+  float mean;
+};
+
+struct NodeStats {
+  bool seen;
+  uint32_t frames;
+  // Downlink sequence numbers skipped, i.e. frames lost on the way.
+  uint32_t lost;
+  uint32_t duplicates;
+  uint32_t malformed;
+  uint32_t samples;
+  uint32_t late;
+  uint32_t restarts;
+  // Ground time minus board time.
+  int64_t offset_us;
+  // kSamples frames stamped in host time, and their one-way latency: receive
+  // time minus the time of the newest sample, so it includes the time spent
+  // queued on the board.
+  uint32_t synced_frames;
+  int64_t latency_min_us;
+  int64_t latency_max_us;
+  int64_t latency_total_us;
+
+  int64_t latency_mean_us() const;
+};
+
+class FanIn {
+ public:
+  // A frame at least this many sequence numbers behind the last one, or
+  // whose board time is this far behind, wherever its sequence number is,
+  // comes from a restarted board.
+  static constexpr int16_t kRestartSeqGap = 256;
+  static constexpr uint64_t kRestartTimeGapUs = 1000000;
+
+  explicit FanIn(uint64_t reorder_window_us)
+      : reorder_window_us_(reorder_window_us) {}
+
+  // Feeds a decoded downlink frame received at ground time `rx_us`. Returns
+  // false if it was not a new, well-formed kTelemetry or kSamples frame.
+  bool on_frame(const Frame& frame, uint64_t rx_us);
+
+  // Appends every held sample older than `now_us - reorder_window_us`, in
+  // time order, to `out`. Returns the number appended.
+  size_t drain(uint64_t now_us, std::vector<MergedSample>* out);
+  // Appends every held sample, e.g. at the end of a capture.
+  size_t flush(std::vector<MergedSample>* out);
+
+  const NodeStats& node(uint8_t id) const { return nodes_[id]; }
+  // Samples held back, waiting for the reorder window.
+  size_t pending() const { return pending_.size(); }
+
+ private:
+  struct Later {
+    bool operator()(const MergedSample& a, const MergedSample& b) const {
+      return a.t_us > b.t_us;
+    }
+  };
+
+  // Per node and frame kind: whether a frame was seen, and its sequence
+  // number and newest sample time.
+  struct SeqTracker {
+    std::array<bool, FRAME_MAX_NODE + 1> seen{};
+    std::array<uint16_t, FRAME_MAX_NODE + 1> last{};
+    std::array<uint64_t, FRAME_MAX_NODE + 1> last_t_us{};
+  };
+
+  // Counts frames skipped since the previous one of its kind, whose newest
+  // sample was taken at `t_us`, and starts the node over if it restarted.
+  // Returns false for duplicates.
+  bool check_seq(const Frame& frame, uint64_t t_us, SeqTracker* tracker);
+  // Lowers the node's clock offset if the frame, whose newest sample was
+  // taken at board time `t_us`, arrived with less delay than any before.
+  void update_offset(uint8_t id, uint64_t t_us, uint64_t rx_us);
+  // Records the one-way latency of a frame stamped in host time.
+  void update_latency(NodeStats* node, uint64_t t_us, uint64_t rx_us);
+  // Queues a sample taken at ground time `t_us - offset_us`, unless it is too
+  // late.
+  void push(NodeStats* node, MergedSample sample, uint64_t t_us,
+            int64_t offset_us);
+  bool on_telemetry(const Frame& frame, uint64_t rx_us);
+  bool on_samples(const Frame& frame, uint64_t rx_us);
+  size_t release(uint64_t until_us, std::vector<MergedSample>* out);
+
+  uint64_t reorder_window_us_;
+  std::array<NodeStats, FRAME_MAX_NODE + 1> nodes_{};
+  // Whether nodes_[id].offset_us holds an offset, i.e. a frame in board time
+  // arrived since the node started or restarted.
+  std::array<bool, FRAME_MAX_NODE + 1> offset_known_{};
+  SeqTracker telemetry_seq_;
+  SeqTracker samples_seq_;
+  std::priority_queue<MergedSample, std::vector<MergedSample>, Later>
+      pending_;
+  uint64_t released_us_ = 0;
+};
@@ -0,0 +1,70 @@
+#include "file_flash.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "datalog/flash_storage.h"
+
+FileFlash::FileFlash(const std::string& path, uint32_t size) : size_(size) {
+  file_ = std::fopen(path.c_str(), "r+b");
+  if (file_ == nullptr) {
+    file_ = std::fopen(path.c_str(), "w+b");
+    if (file_ == nullptr || !erase(0, size)) {
+      return;
+    }
+  }
+  std::fseek(file_, 0, SEEK_END);
+  long file_size = std::ftell(file_);
+  if (file_size >= 0 && static_cast<uint32_t>(file_size) < size_) {
+    size_ = file_size / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE;
+  }
+}
+
+FileFlash::~FileFlash() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+bool FileFlash::erase(uint32_t offset, uint32_t size) {
+  if (file_ == nullptr || offset % FLASH_SECTOR_SIZE != 0 ||
+      size % FLASH_SECTOR_SIZE != 0 || offset + size > size_) {
+    return false;
+  }
+  std::vector<uint8_t> erased(FLASH_SECTOR_SIZE, 0xFF);
+  std::fseek(file_, offset, SEEK_SET);
+  for (uint32_t done = 0; done < size; done += FLASH_SECTOR_SIZE) {
+    if (std::fwrite(erased.data(), 1, erased.size(), file_) != erased.size()) {
+      return false;
+    }
+  }
+  return std::fflush(file_) == 0;
+}
+
+bool FileFlash::write(uint32_t offset, const void* data, size_t size) {
+  std::vector<uint8_t> current(size);
+  if (!read(offset, current.data(), size)) {
+    return false;
+  }
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    if ((bytes[i] & ~current[i]) != 0) {
+      unerased_writes_++;
+    }
+    current[i] &= bytes[i];
+  }
+  std::fseek(file_, offset, SEEK_SET);
+  return std::fwrite(current.data(), 1, size, file_) == size &&
+         std::fflush(file_) == 0;
+}
+
+bool FileFlash::read(uint32_t offset, void* data, size_t size) {
+  if (file_ == nullptr || offset + size > size_) {
+    return false;
+  }
+  std::fseek(file_, offset, SEEK_SET);
+  return std::fread(data, 1, size, file_) == size;
+}
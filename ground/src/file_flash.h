@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "datalog/flash_storage.h"
+
+// FlashStorage backed by a file, standing in for a flash partition on the
+// host. Keeps NOR semantics: erase sets 0xFF and writes can only clear bits,
+// so writing an unerased range is caught. Also reads partition images dumped
+// with `esptool.py read_flash`.
+class FileFlash : public FlashStorage {
+ public:
+  // Opens `path`, creating it erased at `size` bytes if it doesn't exist.
+  FileFlash(const std::string& path, uint32_t size);
+  ~FileFlash() override;
+  FileFlash(const FileFlash&) = delete;
+  FileFlash& operator=(const FileFlash&) = delete;
+
+  bool ok() const { return file_ != nullptr; }
+
+  uint32_t size() const override { return size_; }
+  bool erase(uint32_t offset, uint32_t size) override;
+  bool write(uint32_t offset, const void* data, size_t size) override;
+  bool read(uint32_t offset, void* data, size_t size) override;
+
+  // Writes that tried to set a bit back to 1.
+  uint32_t unerased_writes() const { return unerased_writes_; }
+
+ private:
+  std::FILE* file_ = nullptr;
+  uint32_t size_;
+  uint32_t unerased_writes_ = 0;
+};
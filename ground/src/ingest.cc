@@ -0,0 +1,169 @@
+#include "ingest.h"
+
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "configs/trace_config.h"
+#include "fan_in.h"
+#include "series_store.h"
+#include "telemetry/frame.h"
+#include "telemetry/time_sync.h"
+#include "telemetry/trace_report.h"
+#include "time_series.h"
+
+float IngestStats::decode_error_rate() const {
+  uint64_t errors = stream.bad_crc + stream.bad_length;
+  uint64_t candidates = stream.frames + errors;
+  return candidates == 0 ? 0.0f : static_cast<float>(errors) / candidates;
+}
+
+void Ingest::on_bytes(const uint8_t* data, size_t len, uint64_t now_us) {
+  bytes_ += len;
+  parser_.push(data, len, [&](const Frame& frame) {
+    uint64_t t1_us;
+    TraceZoneStats zones[TRACE_ZONES_PER_FRAME];
+    size_t zone_count;
+    uint16_t cycles_per_us;
+    if (decode_time_request(frame, &t1_us)) {
+      time_requests_.push_back({.t1_us = t1_us, .t2_us = now_us, .t3_us = 0});
+      time_request_count_++;
+    } else if (decode_trace_frame(frame, &cycles_per_us, zones,
+                                  std::size(zones), &zone_count)) {
+      // A table can span several frames, so zones are replaced one by one.
+      for (size_t i = 0; i < zone_count; i++) {
+        traces_[frame.node][zones[i].zone] = zones[i];
+      }
+      trace_cycles_per_us_[frame.node] = cycles_per_us;
+      trace_frames_++;
+    } else if (!fan_in_.on_frame(frame, now_us)) {
+      ignored_frames_++;
+    }
+  });
+}
+
+void Ingest::take_time_requests(std::vector<TimeReply>* out) {
+  out->insert(out->end(), time_requests_.begin(), time_requests_.end());
+  time_requests_.clear();
+}
+
+void Ingest::poll(uint64_t now_us) {
+  released_.clear();
+  fan_in_.drain(now_us, &released_);
+  store(released_);
+}
+
+void Ingest::flush() {
+  released_.clear();
+  fan_in_.flush(&released_);
+  store(released_);
+}
+
+void Ingest::store(const std::vector<MergedSample>& samples) {
+  for (const MergedSample& sample : samples) {
+    samples_++;
+    if (!store_->append(sample)) {
+      store_rejected_++;
+    }
+  }
+}
+
+std::string Ingest::handle_request(const std::string& request) const {
+  std::istringstream in(request);
+  std::string verb;
+  in >> verb;
+  char line[160];
+  std::string reply;
+
+  if (verb == "latest") {
+    for (const MergedSample& sample : store_->latest()) {
+      std::snprintf(line, sizeof(line), "%u %u %" PRIu64 " %u %g %g %g\n",
+                    sample.node, sample.channel, sample.t_us, sample.count,
+                    sample.min, sample.max, sample.mean);
+      reply += line;
+    }
+  } else if (verb == "query") {
+    unsigned node;
+    unsigned channel;
+    uint64_t t0_us;
+    uint64_t t1_us;
+    size_t points;
+    if (!(in >> node >> channel >> t0_us >> t1_us >> points) || node > 0xFF ||
+        channel > 0xFF) {
+      return "error usage: query NODE CHANNEL T0_US T1_US POINTS\n\n";
+    }
+    const TimeSeries* series = store_->series(node, channel);
+    if (series == nullptr) {
+      return "error no such series\n\n";
+    }
+    std::vector<SeriesPoint> result;
+    series->query(t0_us, t1_us, points, &result);
+    for (const SeriesPoint& point : result) {
+      std::snprintf(line, sizeof(line),
+                    "%" PRIu64 " %" PRIu64 " %u %g %g %g\n", point.t_first_us,
+                    point.t_last_us, point.count, point.min, point.max,
+                    point.mean);
+      reply += line;
+    }
+  } else if (verb == "stats") {
+    IngestStats s = stats();
+    std::snprintf(line, sizeof(line),
+                  "bytes=%" PRIu64 " frames=%u bad_crc=%u bad_length=%u "
+                  "skipped=%u samples=%" PRIu64 " decode_error_rate=%.6f\n",
+                  s.bytes, s.stream.frames, s.stream.bad_crc,
+                  s.stream.bad_length, s.stream.skipped_bytes, s.samples,
+                  s.decode_error_rate());
+    reply += line;
+    for (int node = 0; node <= FRAME_MAX_NODE; node++) {
+      const NodeStats& n = fan_in_.node(node);
+      if (n.synced_frames == 0) {
+        continue;
+      }
+      std::snprintf(line, sizeof(line),
+                    "node=%d synced_frames=%u latency_min_us=%" PRId64
+                    " latency_mean_us=%" PRId64 " latency_max_us=%" PRId64
+                    "\n",
+                    node, n.synced_frames, n.latency_min_us,
+                    n.latency_mean_us(), n.latency_max_us);
+      reply += line;
+    }
+  } else if (verb == "trace") {
+    for (const auto& [node, zones] : traces_) {
+      const double cycles_per_us = trace_cycles_per_us_.at(node);
+      for (const auto& [id, zone] : zones) {
+        if (zone.calls == 0 || cycles_per_us == 0) {
+          continue;
+        }
+        const char* name = id < std::size(TRACE_ZONE_NAMES)
+                               ? TRACE_ZONE_NAMES[id]
+                               : "unknown";
+        std::snprintf(line, sizeof(line), "%u %u %u %.2f %.2f %.0f %s\n",
+                      node, id, zone.calls,
+                      zone.total_cycles / cycles_per_us / zone.calls,
+                      zone.max_cycles / cycles_per_us,
+                      zone.total_cycles / cycles_per_us, name);
+        reply += line;
+      }
+    }
+  } else {
+    return "error unknown request\n\n";
+  }
+  return reply + "\n";
+}
+
+IngestStats Ingest::stats() const {
+  return {
+      .bytes = bytes_,
+      .stream = parser_.stats(),
+      .ignored_frames = ignored_frames_,
+      .samples = samples_,
+      .store_rejected = store_rejected_,
+      .time_requests = time_request_count_,
+      .trace_frames = trace_frames_,
+  };
+}
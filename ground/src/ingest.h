@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "fan_in.h"
+#include "series_store.h"
+#include "telemetry/frame_stream.h"
+#include "telemetry/time_sync.h"
+#include "telemetry/trace_report.h"
+
+// Live ingest of the downlink byte stream (a serial port or PTY carrying
+// frames back to back): finds and validates frames, merges the telemetry of
+// every board through a FanIn, and appends the samples to a SeriesStore.
+// Single-threaded; the caller owns the I/O, including answering the boards'
+// clock synchronization requests (see take_time_requests()).
+
+struct IngestStats {
+  uint64_t bytes;
+  FrameStreamStats stream;
+  // Valid frames that carried no new telemetry: acks, duplicates, malformed
+  // bodies.
+  uint64_t ignored_frames;
+  uint64_t samples;
+  // Samples the store refused.
+  uint64_t store_rejected;
+  uint64_t time_requests;
+  uint64_t trace_frames;
+
+  // Frames that failed validation, out of all candidates.
+  float decode_error_rate() const;
+};
+
+class Ingest {
+ public:
+  Ingest(SeriesStore* store, uint64_t reorder_window_us)
+      : store_(store), fan_in_(reorder_window_us) {}
+
+  // Feeds bytes received at ground time `now_us`, which should be Unix time
+  // so the boards synchronize their clocks to it.
+  void on_bytes(const uint8_t* data, size_t len, uint64_t now_us);
+  // Moves the clock synchronization requests received since the last call to
+  // `out`, with their receive time in t2_us. The caller sets t3_us right
+  // before sending each reply (encode_time_reply()).
+  void take_time_requests(std::vector<TimeReply>* out);
+  // Moves samples that cleared the reorder window into the store. Call
+  // regularly, even when no bytes arrive.
+  void poll(uint64_t now_us);
+  // Moves every held sample into the store, e.g. on shutdown.
+  void flush();
+
+  // Answers a plotting client. Requests are single lines:
+  //
+  //   latest                  -> node channel t_us count min max mean
+  //   query N C T0 T1 POINTS  -> t_first_us t_last_us count min max mean
+  //   stats                   -> key=value ...
+  //   trace                   -> node zone calls mean_us max_us total_us name
+  //
+  // The reply is zero or more lines, each ending in '\n', then an empty line.
+  // Errors are a single "error ..." line.
+  std::string handle_request(const std::string& request) const;
+
+  IngestStats stats() const;
+  const FanIn& fan_in() const { return fan_in_; }
+
+ private:
+  void store(const std::vector<MergedSample>& samples);
+
+  SeriesStore* store_;
+  FanIn fan_in_;
+  FrameStreamParser parser_;
+  std::vector<MergedSample> released_;
+  std::vector<TimeReply> time_requests_;
+  // Latest trace table of each node, by zone, and its cycles per
+  // microsecond.
+  std::map<uint8_t, std::map<uint8_t, TraceZoneStats>> traces_;
+  std::map<uint8_t, uint16_t> trace_cycles_per_us_;
+  uint64_t trace_frames_ = 0;
+  uint64_t time_request_count_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t ignored_frames_ = 0;
+  uint64_t samples_ = 0;
+  uint64_t store_rejected_ = 0;
+};
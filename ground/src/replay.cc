@@ -0,0 +1,168 @@
+#include "replay.h"
+
+#include <stand/pt_scale.h>
+#include <stand/stand_controller.h>
+#include <telemetry/stand_state.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "column_reader.h"
+#include "datalog/flash_log.h"
+#include "file_flash.h"
+
+namespace {
+
+// Stand state a logged event leaves the stand in, if it changes it. Redline
+// aborts are left to the replayed logic.
+bool state_after(const LogRecord& record, StandState* state) {
+  switch (static_cast<LogEvent>(record.id)) {
+    case LogEvent::kArm:
+      *state = StandState::kArmed;
+      return true;
+    case LogEvent::kDisarm:
+      *state = StandState::kSafe;
+      return true;
+    case LogEvent::kAbort:
+      *state = StandState::kAbort;
+      return true;
+    case LogEvent::kFire:
+      *state = StandState::kFiring;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool same_decision(const StandDecision& a, const StandDecision& b) {
+  return a.type == b.type && a.index == b.index;
+}
+
+}  // namespace
+
+bool load_flash_log(const std::string& path, uint32_t session,
+                    std::vector<LogRecord>* records) {
+  // FileFlash creates missing files.
+  if (!std::filesystem::exists(path)) {
+    return false;
+  }
+  FileFlash flash(path, UINT32_MAX / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE);
+  if (!flash.ok()) {
+    return false;
+  }
+  // Sessions are in order, so the last one read is the newest.
+  uint32_t current = UINT32_MAX;
+  bool found = false;
+  read_flash_log(&flash, [&](uint32_t record_session, const LogRecord& record) {
+    if (session != UINT32_MAX && record_session != session) {
+      return;
+    }
+    if (record_session != current) {
+      records->clear();
+      current = record_session;
+    }
+    records->push_back(record);
+    found = true;
+  });
+  // Records reach flash in the order they were appended, not taken.
+  std::stable_sort(records->begin(), records->end(),
+                   [](const LogRecord& a, const LogRecord& b) {
+                     return a.t_us < b.t_us;
+                   });
+  return found;
+}
+
+bool load_column_file(const std::string& path, std::vector<LogRecord>* records,
+                      std::string* error) {
+  ColumnFileReader reader;
+  if (!reader.open(path)) {
+    *error = reader.error();
+    return false;
+  }
+  records->clear();
+  for (uint16_t channel = 0; channel < reader.channel_count(); channel++) {
+    const ColumnChannel& column = reader.header().channels[channel];
+    // Valve states and event arguments were stored from `aux`.
+    bool in_aux =
+        column.type == RecordType::kValve || column.type == RecordType::kEvent;
+    for (const ColumnBlockView& block : reader.blocks(channel)) {
+      for (size_t i = 0; i < block.t_us.size; i++) {
+        records->push_back({
+            .t_us = block.t_us[i],
+            .type = column.type,
+            .id = column.id,
+            .aux = static_cast<uint16_t>(in_aux ? block.value[i] : 0),
+            .value = in_aux ? 0 : block.value[i],
+        });
+      }
+    }
+  }
+  std::stable_sort(records->begin(), records->end(),
+                   [](const LogRecord& a, const LogRecord& b) {
+                     return a.t_us < b.t_us;
+                   });
+  return true;
+}
+
+bool ReplayResult::matches() const {
+  return std::equal(decisions.begin(), decisions.end(), recorded.begin(),
+                    recorded.end(), same_decision);
+}
+
+uint64_t ReplayResult::first_abort_us() const {
+  for (const StandDecision& decision : decisions) {
+    if (decision.type == DecisionType::kAbort) {
+      return decision.t_us;
+    }
+  }
+  return 0;
+}
+
+ReplayResult replay(const std::vector<LogRecord>& records,
+                    const ReplayConfig& config) {
+  ReplayResult result;
+  StandController controller(config.logic);
+  StandDecision decision;
+  for (const LogRecord& record : records) {
+    while (controller.poll_sequence(record.t_us, &decision)) {
+      result.decisions.push_back(decision);
+    }
+
+    if (record.type == RecordType::kPt) {
+      float psi = record.value;
+      if (config.scales != nullptr && record.id < config.scale_count) {
+        float voltage = psi_to_voltage(config.recorded_scales[record.id], psi);
+        psi = std::trunc(voltage_to_psi(config.scales[record.id], voltage));
+      }
+      result.samples++;
+      if (controller.on_pt(record.id, record.t_us, psi, &decision)) {
+        result.decisions.push_back(decision);
+      }
+      continue;
+    }
+    if (record.type != RecordType::kEvent) {
+      continue;
+    }
+
+    LogEvent event = static_cast<LogEvent>(record.id);
+    if (event == LogEvent::kRedline || event == LogEvent::kSequencerStep) {
+      result.recorded.push_back({
+          .t_us = record.t_us,
+          .type = event == LogEvent::kRedline ? DecisionType::kAbort
+                                              : DecisionType::kSequenceStep,
+          .index = static_cast<uint8_t>(record.aux),
+      });
+      continue;
+    }
+    StandState state;
+    if (state_after(record, &state)) {
+      controller.set_state(state, record.t_us);
+    }
+  }
+  return result;
+}
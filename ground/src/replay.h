@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stand/pt_scale.h>
+#include <stand/stand_controller.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "datalog/flash_log.h"
+
+// Replays a recorded capture through the stand logic (control/components/
+// stand) as fast as the host allows: the board's own PT filtering, redlines
+// and firing sequence, fed the records in time order, with the stand state
+// following the arm/fire/abort events of the log. With the board's
+// configuration the decisions match the ones it logged; with another one
+// (e.g. a redline sweep) they show what it would have decided.
+
+// Reads the records of one session of a flight-data log image (see
+// datalog/flash_log.h): `session`, or the last one if it is UINT32_MAX.
+// Returns false if the image can't be read or holds no such session.
+bool load_flash_log(const std::string& path, uint32_t session,
+                    std::vector<LogRecord>* records);
+
+// Reads every channel of a column file (see datalog/column_file.h), merged
+// into records in time order. Returns false, with a reason in `error`, if
+// `path` is not a column file.
+bool load_column_file(const std::string& path, std::vector<LogRecord>* records,
+                      std::string* error);
+
+struct ReplayConfig {
+  StandLogicConfig logic;
+  // Optional recalibration, one entry per Pt: recorded pressures are turned
+  // back into voltages with `recorded_scales` (what the board used) and
+  // converted again with `scales`, truncated to whole psi like read_pt().
+  const PtScale* recorded_scales = nullptr;
+  const PtScale* scales = nullptr;
+  size_t scale_count = 0;
+};
+
+struct ReplayResult {
+  // What the replayed logic decided.
+  std::vector<StandDecision> decisions;
+  // What the board logged (kRedline and kSequencerStep events).
+  std::vector<StandDecision> recorded;
+  uint64_t samples = 0;
+
+  // Whether both made the same decisions, in the same order. Times differ by
+  // up to the board's sequencer period (configs/stand_config.h).
+  bool matches() const;
+  // Time of the first abort decided, or 0 if there was none.
+  uint64_t first_abort_us() const;
+};
+
+ReplayResult replay(const std::vector<LogRecord>& records,
+                    const ReplayConfig& config);
@@ -0,0 +1,89 @@
+#include "serial_port.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <string>
+
+namespace {
+
+bool baud_constant(int baud, speed_t* speed) {
+  switch (baud) {
+    case 9600:
+      *speed = B9600;
+      return true;
+    case 115200:
+      *speed = B115200;
+      return true;
+    case 230400:
+      *speed = B230400;
+      return true;
+#ifdef B460800
+    case 460800:
+      *speed = B460800;
+      return true;
+#endif
+#ifdef B921600
+    case 921600:
+      *speed = B921600;
+      return true;
+#endif
+#ifdef B2000000
+    case 2000000:
+      *speed = B2000000;
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+bool make_raw(int fd, int baud) {
+  termios tio;
+  if (tcgetattr(fd, &tio) != 0) {
+    return false;
+  }
+  cfmakeraw(&tio);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tio.c_cflag &= ~CRTSCTS;
+  if (baud > 0) {
+    speed_t speed;
+    if (!baud_constant(baud, &speed)) {
+      return false;
+    }
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+  }
+  return tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+}  // namespace
+
+int open_serial(const std::string& path, int baud) {
+  int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return -1;
+  }
+  if (!make_raw(fd, baud)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int open_pty(std::string* slave_path) {
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0) {
+    return -1;
+  }
+  const char* name = nullptr;
+  if (grantpt(fd) != 0 || unlockpt(fd) != 0 ||
+      (name = ptsname(fd)) == nullptr || !make_raw(fd, 0)) {
+    close(fd);
+    return -1;
+  }
+  *slave_path = name;
+  return fd;
+}
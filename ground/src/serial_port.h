@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+// Opens a serial device or PTY for binary I/O: raw mode, 8N1, no flow
+// control, non-blocking. `baud` 0 keeps the current rate. Returns the file
+// descriptor, or -1 (also for rates the platform lacks).
+int open_serial(const std::string& path, int baud);
+
+// Creates a pseudo-terminal for tests and simulated boards. Returns the
+// master side's file descriptor and the path of the slave, which behaves like
+// a serial device; -1 on failure.
+int open_pty(std::string* slave_path);
@@ -0,0 +1,67 @@
+#include "series_codec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "compress/gorilla.h"
+
+namespace {
+
+constexpr size_t PREFIX_SIZE = 2;
+
+}  // namespace
+
+size_t compress_series(const uint64_t* t_us, const float* values,
+                       size_t count, size_t block_size,
+                       std::vector<uint8_t>* out) {
+  std::vector<uint8_t> block(block_size);
+  GorillaEncoder encoder(block.data(), block.size());
+  size_t blocks = 0;
+  auto emit = [&] {
+    size_t size = encoder.finish();
+    out->push_back(size & 0xFF);
+    out->push_back(size >> 8);
+    out->insert(out->end(), block.begin(), block.begin() + size);
+    encoder.reset();
+    blocks++;
+  };
+  for (size_t i = 0; i < count; i++) {
+    if (!encoder.append(t_us[i], values[i])) {
+      emit();
+      encoder.append(t_us[i], values[i]);
+    }
+  }
+  if (encoder.count() > 0) {
+    emit();
+  }
+  return blocks;
+}
+
+bool decompress_series(const uint8_t* data, size_t len,
+                       std::vector<uint64_t>* t_us,
+                       std::vector<float>* values) {
+  size_t pos = 0;
+  while (pos < len) {
+    if (len - pos < PREFIX_SIZE) {
+      return false;
+    }
+    size_t size = data[pos] | (data[pos + 1] << 8);
+    pos += PREFIX_SIZE;
+    if (len - pos < size) {
+      return false;
+    }
+    GorillaDecoder decoder(&data[pos], size);
+    uint64_t t;
+    float value;
+    while (decoder.next(&t, &value)) {
+      t_us->push_back(t);
+      values->push_back(value);
+    }
+    if (decoder.error()) {
+      return false;
+    }
+    pos += size;
+  }
+  return true;
+}
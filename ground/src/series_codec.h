@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Host side of the on-device sample compression (see compress/gorilla.h):
+// whole series in and out of a stream of Gorilla blocks, each prefixed with
+// its size as a little-endian u16.
+
+// Compresses `count` samples into blocks of at most `block_size` bytes
+// (GORILLA_MIN_BLOCK_SIZE to UINT16_MAX), appended to `out`. Returns the
+// number of blocks.
+size_t compress_series(const uint64_t* t_us, const float* values,
+                       size_t count, size_t block_size,
+                       std::vector<uint8_t>* out);
+
+// Decompresses a block stream built by compress_series(), appending the
+// samples to `t_us` and `values`. Returns false if a block is truncated or
+// malformed; the samples before it are kept.
+bool decompress_series(const uint8_t* data, size_t len,
+                       std::vector<uint64_t>* t_us, std::vector<float>* values);
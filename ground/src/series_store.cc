@@ -0,0 +1,95 @@
+#include "series_store.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "fan_in.h"
+#include "time_series.h"
+
+SeriesStore::~SeriesStore() {
+  for (auto& [key, series] : series_) {
+    if (series.file != nullptr) {
+      std::fclose(series.file);
+    }
+  }
+}
+
+bool SeriesStore::open() {
+  if (directory_.empty()) {
+    return true;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  return std::filesystem::is_directory(directory_);
+}
+
+bool SeriesStore::append(const MergedSample& sample) {
+  auto [it, added] = series_.try_emplace(key(sample.node, sample.channel));
+  Series& series = it->second;
+  if (added && !directory_.empty()) {
+    std::string path = directory_ + "/node" + std::to_string(sample.node) +
+                       "_ch" + std::to_string(sample.channel) + ".bin";
+    series.file = std::fopen(path.c_str(), "ab");
+  }
+  if (!series.series.append(sample.t_us, sample.mean)) {
+    return false;
+  }
+  series.latest = sample;
+  samples_++;
+
+  if (directory_.empty()) {
+    return true;
+  }
+  StoreRecord record = {
+      .t_us = sample.t_us,
+      .min = sample.min,
+      .max = sample.max,
+      .mean = sample.mean,
+      .count = sample.count,
+  };
+  if (series.file == nullptr ||
+      std::fwrite(&record, sizeof(record), 1, series.file) != 1) {
+    write_errors_++;
+    return false;
+  }
+  return true;
+}
+
+void SeriesStore::flush() {
+  for (auto& [key, series] : series_) {
+    if (series.file != nullptr) {
+      std::fflush(series.file);
+    }
+  }
+}
+
+const TimeSeries* SeriesStore::series(uint8_t node, uint8_t channel) const {
+  auto it = series_.find(key(node, channel));
+  return it == series_.end() ? nullptr : &it->second.series;
+}
+
+std::vector<MergedSample> SeriesStore::latest() const {
+  std::vector<MergedSample> latest;
+  latest.reserve(series_.size());
+  for (const auto& [key, series] : series_) {
+    latest.push_back(series.latest);
+  }
+  return latest;
+}
+
+bool read_series_file(const std::string& path,
+                      std::vector<StoreRecord>* records) {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  StoreRecord record;
+  while (std::fread(&record, sizeof(record), 1, file) == 1) {
+    records->push_back(record);
+  }
+  std::fclose(file);
+  return true;
+}
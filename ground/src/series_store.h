@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fan_in.h"
+#include "time_series.h"
+
+// Time-series store for live ingest. Every (node, channel) series is appended
+// to its own file, `<directory>/node<N>_ch<C>.bin`, as packed little-endian
+// StoreRecords, and kept in memory as a TimeSeries of the means for plotting
+// queries.
+
+struct StoreRecord {
+  uint64_t t_us;
+  float min;
+  float max;
+  float mean;
+  uint32_t count;
+};
+static_assert(sizeof(StoreRecord) == 24, "StoreRecord is stored as is");
+
+class SeriesStore {
+ public:
+  // An empty `directory` keeps everything in memory only.
+  explicit SeriesStore(std::string directory)
+      : directory_(std::move(directory)) {}
+  ~SeriesStore();
+  SeriesStore(const SeriesStore&) = delete;
+  SeriesStore& operator=(const SeriesStore&) = delete;
+
+  // Creates the directory. Returns false if it can't.
+  bool open();
+  // Returns false if the sample is older than the series' newest one or
+  // couldn't be written.
+  bool append(const MergedSample& sample);
+  // Pushes buffered records to disk.
+  void flush();
+
+  // Nullptr if nothing was received for the series.
+  const TimeSeries* series(uint8_t node, uint8_t channel) const;
+  // Newest sample of every series, by node then channel.
+  std::vector<MergedSample> latest() const;
+  uint64_t samples() const { return samples_; }
+  uint64_t write_errors() const { return write_errors_; }
+
+ private:
+  struct Series {
+    std::FILE* file = nullptr;
+    TimeSeries series;
+    MergedSample latest;
+  };
+
+  static uint16_t key(uint8_t node, uint8_t channel) {
+    return node << 8 | channel;
+  }
+
+  std::string directory_;
+  std::map<uint16_t, Series> series_;
+  uint64_t samples_ = 0;
+  uint64_t write_errors_ = 0;
+};
+
+// Reads a series file written by SeriesStore. Returns false if it can't be
+// opened.
+bool read_series_file(const std::string& path,
+                      std::vector<StoreRecord>* records);
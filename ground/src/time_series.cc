@@ -0,0 +1,97 @@
+#include "time_series.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+SeriesPoint sample_point(uint64_t t_us, float value) {
+  return {
+      .t_first_us = t_us,
+      .t_last_us = t_us,
+      .min = value,
+      .max = value,
+      .mean = value,
+      .count = 1,
+  };
+}
+
+void merge(SeriesPoint* into, const SeriesPoint& point) {
+  uint32_t count = into->count + point.count;
+  into->t_last_us = point.t_last_us;
+  into->min = std::min(into->min, point.min);
+  into->max = std::max(into->max, point.max);
+  into->mean += (point.mean - into->mean) * point.count / count;
+  into->count = count;
+}
+
+}  // namespace
+
+bool TimeSeries::append(uint64_t t_us, float value) {
+  if (!t_us_.empty() && t_us < t_us_.back()) {
+    return false;
+  }
+  t_us_.push_back(t_us);
+  values_.push_back(value);
+
+  const SeriesPoint sample = sample_point(t_us, value);
+  const size_t index = t_us_.size() - 1;
+  size_t span = PYRAMID_FANOUT;
+  for (std::vector<SeriesPoint>& level : levels_) {
+    if (index % span == 0) {
+      level.push_back(sample);
+    } else {
+      merge(&level.back(), sample);
+    }
+    span *= PYRAMID_FANOUT;
+  }
+
+  // Keep adding levels until the top one is a single point covering every
+  // sample. The first level starts at the second sample.
+  if (levels_.empty() && t_us_.size() == 2) {
+    SeriesPoint top = sample_point(t_us_[0], values_[0]);
+    merge(&top, sample);
+    levels_.push_back({top});
+  } else if (!levels_.empty() && levels_.back().size() == 2) {
+    SeriesPoint top = levels_.back()[0];
+    merge(&top, levels_.back()[1]);
+    levels_.push_back({top});
+  }
+  return true;
+}
+
+size_t TimeSeries::query(uint64_t t0_us, uint64_t t1_us, size_t max_points,
+                         std::vector<SeriesPoint>* out) const {
+  if (max_points == 0 || t1_us < t0_us) {
+    return 0;
+  }
+  auto first = std::lower_bound(t_us_.begin(), t_us_.end(), t0_us);
+  auto last = std::upper_bound(t_us_.begin(), t_us_.end(), t1_us);
+  if (first == last) {
+    return 0;
+  }
+  if (static_cast<size_t>(last - first) <= max_points) {
+    for (auto it = first; it != last; ++it) {
+      out->push_back(sample_point(*it, values_[it - t_us_.begin()]));
+    }
+    return last - first;
+  }
+
+  for (const std::vector<SeriesPoint>& level : levels_) {
+    // Points overlapping the range: from the first one ending at or after
+    // t0 to the last one starting at or before t1.
+    auto begin = std::partition_point(
+        level.begin(), level.end(),
+        [&](const SeriesPoint& point) { return point.t_last_us < t0_us; });
+    auto end = std::partition_point(
+        begin, level.end(),
+        [&](const SeriesPoint& point) { return point.t_first_us <= t1_us; });
+    if (static_cast<size_t>(end - begin) <= max_points) {
+      out->insert(out->end(), begin, end);
+      return end - begin;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One channel of a capture, indexed for plotting.
+//
+// Besides the raw samples, keeps a min/max/mean pyramid (like mipmaps for an
+// image): level i summarizes runs of PYRAMID_FANOUT^(i + 1) consecutive
+// samples, up to a single point covering everything. Every append() updates
+// the newest point of each level, so the index is always current during
+// ingest. A query picks the finest level that answers within the point
+// budget, which costs O(points + log samples) whatever the size of the range.
+
+constexpr size_t PYRAMID_FANOUT = 8;
+
+// A run of samples. Raw samples are points with a count of 1.
+struct SeriesPoint {
+  uint64_t t_first_us;
+  uint64_t t_last_us;
+  float min;
+  float max;
+  float mean;
+  uint32_t count;
+};
+
+class TimeSeries {
+ public:
+  // Adds a sample. Timestamps must not decrease; returns false and drops the
+  // sample otherwise.
+  bool append(uint64_t t_us, float value);
+
+  // Appends to `out` at most `max_points` points covering the samples in
+  // [t0_us, t1_us], oldest first: the raw samples if there are few enough,
+  // else the points of the finest pyramid level that fits. Points at either
+  // edge may include samples just outside the range. Returns the number of
+  // points appended.
+  size_t query(uint64_t t0_us, uint64_t t1_us, size_t max_points,
+               std::vector<SeriesPoint>* out) const;
+
+  size_t size() const { return t_us_.size(); }
+  // Pyramid levels above the raw samples.
+  size_t levels() const { return levels_.size(); }
+  const std::vector<uint64_t>& t_us() const { return t_us_; }
+  const std::vector<float>& values() const { return values_; }
+
+ private:
+  std::vector<uint64_t> t_us_;
+  std::vector<float> values_;
+  std::vector<std::vector<SeriesPoint>> levels_;
+};
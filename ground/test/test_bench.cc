@@ -0,0 +1,30 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+
+#include "bench/bench.h"
+
+TEST_CASE("Benchmark summary takes quantiles per call") {
+  // Out of order, with one preempted batch.
+  uint32_t batch_cycles[] = {500, 100, 300, 200, 400, 9000, 600};
+  BenchResult result = bench_summarize("test", 10, batch_cycles, 7);
+  CHECK(result.iterations == 10);
+  CHECK(result.batches == 7);
+  CHECK(result.cycles_min == 10);
+  CHECK(result.cycles_p25 == 30);
+  CHECK(result.cycles_median == 40);
+  CHECK(result.cycles_p75 == 60);
+  CHECK(result.cycles_max == 900);
+  // The Linux backend counts nanoseconds.
+  CHECK(result.ns_median == 40);
+
+  CHECK(bench_summarize("empty", 10, batch_cycles, 0).cycles_median == 0);
+}
+
+TEST_CASE("Benchmark runs a warm-up call and every batch") {
+  uint32_t calls = 0;
+  BenchResult result = bench_run("count", 4, [&] { calls++; });
+  CHECK(calls == 1 + 4 * BENCH_BATCHES);
+  CHECK(result.batches == BENCH_BATCHES);
+  CHECK(result.cycles_min <= result.cycles_median);
+  CHECK(result.cycles_median <= result.cycles_max);
+}
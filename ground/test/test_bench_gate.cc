@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "bench_gate.h"
+
+namespace {
+
+// 16 batches with an IQR of 8: a notch of 1.57 * 8 / 4 = 3.14 each side.
+std::string line(const char* name, double median) {
+  BenchRecord record;
+  record.name = name;
+  record.iterations = 100;
+  record.batches = 16;
+  record.cycles_min = median - 10;
+  record.cycles_p25 = median - 4;
+  record.cycles_median = median;
+  record.cycles_p75 = median + 4;
+  record.cycles_max = median + 50;
+  record.ns_median = median;
+  return format_bench_line(record) + "\n";
+}
+
+BenchVerdict verdict(const std::vector<BenchComparison>& comparisons,
+                     const std::string& name) {
+  for (const BenchComparison& comparison : comparisons) {
+    if (comparison.name == name) {
+      return comparison.verdict;
+    }
+  }
+  FAIL("no comparison for " << name);
+  return BenchVerdict::kSame;
+}
+
+}  // namespace
+
+TEST_CASE("Benchmark lines parse out of a console capture") {
+  std::vector<BenchRecord> records = parse_bench_lines(
+      "I (120) BENCH: Running benchmarks\n"
+      "bench,name,iterations,batches,cycles_min,cycles_p25,cycles_median,"
+      "cycles_p75,cycles_max,ns_median\n"
+      "bench,pt_convert,1000,15,10.0,11.5,12.0,12.5,40.0,50.0\r\n"
+      "bench,truncated,1000,15,10.0\n"
+      "bench,frame_encode,200,15,300.0,310.0,320.0,330.0,900.0,1333.3\n"
+      // A second run, slowed down by something else on the machine.
+      "bench,pt_convert,1000,15,20.0,21.0,22.0,23.0,50.0,91.7\n"
+      "bench,frame_encode,200,15,290.0,300.0,305.0,310.0,600.0,1270.8");
+  REQUIRE(records.size() == 2);
+  CHECK(records[0].name == "pt_convert");
+  // Each keeps its fastest run.
+  CHECK(records[0].cycles_median == 12);
+  CHECK(records[0].ns_median == 50);
+  CHECK(records[1].name == "frame_encode");
+  CHECK(records[1].iterations == 200);
+  CHECK(records[1].batches == 15);
+  CHECK(records[1].cycles_p25 == 300);
+  CHECK(records[1].ns_median == Approx(1270.8));
+
+  BenchRecord round_trip;
+  REQUIRE(parse_bench_line(format_bench_line(records[1]), &round_trip));
+  CHECK(round_trip.name == "frame_encode");
+  CHECK(round_trip.cycles_max == 600);
+  CHECK(round_trip.median_low() == Approx(305 - 1.57 * 10 / std::sqrt(15)));
+  CHECK(round_trip.median_high() == Approx(305 + 1.57 * 10 / std::sqrt(15)));
+}
+
+TEST_CASE("Benchmark gate fails regressions beyond noise and tolerance") {
+  std::vector<BenchRecord> baseline = parse_bench_lines(
+      line("steady", 100) + line("noisy_shift", 100) + line("slower", 100) +
+      line("faster", 100) + line("small_shift", 1000) + line("dropped", 100));
+  std::vector<BenchRecord> run = parse_bench_lines(
+      // Within both notches.
+      line("steady", 103) +
+      // Notches of 3.14 overlap at a 6 cycle shift, past the tolerance.
+      line("noisy_shift", 106) + line("slower", 120) + line("faster", 80) +
+      // Beyond the notches, but only 1%.
+      line("small_shift", 1010) + line("added", 50));
+  std::vector<BenchComparison> comparisons =
+      compare_bench_results(baseline, run, 0.05);
+
+  REQUIRE(comparisons.size() == 7);
+  CHECK(verdict(comparisons, "steady") == BenchVerdict::kSame);
+  CHECK(verdict(comparisons, "noisy_shift") == BenchVerdict::kSame);
+  CHECK(verdict(comparisons, "slower") == BenchVerdict::kSlower);
+  CHECK(verdict(comparisons, "faster") == BenchVerdict::kFaster);
+  CHECK(verdict(comparisons, "small_shift") == BenchVerdict::kSame);
+  CHECK(verdict(comparisons, "dropped") == BenchVerdict::kMissing);
+  CHECK(verdict(comparisons, "added") == BenchVerdict::kNew);
+  // The run's new benchmark comes last.
+  CHECK(comparisons.back().name == "added");
+
+  int failures = 0;
+  for (const BenchComparison& comparison : comparisons) {
+    failures += comparison.failed();
+  }
+  CHECK(failures == 2);
+  CHECK(comparisons[2].delta == Approx(0.2));
+  CHECK(comparisons[2].baseline_median == 100);
+  CHECK(comparisons[2].median == 120);
+}
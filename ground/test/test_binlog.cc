@@ -0,0 +1,81 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "binlog/binlog.h"
+#include "binlog_expand.h"
+#include "configs/log_format_config.h"
+
+namespace {
+
+constexpr uint16_t PT_READING = static_cast<uint16_t>(LogFormat::kPtReading);
+constexpr uint16_t SERVO_ANGLE =
+    static_cast<uint16_t>(LogFormat::kServoAngle);
+
+}  // namespace
+
+TEST_CASE("Binlog records round trip through console lines") {
+  BinLogRecord record =
+      make_binlog_record(0x123456789ull, SERVO_ANGLE, -45, 1500, 76);
+  record.core = 1;
+
+  char line[BINLOG_LINE_MAX_SIZE];
+  size_t len = format_binlog_line(record, line, sizeof(line));
+  REQUIRE(len == std::strlen(line));
+  REQUIRE(std::string(line).rfind(BINLOG_LINE_PREFIX, 0) == 0);
+
+  BinLogRecord decoded;
+  REQUIRE(parse_binlog_line(line, len, &decoded));
+  CHECK(decoded.t_us == 0x23456789u);  // Only the low 32 bits travel.
+  CHECK(decoded.format == SERVO_ANGLE);
+  CHECK(decoded.core == 1);
+  REQUIRE(decoded.arg_count == 3);
+  CHECK(static_cast<int32_t>(decoded.args[0]) == -45);
+  CHECK(decoded.args[1] == 1500);
+  CHECK(decoded.args[2] == 76);
+
+  // Serial monitors may leave a carriage return.
+  std::string with_cr = std::string(line) + "\r";
+  CHECK(parse_binlog_line(with_cr.data(), with_cr.size(), &decoded));
+}
+
+TEST_CASE("Binlog rejects malformed lines") {
+  BinLogRecord record;
+  std::string text = "I (100) PT: PT 0: 14.70 psi";
+  CHECK_FALSE(parse_binlog_line(text.data(), text.size(), &record));
+
+  char line[BINLOG_LINE_MAX_SIZE];
+  size_t len = format_binlog_line(
+      make_binlog_record(1, PT_READING, 0u, 1.0f), line, sizeof(line));
+  CHECK_FALSE(parse_binlog_line(line, len - 2, &record));  // Truncated.
+  line[len - 1] = 'z';
+  CHECK_FALSE(parse_binlog_line(line, len, &record));
+
+  CHECK(format_binlog_line(make_binlog_record(1, PT_READING), line, 4) == 0);
+}
+
+TEST_CASE("Binlog expands records like ESP_LOG") {
+  BinLogExpander expander;
+  CHECK(expander.expand(make_binlog_record(1234567, PT_READING, 2u, 14.7f)) ==
+        "I (1234) PT: PT 2: 14.70 psi");
+  CHECK(expander.expand(
+            make_binlog_record(1300000, SERVO_ANGLE, -10, 1200, 61)) ==
+        "I (1300) SERVO: Angle: -10 -> Pulsewidth: 1200 us -> Duty: 61");
+
+  // Unknown formats still show their arguments.
+  CHECK(expander.expand(make_binlog_record(1400000, 0xFFFF, 7u)) ==
+        "? (1400) format 65535: 0x00000007");
+}
+
+TEST_CASE("Binlog expander unwraps 32-bit timestamps") {
+  BinLogExpander expander;
+  expander.expand(make_binlog_record(0xFFFFFF00u, PT_READING, 0u, 0.0f));
+  expander.expand(make_binlog_record(0x100, PT_READING, 0u, 0.0f));
+  CHECK(expander.last_t_us() == (uint64_t{1} << 32) + 0x100);
+}
+
+TEST_CASE("Binlog format expansion handles specs and missing arguments") {
+  uint32_t args[] = {255, 0xFFFFFFFF};
+  CHECK(expand_binlog_format("%04x %ld %% %d", args, 2) == "00ff -1 % ?");
+}
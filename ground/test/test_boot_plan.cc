@@ -0,0 +1,33 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+
+#include "sched/boot_plan.h"
+
+TEST_CASE("Boot plan starts phases once their dependencies are done") {
+  // 0 and 1 are independent, 2 needs both, 3 needs 2.
+  const uint32_t depends_on[] = {0, 0, 0b011, 0b100};
+  REQUIRE(boot_plan_valid(depends_on, 4));
+
+  CHECK(boot_plan_ready(depends_on, 4, 0, 0) == 0b0011);
+  // Started but not done: neither ready again nor done.
+  CHECK(boot_plan_ready(depends_on, 4, 0b0011, 0b0001) == 0);
+  CHECK(boot_plan_ready(depends_on, 4, 0b0011, 0b0011) == 0b0100);
+  CHECK(boot_plan_ready(depends_on, 4, 0b0111, 0b0111) == 0b1000);
+  CHECK(boot_plan_ready(depends_on, 4, 0b1111, 0b1111) == 0);
+}
+
+TEST_CASE("Boot plan rejects cycles and unknown phases") {
+  const uint32_t cycle[] = {0, 0b100, 0b010};
+  CHECK_FALSE(boot_plan_valid(cycle, 3));
+  const uint32_t self[] = {0b1};
+  CHECK_FALSE(boot_plan_valid(self, 1));
+  const uint32_t unknown[] = {0, 0b100};
+  CHECK_FALSE(boot_plan_valid(unknown, 2));
+  CHECK(boot_plan_valid(nullptr, 0));
+}
+
+TEST_CASE("Boot plan masks cover every phase") {
+  CHECK(boot_plan_all(0) == 0);
+  CHECK(boot_plan_all(3) == 0b111);
+  CHECK(boot_plan_all(BOOT_PLAN_MAX_PHASES) == UINT32_MAX);
+}
@@ -0,0 +1,319 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "telemetry/channel_access.h"
+#include "telemetry/lora_airtime.h"
+
+namespace {
+
+constexpr LoRaModulation MODULATION = {
+    .spreading_factor = 7,
+    .bandwidth_hz = 125000,
+    .coding_rate = 1,
+    .preamble_length = 8,
+    .explicit_header = true,
+    .crc_on = true,
+    .low_data_rate_optimize = false,
+};
+constexpr size_t FRAME_SIZE = 64;
+constexpr uint64_t STEP_US = 100;
+constexpr uint64_t DURATION_US = 60ull * 1000 * 1000;
+// CAD over 4 symbols at SF7/125 kHz plus processing and TX turnaround.
+constexpr uint64_t CAD_US = 5000;
+constexpr int QUEUE_SIZE = 4;
+// Offered load of each node, as a fraction of the channel's capacity.
+constexpr double NODE_LOAD = 0.2;
+
+// Every transmission on the shared channel. Overlapping transmissions are
+// all lost (no capture effect).
+class SharedChannel {
+ public:
+  bool busy(uint64_t now_us) const {
+    for (const Transmission& tx : on_air_) {
+      if (tx.end_us > now_us) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void start(uint64_t now_us, uint32_t airtime_us) {
+    bool collided = false;
+    for (Transmission& tx : on_air_) {
+      if (tx.end_us > now_us) {
+        tx.collided = true;
+        collided = true;
+      }
+    }
+    on_air_.push_back({now_us + airtime_us, airtime_us, collided});
+  }
+
+  void finish(uint64_t now_us) {
+    for (size_t i = 0; i < on_air_.size();) {
+      if (on_air_[i].end_us > now_us) {
+        i++;
+        continue;
+      }
+      if (on_air_[i].collided) {
+        collisions++;
+      } else {
+        delivered++;
+        delivered_airtime_us += on_air_[i].airtime_us;
+      }
+      on_air_[i] = on_air_.back();
+      on_air_.pop_back();
+    }
+  }
+
+  uint32_t delivered = 0;
+  uint32_t collisions = 0;
+  uint64_t delivered_airtime_us = 0;
+
+ private:
+  struct Transmission {
+    uint64_t end_us;
+    uint32_t airtime_us;
+    bool collided;
+  };
+
+  std::vector<Transmission> on_air_;
+};
+
+struct Node {
+  enum class Phase { kIdle, kWaiting, kCad, kTransmitting };
+
+  Node(const ChannelAccessConfig& config, uint32_t seed)
+      : access(config, seed), rng(seed) {}
+
+  ChannelAccess access;
+  std::mt19937 rng;
+  Phase phase = Phase::kIdle;
+  uint64_t phase_end_us = 0;
+  bool cad_busy = false;
+  uint64_t next_arrival_us = 0;
+  int queued = 0;
+};
+
+struct SimResult {
+  // Delivered airtime as a fraction of the simulated time.
+  double throughput;
+  uint32_t delivered;
+  uint32_t collisions;
+};
+
+// N nodes with Poisson traffic contending for one channel.
+SimResult simulate(AccessMode mode, int node_count) {
+  const uint32_t airtime_us = lora_time_on_air_us(MODULATION, FRAME_SIZE);
+  const double mean_gap_us = airtime_us / NODE_LOAD;
+
+  SharedChannel channel;
+  std::vector<Node> nodes;
+  for (int i = 0; i < node_count; i++) {
+    ChannelAccessConfig config = {
+        .mode = mode,
+        .backoff_slot_us = airtime_us / 2,
+        .min_backoff_exponent = 1,
+        .max_backoff_exponent = 5,
+        .max_attempts = 8,
+        .node_id = static_cast<uint8_t>(i),
+        .node_count = static_cast<uint8_t>(node_count),
+        .slot_us = airtime_us + 2000,
+        .guard_us = 1000,
+    };
+    nodes.emplace_back(config, 1234 + i);
+    // Every node runs on the simulation's clock.
+    nodes.back().access.set_shared_time(0);
+  }
+
+  for (uint64_t now_us = 0; now_us < DURATION_US; now_us += STEP_US) {
+    channel.finish(now_us);
+    for (Node& node : nodes) {
+      while (node.next_arrival_us <= now_us) {
+        node.queued = std::min(node.queued + 1, QUEUE_SIZE);
+        node.next_arrival_us += static_cast<uint64_t>(
+            std::exponential_distribution<double>(1.0 / mean_gap_us)(
+                node.rng));
+      }
+
+      if (node.phase == Node::Phase::kTransmitting &&
+          now_us >= node.phase_end_us) {
+        node.queued--;
+        node.phase = Node::Phase::kIdle;
+      }
+      if (node.phase == Node::Phase::kIdle && node.queued > 0) {
+        node.access.begin(now_us, airtime_us);
+        node.phase = Node::Phase::kWaiting;
+      }
+      if (node.phase == Node::Phase::kWaiting &&
+          now_us >= node.access.next_attempt_us()) {
+        if (node.access.needs_cad()) {
+          node.cad_busy = channel.busy(now_us);
+          node.phase = Node::Phase::kCad;
+          node.phase_end_us = now_us + CAD_US;
+        } else {
+          node.phase_end_us = now_us;
+          node.phase = Node::Phase::kCad;
+        }
+      }
+      if (node.phase == Node::Phase::kCad && now_us >= node.phase_end_us) {
+        switch (node.access.on_attempt(now_us, node.cad_busy)) {
+          case AccessDecision::kTransmit:
+            channel.start(now_us, airtime_us);
+            node.phase = Node::Phase::kTransmitting;
+            node.phase_end_us = now_us + airtime_us;
+            break;
+          case AccessDecision::kWait:
+            node.phase = Node::Phase::kWaiting;
+            break;
+          case AccessDecision::kDrop:
+            node.queued--;
+            node.phase = Node::Phase::kIdle;
+            break;
+        }
+      }
+    }
+  }
+
+  return {
+      .throughput =
+          static_cast<double>(channel.delivered_airtime_us) / DURATION_US,
+      .delivered = channel.delivered,
+      .collisions = channel.collisions,
+  };
+}
+
+ChannelAccessConfig lbt_config() {
+  return {
+      .mode = AccessMode::kListenBeforeTalk,
+      .backoff_slot_us = 1000,
+      .min_backoff_exponent = 2,
+      .max_backoff_exponent = 4,
+      .max_attempts = 3,
+      .node_id = 0,
+      .node_count = 1,
+      .slot_us = 0,
+      .guard_us = 0,
+  };
+}
+
+}  // namespace
+
+TEST_CASE("Aloha always transmits immediately", "[channel_access]") {
+  ChannelAccessConfig config = lbt_config();
+  config.mode = AccessMode::kAloha;
+  ChannelAccess access(config, 1);
+  access.begin(500, 10000);
+  REQUIRE_FALSE(access.needs_cad());
+  REQUIRE(access.next_attempt_us() == 500);
+  REQUIRE(access.on_attempt(500, true) == AccessDecision::kTransmit);
+}
+
+TEST_CASE("Listen-before-talk backs off within the window and drops",
+          "[channel_access]") {
+  ChannelAccess access(lbt_config(), 7);
+  access.begin(0, 10000);
+  REQUIRE(access.needs_cad());
+  REQUIRE(access.on_attempt(0, false) == AccessDecision::kTransmit);
+
+  access.begin(0, 10000);
+  REQUIRE(access.on_attempt(0, true) == AccessDecision::kWait);
+  // First backoff: 1..4 slots.
+  REQUIRE(access.next_attempt_us() >= 1000);
+  REQUIRE(access.next_attempt_us() <= 4000);
+  uint64_t now_us = access.next_attempt_us();
+  REQUIRE(access.on_attempt(now_us, true) == AccessDecision::kWait);
+  // Second backoff: 1..8 slots.
+  REQUIRE(access.next_attempt_us() - now_us >= 1000);
+  REQUIRE(access.next_attempt_us() - now_us <= 8000);
+  now_us = access.next_attempt_us();
+  REQUIRE(access.on_attempt(now_us, true) == AccessDecision::kDrop);
+  REQUIRE(access.busy_count() == 3);
+  REQUIRE(access.drop_count() == 1);
+}
+
+TEST_CASE("TDMA only transmits inside the node's slot", "[channel_access]") {
+  ChannelAccessConfig config = lbt_config();
+  config.mode = AccessMode::kTdma;
+  config.node_id = 2;
+  config.node_count = 4;
+  config.slot_us = 100000;
+  config.guard_us = 5000;
+  ChannelAccess access(config, 1);
+  access.set_shared_time(0);
+  REQUIRE_FALSE(access.needs_cad());
+
+  // Before our slot: wait for its start.
+  access.begin(10000, 50000);
+  REQUIRE(access.next_attempt_us() == 200000);
+  REQUIRE(access.on_attempt(200000, false) == AccessDecision::kTransmit);
+
+  // Inside our slot with room left.
+  access.begin(220000, 50000);
+  REQUIRE(access.next_attempt_us() == 220000);
+
+  // Too late in the slot for the frame and guard: next cycle.
+  access.begin(260000, 50000);
+  REQUIRE(access.next_attempt_us() == 600000);
+  REQUIRE(access.on_attempt(260000, false) == AccessDecision::kWait);
+}
+
+TEST_CASE("TDMA counts slots in shared time", "[channel_access]") {
+  ChannelAccessConfig config = lbt_config();
+  config.mode = AccessMode::kTdma;
+  config.node_count = 2;
+  config.slot_us = 100000;
+  config.guard_us = 5000;
+  ChannelAccessConfig other_config = config;
+  other_config.node_id = 1;
+  ChannelAccess access(config, 1);
+  ChannelAccess other(other_config, 2);
+
+  // Without a shared time base the boards' clocks (time since boot) don't
+  // line up, so TDMA runs listen-before-talk.
+  REQUIRE(access.mode() == AccessMode::kListenBeforeTalk);
+  REQUIRE(access.needs_cad());
+  access.begin(150000, 50000);
+  REQUIRE(access.next_attempt_us() == 150000);
+  REQUIRE(access.on_attempt(150000, true) == AccessDecision::kWait);
+  REQUIRE(access.busy_count() == 1);
+
+  // Booted 30 ms and 70 ms before shared time 0: both wait for their own
+  // slot of the shared cycle.
+  access.set_shared_time(-30000);
+  other.set_shared_time(-70000);
+  REQUIRE(access.mode() == AccessMode::kTdma);
+  access.begin(150000, 50000);
+  other.begin(150000, 50000);
+  REQUIRE(access.next_attempt_us() == 230000);
+  REQUIRE(other.next_attempt_us() == 170000);
+  REQUIRE(access.on_attempt(230000, false) == AccessDecision::kTransmit);
+
+  access.clear_shared_time();
+  REQUIRE(access.needs_cad());
+}
+
+TEST_CASE("Aggregate throughput scales with node count", "[channel_access]") {
+  // Two nodes offer 40% of the channel, eight offer 160%.
+  SimResult aloha_2 = simulate(AccessMode::kAloha, 2);
+  SimResult aloha_8 = simulate(AccessMode::kAloha, 8);
+  SimResult lbt_2 = simulate(AccessMode::kListenBeforeTalk, 2);
+  SimResult lbt_8 = simulate(AccessMode::kListenBeforeTalk, 8);
+  SimResult tdma_2 = simulate(AccessMode::kTdma, 2);
+  SimResult tdma_8 = simulate(AccessMode::kTdma, 8);
+  INFO("aloha " << aloha_2.throughput << " -> " << aloha_8.throughput);
+  INFO("lbt " << lbt_2.throughput << " -> " << lbt_8.throughput);
+  INFO("tdma " << tdma_2.throughput << " -> " << tdma_8.throughput);
+
+  // Blind transmission collapses under load.
+  REQUIRE(aloha_8.throughput < aloha_2.throughput);
+  // Listen-before-talk keeps scaling, well past what Aloha can carry.
+  REQUIRE(lbt_8.throughput > 1.5 * lbt_2.throughput);
+  REQUIRE(lbt_8.throughput > 4 * aloha_8.throughput);
+  REQUIRE(lbt_8.collisions < lbt_8.delivered / 2);
+  // TDMA never collides and fills the channel.
+  REQUIRE(tdma_8.collisions == 0);
+  REQUIRE(tdma_8.throughput > 2 * tdma_2.throughput);
+  REQUIRE(tdma_8.throughput > 0.9);
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "column_reader.h"
+#include "datalog/column_file.h"
+#include "datalog/flash_log.h"
+#include "file_flash.h"
+
+namespace {
+
+constexpr ColumnChannel CHANNELS[] = {
+    {.type = RecordType::kPt, .id = 0, .reserved = 0},
+    {.type = RecordType::kPt, .id = 1, .reserved = 0},
+    {.type = RecordType::kValve, .id = 2, .reserved = 0},
+};
+
+std::string fresh_image(const char* name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / (std::string(name) + ".bin");
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+// Channel 0 at 1 kHz and channel 1 at 100 Hz for `ms` milliseconds.
+void write_samples(ColumnWriter* writer, uint32_t ms) {
+  for (uint32_t t = 0; t < ms; t++) {
+    REQUIRE(writer->append(0, t * 1000ull, static_cast<float>(t)));
+    if (t % 10 == 0) {
+      REQUIRE(writer->append(1, t * 1000ull, -static_cast<float>(t)));
+    }
+  }
+}
+
+std::vector<float> channel_values(const ColumnFileReader& reader,
+                                  uint16_t channel) {
+  std::vector<float> values;
+  for (const ColumnBlockView& block : reader.blocks(channel)) {
+    values.insert(values.end(), block.value.begin(), block.value.end());
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST_CASE("Column files round trip through the mmap reader") {
+  std::string path = fresh_image("column_round_trip");
+  static ColumnBlock blocks[COLUMN_MAX_CHANNELS];
+  {
+    FileFlash flash(path, 64 * FLASH_SECTOR_SIZE);
+    ColumnWriter writer(&flash, blocks);
+    REQUIRE(writer.open(CHANNELS, 3, 7));
+    write_samples(&writer, 1000);
+    REQUIRE(writer.finish());
+    CHECK(writer.stats().samples == 1100);
+    CHECK(flash.unerased_writes() == 0);
+  }
+
+  ColumnFileReader reader;
+  REQUIRE(reader.open(path));
+  CHECK(reader.finished());
+  CHECK(reader.header().session == 7);
+  REQUIRE(reader.channel_count() == 3);
+  CHECK(reader.header().channels[2].type == RecordType::kValve);
+  CHECK(reader.sample_count(0) == 1000);
+  CHECK(reader.sample_count(1) == 100);
+  CHECK(reader.sample_count(2) == 0);
+
+  std::vector<ColumnBlockView> blocks0 = reader.blocks(0);
+  REQUIRE(blocks0.size() == 4);  // 3 full blocks and the rest.
+  CHECK(blocks0[0].entry->count == COLUMN_BLOCK_SAMPLES);
+  CHECK(blocks0[0].entry->min == 0.0f);
+  CHECK(blocks0[0].entry->max == 255.0f);
+  CHECK(blocks0[0].entry->mean == Approx(127.5f));
+  CHECK(blocks0[3].entry->count == 1000 - 3 * COLUMN_BLOCK_SAMPLES);
+  CHECK(blocks0[3].entry->t_last_us == 999000);
+
+  std::vector<float> values = channel_values(reader, 0);
+  REQUIRE(values.size() == 1000);
+  for (uint32_t t = 0; t < 1000; t++) {
+    REQUIRE(values[t] == static_cast<float>(t));
+  }
+  ColumnBlockView last = reader.blocks(1).back();
+  CHECK(last.t_us[last.t_us.size - 1] == 990000);
+  CHECK(last.value[last.value.size - 1] == -990.0f);
+}
+
+TEST_CASE("Column writer maps flash log records to channels") {
+  std::string path = fresh_image("column_records");
+  static ColumnBlock blocks[COLUMN_MAX_CHANNELS];
+  FileFlash flash(path, 16 * FLASH_SECTOR_SIZE);
+  ColumnWriter writer(&flash, blocks);
+  REQUIRE(writer.open(CHANNELS, 3, 1));
+
+  CHECK(writer.append(LogRecord{.t_us = 10,
+                                .type = RecordType::kPt,
+                                .id = 1,
+                                .aux = 0,
+                                .value = 14.7f}));
+  CHECK(writer.append(LogRecord{.t_us = 20,
+                                .type = RecordType::kValve,
+                                .id = 2,
+                                .aux = 1,
+                                .value = 0}));
+  // No channel for this PT.
+  CHECK_FALSE(writer.append(LogRecord{.t_us = 30,
+                                      .type = RecordType::kPt,
+                                      .id = 5,
+                                      .aux = 0,
+                                      .value = 1}));
+  // Older than the last sample of its channel.
+  CHECK_FALSE(writer.append(1, 5, 1.0f));
+  CHECK(writer.stats().out_of_order == 1);
+  REQUIRE(writer.finish());
+
+  ColumnFileReader reader;
+  REQUIRE(reader.open(path));
+  CHECK(channel_values(reader, 1) == std::vector<float>{14.7f});
+  CHECK(channel_values(reader, 2) == std::vector<float>{1.0f});
+}
+
+TEST_CASE("Unfinished column files are read up to their last block") {
+  std::string path = fresh_image("column_unfinished");
+  static ColumnBlock blocks[COLUMN_MAX_CHANNELS];
+  {
+    // An older, longer file is overwritten by one that never finishes.
+    FileFlash flash(path, 64 * FLASH_SECTOR_SIZE);
+    ColumnWriter writer(&flash, blocks);
+    REQUIRE(writer.open(CHANNELS, 3, 1));
+    write_samples(&writer, 2000);
+    REQUIRE(writer.finish());
+
+    REQUIRE(writer.open(CHANNELS, 3, 2));
+    write_samples(&writer, 600);
+    CHECK(flash.unerased_writes() == 0);
+  }
+
+  ColumnFileReader reader;
+  REQUIRE(reader.open(path));
+  CHECK_FALSE(reader.finished());
+  CHECK(reader.header().session == 2);
+  // Only full blocks reached flash.
+  CHECK(reader.sample_count(0) == 2 * COLUMN_BLOCK_SAMPLES);
+  CHECK(reader.sample_count(1) == 0);
+}
+
+TEST_CASE("Column writer stops at the end of the region") {
+  std::string path = fresh_image("column_full");
+  static ColumnBlock blocks[COLUMN_MAX_CHANNELS];
+  FileFlash flash(path, 2 * FLASH_SECTOR_SIZE);
+  ColumnWriter writer(&flash, blocks);
+  REQUIRE(writer.open(CHANNELS, 3, 1));
+
+  uint32_t t = 0;
+  while (writer.append(0, t, 1.0f)) {
+    t++;
+  }
+  CHECK(writer.stats().blocks == 2);
+  CHECK(writer.stats().dropped > 0);
+  CHECK_FALSE(writer.finish());
+
+  ColumnFileReader reader;
+  REQUIRE(reader.open(path));
+  CHECK(reader.sample_count(0) == 2 * COLUMN_BLOCK_SAMPLES);
+}
+
+TEST_CASE("Column reader rejects other files") {
+  std::string path = fresh_image("column_not");
+  { FileFlash flash(path, FLASH_SECTOR_SIZE); }
+  ColumnFileReader reader;
+  CHECK_FALSE(reader.open(path));
+  CHECK_FALSE(reader.open(path + ".missing"));
+}
@@ -0,0 +1,460 @@
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "telemetry/command_link.h"
+#include "telemetry/frame.h"
+#include "telemetry/lora_airtime.h"
+
+namespace {
+
+constexpr LoRaModulation MODULATION = {
+    .spreading_factor = 7,
+    .bandwidth_hz = 125000,
+    .coding_rate = 1,
+    .preamble_length = 8,
+    .explicit_header = true,
+    .crc_on = true,
+    .low_data_rate_optimize = false,
+};
+constexpr uint32_t TURNAROUND_US = 1000;
+constexpr uint64_t STEP_US = 100;
+constexpr uint64_t TELEMETRY_PERIOD_US = 250 * 1000;
+constexpr uint8_t NODE = 3;
+constexpr uint8_t SESSION = 0x5A;
+
+// One direction of a simulated LoRa link. Packets arrive after their time on
+// air and are dropped with probability `loss`.
+class SimChannel {
+ public:
+  SimChannel(double loss, uint32_t seed) : loss_(loss), rng_(seed) {}
+
+  void transmit(const uint8_t* data, size_t len, uint64_t now_us) {
+    if (std::uniform_real_distribution<double>(0, 1)(rng_) < loss_) {
+      return;
+    }
+    in_flight_.push_back({now_us + lora_time_on_air_us(MODULATION, len),
+                          std::vector<uint8_t>(data, data + len)});
+  }
+
+  bool receive(uint64_t now_us, std::vector<uint8_t>* packet) {
+    if (in_flight_.empty() || in_flight_.front().arrival_us > now_us) {
+      return false;
+    }
+    *packet = std::move(in_flight_.front().data);
+    in_flight_.pop_front();
+    return true;
+  }
+
+ private:
+  struct Packet {
+    uint64_t arrival_us;
+    std::vector<uint8_t> data;
+  };
+
+  double loss_;
+  std::mt19937 rng_;
+  std::deque<Packet> in_flight_;
+};
+
+// A half-duplex endpoint can't start a transmission while one is on air.
+struct Radio {
+  uint64_t busy_until_us = 0;
+
+  bool transmit(SimChannel& channel, const uint8_t* data, size_t len,
+                uint64_t now_us) {
+    if (now_us < busy_until_us) {
+      return false;
+    }
+    channel.transmit(data, len, now_us);
+    busy_until_us =
+        now_us + lora_time_on_air_us(MODULATION, len) + TURNAROUND_US;
+    return true;
+  }
+};
+
+struct Board {
+  Radio radio;
+  CommandReceiver receiver{NODE};
+  std::vector<Command> executed;
+  uint16_t downlink_seq = 0;
+  uint64_t next_telemetry_us = 0;
+
+  void step(SimChannel& uplink, SimChannel& downlink, uint64_t now_us) {
+    std::vector<uint8_t> packet;
+    while (uplink.receive(now_us, &packet)) {
+      Command command;
+      if (receiver.on_packet(packet.data(), packet.size(), &command) ==
+          CommandResult::kExecute) {
+        executed.push_back(command);
+      }
+    }
+
+    bool telemetry_due = now_us >= next_telemetry_us;
+    if (!telemetry_due && !receiver.ack_pending()) {
+      return;
+    }
+    uint8_t body[64] = {};
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t size = encode_telemetry_frame(
+        NODE, downlink_seq, receiver.ack(), body,
+        telemetry_due ? sizeof(body) : 0, frame, sizeof(frame));
+    if (radio.transmit(downlink, frame, size, now_us)) {
+      downlink_seq++;
+      receiver.ack_sent();
+      if (telemetry_due) {
+        next_telemetry_us = now_us + TELEMETRY_PERIOD_US;
+      }
+    }
+  }
+};
+
+struct Ground {
+  Radio radio;
+  CommandSender sender;
+
+  explicit Ground(const CommandLinkConfig& config) : sender(config, NODE, SESSION) {}
+
+  void step(SimChannel& uplink, SimChannel& downlink, uint64_t now_us) {
+    std::vector<uint8_t> packet;
+    while (downlink.receive(now_us, &packet)) {
+      Frame frame;
+      if (decode_frame(packet.data(), packet.size(), &frame) ==
+          FrameError::kOk) {
+        sender.on_downlink(frame, now_us);
+      }
+    }
+
+    if (now_us < radio.busy_until_us) {
+      return;
+    }
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t size = sender.poll(now_us, frame, sizeof(frame));
+    if (size > 0) {
+      radio.transmit(uplink, frame, size, now_us);
+    }
+  }
+};
+
+CommandLinkConfig link_config(uint8_t max_retries) {
+  return {
+      .retransmit_timeout_us =
+          command_round_trip_us(MODULATION, TURNAROUND_US) + 5000,
+      .max_retries = max_retries,
+  };
+}
+
+}  // namespace
+
+TEST_CASE("LoRa time on air matches the datasheet formula", "[airtime]") {
+  // SF7, 125 kHz, 4/5, 8 symbol preamble, explicit header, CRC on:
+  // 12.25 preamble + 8 + 4 * 5 payload symbols of 1.024 ms each.
+  REQUIRE(lora_time_on_air_us(MODULATION, 10) == 41216);
+  REQUIRE(lora_bandwidth_hz(0x04) == 125000);
+}
+
+TEST_CASE("Frames round trip and reject corruption", "[frame]") {
+  const uint8_t body[] = {1, 2, 3, 4, 5};
+  const AckField ack = {.seq = 42, .bitmap = 0x80000001, .refused = 0x5};
+  uint8_t buf[FRAME_MAX_SIZE];
+  size_t size =
+      encode_telemetry_frame(NODE, 7, ack, body, sizeof(body), buf,
+                             sizeof(buf));
+  REQUIRE(size == sizeof(body) + ACK_FIELD_SIZE + FRAME_OVERHEAD);
+
+  Frame frame;
+  REQUIRE(decode_frame(buf, size, &frame) == FrameError::kOk);
+  REQUIRE(frame.type == FrameType::kTelemetry);
+  REQUIRE(frame.node == NODE);
+  REQUIRE(frame.seq == 7);
+  AckField decoded;
+  REQUIRE(decode_ack(frame, &decoded));
+  REQUIRE(decoded.seq == 42);
+  REQUIRE(decoded.bitmap == 0x80000001);
+  REQUIRE(decoded.refused == 0x5);
+
+  buf[FRAME_HEADER_SIZE + 3] ^= 0x10;
+  REQUIRE(decode_frame(buf, size, &frame) == FrameError::kBadCrc);
+  REQUIRE(decode_frame(buf, size - 1, &frame) == FrameError::kBadLength);
+}
+
+TEST_CASE("Receiver acknowledges out of order sequence numbers selectively",
+          "[command]") {
+  CommandSender sender(link_config(3), NODE, SESSION);
+  CommandReceiver receiver(NODE);
+  for (uint16_t id = 1; id <= 3; id++) {
+    REQUIRE(sender.send({.id = id, .type = CommandType::kArm, .arg = 0}));
+  }
+  uint8_t frames[3][FRAME_MAX_SIZE];
+  size_t sizes[3];
+  for (int i = 0; i < 3; i++) {
+    sizes[i] = sender.poll(0, frames[i], FRAME_MAX_SIZE);
+    REQUIRE(sizes[i] == COMMAND_FRAME_SIZE);
+  }
+
+  // The second command is lost.
+  Command command;
+  REQUIRE(receiver.on_packet(frames[2], sizes[2], &command) ==
+          CommandResult::kExecute);
+  REQUIRE(receiver.on_packet(frames[0], sizes[0], &command) ==
+          CommandResult::kExecute);
+  REQUIRE(receiver.ack().seq == 3);
+  REQUIRE(receiver.ack().bitmap == 0b10);
+
+  sender.on_ack(receiver.ack(), 1000);
+  REQUIRE(sender.in_flight() == 1);
+  REQUIRE(sender.stats().commands_acked == 2);
+}
+
+TEST_CASE("Receiver does not execute a command id twice", "[command]") {
+  CommandSender sender(link_config(3), NODE, SESSION);
+  CommandReceiver receiver(NODE);
+  REQUIRE(sender.send({.id = 9, .type = CommandType::kOpenValve, .arg = 2}));
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t size = sender.poll(0, frame, sizeof(frame));
+
+  Command command;
+  REQUIRE(receiver.on_packet(frame, size, &command) ==
+          CommandResult::kExecute);
+  REQUIRE(command.type == CommandType::kOpenValve);
+  REQUIRE(command.arg == 2);
+  receiver.ack_sent();
+
+  // Retransmission after a lost acknowledgement.
+  size = sender.poll(link_config(3).retransmit_timeout_us, frame,
+                     sizeof(frame));
+  REQUIRE(sender.stats().retransmissions == 1);
+  REQUIRE(receiver.on_packet(frame, size, &command) ==
+          CommandResult::kDuplicate);
+  REQUIRE(receiver.ack_pending());
+
+  frame[FRAME_HEADER_SIZE] ^= 0xFF;
+  REQUIRE(receiver.on_packet(frame, size, &command) ==
+          CommandResult::kInvalid);
+}
+
+TEST_CASE("A restarted sender's commands run despite reused ids",
+          "[command]") {
+  CommandReceiver receiver(NODE);
+  Command command;
+  uint8_t frame[FRAME_MAX_SIZE];
+  {
+    CommandSender sender(link_config(3), NODE, SESSION);
+    for (uint16_t id = 1; id <= 5; id++) {
+      REQUIRE(sender.send({.id = id, .type = CommandType::kMark, .arg = 0}));
+      size_t size = sender.poll(0, frame, sizeof(frame));
+      REQUIRE(receiver.on_packet(frame, size, &command) ==
+              CommandResult::kExecute);
+    }
+    REQUIRE(receiver.ack().seq == 5);
+  }
+
+  // The ground station restarts: sequence numbers and ids start over.
+  CommandSender restarted(link_config(3), NODE, SESSION + 1);
+  REQUIRE(restarted.send({.id = 1, .type = CommandType::kAbort, .arg = 0}));
+  size_t size = restarted.poll(0, frame, sizeof(frame));
+  REQUIRE(receiver.on_packet(frame, size, &command) ==
+          CommandResult::kExecute);
+  REQUIRE(command.type == CommandType::kAbort);
+  REQUIRE(receiver.stats().sessions == 2);
+  REQUIRE(receiver.ack().seq == 1);
+  REQUIRE(receiver.ack().bitmap == 0);
+
+  restarted.on_ack(receiver.ack(), 1000);
+  REQUIRE(restarted.in_flight() == 0);
+  CommandOutcome outcome;
+  REQUIRE(restarted.pop_outcome(&outcome));
+  REQUIRE(outcome.status == CommandStatus::kExecuted);
+
+  // Within the session ids are still executed once.
+  size = restarted.poll(link_config(3).retransmit_timeout_us, frame,
+                        sizeof(frame));
+  REQUIRE(size == 0);
+  REQUIRE(restarted.send({.id = 1, .type = CommandType::kAbort, .arg = 0}));
+  size = restarted.poll(2000, frame, sizeof(frame));
+  REQUIRE(receiver.on_packet(frame, size, &command) ==
+          CommandResult::kDuplicate);
+}
+
+TEST_CASE("A refused command is acknowledged as refused", "[command]") {
+  CommandSender sender(link_config(3), NODE, SESSION);
+  CommandReceiver receiver(NODE);
+  REQUIRE(sender.send({.id = 1, .type = CommandType::kArm, .arg = 0}));
+  REQUIRE(sender.send({.id = 2, .type = CommandType::kOpenValve, .arg = 1}));
+  uint8_t frames[2][FRAME_MAX_SIZE];
+  size_t sizes[2];
+  for (int i = 0; i < 2; i++) {
+    sizes[i] = sender.poll(0, frames[i], FRAME_MAX_SIZE);
+  }
+
+  // Armed, the board refuses the valve command.
+  Command command;
+  REQUIRE(receiver.on_packet(frames[0], sizes[0], &command) ==
+          CommandResult::kExecute);
+  REQUIRE(receiver.on_packet(frames[1], sizes[1], &command) ==
+          CommandResult::kExecute);
+  receiver.refuse();
+  REQUIRE(receiver.stats().refused == 1);
+  REQUIRE(receiver.ack().refused == 0b1);
+
+  // The retransmission of a refused command is refused again.
+  sizes[1] = sender.poll(link_config(3).retransmit_timeout_us, frames[1],
+                         FRAME_MAX_SIZE);
+  REQUIRE(receiver.on_packet(frames[1], sizes[1], &command) ==
+          CommandResult::kDuplicate);
+  REQUIRE(receiver.ack().refused == 0b1);
+
+  uint8_t ack[FRAME_MAX_SIZE];
+  size_t ack_size = encode_ack_frame(NODE, 1, receiver.ack(), ack, sizeof(ack));
+  Frame frame;
+  REQUIRE(decode_frame(ack, ack_size, &frame) == FrameError::kOk);
+  sender.on_downlink(frame, 1000);
+  REQUIRE(sender.in_flight() == 0);
+  REQUIRE(sender.stats().commands_acked == 2);
+  REQUIRE(sender.stats().commands_refused == 1);
+
+  CommandOutcome outcome;
+  REQUIRE(sender.pop_outcome(&outcome));
+  REQUIRE(outcome.command.id == 1);
+  REQUIRE(outcome.status == CommandStatus::kExecuted);
+  REQUIRE(sender.pop_outcome(&outcome));
+  REQUIRE(outcome.command.id == 2);
+  REQUIRE(outcome.status == CommandStatus::kRefused);
+  REQUIRE(outcome.latency_us == 1000);
+  REQUIRE_FALSE(sender.pop_outcome(&outcome));
+
+  // Newer commands move the refusal along with the sequence numbers.
+  REQUIRE(sender.send({.id = 3, .type = CommandType::kDisarm, .arg = 0}));
+  size_t size = sender.poll(2000, frames[0], FRAME_MAX_SIZE);
+  REQUIRE(receiver.on_packet(frames[0], size, &command) ==
+          CommandResult::kExecute);
+  REQUIRE(receiver.ack().seq == 3);
+  REQUIRE(receiver.ack().refused == 0b10);
+  sender.on_ack(receiver.ack(), 3000);
+  REQUIRE(sender.pop_outcome(&outcome));
+  REQUIRE(outcome.command.id == 3);
+  REQUIRE(outcome.status == CommandStatus::kExecuted);
+}
+
+TEST_CASE("Each node has its own sequence space", "[command]") {
+  CommandSender to_node_1(link_config(3), 1, SESSION);
+  CommandSender to_node_2(link_config(3), 2, SESSION);
+  CommandReceiver node_1(1);
+  CommandReceiver node_2(2);
+  REQUIRE(to_node_1.send({.id = 1, .type = CommandType::kArm, .arg = 0}));
+  REQUIRE(to_node_2.send({.id = 1, .type = CommandType::kArm, .arg = 0}));
+  uint8_t frame_1[FRAME_MAX_SIZE];
+  uint8_t frame_2[FRAME_MAX_SIZE];
+  size_t size_1 = to_node_1.poll(0, frame_1, sizeof(frame_1));
+  size_t size_2 = to_node_2.poll(0, frame_2, sizeof(frame_2));
+
+  // Both boards hear both frames but only execute their own.
+  Command command;
+  REQUIRE(node_1.on_packet(frame_2, size_2, &command) ==
+          CommandResult::kOtherNode);
+  REQUIRE(node_1.on_packet(frame_1, size_1, &command) ==
+          CommandResult::kExecute);
+  REQUIRE(node_2.on_packet(frame_2, size_2, &command) ==
+          CommandResult::kExecute);
+  REQUIRE(node_2.ack_pending());
+  REQUIRE(node_1.stats().other_node == 1);
+
+  // Both used sequence number 1; node 1's acknowledgement must not complete
+  // the command to node 2.
+  uint8_t ack[FRAME_MAX_SIZE];
+  size_t ack_size = encode_ack_frame(1, 1, node_1.ack(), ack, sizeof(ack));
+  Frame frame;
+  REQUIRE(decode_frame(ack, ack_size, &frame) == FrameError::kOk);
+  to_node_1.on_downlink(frame, 1000);
+  to_node_2.on_downlink(frame, 1000);
+  REQUIRE(to_node_1.in_flight() == 0);
+  REQUIRE(to_node_2.in_flight() == 1);
+}
+
+TEST_CASE("Command round trip on a clean link is one command plus one ack",
+          "[command][sim]") {
+  SimChannel uplink(0.0, 1);
+  SimChannel downlink(0.0, 2);
+  Board board;
+  Ground ground(link_config(3));
+  // Start between telemetry frames so the ack can't ride on one.
+  board.next_telemetry_us = 10 * 1000 * 1000;
+
+  REQUIRE(ground.sender.send({.id = 1, .type = CommandType::kArm, .arg = 0}));
+  for (uint64_t now = 0; now < 1000 * 1000; now += STEP_US) {
+    ground.step(uplink, downlink, now);
+    board.step(uplink, downlink, now);
+  }
+
+  const CommandLinkStats& stats = ground.sender.stats();
+  REQUIRE(board.executed.size() == 1);
+  REQUIRE(stats.commands_acked == 1);
+  REQUIRE(stats.retransmissions == 0);
+  const uint32_t ideal_us = command_round_trip_us(MODULATION, 0);
+  REQUIRE(stats.latency_max_us >= ideal_us);
+  REQUIRE(stats.latency_max_us <= ideal_us + 2 * STEP_US);
+}
+
+TEST_CASE("Lossy link executes every acknowledged command exactly once",
+          "[command][sim]") {
+  constexpr int kCommands = 200;
+  SimChannel uplink(0.3, 3);
+  SimChannel downlink(0.3, 4);
+  Board board;
+  Ground ground(link_config(10));
+
+  uint16_t next_id = 1;
+  uint64_t now = 0;
+  while (now < 600ull * 1000 * 1000 &&
+         (next_id <= kCommands || ground.sender.in_flight() > 0)) {
+    if (next_id <= kCommands &&
+        ground.sender.send(
+            {.id = next_id, .type = CommandType::kOpenValve, .arg = 0})) {
+      next_id++;
+    }
+    ground.step(uplink, downlink, now);
+    board.step(uplink, downlink, now);
+    now += STEP_US;
+  }
+
+  const CommandLinkStats& stats = ground.sender.stats();
+  REQUIRE(stats.commands_sent == kCommands);
+  REQUIRE(stats.commands_acked + stats.commands_lost == kCommands);
+  REQUIRE(stats.retransmissions > 0);
+  INFO("lost: " << stats.commands_lost
+                << ", retransmissions: " << stats.retransmissions
+                << ", mean latency: " << stats.latency_mean_us() << " us");
+  REQUIRE(stats.loss_rate() < 0.01f);
+
+  std::set<uint16_t> ids;
+  for (const Command& command : board.executed) {
+    REQUIRE(ids.insert(command.id).second);
+  }
+  REQUIRE(ids.size() >= stats.commands_acked);
+}
+
+TEST_CASE("Commands are declared lost after max retries", "[command][sim]") {
+  SimChannel uplink(1.0, 5);
+  SimChannel downlink(0.0, 6);
+  Board board;
+  Ground ground(link_config(2));
+
+  REQUIRE(ground.sender.send({.id = 1, .type = CommandType::kAbort, .arg = 0}));
+  for (uint64_t now = 0; now < 2 * 1000 * 1000; now += STEP_US) {
+    ground.step(uplink, downlink, now);
+    board.step(uplink, downlink, now);
+  }
+
+  const CommandLinkStats& stats = ground.sender.stats();
+  REQUIRE(stats.transmissions == 3);
+  REQUIRE(stats.commands_lost == 1);
+  REQUIRE(stats.loss_rate() == 1.0f);
+  REQUIRE(ground.sender.in_flight() == 0);
+  CommandOutcome outcome;
+  REQUIRE(ground.sender.pop_outcome(&outcome));
+  REQUIRE(outcome.status == CommandStatus::kLost);
+}
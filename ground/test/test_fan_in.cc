@@ -0,0 +1,201 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "board_sim.h"
+#include "fan_in.h"
+#include "telemetry/frame.h"
+
+namespace {
+
+constexpr uint64_t SAMPLE_PERIOD_US = 1000;
+constexpr uint64_t FRAME_PERIOD_US = 50 * 1000;
+constexpr uint64_t MAX_DELAY_US = 30 * 1000;
+constexpr uint64_t REORDER_WINDOW_US = 100 * 1000;
+constexpr uint64_t DURATION_US = 10ull * 1000 * 1000;
+
+struct Arrival {
+  uint64_t rx_us;
+  std::vector<uint8_t> data;
+};
+
+}  // namespace
+
+TEST_CASE("Fan-in merges several boards into one time-ordered feed",
+          "[fan_in]") {
+  constexpr int kNodes = 4;
+  std::mt19937 rng(5);
+  std::vector<SimulatedBoard> boards;
+  for (int i = 0; i < kNodes; i++) {
+    // Boards booted at different times, so their clocks disagree.
+    boards.emplace_back(10 + i, i * 3700000);
+  }
+
+  // Frames leave every board at its own phase, arrive after a random delay
+  // and are occasionally lost.
+  std::vector<Arrival> arrivals;
+  std::vector<uint32_t> sent(kNodes);
+  std::vector<uint32_t> dropped(kNodes);
+  for (uint64_t now_us = 0; now_us < DURATION_US; now_us += SAMPLE_PERIOD_US) {
+    for (int i = 0; i < kNodes; i++) {
+      boards[i].sample(now_us);
+      if ((now_us + i * 13000) % FRAME_PERIOD_US != 0) {
+        continue;
+      }
+      uint8_t frame[FRAME_MAX_SIZE];
+      size_t size = boards[i].frame(now_us, frame, sizeof(frame));
+      REQUIRE(size > 0);
+      sent[i]++;
+      if (std::uniform_int_distribution<int>(0, 49)(rng) == 0) {
+        dropped[i]++;
+        continue;
+      }
+      uint64_t delay_us =
+          std::uniform_int_distribution<uint64_t>(0, MAX_DELAY_US)(rng);
+      arrivals.push_back({now_us + delay_us,
+                          std::vector<uint8_t>(frame, frame + size)});
+    }
+  }
+  std::stable_sort(arrivals.begin(), arrivals.end(),
+                   [](const Arrival& a, const Arrival& b) {
+                     return a.rx_us < b.rx_us;
+                   });
+
+  FanIn fan_in(REORDER_WINDOW_US);
+  std::vector<MergedSample> feed;
+  for (const Arrival& arrival : arrivals) {
+    Frame frame;
+    REQUIRE(decode_frame(arrival.data.data(), arrival.data.size(), &frame) ==
+            FrameError::kOk);
+    fan_in.on_frame(frame, arrival.rx_us);
+    fan_in.drain(arrival.rx_us, &feed);
+  }
+  fan_in.flush(&feed);
+
+  REQUIRE(std::is_sorted(feed.begin(), feed.end(),
+                         [](const MergedSample& a, const MergedSample& b) {
+                           return a.t_us < b.t_us;
+                         }));
+  size_t total = 0;
+  for (int i = 0; i < kNodes; i++) {
+    const NodeStats& stats = fan_in.node(10 + i);
+    INFO("node " << 10 + i);
+    REQUIRE(stats.frames == sent[i] - dropped[i]);
+    REQUIRE(stats.lost == dropped[i]);
+    REQUIRE(stats.late == 0);
+    REQUIRE(stats.samples == stats.frames * BOARD_SIM_CHANNELS);
+    // The offset estimate is off by at most the smallest delay seen.
+    REQUIRE(stats.offset_us >= -i * 3700000);
+    REQUIRE(stats.offset_us <= -i * 3700000 + 1000);
+    total += stats.samples;
+  }
+  REQUIRE(feed.size() == total);
+}
+
+TEST_CASE("Fan-in drops duplicate and stale frames",
+          "[fan_in]") {
+  SimulatedBoard board(1, 0);
+  uint8_t frames[2][FRAME_MAX_SIZE];
+  size_t sizes[2];
+  for (int i = 0; i < 2; i++) {
+    uint64_t now_us = i * FRAME_PERIOD_US;
+    board.sample(now_us);
+    sizes[i] = board.frame(now_us, frames[i], FRAME_MAX_SIZE);
+  }
+
+  FanIn fan_in(REORDER_WINDOW_US);
+  std::vector<MergedSample> feed;
+  Frame frame;
+  REQUIRE(decode_frame(frames[1], sizes[1], &frame) == FrameError::kOk);
+  REQUIRE(fan_in.on_frame(frame, FRAME_PERIOD_US));
+  REQUIRE_FALSE(fan_in.on_frame(frame, FRAME_PERIOD_US));
+  REQUIRE(fan_in.node(1).duplicates == 1);
+  fan_in.drain(FRAME_PERIOD_US + REORDER_WINDOW_US, &feed);
+  REQUIRE(feed.size() == BOARD_SIM_CHANNELS);
+
+  // A single link never reorders a node's frames, so an older sequence number
+  // is a stale copy.
+  REQUIRE(decode_frame(frames[0], sizes[0], &frame) == FrameError::kOk);
+  REQUIRE_FALSE(fan_in.on_frame(frame, 2 * REORDER_WINDOW_US));
+  REQUIRE(fan_in.node(1).duplicates == 2);
+}
+
+TEST_CASE("Fan-in starts a node over when its board restarts", "[fan_in]") {
+  // Booted 20 s before the ground station, then restarted 5 s in.
+  constexpr uint64_t kRestartUs = 5ull * 1000 * 1000;
+  SimulatedBoard before(1, 20ull * 1000 * 1000);
+  SimulatedBoard after(1, 0);
+
+  FanIn fan_in(REORDER_WINDOW_US);
+  std::vector<MergedSample> feed;
+  for (uint64_t now_us = 0; now_us < 2 * kRestartUs;
+       now_us += SAMPLE_PERIOD_US) {
+    SimulatedBoard& board = now_us < kRestartUs ? before : after;
+    board.sample(now_us);
+    if (now_us % FRAME_PERIOD_US != 0) {
+      continue;
+    }
+    uint8_t data[FRAME_MAX_SIZE];
+    size_t size = board.frame(now_us, data, sizeof(data));
+    Frame frame;
+    REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+    // Its sequence numbers start over well within kRestartSeqGap, so only
+    // the clock gives the restart away.
+    REQUIRE(fan_in.on_frame(frame, now_us + 1000));
+    fan_in.drain(now_us, &feed);
+  }
+  fan_in.flush(&feed);
+
+  const NodeStats& stats = fan_in.node(1);
+  REQUIRE(stats.restarts == 1);
+  REQUIRE(stats.duplicates == 0);
+  REQUIRE(stats.lost == 0);
+  REQUIRE(stats.late == 0);
+  REQUIRE(stats.frames == 2 * kRestartUs / FRAME_PERIOD_US);
+  // The offset was learned again from the restarted clock.
+  REQUIRE(stats.offset_us == 1000);
+  REQUIRE(feed.size() == stats.samples);
+}
+
+TEST_CASE("Fan-in sees a restart whose sequence numbers land just ahead",
+          "[fan_in]") {
+  constexpr uint64_t kRestartUs = 5ull * 1000 * 1000;
+  constexpr uint64_t kFramesBefore = kRestartUs / FRAME_PERIOD_US;
+  SimulatedBoard before(1, 20ull * 1000 * 1000);
+  SimulatedBoard after(1, 0);
+
+  FanIn fan_in(REORDER_WINDOW_US);
+  std::vector<MergedSample> feed;
+  uint64_t frames = 0;
+  for (uint64_t now_us = 0; now_us < 2 * kRestartUs;
+       now_us += SAMPLE_PERIOD_US) {
+    SimulatedBoard& board = now_us < kRestartUs ? before : after;
+    board.sample(now_us);
+    if (now_us % FRAME_PERIOD_US != 0) {
+      continue;
+    }
+    uint8_t data[FRAME_MAX_SIZE];
+    size_t size = board.frame(now_us, data, sizeof(data));
+    Frame frame;
+    REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+    // The board had almost wrapped its sequence numbers when it restarted,
+    // so its first frame after, seq 1, is 3 ahead of its last before.
+    if (frames < kFramesBefore) {
+      frame.seq = static_cast<uint16_t>(0xFFFE - (kFramesBefore - 1) + frames);
+    }
+    frames++;
+    REQUIRE(fan_in.on_frame(frame, now_us + 1000));
+    fan_in.drain(now_us, &feed);
+  }
+  fan_in.flush(&feed);
+
+  const NodeStats& stats = fan_in.node(1);
+  REQUIRE(stats.restarts == 1);
+  REQUIRE(stats.duplicates == 0);
+  REQUIRE(stats.lost == 0);
+  REQUIRE(stats.frames == frames);
+  REQUIRE(stats.offset_us == 1000);
+}
@@ -0,0 +1,141 @@
+#include <catch2/catch.hpp>
+
+#include "sim/feed_plant.h"
+
+namespace {
+
+constexpr double PA_PER_PSI = 6894.757293168;
+
+// pressure_drop.py's GOX case: 72 F.
+constexpr double GOX_K = 295.372;
+
+FeedPlantState run(FeedPlant* plant, double seconds) {
+  plant->step(seconds);
+  return plant->state();
+}
+
+}  // namespace
+
+TEST_CASE("Feed plant relations match simulation_and_calculations") {
+  // The GOX ball valve at the design flow: 345.48 psia in for 322.31 out,
+  // with Q in standard ft^3/h.
+  CHECK(gas_valve_flow_kg_s(1.5, OXYGEN, GOX_K, 345.4813, 322.3056) ==
+        Approx(0.0787088).epsilon(1e-4));
+  CHECK(gas_valve_flow_kg_s(1.5, OXYGEN, GOX_K, 322.3056, 345.4813) ==
+        Approx(-0.0787088).epsilon(1e-4));
+  // Choked below half the inlet pressure.
+  CHECK(gas_valve_flow_kg_s(1.5, OXYGEN, GOX_K, 500, 100) ==
+        gas_valve_flow_kg_s(1.5, OXYGEN, GOX_K, 500, 250));
+  CHECK(gas_valve_flow_kg_s(0, OXYGEN, GOX_K, 500, 100) == 0);
+
+  // The ethanol system Cv of 0.404 at 0.0656 kg/s: 8.37 psi at SG 0.787.
+  CHECK(liquid_valve_dp_psi(0.404, 789, 0.0655907) ==
+        Approx(8.37).epsilon(0.01));
+
+  // Orifices sized by coaxial_injector_orifice_sizing.py: 25 to 20 bar of GOX
+  // at 300 K, and 1.4 bar of ethanol.
+  CHECK(gas_orifice_flow_kg_s(2.23972e-5, 0.7, OXYGEN, 300, 25e5, 20e5) ==
+        Approx(0.0787088).epsilon(1e-4));
+  const double choked =
+      gas_orifice_flow_kg_s(2.23972e-5, 0.7, OXYGEN, 300, 25e5, 10e5);
+  CHECK(choked == Approx(0.0961265).epsilon(1e-4));
+  CHECK(gas_orifice_flow_kg_s(2.23972e-5, 0.7, OXYGEN, 300, 25e5, 1e5) ==
+        choked);
+  CHECK(liquid_orifice_flow_kg_s(6.30415e-6, 0.7, 789, 1.4e5) ==
+        Approx(0.0655907).epsilon(1e-4));
+  CHECK(liquid_orifice_flow_kg_s(6.30415e-6, 0.7, 789, -1) == 0);
+}
+
+TEST_CASE("Feed plant holds still with its valves closed") {
+  FeedPlantConfig config;
+  FeedPlant plant(config);
+  FeedPlantState state = run(&plant, 1);
+  CHECK(state.t_s == Approx(1));
+  CHECK(state.gox_flow_kg_s == 0);
+  CHECK(state.fuel_flow_kg_s == 0);
+  CHECK(state.thrust_n == 0);
+  CHECK_FALSE(state.ignited);
+  CHECK(plant.pressure_psig(PlantPt::kChamber) == Approx(0).margin(1e-9));
+  CHECK(plant.pressure_psig(PlantPt::kGoxLine) ==
+        Approx(config.gox_regulator_psia - config.ambient_psia));
+  CHECK(plant.pressure_psig(PlantPt::kGoxReg) ==
+        Approx(config.gox_bottle_psia - config.ambient_psia));
+  CHECK(plant.pressure_psig(PlantPt::kEthLine) == Approx(0).margin(1e-9));
+  CHECK(state.fuel_liters == Approx(config.fuel_liters));
+}
+
+TEST_CASE("Feed plant pressurizes the fuel tank to the regulator") {
+  FeedPlantConfig config;
+  FeedPlant plant(config);
+  plant.set_valve(PlantValve::kPressurizeFuelTank, 1);
+  run(&plant, 0.1);
+  // Still on its way, through the valve's stroke.
+  CHECK(plant.pressure_psig(PlantPt::kEthLine) <
+        config.fuel_regulator_psia - config.ambient_psia - 10);
+  run(&plant, 2);
+  CHECK(plant.pressure_psig(PlantPt::kEthLine) ==
+        Approx(config.fuel_regulator_psia - config.ambient_psia).margin(2));
+  CHECK(plant.pressure_psig(PlantPt::kEthN2Reg) ==
+        Approx(plant.pressure_psig(PlantPt::kEthLine)).margin(1));
+}
+
+TEST_CASE("Feed plant burns near the design point once lit") {
+  FeedPlantConfig config;
+  FeedPlant plant(config);
+  plant.set_valve(PlantValve::kPressurizeFuelTank, 1);
+  run(&plant, 1);
+
+  // Cold flow: GOX alone doesn't light.
+  plant.set_igniter(true);
+  plant.set_valve(PlantValve::kGoxRelease, 1);
+  FeedPlantState state = run(&plant, 0.5);
+  CHECK_FALSE(state.ignited);
+  const double cold_psig = state.psig[static_cast<int>(PlantPt::kChamber)];
+  CHECK(cold_psig > 0);
+
+  plant.set_valve(PlantValve::kFuelRelease, 1);
+  state = run(&plant, 0.5);
+  REQUIRE(state.ignited);
+  const double chamber_pa =
+      (state.psig[static_cast<int>(PlantPt::kChamber)] + config.ambient_psia) *
+      PA_PER_PSI;
+  // Pc = mdot c* / At, near the 20 bar design.
+  CHECK(chamber_pa == Approx((state.gox_flow_kg_s + state.fuel_flow_kg_s) *
+                             config.c_star_m_s / config.throat_m2)
+                          .epsilon(0.01));
+  CHECK(chamber_pa == Approx(20e5).epsilon(0.1));
+  CHECK(state.gox_flow_kg_s == Approx(0.0787).epsilon(0.1));
+  CHECK(state.fuel_flow_kg_s == Approx(0.0656).epsilon(0.1));
+  CHECK(state.psig[static_cast<int>(PlantPt::kInjectorGox)] >
+        state.psig[static_cast<int>(PlantPt::kChamber)]);
+  CHECK(state.psig[static_cast<int>(PlantPt::kInjectorEth)] >
+        state.psig[static_cast<int>(PlantPt::kChamber)]);
+  CHECK(state.thrust_n ==
+        Approx(config.thrust_coefficient * (chamber_pa - 14.696 * PA_PER_PSI) *
+               config.throat_m2)
+            .epsilon(1e-6));
+  CHECK(state.fuel_liters < config.fuel_liters);
+
+  // Keeps burning without the igniter, until the fuel stops.
+  plant.set_igniter(false);
+  CHECK(run(&plant, 0.1).ignited);
+  plant.set_valve(PlantValve::kFuelRelease, 0);
+  state = run(&plant, 0.5);
+  CHECK_FALSE(state.ignited);
+  CHECK(state.fuel_flow_kg_s == 0);
+  CHECK(state.psig[static_cast<int>(PlantPt::kChamber)] ==
+        Approx(cold_psig).epsilon(0.05));
+}
+
+TEST_CASE("Feed plant purges the GOX manifold with N2") {
+  FeedPlantConfig config;
+  FeedPlant plant(config);
+  plant.set_valve(PlantValve::kN2PurgeGox, 1);
+  FeedPlantState state = run(&plant, 0.5);
+  CHECK(state.gox_flow_kg_s == 0);
+  CHECK(state.purge_flow_kg_s > 0);
+  CHECK(state.psig[static_cast<int>(PlantPt::kInjectorGox)] > 0);
+  CHECK(state.psig[static_cast<int>(PlantPt::kInjectorGox)] <
+        config.purge_psia - config.ambient_psia);
+  CHECK_FALSE(state.ignited);
+}
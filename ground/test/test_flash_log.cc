@@ -0,0 +1,206 @@
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "datalog/flash_log.h"
+#include "file_flash.h"
+
+namespace {
+
+constexpr uint32_t RECORDS = FLASH_LOG_RECORDS_PER_SECTOR;
+
+std::string fresh_image(const char* name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / (std::string(name) + ".bin");
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+LogRecord pt_record(uint64_t t_us, uint8_t pt, float psi) {
+  return {
+      .t_us = t_us,
+      .type = RecordType::kPt,
+      .id = pt,
+      .aux = 0,
+      .value = psi,
+  };
+}
+
+std::vector<LogRecord> read_all(FileFlash* flash, uint32_t session) {
+  std::vector<LogRecord> records;
+  read_flash_log(flash, [&](uint32_t record_session, const LogRecord& record) {
+    if (record_session == session) {
+      records.push_back(record);
+    }
+  });
+  return records;
+}
+
+}  // namespace
+
+TEST_CASE("Flash log writes whole sectors and reads back in order",
+          "[flash_log]") {
+  FileFlash flash(fresh_image("flash_log_order"), 16 * FLASH_SECTOR_SIZE);
+  REQUIRE(flash.ok());
+  FlashLog log(&flash);
+  REQUIRE(log.open());
+  REQUIRE(log.session() == 1);
+
+  const uint32_t count = 3 * RECORDS + 10;
+  for (uint32_t i = 0; i < count; i++) {
+    REQUIRE(log.append(pt_record(i, i % 7, i * 0.5f)));
+    while (log.service()) {
+    }
+  }
+  REQUIRE(log.stats().sectors_written == 3);
+  log.flush();
+  REQUIRE(log.service());
+
+  FlashLogStats stats = log.stats();
+  REQUIRE(stats.records == count);
+  REQUIRE(stats.dropped == 0);
+  REQUIRE(stats.padding == RECORDS - 10);
+  REQUIRE(log.bytes_written() == 4 * FLASH_SECTOR_SIZE);
+  REQUIRE(flash.unerased_writes() == 0);
+
+  std::vector<LogRecord> records = read_all(&flash, 1);
+  REQUIRE(records.size() == count);
+  for (uint32_t i = 0; i < count; i++) {
+    REQUIRE(records[i].t_us == i);
+    REQUIRE(records[i].type == RecordType::kPt);
+    REQUIRE(records[i].value == i * 0.5f);
+  }
+}
+
+TEST_CASE("Flash log drops instead of blocking when the writer stalls",
+          "[flash_log]") {
+  FileFlash flash(fresh_image("flash_log_stall"), 16 * FLASH_SECTOR_SIZE);
+  FlashLog log(&flash);
+  REQUIRE(log.open());
+
+  for (uint32_t i = 0; i < 3 * RECORDS; i++) {
+    log.append(pt_record(i, 0, 0));
+  }
+  FlashLogStats stats = log.stats();
+  REQUIRE(stats.records == 2 * RECORDS);
+  REQUIRE(stats.dropped == RECORDS);
+  REQUIRE(stats.high_water == 2 * RECORDS);
+
+  // Writing one buffer frees it for producers again.
+  REQUIRE(log.service());
+  REQUIRE(log.append(pt_record(0, 0, 0)));
+}
+
+TEST_CASE("Flash log counts retried records as dropped only when given up",
+          "[flash_log]") {
+  FileFlash flash(fresh_image("flash_log_retry"), 16 * FLASH_SECTOR_SIZE);
+  FlashLog log(&flash);
+  REQUIRE(log.open());
+
+  for (uint32_t i = 0; i < 2 * RECORDS; i++) {
+    REQUIRE(log.append(pt_record(i, 0, 0)));
+  }
+  REQUIRE_FALSE(log.try_append(pt_record(0, 0, 0)));
+  REQUIRE_FALSE(log.try_append(pt_record(0, 0, 0)));
+  CHECK(log.stats().dropped == 0);
+  REQUIRE(log.service());
+  REQUIRE(log.try_append(pt_record(0, 0, 0)));
+
+  // Closed until open(): a caller gives up and drops once.
+  FlashLog closed(&flash);
+  REQUIRE_FALSE(closed.try_append(pt_record(0, 0, 0)));
+  REQUIRE_FALSE(closed.service());
+  closed.drop();
+  CHECK(closed.stats().dropped == 1);
+}
+
+TEST_CASE("Flash log sessions append after each other until full",
+          "[flash_log]") {
+  std::string path = fresh_image("flash_log_sessions");
+  {
+    FileFlash flash(path, 4 * FLASH_SECTOR_SIZE);
+    FlashLog log(&flash);
+    REQUIRE(log.open());
+    for (uint32_t i = 0; i < RECORDS + 1; i++) {
+      log.append(pt_record(i, 1, 1));
+    }
+    log.flush();
+    while (log.service()) {
+    }
+  }
+
+  // A reboot: the next session starts after the two sectors in flash.
+  FileFlash flash(path, 4 * FLASH_SECTOR_SIZE);
+  FlashLog log(&flash);
+  REQUIRE(log.open());
+  REQUIRE(log.session() == 2);
+  for (uint32_t i = 0; i < 3 * RECORDS; i++) {
+    log.append(pt_record(i, 2, 2));
+    while (log.service()) {
+    }
+  }
+  REQUIRE(log.stats().full);
+  REQUIRE(log.stats().records == 2 * RECORDS);
+  REQUIRE(read_all(&flash, 1).size() == RECORDS + 1);
+  REQUIRE(read_all(&flash, 2).size() == 2 * RECORDS);
+
+  REQUIRE(log.erase_all() == EraseResult::kErased);
+  REQUIRE(log.session() == 1);
+  REQUIRE_FALSE(log.stats().full);
+  REQUIRE(read_all(&flash, 1).empty());
+}
+
+TEST_CASE("Flash log takes records from several producer threads",
+          "[flash_log]") {
+  FileFlash flash(fresh_image("flash_log_threads"), 256 * FLASH_SECTOR_SIZE);
+  FlashLog log(&flash);
+  REQUIRE(log.open());
+
+  constexpr int kProducers = 3;
+  constexpr uint32_t kPerProducer = 15000;
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    while (!done) {
+      if (!log.service()) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; p++) {
+    producers.emplace_back([&log, p] {
+      for (uint32_t i = 0; i < kPerProducer; i++) {
+        log.append(pt_record(i, p, 0));
+        if (i % 64 == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  done = true;
+  writer.join();
+  log.flush();
+  while (log.service()) {
+  }
+
+  FlashLogStats stats = log.stats();
+  REQUIRE(stats.records + stats.dropped == kProducers * kPerProducer);
+  REQUIRE(stats.write_errors == 0);
+
+  // Every accepted record is in flash, in order for each producer.
+  std::vector<LogRecord> records = read_all(&flash, 1);
+  REQUIRE(records.size() == stats.records);
+  std::vector<int64_t> last(kProducers, -1);
+  for (const LogRecord& record : records) {
+    REQUIRE(record.id < kProducers);
+    REQUIRE(static_cast<int64_t>(record.t_us) > last[record.id]);
+    last[record.id] = record.t_us;
+  }
+}
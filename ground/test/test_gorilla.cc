@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "compress/gorilla.h"
+#include "series_codec.h"
+
+namespace {
+
+bool same_bits(float a, float b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+
+// A chamber PT as read_pt() returns it: whole psi from a 12-bit ADC, sampled
+// at 1 kHz by a task that wakes a few microseconds late.
+void pt_capture(size_t count, std::vector<uint64_t>* t_us,
+                std::vector<float>* values) {
+  std::mt19937 rng(3);
+  std::uniform_int_distribution<int> jitter(-15, 15);
+  std::uniform_int_distribution<int> noise(-1, 1);
+  for (size_t i = 0; i < count; i++) {
+    float psi = 300 * (1 - std::exp(-static_cast<float>(i) / 2000));
+    int code = 410 + static_cast<int>(psi / 1000 * 3277) + noise(rng);
+    float volts = code * 5.0f / 4096;
+    t_us->push_back(1000000 + i * 1000 + jitter(rng));
+    values->push_back(static_cast<uint16_t>(
+        std::max(0.0f, volts - 0.5f) / 4.0f * 1000));
+  }
+}
+
+}  // namespace
+
+TEST_CASE("Gorilla blocks round trip bit-exact", "[compress]") {
+  std::mt19937 rng(11);
+  std::vector<uint64_t> t_us;
+  std::vector<float> values;
+  uint64_t t = 0;
+  for (int i = 0; i < 5000; i++) {
+    // Regular intervals, jitter, gaps and the odd step backwards.
+    switch (rng() % 5) {
+      case 0:
+        t += 1000;
+        break;
+      case 1:
+        t += 1000 + rng() % 100;
+        break;
+      case 2:
+        t += rng() % 100000;
+        break;
+      case 3:
+        t += uint64_t{rng()} << 20;
+        break;
+      default:
+        t -= rng() % 50;
+        break;
+    }
+    uint32_t bits = rng();
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    t_us.push_back(t);
+    // Mix repeated, nearby and arbitrary (including NaN) values.
+    values.push_back(i % 3 == 0 && i > 0 ? values.back()
+                     : i % 3 == 1       ? std::nextafter(values.back(), 0.0f)
+                                        : value);
+  }
+
+  uint8_t block[256];
+  GorillaEncoder encoder(block, sizeof(block));
+  size_t next = 0;
+  while (next < t_us.size()) {
+    size_t first = next;
+    while (next < t_us.size() && encoder.append(t_us[next], values[next])) {
+      next++;
+    }
+    REQUIRE(next > first);
+    size_t size = encoder.finish();
+    REQUIRE(size <= sizeof(block));
+    REQUIRE(encoder.count() == next - first);
+
+    GorillaDecoder decoder(block, size);
+    REQUIRE(decoder.count() == next - first);
+    uint64_t decoded_t;
+    float decoded_value;
+    for (size_t i = first; i < next; i++) {
+      REQUIRE(decoder.next(&decoded_t, &decoded_value));
+      REQUIRE(decoded_t == t_us[i]);
+      REQUIRE(same_bits(decoded_value, values[i]));
+    }
+    REQUIRE_FALSE(decoder.next(&decoded_t, &decoded_value));
+    REQUIRE_FALSE(decoder.error());
+    encoder.reset();
+  }
+}
+
+TEST_CASE("Truncated Gorilla blocks are rejected", "[compress]") {
+  std::vector<uint64_t> t_us;
+  std::vector<float> values;
+  pt_capture(100, &t_us, &values);
+  uint8_t block[256];
+  GorillaEncoder encoder(block, sizeof(block));
+  for (size_t i = 0; i < t_us.size(); i++) {
+    encoder.append(t_us[i], values[i]);
+  }
+  size_t size = encoder.finish();
+
+  GorillaDecoder decoder(block, size / 2);
+  uint64_t t;
+  float value;
+  size_t decoded = 0;
+  while (decoder.next(&t, &value)) {
+    decoded++;
+  }
+  REQUIRE(decoder.error());
+  REQUIRE(decoded < encoder.count());
+}
+
+TEST_CASE("Slowly changing sensors compress well", "[compress]") {
+  std::vector<uint64_t> t_us;
+  std::vector<float> values;
+  pt_capture(60000, &t_us, &values);
+
+  // Frame-sized blocks.
+  std::vector<uint8_t> stream;
+  size_t blocks = compress_series(t_us.data(), values.data(), t_us.size(),
+                                  240, &stream);
+  REQUIRE(blocks > 1);
+  double raw = t_us.size() * (sizeof(uint64_t) + sizeof(float));
+  INFO("ratio " << raw / stream.size());
+  REQUIRE(raw / stream.size() > 4);
+
+  std::vector<uint64_t> decoded_t;
+  std::vector<float> decoded_values;
+  REQUIRE(decompress_series(stream.data(), stream.size(), &decoded_t,
+                            &decoded_values));
+  REQUIRE(decoded_t == t_us);
+  REQUIRE(decoded_values == values);
+
+  // A stream cut mid-block keeps the blocks before the cut.
+  decoded_t.clear();
+  decoded_values.clear();
+  REQUIRE_FALSE(decompress_series(stream.data(), stream.size() - 3,
+                                  &decoded_t, &decoded_values));
+  REQUIRE(decoded_t.size() < t_us.size());
+  REQUIRE(std::equal(decoded_t.begin(), decoded_t.end(), t_us.begin()));
+}
@@ -0,0 +1,64 @@
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "hal/memory.h"
+#include "hal/rtos.h"
+
+namespace {
+
+const hal_alloc_site_t* find_site(const hal_alloc_site_t* sites, size_t count,
+                                  const char* site) {
+  for (size_t i = 0; i < count; i++) {
+    if (sites[i].site == site) {
+      return &sites[i];
+    }
+  }
+  return nullptr;
+}
+
+const char* const SITE = "test_hal_memory.cc";
+
+}  // namespace
+
+TEST_CASE("hal_malloc counts allocations per call site") {
+  const uint32_t allocs = hal_heap_alloc_count();
+  for (int i = 0; i < 3; i++) {
+    void* ptr = hal_malloc_at(10 + i, SITE);
+    REQUIRE(ptr != nullptr);
+    hal_free(ptr);
+  }
+  // On Linux only hal_malloc() is counted.
+  CHECK(hal_heap_alloc_count() - allocs == 3);
+
+  hal_alloc_site_t sites[HAL_ALLOC_SITE_MAX];
+  size_t count = hal_alloc_sites(sites, HAL_ALLOC_SITE_MAX);
+  const hal_alloc_site_t* site = find_site(sites, count, SITE);
+  REQUIRE(site != nullptr);
+  CHECK(site->count == 3);
+  CHECK(site->bytes == 10 + 11 + 12);
+
+  // The macro names the file and line.
+  void* ptr = hal_malloc(4);
+  hal_free(ptr);
+  count = hal_alloc_sites(sites, HAL_ALLOC_SITE_MAX);
+  bool found = false;
+  for (size_t i = 0; i < count; i++) {
+    found |= std::strstr(sites[i].site, "test_hal_memory.cc:") != nullptr;
+  }
+  CHECK(found);
+}
+
+TEST_CASE("Tracked tasks report their stacks") {
+  hal_task_track(hal_task_current(), "catch", 8192);
+  hal_task_stack_t stacks[HAL_TRACKED_TASK_MAX];
+  size_t count = hal_task_stacks(stacks, HAL_TRACKED_TASK_MAX);
+  REQUIRE(count >= 1);
+  const hal_task_stack_t& stack = stacks[count - 1];
+  CHECK(std::strcmp(stack.name, "catch") == 0);
+  CHECK(stack.stack_size == 8192);
+  // Threads' stacks aren't measured on Linux.
+  CHECK(stack.free_min == HAL_STACK_UNKNOWN);
+  CHECK(hal_heap_size() > 0);
+}
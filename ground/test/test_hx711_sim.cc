@@ -0,0 +1,82 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+
+#include "hal/gpio.h"
+#include "sim/hx711_sim.h"
+
+namespace {
+
+// load_cell_config.h's wiring.
+constexpr hal_gpio_t DOUT = 48;
+constexpr hal_gpio_t PD_SCK = 47;
+
+// Clocks out a conversion as load_cell.cc does, with `gain_pulses` after the
+// data, and returns it sign-extended.
+int32_t read_conversion(int gain_pulses) {
+  uint32_t data = 0;
+  for (int i = 0; i < 24 + gain_pulses; i++) {
+    hal_gpio_set_level(PD_SCK, 1);
+    if (i < 24) {
+      data = data << 1 | hal_gpio_get_level(DOUT);
+    }
+    hal_gpio_set_level(PD_SCK, 0);
+  }
+  return static_cast<int32_t>(data << 8) >> 8;
+}
+
+}  // namespace
+
+TEST_CASE("Simulated HX711 shifts out conversions and selects the gain") {
+  Hx711Sim sim(3.3);
+  sim.attach(DOUT, PD_SCK);
+  sim.set_input(Hx711Input::kA, [](double) { return 0.005; });
+  sim.set_input(Hx711Input::kB, [](double) { return -0.02; });
+  hal_gpio_set_level(PD_SCK, 0);
+
+  // A at 128 after power-up.
+  REQUIRE(hal_gpio_get_level(DOUT) == 0);
+  const int32_t a128 = read_conversion(2);
+  CHECK(a128 == sim.code_for(0.005, 128));
+  CHECK(a128 == 3253763);
+  // Two pulses selected B at 32.
+  REQUIRE(hal_gpio_get_level(DOUT) == 0);
+  CHECK(read_conversion(3) == sim.code_for(-0.02, 32));
+  // Three selected A at 64.
+  REQUIRE(hal_gpio_get_level(DOUT) == 0);
+  CHECK(read_conversion(1) == sim.code_for(0.005, 64));
+
+  // Full scale is +-0.5 AVDD / gain.
+  CHECK(sim.code_for(1, 128) == 0x7FFFFF);
+  CHECK(sim.code_for(-1, 128) == -0x800000);
+
+  Hx711SimStats stats = sim.stats();
+  CHECK(stats.conversions == 3);
+  CHECK(stats.stray_pulses == 0);
+}
+
+TEST_CASE("Paced simulated HX711 is ready at its data rate") {
+  double now_s = 0;
+  Hx711Sim sim(3.3, 80);
+  sim.attach(DOUT, PD_SCK);
+  sim.set_time_source([&now_s] { return now_s; });
+  sim.set_paced(true);
+  sim.set_input(Hx711Input::kA, [](double t_s) { return t_s * 0.001; });
+  hal_gpio_set_level(PD_SCK, 0);
+
+  // Clocking before DOUT showed a conversion shifts nothing.
+  hal_gpio_set_level(PD_SCK, 1);
+  hal_gpio_set_level(PD_SCK, 0);
+  CHECK(sim.stats().stray_pulses == 1);
+
+  REQUIRE(hal_gpio_get_level(DOUT) == 0);
+  CHECK(read_conversion(1) == 0);
+  // Busy until 1 / 80 s later, then sampled then.
+  CHECK(hal_gpio_get_level(DOUT) == 1);
+  now_s = 0.01;
+  CHECK(hal_gpio_get_level(DOUT) == 1);
+  now_s = 0.0125;
+  REQUIRE(hal_gpio_get_level(DOUT) == 0);
+  now_s = 0.02;
+  CHECK(read_conversion(1) == sim.code_for(0.0125 * 0.001, 128));
+  CHECK(sim.stats().conversions == 2);
+}
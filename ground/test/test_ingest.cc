@@ -0,0 +1,194 @@
+#include <catch2/catch.hpp>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board_sim.h"
+#include "ingest.h"
+#include "serial_port.h"
+#include "series_store.h"
+#include "telemetry/frame.h"
+#include "telemetry/frame_stream.h"
+#include "telemetry/trace_report.h"
+
+namespace {
+
+constexpr uint64_t FRAME_PERIOD_US = 50 * 1000;
+constexpr uint64_t REORDER_WINDOW_US = 100 * 1000;
+
+// One second of downlink from `board`, frames back to back.
+std::vector<std::vector<uint8_t>> board_frames(SimulatedBoard* board,
+                                               uint64_t from_us) {
+  std::vector<std::vector<uint8_t>> frames;
+  for (uint64_t now_us = from_us; now_us < from_us + 1000000;
+       now_us += 1000) {
+    board->sample(now_us);
+    if (now_us % FRAME_PERIOD_US == 0) {
+      uint8_t frame[FRAME_MAX_SIZE];
+      size_t size = board->frame(now_us, frame, sizeof(frame));
+      REQUIRE(size > 0);
+      frames.emplace_back(frame, frame + size);
+    }
+  }
+  return frames;
+}
+
+}  // namespace
+
+TEST_CASE("Frame stream parser resynchronizes after noise", "[ingest]") {
+  SimulatedBoard board(3, 0);
+  std::vector<std::vector<uint8_t>> frames = board_frames(&board, 0);
+  REQUIRE(frames.size() == 20);
+
+  // Garbage (including stray SYNC bytes) between frames, and one corrupted
+  // frame.
+  std::mt19937 rng(9);
+  std::vector<uint8_t> stream = {0x00, FRAME_SYNC, 0x13};
+  for (size_t i = 0; i < frames.size(); i++) {
+    std::vector<uint8_t> frame = frames[i];
+    if (i == 7) {
+      frame[frame.size() / 2] ^= 0x10;
+    }
+    stream.insert(stream.end(), frame.begin(), frame.end());
+    if (i % 3 == 0) {
+      stream.push_back(FRAME_SYNC);
+      stream.push_back(rng() & 0xFF);
+    }
+  }
+
+  // Whatever way the stream is split into reads.
+  for (size_t chunk : {1, 7, 64, 4096}) {
+    FrameStreamParser parser;
+    std::vector<uint16_t> seqs;
+    for (size_t at = 0; at < stream.size(); at += chunk) {
+      size_t len = std::min(chunk, stream.size() - at);
+      parser.push(&stream[at], len, [&](const Frame& frame) {
+        CHECK(frame.node == 3);
+        seqs.push_back(frame.seq);
+      });
+    }
+    REQUIRE(seqs.size() == frames.size() - 1);
+    CHECK(parser.stats().frames == frames.size() - 1);
+    CHECK(parser.stats().bad_crc + parser.stats().bad_length >= 1);
+    CHECK(std::find(seqs.begin(), seqs.end(), 8) == seqs.end());
+  }
+}
+
+TEST_CASE("Ingest stores telemetry read from a PTY", "[ingest]") {
+  std::string slave;
+  int master = open_pty(&slave);
+  REQUIRE(master >= 0);
+  int serial = open_serial(slave, 921600);
+  REQUIRE(serial >= 0);
+
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "ingest_store";
+  std::filesystem::remove_all(directory);
+  SeriesStore store(directory.string());
+  REQUIRE(store.open());
+  Ingest ingest(&store, REORDER_WINDOW_US);
+
+  SimulatedBoard board(1, 5000000);
+  uint64_t now_us = 0;
+  for (int second = 0; second < 3; second++) {
+    for (const std::vector<uint8_t>& frame :
+         board_frames(&board, second * 1000000)) {
+      REQUIRE(write(master, frame.data(), frame.size()) ==
+              static_cast<ssize_t>(frame.size()));
+      now_us += FRAME_PERIOD_US;
+      // Read whatever arrived, as the daemon would.
+      uint8_t buffer[1024];
+      ssize_t n;
+      int idle = 0;
+      size_t got = 0;
+      while (got < frame.size() && idle < 1000) {
+        n = read(serial, buffer, sizeof(buffer));
+        if (n > 0) {
+          ingest.on_bytes(buffer, n, now_us);
+          got += n;
+        } else {
+          idle++;
+          std::this_thread::yield();
+        }
+      }
+      ingest.poll(now_us);
+    }
+  }
+  ingest.flush();
+  store.flush();
+  close(serial);
+  close(master);
+
+  IngestStats stats = ingest.stats();
+  CHECK(stats.stream.frames == 60);
+  CHECK(stats.decode_error_rate() == 0.0f);
+  CHECK(stats.samples == 60 * BOARD_SIM_CHANNELS);
+  CHECK(stats.store_rejected == 0);
+  CHECK(store.samples() == stats.samples);
+
+  std::vector<MergedSample> latest = store.latest();
+  REQUIRE(latest.size() == BOARD_SIM_CHANNELS);
+  CHECK(latest[0].node == 1);
+
+  std::vector<StoreRecord> records;
+  REQUIRE(read_series_file((directory / "node1_ch0.bin").string(), &records));
+  CHECK(records.size() == 60);
+  CHECK(records.back().t_us == latest[0].t_us);
+  CHECK(records.back().mean == latest[0].mean);
+
+  std::string reply = ingest.handle_request("latest");
+  CHECK(std::count(reply.begin(), reply.end(), '\n') ==
+        BOARD_SIM_CHANNELS + 1);
+  CHECK(reply.rfind("1 0 ", 0) == 0);
+  CHECK(reply.substr(reply.size() - 2) == "\n\n");
+
+  reply = ingest.handle_request("query 1 0 0 100000000 10");
+  size_t lines = std::count(reply.begin(), reply.end(), '\n');
+  CHECK(lines >= 2);
+  CHECK(lines <= 11);
+  CHECK(ingest.handle_request("stats").rfind("bytes=", 0) == 0);
+  CHECK(ingest.handle_request("query 9 0 0 1 1") ==
+        "error no such series\n\n");
+  CHECK(ingest.handle_request("query 1").rfind("error usage", 0) == 0);
+  CHECK(ingest.handle_request("plot") == "error unknown request\n\n");
+}
+
+TEST_CASE("Ingest keeps the latest trace table of each board", "[ingest]") {
+  std::filesystem::path directory =
+      std::filesystem::temp_directory_path() / "ingest_trace_store";
+  std::filesystem::remove_all(directory);
+  SeriesStore store(directory.string());
+  REQUIRE(store.open());
+  Ingest ingest(&store, REORDER_WINDOW_US);
+
+  // 1000 loops of 2.5 ms at 240 cycles per microsecond, then an update.
+  TraceZoneStats zones[] = {
+      {.zone = 0, .calls = 1000, .total_cycles = 600000000,
+       .max_cycles = 1200000},
+      {.zone = 1, .calls = 1000, .total_cycles = 480000000,
+       .max_cycles = 960000},
+  };
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t consumed;
+  size_t size = encode_trace_frame(3, 1, AckField{}, 240, zones, 2, &consumed,
+                                   frame, sizeof(frame));
+  REQUIRE(size > 0);
+  ingest.on_bytes(frame, size, 0);
+  zones[1].calls = 2000;
+  size = encode_trace_frame(3, 2, AckField{}, 240, &zones[1], 1, &consumed,
+                            frame, sizeof(frame));
+  ingest.on_bytes(frame, size, 0);
+
+  CHECK(ingest.stats().trace_frames == 2);
+  CHECK(ingest.stats().ignored_frames == 0);
+  CHECK(ingest.handle_request("trace") ==
+        "3 0 1000 2500.00 5000.00 2500000 acquisition_loop\n"
+        "3 1 2000 1000.00 4000.00 2000000 adc_spi\n\n");
+}
@@ -0,0 +1,178 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "esp32_driver_mcp320x/mcp320x.h"
+#include "hal/spi.h"
+#include "sim/mcp320x_sim.h"
+
+namespace {
+
+// The driver's hardware tests: MCP3204 on SPI3 (host 2), chip select 5,
+// 1 MHz, 5 V reference.
+constexpr hal_spi_host_t HOST = 2;
+constexpr hal_gpio_t CS = 5;
+
+mcp320x_config_t config(mcp320x_model_t model, uint32_t clock_speed_hz) {
+  return mcp320x_config_t{
+      .host = HOST,
+      .cs_io_num = CS,
+      .device_model = model,
+      .clock_speed_hz = clock_speed_hz,
+      .reference_voltage = 5000,
+  };
+}
+
+}  // namespace
+
+TEST_CASE("Simulated MCP3204 samples 2.5 V as mid-scale") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3204, 5.0);
+  sim.attach(HOST, CS);
+  sim.set_waveform(3, AdcWaveform{.offset_v = 2.5});
+
+  mcp320x_config_t cfg = config(MCP3204_MODEL, 1000 * 1000);
+  mcp320x_t* handle = mcp320x_install(&cfg);
+  REQUIRE(handle != nullptr);
+  uint16_t value = 0;
+  REQUIRE(mcp320x_sample(handle, MCP320X_CHANNEL_3, MCP320X_READ_MODE_SINGLE,
+                         5, &value) == MCP320X_OK);
+  CHECK(value == 2048);
+  uint16_t voltage_mv = 0;
+  REQUIRE(mcp320x_read_voltage(handle, MCP320X_CHANNEL_3,
+                               MCP320X_READ_MODE_SINGLE,
+                               &voltage_mv) == MCP320X_OK);
+  CHECK(voltage_mv == 2500);
+  mcp320x_delete(handle);
+
+  Mcp320xSimStats stats = sim.stats();
+  CHECK(stats.transfers == 6);
+  CHECK(stats.conversions == 6);
+  CHECK(stats.truncated == 0);
+  CHECK(stats.out_of_spec_clock == 0);
+  CHECK(stats.bus_time_ns == 6 * 24 * 1000);
+}
+
+TEST_CASE("Simulated MCP3208 decodes every channel and mode") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3208, 5.0);
+  sim.attach(HOST, CS);
+  for (int channel = 0; channel < 8; channel++) {
+    sim.set_waveform(channel, AdcWaveform{.offset_v = 0.5 * channel + 0.2});
+  }
+
+  mcp320x_config_t cfg = config(MCP3208_MODEL, 2000 * 1000);
+  mcp320x_t* handle = mcp320x_install(&cfg);
+  REQUIRE(handle != nullptr);
+  for (int channel = 0; channel < 8; channel++) {
+    uint16_t value = 0;
+    REQUIRE(mcp320x_read(handle, static_cast<mcp320x_channel_t>(channel),
+                         MCP320X_READ_MODE_SINGLE, &value) == MCP320X_OK);
+    CHECK(value == sim.code_for(0.5 * channel + 0.2));
+  }
+
+  // Differential: even select bit reads CHn - CHn+1, which is negative here
+  // and clips to 0; odd reads CHn+1 - CHn.
+  uint16_t value = 0;
+  REQUIRE(mcp320x_read(handle, MCP320X_CHANNEL_0,
+                       MCP320X_READ_MODE_DIFFERENTIAL, &value) == MCP320X_OK);
+  CHECK(value == 0);
+  REQUIRE(mcp320x_read(handle, MCP320X_CHANNEL_5,
+                       MCP320X_READ_MODE_DIFFERENTIAL, &value) == MCP320X_OK);
+  CHECK(value == sim.code_for(0.5));
+  mcp320x_delete(handle);
+}
+
+TEST_CASE("Simulated MCP320x clocks out the documented bit stream") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3204, 4.096);
+  sim.set_waveform(1, AdcWaveform{.offset_v = 1.2705});  // Code 1270.
+  REQUIRE(sim.code_for(1.2705) == 1270);
+
+  // Start, single, channel 1, then 32 more clocks: null bit, B11..B0, then
+  // B1..B11 LSB first and zeros.
+  const uint8_t tx[5] = {0b00000110, 0b01000000, 0, 0, 0};
+  uint8_t rx[5];
+  sim.transfer(1000 * 1000, tx, rx, sizeof(tx));
+  // Up to the sample clock DOUT is high impedance and reads high.
+  CHECK(rx[0] == 0xFF);
+  CHECK((rx[1] & 0xE0) == 0xE0);
+  uint16_t msb_first = ((rx[1] << 8 | rx[2]) & 0x1FFF);
+  CHECK(msb_first == 1270);  // The null bit is the 0 above B11.
+  uint16_t lsb_first = 0;
+  for (int bit = 0; bit < 11; bit++) {
+    int i = 24 + bit;
+    lsb_first |= ((rx[i / 8] >> (7 - i % 8)) & 1) << (bit + 1);
+  }
+  CHECK(lsb_first == (1270 & ~1));
+  CHECK((rx[4] & 0x1F) == 0);
+
+  // Too few clocks for B0.
+  sim.transfer(1000 * 1000, tx, rx, 2);
+  CHECK(sim.stats().truncated == 1);
+  CHECK(sim.stats().conversions == 1);
+}
+
+TEST_CASE("Simulated MCP320x samples at the configured clock") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3204, 5.0);
+  sim.attach(HOST, CS);
+  // Every transfer starts at t = 0 on a 1 V/ms ramp, so the code tells when
+  // the sample period ended: 10.5 clocks into the driver's transfer.
+  sim.set_time_source([] { return 0.0; });
+  sim.set_input(0, [](double t_s) { return t_s * 1000; });
+
+  for (uint32_t clock_hz : {1000u * 1000, 100u * 1000, 20u * 1000}) {
+    mcp320x_config_t cfg = config(MCP3204_MODEL, clock_hz);
+    mcp320x_t* handle = mcp320x_install(&cfg);
+    REQUIRE(handle != nullptr);
+    uint32_t actual_hz = 0;
+    REQUIRE(mcp320x_get_actual_freq(handle, &actual_hz) == MCP320X_OK);
+    uint16_t value = 0;
+    REQUIRE(mcp320x_read(handle, MCP320X_CHANNEL_0, MCP320X_READ_MODE_SINGLE,
+                         &value) == MCP320X_OK);
+    CHECK(value == sim.code_for(10.5 / actual_hz * 1000));
+    mcp320x_delete(handle);
+  }
+}
+
+TEST_CASE("Simulated MCP320x flags clocks outside the datasheet range") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3204, 5.0, 2.7);
+  sim.attach(HOST, CS);
+  CHECK(sim.max_clock_hz() == 1e6);
+
+  // The driver allows 2 MHz, which is only in spec at 5 V.
+  mcp320x_config_t cfg = config(MCP3204_MODEL, 2000 * 1000);
+  mcp320x_t* handle = mcp320x_install(&cfg);
+  REQUIRE(handle != nullptr);
+  uint16_t value = 0;
+  REQUIRE(mcp320x_read(handle, MCP320X_CHANNEL_0, MCP320X_READ_MODE_SINGLE,
+                       &value) == MCP320X_OK);
+  mcp320x_delete(handle);
+  CHECK(sim.stats().out_of_spec_clock == 1);
+}
+
+TEST_CASE("Simulated MCP320x noise averages out in mcp320x_sample") {
+  Mcp320xSim sim(Mcp320xModel::kMcp3204, 5.0, 5.0, 7);
+  sim.attach(HOST, CS);
+  // 5 mV RMS is about 4 LSB.
+  sim.set_waveform(2, AdcWaveform{.offset_v = 1.0, .noise_v = 0.005});
+
+  mcp320x_config_t cfg = config(MCP3204_MODEL, 2000 * 1000);
+  mcp320x_t* handle = mcp320x_install(&cfg);
+  REQUIRE(handle != nullptr);
+  uint16_t single_min = UINT16_MAX;
+  uint16_t single_max = 0;
+  for (int i = 0; i < 100; i++) {
+    uint16_t value = 0;
+    REQUIRE(mcp320x_read(handle, MCP320X_CHANNEL_2, MCP320X_READ_MODE_SINGLE,
+                         &value) == MCP320X_OK);
+    single_min = std::min(single_min, value);
+    single_max = std::max(single_max, value);
+  }
+  CHECK(single_max - single_min >= 8);
+
+  uint16_t averaged = 0;
+  REQUIRE(mcp320x_sample(handle, MCP320X_CHANNEL_2, MCP320X_READ_MODE_SINGLE,
+                         400, &averaged) == MCP320X_OK);
+  // The mean of 400 floored codes sits half an LSB low.
+  CHECK(std::abs(averaged - (sim.code_for(1.0) - 0.5)) <= 1.5);
+  mcp320x_delete(handle);
+}
@@ -0,0 +1,239 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "configs/pt_scale_config.h"
+#include "configs/stand_config.h"
+#include "pt.h"
+#include "datalog/flash_log.h"
+#include "file_flash.h"
+#include "replay.h"
+#include "valve.h"
+
+namespace {
+
+constexpr uint64_t FIRE_US = 2000000;
+constexpr uint64_t SPIKE_US = FIRE_US + 3000000;
+constexpr uint64_t END_US = FIRE_US + 10000000;
+
+// A chamber redline and a firing sequence, with made-up limits and timings.
+constexpr Redline REDLINES[] = {
+    {
+        .pt = static_cast<uint8_t>(Pt::kChamber),
+        .states = stand_state_bit(StandState::kArmed) |
+                  stand_state_bit(StandState::kFiring),
+        .min_psi = 0,
+        .max_psi = 400,
+        .persist_us = 5000,
+    },
+};
+
+constexpr SequenceStep FIRE_SEQUENCE[] = {
+    {
+        .t_ms = 0,
+        .action = SequenceAction::kIgnitionOn,
+        .arg = 0,
+    },
+    {
+        .t_ms = 1500,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kGoxRelease),
+    },
+    {
+        .t_ms = 1700,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kFuelRelease),
+    },
+    {
+        .t_ms = 2500,
+        .action = SequenceAction::kIgnitionOff,
+        .arg = 0,
+    },
+    {
+        .t_ms = 7000,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kFuelRelease),
+    },
+    {
+        .t_ms = 7100,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kGoxRelease),
+    },
+    {
+        .t_ms = 7200,
+        .action = SequenceAction::kOpenValve,
+        .arg = static_cast<uint8_t>(Valve::kN2PurgeGox),
+    },
+    {
+        .t_ms = 9200,
+        .action = SequenceAction::kCloseValve,
+        .arg = static_cast<uint8_t>(Valve::kN2PurgeGox),
+    },
+};
+
+constexpr StandLogicConfig LOGIC = {
+    .filter = STAND_PT_FILTER,
+    .redlines = REDLINES,
+    .redline_count = std::size(REDLINES),
+    .sequence = FIRE_SEQUENCE,
+    .sequence_count = std::size(FIRE_SEQUENCE),
+};
+
+std::string fresh_image(const char* name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / (std::string(name) + ".bin");
+  std::filesystem::remove(path);
+  return path.string();
+}
+
+LogRecord event_record(uint64_t t_us, LogEvent event, uint16_t arg = 0) {
+  return {
+      .t_us = t_us,
+      .type = RecordType::kEvent,
+      .id = static_cast<uint8_t>(event),
+      .aux = arg,
+      .value = 0,
+  };
+}
+
+// Chamber pressure of a burn that starts when the fuel valve opens and
+// spikes past the chamber redline for 50 ms.
+float chamber_psi(uint64_t t_us) {
+  if (t_us < FIRE_US + 1700000) {
+    return 0;
+  }
+  if (t_us >= SPIKE_US && t_us < SPIKE_US + 50000) {
+    return 450;
+  }
+  return std::min(300.0f, (t_us - FIRE_US - 1700000) / 1000.0f);
+}
+
+// Runs the stand logic the way the board does (control/src/stand_control.cc):
+// a 1 kHz chamber PT, the sequencer polled every 10 ms, and every decision
+// logged. Returns the decisions taken.
+std::vector<StandDecision> run_board(FlashLog* log) {
+  std::vector<StandDecision> decisions;
+  StandController controller(LOGIC);
+  auto carry_out = [&](const StandDecision& decision) {
+    decisions.push_back(decision);
+    log->append(event_record(decision.t_us,
+                             decision.type == DecisionType::kAbort
+                                 ? LogEvent::kRedline
+                                 : LogEvent::kSequencerStep,
+                             decision.index));
+  };
+
+  log->append(event_record(1000000, LogEvent::kArm));
+  controller.set_state(StandState::kArmed, 1000000);
+  StandDecision decision;
+  for (uint64_t t_us = 0; t_us < END_US; t_us += 1000) {
+    if (t_us == FIRE_US) {
+      log->append(event_record(t_us, LogEvent::kFire));
+      controller.set_state(StandState::kFiring, t_us);
+    }
+    if (t_us % 10000 == 5000) {
+      while (controller.poll_sequence(t_us, &decision)) {
+        carry_out(decision);
+      }
+    }
+    // read_pt() reports whole psi.
+    float psi = static_cast<uint16_t>(chamber_psi(t_us));
+    log->append({
+        .t_us = t_us,
+        .type = RecordType::kPt,
+        .id = static_cast<uint8_t>(Pt::kChamber),
+        .aux = 0,
+        .value = psi,
+    });
+    if (controller.on_pt(static_cast<uint8_t>(Pt::kChamber), t_us, psi,
+                         &decision)) {
+      carry_out(decision);
+    }
+    while (log->service()) {
+    }
+  }
+  log->flush();
+  log->service();
+  return decisions;
+}
+
+std::vector<LogRecord> record_board(const char* name,
+                                    std::vector<StandDecision>* decisions) {
+  std::string path = fresh_image(name);
+  {
+    FileFlash flash(path, 256 * FLASH_SECTOR_SIZE);
+    FlashLog log(&flash);
+    REQUIRE(log.open());
+    *decisions = run_board(&log);
+    REQUIRE(log.stats().dropped == 0);
+  }
+  std::vector<LogRecord> records;
+  REQUIRE(load_flash_log(path, UINT32_MAX, &records));
+  return records;
+}
+
+}  // namespace
+
+TEST_CASE("Replay makes the board's decisions from its flight-data log",
+          "[replay]") {
+  std::vector<StandDecision> board;
+  std::vector<LogRecord> records = record_board("replay_board", &board);
+
+  // The sequence up to the spike, then the chamber redline.
+  REQUIRE(board.size() == 5);
+  REQUIRE(board.back().type == DecisionType::kAbort);
+  REQUIRE(board.back().index == 0);
+  REQUIRE(board.back().t_us > SPIKE_US);
+  // Filtered, then held for the redline's persist_us.
+  REQUIRE(board.back().t_us < SPIKE_US + 20000);
+
+  ReplayResult result = replay(records, ReplayConfig{.logic = LOGIC});
+  REQUIRE(result.samples == END_US / 1000);
+  REQUIRE(result.recorded.size() == board.size());
+  REQUIRE(result.matches());
+  REQUIRE(result.first_abort_us() == board.back().t_us);
+  for (size_t i = 0; i < board.size(); i++) {
+    // Steps come due between PT samples here, and every 10 ms on the board.
+    REQUIRE(result.decisions[i].t_us <= board[i].t_us);
+    REQUIRE(board[i].t_us - result.decisions[i].t_us < 10000);
+  }
+}
+
+TEST_CASE("Replay shows when other redlines would have tripped", "[replay]") {
+  std::vector<StandDecision> board;
+  std::vector<LogRecord> records = record_board("replay_sweep", &board);
+
+  Redline redlines[std::size(REDLINES)];
+  std::copy(std::begin(REDLINES), std::end(REDLINES), redlines);
+  ReplayConfig config = {.logic = LOGIC};
+  config.logic.redlines = redlines;
+
+  // Above the spike: the whole sequence runs.
+  redlines[0].max_psi = 500;
+  ReplayResult result = replay(records, config);
+  REQUIRE(result.first_abort_us() == 0);
+  REQUIRE(result.decisions.size() == std::size(FIRE_SEQUENCE));
+  REQUIRE_FALSE(result.matches());
+
+  // Below the steady chamber pressure: trips during the ramp.
+  redlines[0].max_psi = 200;
+  result = replay(records, config);
+  REQUIRE(result.first_abort_us() > FIRE_US + 1900000);
+  REQUIRE(result.first_abort_us() < FIRE_US + 1920000);
+
+  // The same redline with a transducer reading twice as high.
+  redlines[0].max_psi = 400;
+  PtScale scales[std::size(PT_SCALES)];
+  std::copy(std::begin(PT_SCALES), std::end(PT_SCALES), scales);
+  scales[static_cast<int>(Pt::kChamber)].max_pressure = 2000;
+  config.recorded_scales = PT_SCALES;
+  config.scales = scales;
+  config.scale_count = std::size(scales);
+  result = replay(records, config);
+  REQUIRE(result.first_abort_us() > FIRE_US + 1900000);
+  REQUIRE(result.first_abort_us() < FIRE_US + 1920000);
+}
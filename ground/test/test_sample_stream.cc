@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "board_sim.h"
+#include "fan_in.h"
+#include "telemetry/frame.h"
+#include "telemetry/sample_stream.h"
+
+namespace {
+
+constexpr uint64_t SAMPLE_PERIOD_US = 1000;
+// WIRED_TASK_PERIOD_MS on the board.
+constexpr uint64_t WIRED_PERIOD_US = 10 * 1000;
+// 921600 baud, 8N1.
+constexpr size_t WIRED_BYTES_PER_S = 921600 / 10;
+
+}  // namespace
+
+TEST_CASE("Sample bodies round-trip", "[sample_stream]") {
+  std::vector<RawSample> samples;
+  for (size_t i = 0; i < 2 * SAMPLES_PER_FRAME; i++) {
+    samples.push_back({
+        .t_us = 5000000000ull + i * 125,
+        .channel = static_cast<uint8_t>(i % 8),
+        .value = 0.5f * i,
+    });
+  }
+
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t consumed;
+  size_t size = encode_samples_frame(3, 7, AckField{}, samples.data(),
+                                     samples.size(), SampleClock::kHost,
+                                     &consumed, frame, sizeof(frame));
+  REQUIRE(size > 0);
+  REQUIRE(size <= FRAME_MAX_SIZE);
+  REQUIRE(consumed == SAMPLES_PER_FRAME);
+
+  Frame decoded;
+  REQUIRE(decode_frame(frame, size, &decoded) == FrameError::kOk);
+  REQUIRE(decoded.type == FrameType::kSamples);
+  REQUIRE(decoded.node == 3);
+  REQUIRE(decoded.seq == 7);
+  AckField ack;
+  REQUIRE(decode_ack(decoded, &ack));
+
+  RawSample out[SAMPLES_PER_FRAME];
+  size_t count;
+  SampleClock clock;
+  REQUIRE(decode_samples_frame(decoded, out, SAMPLES_PER_FRAME, &count,
+                               &clock));
+  REQUIRE(count == consumed);
+  REQUIRE(clock == SampleClock::kHost);
+  for (size_t i = 0; i < count; i++) {
+    REQUIRE(out[i].t_us == samples[i].t_us);
+    REQUIRE(out[i].channel == samples[i].channel);
+    REQUIRE(out[i].value == samples[i].value);
+  }
+
+  // A truncated body is rejected rather than half decoded.
+  REQUIRE_FALSE(decode_sample_body(&decoded.payload[ACK_FIELD_SIZE],
+                                   decoded.payload_len - ACK_FIELD_SIZE - 1,
+                                   out, SAMPLES_PER_FRAME, &count, &clock));
+}
+
+TEST_CASE("Sample bodies stop where time offsets no longer fit",
+          "[sample_stream]") {
+  RawSample samples[] = {
+      {.t_us = 1000, .channel = 0, .value = 1},
+      {.t_us = 1000 + SAMPLE_BODY_MAX_SPAN_US, .channel = 1, .value = 2},
+      {.t_us = 1001 + SAMPLE_BODY_MAX_SPAN_US, .channel = 2, .value = 3},
+  };
+  uint8_t body[FRAME_MAX_PAYLOAD];
+  size_t consumed;
+  REQUIRE(encode_sample_body(samples, 3, SampleClock::kBoard, &consumed, body,
+                             sizeof(body)) > 0);
+  REQUIRE(consumed == 2);
+
+  // An older sample, e.g. recorded by a preempted task, starts a new body.
+  RawSample reordered[] = {
+      {.t_us = 2000, .channel = 0, .value = 1},
+      {.t_us = 1999, .channel = 1, .value = 2},
+  };
+  REQUIRE(encode_sample_body(reordered, 2, SampleClock::kBoard, &consumed,
+                             body, sizeof(body)) > 0);
+  REQUIRE(consumed == 1);
+}
+
+TEST_CASE("Full-rate samples of every channel fit the wired link",
+          "[sample_stream]") {
+  // One second of 8 channels at 1 kHz, sent every wired task period.
+  SimulatedBoard board(2, 4200000);
+  board.set_wired(true);
+  FanIn fan_in(2 * WIRED_PERIOD_US);
+  std::vector<MergedSample> feed;
+  size_t bytes = 0;
+  size_t sampled = 0;
+  for (uint64_t now_us = 0; now_us < 1000 * 1000;
+       now_us += SAMPLE_PERIOD_US) {
+    board.sample(now_us);
+    sampled += BOARD_SIM_CHANNELS;
+    if ((now_us + SAMPLE_PERIOD_US) % WIRED_PERIOD_US != 0) {
+      continue;
+    }
+    uint8_t data[FRAME_MAX_SIZE];
+    size_t size;
+    while ((size = board.samples_frame(data, sizeof(data))) > 0) {
+      bytes += size;
+      Frame frame;
+      REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+      // Delivered within the period, as the UART would.
+      REQUIRE(fan_in.on_frame(frame, now_us + SAMPLE_PERIOD_US));
+    }
+    fan_in.drain(now_us, &feed);
+  }
+  fan_in.flush(&feed);
+
+  REQUIRE(bytes <= WIRED_BYTES_PER_S);
+  const NodeStats& stats = fan_in.node(2);
+  REQUIRE(stats.lost == 0);
+  REQUIRE(stats.late == 0);
+  REQUIRE(feed.size() == sampled);
+  for (size_t i = 0; i < feed.size(); i++) {
+    INFO("sample " << i);
+    REQUIRE(feed[i].count == 1);
+    if (i > 0) {
+      REQUIRE(feed[i].t_us >= feed[i - 1].t_us);
+    }
+  }
+  // The newest sample of every period was delivered a sample period later.
+  REQUIRE(stats.offset_us ==
+          static_cast<int64_t>(SAMPLE_PERIOD_US) - 4200000);
+  // Consecutive samples of one channel stay a sample period apart once
+  // mapped to ground time. The first period was mapped with the offset of
+  // its first frame, before the later frames lowered it.
+  std::vector<uint64_t> chamber;
+  for (const MergedSample& sample : feed) {
+    if (sample.channel == 0) {
+      chamber.push_back(sample.t_us);
+    }
+  }
+  REQUIRE(chamber.size() == 1000);
+  const size_t first_period = WIRED_PERIOD_US / SAMPLE_PERIOD_US;
+  for (size_t i = first_period + 1; i < chamber.size(); i++) {
+    REQUIRE(chamber[i] - chamber[i - 1] == SAMPLE_PERIOD_US);
+  }
+}
@@ -0,0 +1,68 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+
+#include "sched/monitor.h"
+
+TEST_CASE("Deadline monitor tracks jitter, execution time and misses") {
+  DeadlineMonitor monitor(10000, 8000);
+  // Released at 0, started 200 us late, ran 3 ms.
+  monitor.begin(0, 200);
+  CHECK_FALSE(monitor.end(3200));
+  // Started 1 ms late and ran past the deadline.
+  monitor.begin(10000, 11000);
+  CHECK(monitor.end(18500));
+  // Started before its release, by the clock's granularity.
+  monitor.begin(20000, 19990);
+  CHECK_FALSE(monitor.end(22990));
+
+  const DeadlineStats& stats = monitor.stats();
+  CHECK(stats.runs == 3);
+  CHECK(stats.misses == 1);
+  CHECK(stats.jitter_max_us == 1000);
+  CHECK(stats.jitter_mean_us() == 400);
+  CHECK(stats.exec_max_us == 7500);
+  CHECK(stats.exec_mean_us() == 4500);
+
+  monitor.reset();
+  CHECK(monitor.stats().runs == 0);
+  CHECK(monitor.stats().jitter_mean_us() == 0);
+  CHECK(monitor.period_us() == 10000);
+  CHECK(monitor.deadline_us() == 8000);
+}
+
+TEST_CASE("CPU load meter reads the idle counter across a wrap") {
+  CpuLoadMeter meter;
+  CHECK(meter.update(UINT32_MAX - 100000, 0) == 0);
+  // 250 ms idle of 1 s, with the counter wrapping.
+  CHECK(meter.update(149999, 1000000) == Approx(0.75f));
+  CHECK(meter.load() == Approx(0.75f));
+  // Fully idle, and idle a bit more than the wall clock.
+  CHECK(meter.update(1149999, 2000000) == 0);
+  CHECK(meter.update(2200000, 3000000) == 0);
+  // No time passed: keeps the previous load.
+  CHECK(meter.update(2200000, 3000000) == 0);
+  CHECK(meter.update(2200000, 4000000) == Approx(1));
+}
+
+TEST_CASE("Degrade monitor trips on misses or load and recovers") {
+  DegradeMonitor monitor({
+      .max_misses = 3,
+      .max_cpu_load = 0.9f,
+      .recovery_us = 10000000,
+  });
+  CHECK_FALSE(monitor.update(0, 2, 0.5f));
+  CHECK(monitor.update(1000000, 3, 0.5f));
+  CHECK(monitor.trips() == 1);
+  // Stays degraded until clean for recovery_us.
+  CHECK(monitor.update(2000000, 0, 0.5f));
+  CHECK(monitor.update(10999999, 0, 0.5f));
+  CHECK_FALSE(monitor.update(11000000, 0, 0.5f));
+  CHECK_FALSE(monitor.degraded());
+
+  CHECK(monitor.update(12000000, 0, 0.95f));
+  // A relapse restarts recovery.
+  CHECK(monitor.update(20000000, 0, 0.95f));
+  CHECK(monitor.update(29000000, 0, 0.5f));
+  CHECK_FALSE(monitor.update(30000000, 0, 0.5f));
+  CHECK(monitor.trips() == 2);
+}
@@ -0,0 +1,168 @@
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#include "telemetry/frame.h"
+#include "telemetry/scheduler.h"
+#include "telemetry/stand_state.h"
+
+namespace {
+
+//                                              kSafe kArmed kFiring kAbort
+const ChannelSpec CHANNELS[] = {
+    {.id = 0, .priority = ChannelPriority::kCritical, .rate_hz = {1, 1, 1, 1}},
+    {.id = 1, .priority = ChannelPriority::kHigh, .rate_hz = {2, 2, 20, 2}},
+    {.id = 2, .priority = ChannelPriority::kNormal, .rate_hz = {0, 1, 10, 1}},
+    {.id = 3, .priority = ChannelPriority::kLow, .rate_hz = {1, 1, 1, 1}},
+};
+constexpr size_t CHANNEL_COUNT = sizeof(CHANNELS) / sizeof(CHANNELS[0]);
+constexpr size_t BODY_CAP = FRAME_MAX_PAYLOAD - ACK_FIELD_SIZE;
+
+struct Decoded {
+  TelemetryHeader header;
+  ChannelSummary summaries[TELEMETRY_MAX_CHANNELS];
+  size_t count = 0;
+
+  const ChannelSummary* find(uint8_t id) const {
+    for (size_t i = 0; i < count; i++) {
+      if (summaries[i].id == id) {
+        return &summaries[i];
+      }
+    }
+    return nullptr;
+  }
+};
+
+Decoded build_and_decode(TelemetryScheduler& scheduler, uint64_t now_us,
+                         size_t cap = BODY_CAP) {
+  uint8_t body[BODY_CAP];
+  size_t len = scheduler.build(now_us, body, cap);
+  Decoded decoded;
+  if (len > 0) {
+    REQUIRE(decode_telemetry_body(body, len, &decoded.header,
+                                  decoded.summaries, TELEMETRY_MAX_CHANNELS,
+                                  &decoded.count));
+  }
+  return decoded;
+}
+
+}  // namespace
+
+TEST_CASE("Samples are summarized rather than dropped", "[scheduler]") {
+  TelemetryScheduler scheduler(CHANNELS, CHANNEL_COUNT);
+  for (int i = 0; i < 100; i++) {
+    scheduler.record(1, i, i * 1000);
+  }
+  scheduler.record(3, 42.5f, 50000);
+
+  Decoded decoded = build_and_decode(scheduler, 100000);
+  REQUIRE(decoded.header.t_ms == 100);
+  REQUIRE(decoded.header.state == StandState::kSafe);
+
+  const ChannelSummary* summary = decoded.find(1);
+  REQUIRE(summary != nullptr);
+  REQUIRE(summary->count == 100);
+  REQUIRE(summary->min == 0);
+  REQUIRE(summary->max == 99);
+  REQUIRE(summary->mean == Approx(49.5));
+  REQUIRE(summary->t_ms == 99);
+
+  const ChannelSummary* single = decoded.find(3);
+  REQUIRE(single != nullptr);
+  REQUIRE(single->count == 1);
+  REQUIRE(single->mean == 42.5f);
+
+  // Nothing new: nothing to send.
+  REQUIRE(build_and_decode(scheduler, 110000).count == 0);
+}
+
+TEST_CASE("Critical channels always make the next frame", "[scheduler]") {
+  TelemetryScheduler scheduler(CHANNELS, CHANNEL_COUNT);
+  for (uint64_t t = 0; t < 10; t++) {
+    for (size_t i = 0; i < CHANNEL_COUNT; i++) {
+      scheduler.record(i, t, t * 1000);
+      scheduler.record(i, t, t * 1000);
+    }
+    // Room for the header and a single summary only.
+    Decoded decoded = build_and_decode(
+        scheduler, t * 1000 + 1, TELEMETRY_HEADER_SIZE + TELEMETRY_SUMMARY_SIZE);
+    REQUIRE(decoded.count == 1);
+    REQUIRE(decoded.summaries[0].id == 0);
+  }
+}
+
+TEST_CASE("Channels that don't fit keep accumulating", "[scheduler]") {
+  TelemetryScheduler scheduler(CHANNELS, CHANNEL_COUNT);
+  scheduler.set_state(StandState::kFiring, 0);
+  for (int i = 0; i < 10; i++) {
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+      scheduler.record(c, i, i);
+    }
+  }
+
+  const size_t cap = TELEMETRY_HEADER_SIZE + 2 * TELEMETRY_SUMMARY_SIZE;
+  Decoded first = build_and_decode(scheduler, 1000, cap);
+  REQUIRE(first.count == 2);
+  REQUIRE(first.find(0) != nullptr);
+  REQUIRE(first.find(1) != nullptr);
+  REQUIRE(scheduler.fill_ratio() == 1.0f);
+
+  Decoded second = build_and_decode(scheduler, 2000, cap);
+  const ChannelSummary* late = second.find(2);
+  REQUIRE(late != nullptr);
+  REQUIRE(late->count == 10);
+}
+
+TEST_CASE("Low-priority channels are held back, not dropped",
+          "[scheduler]") {
+  TelemetryScheduler scheduler(CHANNELS, CHANNEL_COUNT);
+  scheduler.set_state(StandState::kFiring, 0);
+  scheduler.set_min_priority(ChannelPriority::kHigh);
+  for (int i = 0; i < 10; i++) {
+    for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+      scheduler.record(c, i, i);
+    }
+  }
+
+  Decoded shed = build_and_decode(scheduler, 2000000);
+  REQUIRE(shed.count == 2);
+  REQUIRE(shed.find(0) != nullptr);
+  REQUIRE(shed.find(1) != nullptr);
+
+  scheduler.set_min_priority(ChannelPriority::kLow);
+  Decoded all = build_and_decode(scheduler, 4000000);
+  REQUIRE(all.find(2) != nullptr);
+  REQUIRE(all.find(2)->count == 10);
+  REQUIRE(all.find(3) != nullptr);
+}
+
+TEST_CASE("Achieved rates follow the stand state", "[scheduler]") {
+  TelemetryScheduler scheduler(CHANNELS, CHANNEL_COUNT);
+  auto run = [&](StandState state, uint64_t start_us) {
+    scheduler.set_state(state, start_us);
+    scheduler.reset_stats(start_us);
+    const uint64_t end_us = start_us + 10 * 1000 * 1000;
+    for (uint64_t t = start_us; t < end_us; t += 1000) {
+      for (size_t c = 0; c < CHANNEL_COUNT; c++) {
+        scheduler.record(c, 1.0f, t);
+      }
+      if (t % (50 * 1000) == 0) {
+        uint8_t body[BODY_CAP];
+        scheduler.build(t, body, sizeof(body));
+      }
+    }
+    return end_us;
+  };
+
+  uint64_t now = run(StandState::kSafe, 0);
+  REQUIRE(scheduler.report(1, now).achieved_rate_hz == Approx(2).margin(0.2));
+  REQUIRE(scheduler.report(2, now).records == 0);
+  REQUIRE(scheduler.report(3, now).achieved_rate_hz == Approx(1).margin(0.2));
+  // Critical channels go out in every frame.
+  REQUIRE(scheduler.report(0, now).achieved_rate_hz == Approx(20).margin(0.2));
+
+  now = run(StandState::kFiring, now);
+  REQUIRE(scheduler.report(1, now).achieved_rate_hz == Approx(20).margin(1));
+  REQUIRE(scheduler.report(2, now).achieved_rate_hz == Approx(10).margin(1));
+  REQUIRE(scheduler.report(2, now).samples == 10000);
+}
@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+#include <cstdint>
+#include <thread>
+
+#include "telemetry/spsc_ring.h"
+
+TEST_CASE("Ring drops when full and keeps order", "[ring]") {
+  SpscRing<int, 4> ring;
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(ring.push(i));
+  }
+  REQUIRE_FALSE(ring.push(4));
+  REQUIRE(ring.dropped() == 1);
+  REQUIRE(ring.high_water() == 4);
+
+  int value;
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(ring.pop(&value));
+    REQUIRE(value == i);
+  }
+  REQUIRE_FALSE(ring.pop(&value));
+}
+
+TEST_CASE("Ring transfers in place between threads", "[ring]") {
+  struct Packet {
+    uint32_t seq;
+    uint8_t data[255];
+  };
+  constexpr uint32_t kPackets = 20000;
+  static SpscRing<Packet, 8> ring;
+
+  std::thread producer([] {
+    for (uint32_t seq = 0; seq < kPackets;) {
+      if (Packet* slot = ring.claim()) {
+        slot->seq = seq;
+        slot->data[254] = seq & 0xFF;
+        ring.publish();
+        seq++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  uint32_t expected = 0;
+  while (expected < kPackets) {
+    if (Packet* slot = ring.front()) {
+      REQUIRE(slot->seq == expected);
+      REQUIRE(slot->data[254] == (expected & 0xFF));
+      ring.pop();
+      expected++;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  REQUIRE(ring.size() == 0);
+}
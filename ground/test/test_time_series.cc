@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "time_series.h"
+
+namespace {
+
+// 1 kHz sine with a spike at sample 12345.
+TimeSeries make_series(uint32_t samples) {
+  TimeSeries series;
+  for (uint32_t i = 0; i < samples; i++) {
+    float value = i == 12345 ? 1000.0f : std::sin(i * 0.01f);
+    REQUIRE(series.append(i * 1000ull, value));
+  }
+  return series;
+}
+
+}  // namespace
+
+TEST_CASE("Time series returns raw samples for short ranges") {
+  TimeSeries series = make_series(1000);
+  std::vector<SeriesPoint> points;
+  REQUIRE(series.query(100000, 199999, 100, &points) == 100);
+  CHECK(points.front().t_first_us == 100000);
+  CHECK(points.back().t_first_us == 199000);
+  CHECK(points[5].count == 1);
+  CHECK(points[5].mean == series.values()[105]);
+
+  points.clear();
+  CHECK(series.query(2000000, 3000000, 100, &points) == 0);
+  CHECK(series.query(5000, 1000, 100, &points) == 0);
+}
+
+TEST_CASE("Time series queries stay within the point budget") {
+  const uint32_t samples = 100000;
+  TimeSeries series = make_series(samples);
+  CHECK(series.levels() == 6);  // 8^6 > 100000 > 8^5.
+
+  for (size_t budget : {1, 7, 100, 1000, 5000}) {
+    std::vector<SeriesPoint> points;
+    size_t count = series.query(0, samples * 1000ull, budget, &points);
+    REQUIRE(count > 0);
+    REQUIRE(count <= budget);
+    // Coarser levels only when needed.
+    CHECK(count * PYRAMID_FANOUT > std::min<size_t>(budget, samples));
+
+    // Points tile the series: every sample is counted once and extremes
+    // survive decimation.
+    uint64_t total = 0;
+    float max = points[0].max;
+    for (size_t i = 0; i < points.size(); i++) {
+      total += points[i].count;
+      max = std::max(max, points[i].max);
+      if (i > 0) {
+        CHECK(points[i].t_first_us > points[i - 1].t_last_us);
+      }
+    }
+    CHECK(total == samples);
+    CHECK(max == 1000.0f);
+  }
+}
+
+TEST_CASE("Time series points summarize their samples") {
+  TimeSeries series = make_series(4096);
+  std::vector<SeriesPoint> points;
+  // 4096 samples over 64 points: level 1, 64 samples each.
+  REQUIRE(series.query(0, 4095000, 64, &points) == 64);
+  for (const SeriesPoint& point : points) {
+    REQUIRE(point.count == 64);
+    size_t first = point.t_first_us / 1000;
+    auto begin = series.values().begin() + first;
+    auto end = begin + point.count;
+    CHECK(point.t_last_us == (first + 63) * 1000);
+    CHECK(point.min == *std::min_element(begin, end));
+    CHECK(point.max == *std::max_element(begin, end));
+    double sum = 0;
+    for (auto it = begin; it != end; ++it) {
+      sum += *it;
+    }
+    CHECK(point.mean == Approx(sum / point.count).margin(1e-5));
+  }
+}
+
+TEST_CASE("Time series index is current while ingesting") {
+  TimeSeries series;
+  std::vector<SeriesPoint> points;
+  for (uint32_t i = 0; i < 1000; i++) {
+    series.append(i, static_cast<float>(i));
+    points.clear();
+    series.query(0, i, 4, &points);
+    uint64_t total = 0;
+    for (const SeriesPoint& point : points) {
+      total += point.count;
+    }
+    REQUIRE(total == i + 1);
+    REQUIRE(points.back().max == static_cast<float>(i));
+  }
+  CHECK_FALSE(series.append(5, 0.0f));
+  CHECK(series.size() == 1000);
+}
@@ -0,0 +1,151 @@
+#include <catch2/catch.hpp>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "fan_in.h"
+#include "telemetry/frame.h"
+#include "telemetry/sample_stream.h"
+#include "telemetry/time_sync.h"
+
+namespace {
+
+// Host Unix time when the simulation starts, and the board's uptime then.
+constexpr uint64_t HOST_START_US = 1760000000ull * 1000000;
+constexpr uint64_t BOARD_START_US = 42 * 1000000;
+// The board's crystal runs fast.
+constexpr double BOARD_DRIFT = 40e-6;
+
+// A board and a host on a serial link, both clocks derived from true time
+// `t_us` since the start of the simulation.
+struct SimulatedLink {
+  std::mt19937 rng{7};
+  std::exponential_distribution<double> jitter_us{1 / 200.0};
+  std::uniform_real_distribution<double> chance{0, 1};
+
+  static uint64_t board_us(double t_us) {
+    return BOARD_START_US + std::llround(t_us * (1 + BOARD_DRIFT));
+  }
+  static uint64_t host_us(double t_us) {
+    return HOST_START_US + std::llround(t_us);
+  }
+
+  // One way: the wire plus a little jitter, and now and then a wait behind a
+  // burst of samples.
+  double delay_us(bool uplink_burst) {
+    double delay = 300 + jitter_us(rng);
+    if (uplink_burst && chance(rng) < 0.2) {
+      delay += 3000 + 5000 * chance(rng);
+    }
+    return delay;
+  }
+
+  // Runs one exchange started at true time `t_us` and feeds it to `sync`.
+  bool exchange(double t_us, ClockSync* sync) {
+    TimeReply reply;
+    reply.t1_us = board_us(t_us);
+    t_us += delay_us(true);
+    reply.t2_us = host_us(t_us);
+    t_us += 50;
+    reply.t3_us = host_us(t_us);
+    t_us += delay_us(false);
+    return sync->on_exchange(reply, board_us(t_us));
+  }
+};
+
+}  // namespace
+
+TEST_CASE("Time sync frames round-trip", "[time_sync]") {
+  uint8_t data[FRAME_MAX_SIZE];
+  size_t size = encode_time_request(9, 123456789012ull, data, sizeof(data));
+  REQUIRE(size == FRAME_OVERHEAD + TIME_REQUEST_PAYLOAD_SIZE);
+  Frame frame;
+  REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+  uint64_t t1_us;
+  REQUIRE(decode_time_request(frame, &t1_us));
+  REQUIRE(t1_us == 123456789012ull);
+  TimeReply reply;
+  REQUIRE_FALSE(decode_time_reply(frame, &reply));
+
+  size = encode_time_reply(
+      10, {.t1_us = 1, .t2_us = HOST_START_US, .t3_us = HOST_START_US + 50},
+      data, sizeof(data));
+  REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+  REQUIRE(decode_time_reply(frame, &reply));
+  REQUIRE(reply.t1_us == 1);
+  REQUIRE(reply.t2_us == HOST_START_US);
+  REQUIRE(reply.t3_us == HOST_START_US + 50);
+}
+
+TEST_CASE("Clock sync tracks offset and drift over a delayed link",
+          "[time_sync]") {
+  SimulatedLink link;
+  ClockSync sync(500);
+  REQUIRE_FALSE(sync.synced());
+
+  // Two minutes of exchanges once a second.
+  double t_us = 0;
+  for (int i = 0; i < 120; i++) {
+    link.exchange(t_us, &sync);
+    t_us += 1e6;
+  }
+  REQUIRE(sync.synced());
+  ClockSyncStats stats = sync.stats();
+  REQUIRE(stats.exchanges == 120);
+  // The exchanges stuck behind a burst are left out.
+  REQUIRE(stats.rejected > 10);
+  REQUIRE(stats.delay_min_us >= 600);
+  REQUIRE(stats.delay_max_us < 600 + 500 + 2000);
+  INFO("drift " << stats.drift_ppm);
+  REQUIRE(std::abs(stats.drift_ppm + 40) < 5);
+
+  // Board timestamps map to host time within a fraction of the one-way
+  // latency, now and a few seconds past the last exchange.
+  for (double later_us : {0.0, 5e6}) {
+    double at_us = t_us + later_us;
+    int64_t error_us =
+        static_cast<int64_t>(sync.to_host(SimulatedLink::board_us(at_us))) -
+        static_cast<int64_t>(SimulatedLink::host_us(at_us));
+    INFO("error " << error_us << " us, " << later_us << " us later");
+    REQUIRE(std::abs(error_us) < 100);
+  }
+
+  // Nonsense is rejected: a reply that claims to leave before it arrived.
+  REQUIRE_FALSE(sync.on_exchange(
+      {.t1_us = 10, .t2_us = HOST_START_US + 5, .t3_us = HOST_START_US},
+      20));
+}
+
+TEST_CASE("Fan-in measures the one-way latency of synced samples",
+          "[time_sync]") {
+  FanIn fan_in(0);
+  std::vector<MergedSample> feed;
+  for (uint64_t i = 0; i < 3; i++) {
+    RawSample samples[] = {
+        {.t_us = HOST_START_US + i * 10000, .channel = 0, .value = 1},
+        {.t_us = HOST_START_US + i * 10000 + 500, .channel = 1, .value = 2},
+    };
+    uint8_t data[FRAME_MAX_SIZE];
+    size_t consumed;
+    size_t size =
+        encode_samples_frame(4, i + 1, AckField{}, samples, 2,
+                             SampleClock::kHost, &consumed, data, sizeof(data));
+    Frame frame;
+    REQUIRE(decode_frame(data, size, &frame) == FrameError::kOk);
+    // Received 1 to 3 ms after the newest sample was taken.
+    REQUIRE(fan_in.on_frame(frame, samples[1].t_us + (i + 1) * 1000));
+  }
+  fan_in.flush(&feed);
+
+  const NodeStats& node = fan_in.node(4);
+  REQUIRE(node.synced_frames == 3);
+  REQUIRE(node.latency_min_us == 1000);
+  REQUIRE(node.latency_max_us == 3000);
+  REQUIRE(node.latency_mean_us() == 2000);
+  // Host time needs no offset.
+  REQUIRE(feed.size() == 6);
+  REQUIRE(feed.front().t_us == HOST_START_US);
+  REQUIRE(feed.back().t_us == HOST_START_US + 20500);
+}
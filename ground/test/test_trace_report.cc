@@ -0,0 +1,91 @@
+#include <catch2/catch.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "telemetry/frame.h"
+#include "telemetry/trace_report.h"
+
+TEST_CASE("Trace tables round-trip across frames", "[trace_report]") {
+  std::vector<TraceZoneStats> zones;
+  for (size_t i = 0; i < TRACE_ZONES_PER_FRAME + 3; i++) {
+    zones.push_back({
+        .zone = static_cast<uint8_t>(i),
+        .calls = static_cast<uint32_t>(1000 + i),
+        .total_cycles = 5000000000ull + i,
+        .max_cycles = static_cast<uint32_t>(240000 + i),
+    });
+  }
+
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t consumed;
+  size_t size =
+      encode_trace_frame(2, 9, AckField{.seq = 4, .bitmap = 1}, 240,
+                         zones.data(), zones.size(), &consumed, frame,
+                         sizeof(frame));
+  REQUIRE(size > 0);
+  REQUIRE(size <= FRAME_MAX_SIZE);
+  REQUIRE(consumed == TRACE_ZONES_PER_FRAME);
+
+  Frame decoded;
+  REQUIRE(decode_frame(frame, size, &decoded) == FrameError::kOk);
+  CHECK(decoded.type == FrameType::kTrace);
+  CHECK(decoded.node == 2);
+  CHECK(decoded.seq == 9);
+  AckField ack;
+  REQUIRE(decode_ack(decoded, &ack));
+  CHECK(ack.seq == 4);
+
+  TraceZoneStats out[TRACE_ZONES_PER_FRAME];
+  size_t count;
+  uint16_t cycles_per_us;
+  REQUIRE(decode_trace_frame(decoded, &cycles_per_us, out,
+                             TRACE_ZONES_PER_FRAME, &count));
+  CHECK(cycles_per_us == 240);
+  REQUIRE(count == TRACE_ZONES_PER_FRAME);
+  for (size_t i = 0; i < count; i++) {
+    CHECK(out[i].zone == zones[i].zone);
+    CHECK(out[i].calls == zones[i].calls);
+    CHECK(out[i].total_cycles == zones[i].total_cycles);
+    CHECK(out[i].max_cycles == zones[i].max_cycles);
+  }
+
+  // The rest in a second frame.
+  size = encode_trace_frame(2, 10, AckField{}, 240, &zones[consumed],
+                            zones.size() - consumed, &consumed, frame,
+                            sizeof(frame));
+  REQUIRE(consumed == 3);
+  REQUIRE(decode_frame(frame, size, &decoded) == FrameError::kOk);
+  REQUIRE(decode_trace_frame(decoded, &cycles_per_us, out,
+                             TRACE_ZONES_PER_FRAME, &count));
+  REQUIRE(count == 3);
+  CHECK(out[2].zone == zones.back().zone);
+}
+
+TEST_CASE("Trace frames reject other frames and bad lengths",
+          "[trace_report]") {
+  uint8_t frame[FRAME_MAX_SIZE];
+  size_t consumed;
+  TraceZoneStats zone = {.zone = 1, .calls = 1};
+  CHECK(encode_trace_frame(0, 1, AckField{}, 240, &zone, 0, &consumed, frame,
+                           sizeof(frame)) == 0);
+  CHECK(encode_trace_frame(0, 1, AckField{}, 240, &zone, 1, &consumed, frame,
+                           FRAME_OVERHEAD + ACK_FIELD_SIZE) == 0);
+
+  TraceZoneStats out[1];
+  size_t count;
+  uint16_t cycles_per_us;
+  uint8_t payload[ACK_FIELD_SIZE + TRACE_BODY_HEADER_SIZE + 1] = {};
+  // Claims a zone but carries a single byte of it.
+  payload[ACK_FIELD_SIZE + 2] = 1;
+  size_t size = encode_frame(FrameType::kTrace, 0, 1, payload,
+                             sizeof(payload), frame, sizeof(frame));
+  Frame decoded;
+  REQUIRE(decode_frame(frame, size, &decoded) == FrameError::kOk);
+  CHECK_FALSE(decode_trace_frame(decoded, &cycles_per_us, out, 1, &count));
+
+  size = encode_frame(FrameType::kSamples, 0, 1, payload, sizeof(payload),
+                      frame, sizeof(frame));
+  REQUIRE(decode_frame(frame, size, &decoded) == FrameError::kOk);
+  CHECK_FALSE(decode_trace_frame(decoded, &cycles_per_us, out, 1, &count));
+}
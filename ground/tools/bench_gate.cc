@@ -0,0 +1,97 @@
+// Fails when a microbenchmark run is slower than a stored baseline:
+//
+//   for i in 1 2 3; do micro_bench; done > baseline.csv
+//   ... change the code ...
+//   for i in 1 2 3; do micro_bench; done | bench_gate baseline.csv -
+//   bench_gate board_baseline.csv console.log --tolerance 3
+//
+// Reads the "bench," lines of each file ("-" for stdin), so a board's
+// console capture works as it is. Repeated runs, in one file or several,
+// keep each benchmark's fastest result, which steadies a shared host. Prints one CSV line per benchmark with its
+// median before and after, the change and the verdict (see bench_gate.h),
+// and exits with 1 if any benchmark got slower or went missing. --update
+// stores the run as the new baseline afterwards. Keep one baseline per
+// machine: the host's are nanoseconds, the board's CPU cycles.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "bench_gate.h"
+
+namespace {
+
+// Default --tolerance, in percent.
+constexpr double DEFAULT_TOLERANCE_PERCENT = 5;
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr,
+                 "usage: %s <baseline> <results|->... [--tolerance PERCENT] "
+                 "[--update]\n",
+                 argv[0]);
+    return 2;
+  }
+  double tolerance_percent = DEFAULT_TOLERANCE_PERCENT;
+  bool update = false;
+  std::vector<const char*> results;
+  for (int i = 2; i < argc; i++) {
+    if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      tolerance_percent = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--update") == 0) {
+      update = true;
+    } else if (std::strncmp(argv[i], "--", 2) == 0) {
+      std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+      return 2;
+    } else {
+      results.push_back(argv[i]);
+    }
+  }
+
+  std::vector<BenchRecord> run;
+  for (const char* path : results) {
+    if (!load_bench_results(path, &run)) {
+      std::fprintf(stderr, "can't read %s\n", path);
+      return 1;
+    }
+  }
+  if (run.empty()) {
+    std::fprintf(stderr, "no benchmark results\n");
+    return 1;
+  }
+  std::vector<BenchRecord> baseline;
+  if (!load_bench_results(argv[1], &baseline)) {
+    if (!update) {
+      std::fprintf(stderr, "can't read baseline %s\n", argv[1]);
+      return 1;
+    }
+    std::fprintf(stderr, "no baseline yet, creating %s\n", argv[1]);
+  }
+
+  std::vector<BenchComparison> comparisons =
+      compare_bench_results(baseline, run, tolerance_percent / 100);
+  int failures = 0;
+  std::printf("name,baseline_median,median,delta_percent,verdict\n");
+  for (const BenchComparison& comparison : comparisons) {
+    std::printf("%s,%.1f,%.1f,%+.1f,%s\n", comparison.name.c_str(),
+                comparison.baseline_median, comparison.median,
+                100 * comparison.delta,
+                bench_verdict_name(comparison.verdict));
+    failures += comparison.failed();
+  }
+  std::fprintf(stderr, "%zu benchmarks, %d failed (tolerance %.1f%%)\n",
+               comparisons.size(), failures, tolerance_percent);
+
+  if (update) {
+    if (!save_bench_results(argv[1], run)) {
+      std::fprintf(stderr, "can't write baseline %s\n", argv[1]);
+      return 1;
+    }
+    std::fprintf(stderr, "baseline %s updated\n", argv[1]);
+  }
+  return failures > 0 ? 1 : 0;
+}
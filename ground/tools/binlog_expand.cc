@@ -0,0 +1,34 @@
+// Expands the deferred log records in a board's console output and passes
+// every other line through unchanged:
+//
+//   pio device monitor | binlog_expand
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "binlog/binlog.h"
+#include "binlog_expand.h"
+
+int main() {
+  BinLogExpander expander;
+  std::string line;
+  uint32_t bad = 0;
+  while (std::getline(std::cin, line)) {
+    BinLogRecord record;
+    if (parse_binlog_line(line.data(), line.size(), &record)) {
+      std::cout << expander.expand(record) << '\n';
+      continue;
+    }
+    if (line.compare(0, std::strlen(BINLOG_LINE_PREFIX), BINLOG_LINE_PREFIX) ==
+        0) {
+      bad++;
+    }
+    std::cout << line << '\n';
+  }
+  if (bad > 0) {
+    std::fprintf(stderr, "%u malformed records\n", bad);
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+// Prints at most <points> min/max/mean points of one channel of a column file
+// over [t0_ms, t1_ms], as CSV for plotting:
+//
+//   capture_plot columns.bin 0 0 600000 2000 > chamber.csv
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "column_reader.h"
+#include "time_series.h"
+
+int main(int argc, char** argv) {
+  if (argc != 6) {
+    std::fprintf(stderr, "usage: %s <file> <channel> <t0_ms> <t1_ms> <points>\n",
+                 argv[0]);
+    return 2;
+  }
+  ColumnFileReader reader;
+  if (!reader.open(argv[1])) {
+    std::fprintf(stderr, "%s\n", reader.error().c_str());
+    return 1;
+  }
+  uint16_t channel = std::atoi(argv[2]);
+  uint64_t t0_us = std::strtoull(argv[3], nullptr, 10) * 1000;
+  uint64_t t1_us = std::strtoull(argv[4], nullptr, 10) * 1000;
+  size_t max_points = std::strtoul(argv[5], nullptr, 10);
+
+  auto start = std::chrono::steady_clock::now();
+  TimeSeries series;
+  for (const ColumnBlockView& block : reader.blocks(channel)) {
+    for (size_t i = 0; i < block.t_us.size; i++) {
+      series.append(block.t_us[i], block.value[i]);
+    }
+  }
+  auto indexed = std::chrono::steady_clock::now();
+  std::vector<SeriesPoint> points;
+  series.query(t0_us, t1_us, max_points, &points);
+  auto queried = std::chrono::steady_clock::now();
+
+  std::printf("t_first_us,t_last_us,count,min,max,mean\n");
+  for (const SeriesPoint& point : points) {
+    std::printf("%llu,%llu,%u,%g,%g,%g\n",
+                static_cast<unsigned long long>(point.t_first_us),
+                static_cast<unsigned long long>(point.t_last_us), point.count,
+                point.min, point.max, point.mean);
+  }
+  std::fprintf(
+      stderr, "%zu samples indexed in %.1f ms, %zu points in %.3f ms\n",
+      series.size(),
+      std::chrono::duration<double, std::milli>(indexed - start).count(),
+      points.size(),
+      std::chrono::duration<double, std::milli>(queried - indexed).count());
+  return 0;
+}
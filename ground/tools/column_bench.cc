@@ -0,0 +1,93 @@
+// Writes a synthetic capture (every channel at 1 kHz) as a column file and
+// times opening it and reading every sample through the mapping.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "column_reader.h"
+#include "datalog/column_file.h"
+#include "file_flash.h"
+
+namespace {
+
+constexpr uint16_t CHANNELS = 8;
+
+double ms_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t seconds = argc > 1 ? std::atoi(argv[1]) : 300;
+  std::string path =
+      (std::filesystem::temp_directory_path() / "column_bench.bin").string();
+  std::filesystem::remove(path);
+
+  uint64_t samples = uint64_t{seconds} * 1000 * CHANNELS;
+  uint64_t bytes = sizeof(ColumnFileHeader) +
+                   (samples / COLUMN_BLOCK_SAMPLES + CHANNELS) *
+                       (sizeof(ColumnBlock) + sizeof(ColumnIndexEntry));
+  uint32_t size =
+      (bytes / FLASH_SECTOR_SIZE + 2) * FLASH_SECTOR_SIZE;
+
+  static ColumnBlock blocks[COLUMN_MAX_CHANNELS];
+  ColumnChannel channels[CHANNELS];
+  for (uint16_t i = 0; i < CHANNELS; i++) {
+    channels[i] = {.type = RecordType::kPt,
+                   .id = static_cast<uint8_t>(i),
+                   .reserved = 0};
+  }
+  auto start = std::chrono::steady_clock::now();
+  {
+    FileFlash flash(path, size);
+    ColumnWriter writer(&flash, blocks);
+    if (!writer.open(channels, CHANNELS, 1)) {
+      std::fprintf(stderr, "can't write %s\n", path.c_str());
+      return 1;
+    }
+    for (uint64_t t_ms = 0; t_ms < uint64_t{seconds} * 1000; t_ms++) {
+      for (uint16_t i = 0; i < CHANNELS; i++) {
+        writer.append(i, t_ms * 1000, 100 * std::sin(t_ms * 0.001f + i));
+      }
+    }
+    writer.finish();
+  }
+  double write_ms = ms_since(start);
+
+  start = std::chrono::steady_clock::now();
+  ColumnFileReader reader;
+  if (!reader.open(path)) {
+    std::fprintf(stderr, "%s\n", reader.error().c_str());
+    return 1;
+  }
+  double open_ms = ms_since(start);
+
+  start = std::chrono::steady_clock::now();
+  double sum = 0;
+  uint64_t read = 0;
+  for (uint16_t i = 0; i < CHANNELS; i++) {
+    for (const ColumnBlockView& block : reader.blocks(i)) {
+      for (float value : block.value) {
+        sum += value;
+      }
+      read += block.value.size;
+    }
+  }
+  double scan_ms = ms_since(start);
+
+  std::printf("%u s, %u channels at 1 kHz: %llu samples, %.1f MB\n", seconds,
+              CHANNELS, static_cast<unsigned long long>(read),
+              std::filesystem::file_size(path) / 1e6);
+  std::printf("write %.0f ms, open %.2f ms, read all %.2f ms (sum %g)\n",
+              write_ms, open_ms, scan_ms, sum);
+  std::filesystem::remove(path);
+  return 0;
+}
@@ -0,0 +1,65 @@
+// Prints a column file: a summary of its channels and blocks, or one channel
+// as CSV. Reads files written by the host build or the column partition image
+// from the board:
+//
+//   esptool.py read_flash 0x188000 0x78000 columns.bin
+//   column_dump columns.bin        # summary
+//   column_dump columns.bin 0      # channel 0 as t_us,value
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "column_reader.h"
+
+int main(int argc, char** argv) {
+  if (argc != 2 && argc != 3) {
+    std::fprintf(stderr, "usage: %s <file> [channel]\n", argv[0]);
+    return 2;
+  }
+  ColumnFileReader reader;
+  if (!reader.open(argv[1])) {
+    std::fprintf(stderr, "%s\n", reader.error().c_str());
+    return 1;
+  }
+
+  if (argc == 3) {
+    uint16_t channel = std::atoi(argv[2]);
+    std::printf("t_us,value\n");
+    for (const ColumnBlockView& block : reader.blocks(channel)) {
+      for (size_t i = 0; i < block.t_us.size; i++) {
+        std::printf("%llu,%g\n",
+                    static_cast<unsigned long long>(block.t_us[i]),
+                    block.value[i]);
+      }
+    }
+    return 0;
+  }
+
+  const ColumnFileHeader& header = reader.header();
+  std::printf("session %u, %zu blocks%s\n", header.session,
+              reader.index().size(), reader.finished() ? "" : ", unfinished");
+  std::printf("channel,type,id,samples,blocks,t_first_us,t_last_us,min,max\n");
+  for (uint16_t channel = 0; channel < reader.channel_count(); channel++) {
+    auto blocks = reader.blocks(channel);
+    float min = 0;
+    float max = 0;
+    for (const ColumnBlockView& block : blocks) {
+      bool first = &block == &blocks.front();
+      min = first ? block.entry->min : std::min(min, block.entry->min);
+      max = first ? block.entry->max : std::max(max, block.entry->max);
+    }
+    std::printf("%u,%u,%u,%llu,%zu,%llu,%llu,%g,%g\n", channel,
+                static_cast<unsigned>(header.channels[channel].type),
+                header.channels[channel].id,
+                static_cast<unsigned long long>(reader.sample_count(channel)),
+                blocks.size(),
+                static_cast<unsigned long long>(
+                    blocks.empty() ? 0 : blocks.front().entry->t_first_us),
+                static_cast<unsigned long long>(
+                    blocks.empty() ? 0 : blocks.back().entry->t_last_us),
+                min, max);
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+// Sends commands to a board and reports what became of each. Writes kCommand
+// frames to a serial device whose other end puts them on air (a ground radio,
+// or fake_board's PTY), and reads the board's acknowledgements from the
+// downlink frames coming back on it:
+//
+//   command_send /dev/ttyUSB0 0 arm open_valve:2 [--baud N] [--session S]
+//
+// Commands go out one at a time, each once the previous was executed, and
+// the first one refused or lost stops the rest. Exits with 0 if all were
+// executed. The device carries the downlink too, so ingestd can't hold it
+// meanwhile.
+//
+// Each run is a new CommandSender session (random unless --session), so the
+// board doesn't take its ids, which start at 1 again, for the previous run's.
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "serial_port.h"
+#include "telemetry/command_link.h"
+#include "telemetry/frame.h"
+#include "telemetry/frame_stream.h"
+
+namespace {
+
+constexpr int POLL_PERIOD_MS = 5;
+// The board acknowledges right away, but its radio task may be sending a
+// frame or waiting for its TDMA slot, and the ground radio adds its own
+// latency; well above command_round_trip_us() for the board's SF7, 125 kHz.
+constexpr uint32_t RETRANSMIT_TIMEOUT_US = 500 * 1000;
+constexpr uint8_t MAX_RETRIES = 5;
+
+struct CommandName {
+  const char* name;
+  CommandType type;
+  bool takes_arg;
+};
+
+constexpr CommandName COMMAND_NAMES[] = {
+    {"open_valve", CommandType::kOpenValve, true},
+    {"close_valve", CommandType::kCloseValve, true},
+    {"arm", CommandType::kArm, false},
+    {"disarm", CommandType::kDisarm, false},
+    {"abort", CommandType::kAbort, false},
+    {"erase_log", CommandType::kEraseLog, false},
+    {"mark", CommandType::kMark, true},
+    {"trace", CommandType::kTrace, true},
+    {"memory", CommandType::kMemory, false},
+};
+
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Parses NAME or NAME:ARG.
+bool parse_command(const std::string& text, uint16_t id, Command* command) {
+  const size_t colon = text.find(':');
+  const std::string name = text.substr(0, colon);
+  for (const CommandName& entry : COMMAND_NAMES) {
+    if (name != entry.name || (colon != std::string::npos) != entry.takes_arg) {
+      continue;
+    }
+    *command = {
+        .id = id,
+        .type = entry.type,
+        .arg = entry.takes_arg
+                   ? static_cast<uint8_t>(std::atoi(&text[colon + 1]))
+                   : uint8_t{0},
+    };
+    return true;
+  }
+  return false;
+}
+
+const char* status_name(CommandStatus status) {
+  switch (status) {
+    case CommandStatus::kExecuted:
+      return "executed";
+    case CommandStatus::kRefused:
+      return "refused";
+    case CommandStatus::kLost:
+      return "lost";
+  }
+  return "?";
+}
+
+// Sends `command` and waits for its outcome.
+CommandOutcome send_command(int serial, CommandSender* sender,
+                            FrameStreamParser* parser,
+                            const Command& command) {
+  sender->send(command);
+  CommandOutcome outcome;
+  while (!sender->pop_outcome(&outcome)) {
+    uint8_t frame[FRAME_MAX_SIZE];
+    size_t size = sender->poll(now_us(), frame, sizeof(frame));
+    if (size > 0 &&
+        write(serial, frame, size) != static_cast<ssize_t>(size)) {
+      std::fprintf(stderr, "write failed\n");
+    }
+    pollfd pfd = {serial, POLLIN, 0};
+    if (poll(&pfd, 1, POLL_PERIOD_MS) <= 0 || !(pfd.revents & POLLIN)) {
+      continue;
+    }
+    uint8_t data[512];
+    ssize_t n;
+    while ((n = read(serial, data, sizeof(data))) > 0) {
+      parser->push(data, n, [&](const Frame& downlink) {
+        sender->on_downlink(downlink, now_us());
+      });
+    }
+  }
+  return outcome;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> texts;
+  int baud = 0;
+  int session = -1;
+  for (int i = 3; i < argc; i++) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--baud") == 0) {
+      baud = std::atoi(argv[++i]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--session") == 0) {
+      session = std::atoi(argv[++i]);
+    } else {
+      texts.push_back(argv[i]);
+    }
+  }
+  if (argc < 4 || texts.empty()) {
+    std::fprintf(stderr,
+                 "usage: %s <device> <node> <command[:arg]>... [--baud N] "
+                 "[--session S]\n",
+                 argv[0]);
+    return 2;
+  }
+  const int node = std::atoi(argv[2]);
+  if (node < 0 || node > FRAME_MAX_NODE) {
+    std::fprintf(stderr, "node must be 0-%d\n", FRAME_MAX_NODE);
+    return 2;
+  }
+  std::vector<Command> commands;
+  for (const std::string& text : texts) {
+    Command command;
+    if (!parse_command(text, commands.size() + 1, &command)) {
+      std::fprintf(stderr, "unknown command %s\n", text.c_str());
+      return 2;
+    }
+    commands.push_back(command);
+  }
+
+  int serial = open_serial(argv[1], baud);
+  if (serial < 0) {
+    std::fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+  if (session < 0) {
+    session = std::random_device()() & 0xFF;
+  }
+  const CommandLinkConfig config = {
+      .retransmit_timeout_us = RETRANSMIT_TIMEOUT_US,
+      .max_retries = MAX_RETRIES,
+  };
+  CommandSender sender(config, node, session);
+  FrameStreamParser parser;
+
+  int exit_code = 0;
+  for (size_t i = 0; i < commands.size(); i++) {
+    CommandOutcome outcome =
+        send_command(serial, &sender, &parser, commands[i]);
+    std::printf("%s: %s in %.1f ms\n", texts[i].c_str(),
+                status_name(outcome.status), outcome.latency_us / 1000.0);
+    if (outcome.status != CommandStatus::kExecuted) {
+      exit_code = 1;
+      break;
+    }
+  }
+  const CommandLinkStats& stats = sender.stats();
+  std::fprintf(stderr, "session %d, %u transmissions, %u retransmissions\n",
+               session, stats.transmissions, stats.retransmissions);
+  close(serial);
+  return exit_code;
+}
@@ -0,0 +1,198 @@
+// Compression ratio and cost of the on-device sample compression (see
+// compress/gorilla.h) on synthetic captures, and on the channels of any
+// column files given, e.g. a board's capture:
+//
+//   esptool.py read_flash 0x188000 0x78000 columns.bin
+//   compress_bench [--block BYTES] [columns.bin...]
+//
+// The ratio is against 12 bytes per sample (u64 timestamp, f32 value). The
+// board logs the same ratio and its own cost per sample for every capture it
+// exports.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "column_reader.h"
+#include "compress/gorilla.h"
+#include "series_codec.h"
+
+namespace {
+
+// Frame-sized blocks by default.
+constexpr size_t DEFAULT_BLOCK_SIZE = 240;
+// Samples compressed per timing run; short series are repeated.
+constexpr size_t TIMED_SAMPLES = 4000000;
+
+struct Series {
+  std::string name;
+  std::vector<uint64_t> t_us;
+  std::vector<float> values;
+};
+
+// `seconds` at `rate_hz`, with the scheduling jitter of an acquisition task.
+Series make_series(const std::string& name, double seconds, double rate_hz,
+                   uint32_t jitter_us, float (*value)(double t, std::mt19937&)) {
+  Series series{name, {}, {}};
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> jitter(-static_cast<int>(jitter_us),
+                                            jitter_us);
+  size_t count = seconds * rate_hz;
+  for (size_t i = 0; i < count; i++) {
+    double t = i / rate_hz;
+    series.t_us.push_back(1000000 + static_cast<uint64_t>(t * 1e6) +
+                          jitter(rng));
+    series.values.push_back(value(t, rng));
+  }
+  return series;
+}
+
+// Chamber pressure over a 10 s burn: ramp, plateau, tail-off.
+double burn_psi(double t) {
+  if (t < 2 || t > 12) {
+    return 0;
+  }
+  return 300 * (1 - std::exp(-(t - 2) * 4)) * (t > 11 ? 12 - t : 1);
+}
+
+// 12-bit MCP3204 code for a 0.5-4.5 V, 1000 psi PT, with a count of noise.
+int adc_code(double psi, std::mt19937& rng) {
+  int noise = std::uniform_int_distribution<int>(-1, 1)(rng);
+  return static_cast<int>((0.5 + psi / 1000 * 4) / 5 * 4096) + noise;
+}
+
+std::vector<Series> synthetic() {
+  std::vector<Series> series;
+  // What read_pt() returns: whole psi.
+  series.push_back(make_series(
+      "pt_psi_1khz", 15, 1000, 15, [](double t, std::mt19937& rng) {
+        float volts = adc_code(burn_psi(t), rng) * 5.0f / 4096;
+        return static_cast<float>(static_cast<uint16_t>(
+            std::max(0.0f, volts - 0.5f) / 4.0f * 1000));
+      }));
+  // The same PT converted without rounding.
+  series.push_back(make_series(
+      "pt_float_1khz", 15, 1000, 15, [](double t, std::mt19937& rng) {
+        float volts = adc_code(burn_psi(t), rng) * 5.0f / 4096;
+        return std::max(0.0f, volts - 0.5f) / 4.0f * 1000;
+      }));
+  // The same PT on an exact clock, e.g. timestamps from a hardware timer.
+  series.push_back(make_series(
+      "pt_psi_1khz_exact", 15, 1000, 0, [](double t, std::mt19937& rng) {
+        float volts = adc_code(burn_psi(t), rng) * 5.0f / 4096;
+        return static_cast<float>(static_cast<uint16_t>(
+            std::max(0.0f, volts - 0.5f) / 4.0f * 1000));
+      }));
+  // HX711 raw counts at 80 Hz.
+  series.push_back(make_series(
+      "load_cell_80hz", 15, 80, 15, [](double t, std::mt19937& rng) {
+        return static_cast<float>(
+            8388000 + static_cast<int>(burn_psi(t) * 40) +
+            std::uniform_int_distribution<int>(-60, 60)(rng));
+      }));
+  // Valve bitmap, sampled with housekeeping.
+  series.push_back(make_series(
+      "valve_states_2hz", 600, 2, 0, [](double t, std::mt19937& rng) {
+        return t > 300 && t < 312 ? 7.0f : 0.0f;
+      }));
+  // Worst case for XOR coding: every mantissa bit changes.
+  series.push_back(make_series(
+      "sine_float_1khz", 15, 1000, 15, [](double t, std::mt19937& rng) {
+        return static_cast<float>(100 * std::sin(t));
+      }));
+  return series;
+}
+
+std::vector<Series> from_column_file(const std::string& path) {
+  std::vector<Series> series;
+  ColumnFileReader reader;
+  if (!reader.open(path)) {
+    std::fprintf(stderr, "%s: %s\n", path.c_str(), reader.error().c_str());
+    return series;
+  }
+  for (uint16_t channel = 0; channel < reader.channel_count(); channel++) {
+    Series s{path + ":" + std::to_string(channel), {}, {}};
+    for (const ColumnBlockView& block : reader.blocks(channel)) {
+      s.t_us.insert(s.t_us.end(), block.t_us.begin(), block.t_us.end());
+      s.values.insert(s.values.end(), block.value.begin(), block.value.end());
+    }
+    if (!s.t_us.empty()) {
+      series.push_back(std::move(s));
+    }
+  }
+  return series;
+}
+
+double ns_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t block_size = DEFAULT_BLOCK_SIZE;
+  std::vector<Series> all = synthetic();
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && std::strcmp(argv[i], "--block") == 0) {
+      block_size = std::atoi(argv[++i]);
+    } else {
+      for (Series& series : from_column_file(argv[i])) {
+        all.push_back(std::move(series));
+      }
+    }
+  }
+  if (block_size < GORILLA_MIN_BLOCK_SIZE || block_size > UINT16_MAX) {
+    std::fprintf(stderr, "block size must be %zu to %u bytes\n",
+                 GORILLA_MIN_BLOCK_SIZE, UINT16_MAX);
+    return 2;
+  }
+
+  std::printf("series,samples,raw_bytes,compressed_bytes,ratio,bits_per_sample,"
+              "encode_ns_per_sample,decode_ns_per_sample\n");
+  for (const Series& series : all) {
+    size_t count = series.t_us.size();
+    std::vector<uint8_t> stream;
+    size_t runs = std::max<size_t>(1, TIMED_SAMPLES / count);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t run = 0; run < runs; run++) {
+      stream.clear();
+      compress_series(series.t_us.data(), series.values.data(), count,
+                      block_size, &stream);
+    }
+    double encode_ns = ns_since(start) / (runs * count);
+
+    std::vector<uint64_t> t_us;
+    std::vector<float> values;
+    t_us.reserve(count);
+    values.reserve(count);
+    start = std::chrono::steady_clock::now();
+    for (size_t run = 0; run < runs; run++) {
+      t_us.clear();
+      values.clear();
+      decompress_series(stream.data(), stream.size(), &t_us, &values);
+    }
+    double decode_ns = ns_since(start) / (runs * count);
+    if (t_us != series.t_us ||
+        std::memcmp(values.data(), series.values.data(),
+                    count * sizeof(float)) != 0) {
+      std::fprintf(stderr, "%s: round trip mismatch\n", series.name.c_str());
+      return 1;
+    }
+
+    size_t raw = count * (sizeof(uint64_t) + sizeof(float));
+    std::printf("%s,%zu,%zu,%zu,%.2f,%.2f,%.1f,%.1f\n", series.name.c_str(),
+                count, raw, stream.size(),
+                static_cast<double>(raw) / stream.size(),
+                8.0 * stream.size() / count, encode_ns, decode_ns);
+  }
+  return 0;
+}
@@ -0,0 +1,207 @@
+// Stands in for a board on a serial link: creates a PTY and streams the
+// downlink frames of simulated boards into it, so ingestd can be run without
+// hardware:
+//
+//   fake_board [--boards N] [--seconds S] [--corrupt P] [--fast] [--wired]
+//   ingestd /dev/pts/N capture/
+//
+// --corrupt flips a random bit in a fraction P of the frames. --fast sends as
+// fast as the PTY accepts instead of in real time. --wired behaves like a
+// board on the cable: while the reader sends heartbeats every sample goes out
+// in kSamples frames, and otherwise the LoRa telemetry schedule is used.
+//
+// The boards also take kCommand frames written to the PTY, as if a ground
+// radio put them on air, and acknowledge them right away, so command_send
+// can be tried out:
+//
+//   command_send /dev/pts/N 0 arm erase_log
+
+#include <poll.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board_sim.h"
+#include "serial_port.h"
+#include "telemetry/frame.h"
+#include "telemetry/frame_stream.h"
+
+namespace {
+
+constexpr uint64_t SAMPLE_PERIOD_US = 1000;
+// Same as WIRED_LINK_TIMEOUT_MS and WIRED_TASK_PERIOD_MS on the board.
+constexpr uint64_t LINK_TIMEOUT_US = 1000 * 1000;
+constexpr uint64_t WIRED_PERIOD_US = 10 * 1000;
+
+// Writes all of `data`, waiting for the reader to drain the PTY.
+bool write_all(int fd, const uint8_t* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = write(fd, data, len);
+    if (n > 0) {
+      data += n;
+      len -= n;
+      continue;
+    }
+    pollfd pfd = {fd, POLLOUT, 0};
+    if (poll(&pfd, 1, 1000) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Reads what the reader sent and hands commands to the boards. Returns
+// whether it included a heartbeat.
+bool read_host_frames(int fd, FrameStreamParser* parser,
+                      std::vector<SimulatedBoard>* boards) {
+  bool heartbeat = false;
+  uint8_t data[256];
+  pollfd pfd = {fd, POLLIN, 0};
+  while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+    ssize_t n = read(fd, data, sizeof(data));
+    if (n <= 0) {
+      break;
+    }
+    parser->push(data, n, [&](const Frame& frame) {
+      heartbeat |= frame.type == FrameType::kHeartbeat;
+      if (frame.type != FrameType::kCommand) {
+        return;
+      }
+      // The packet as the ground radio would put it on air.
+      uint8_t packet[FRAME_MAX_SIZE];
+      size_t size = encode_frame(frame.type, frame.node, frame.seq,
+                                 frame.payload, frame.payload_len, packet,
+                                 sizeof(packet));
+      for (SimulatedBoard& board : *boards) {
+        board.on_uplink(packet, size);
+      }
+    });
+  }
+  return heartbeat;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int board_count = 1;
+  double seconds = 60;
+  double corrupt = 0;
+  bool fast = false;
+  bool wired = false;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--fast") == 0) {
+      fast = true;
+    } else if (std::strcmp(argv[i], "--wired") == 0) {
+      wired = true;
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--boards") == 0) {
+      board_count = std::atoi(argv[++i]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--seconds") == 0) {
+      seconds = std::atof(argv[++i]);
+    } else if (i + 1 < argc && std::strcmp(argv[i], "--corrupt") == 0) {
+      corrupt = std::atof(argv[++i]);
+    }
+  }
+
+  std::string slave;
+  int pty = open_pty(&slave);
+  if (pty < 0) {
+    std::fprintf(stderr, "can't create a PTY\n");
+    return 1;
+  }
+  std::printf("%s\n", slave.c_str());
+  std::fflush(stdout);
+
+  std::vector<SimulatedBoard> boards;
+  for (int i = 0; i < board_count; i++) {
+    boards.emplace_back(i, 1000000 * (i + 1));
+  }
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> chance(0, 1);
+  const uint64_t frame_period_us = 1e6 / BOARD_SIM_FRAME_RATE_HZ;
+  const uint64_t duration_us = seconds * 1e6;
+  uint64_t frames = 0;
+  uint64_t corrupted = 0;
+  FrameStreamParser parser;
+  bool heard = false;
+  uint64_t last_heartbeat_us = 0;
+  auto send = [&](uint8_t* frame, size_t size) {
+    if (chance(rng) < corrupt) {
+      frame[rng() % size] ^= 1 << (rng() % 8);
+      corrupted++;
+    }
+    if (!write_all(pty, frame, size)) {
+      std::fprintf(stderr, "write failed\n");
+      return false;
+    }
+    frames++;
+    return true;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t now_us = 0; now_us < duration_us;
+       now_us += SAMPLE_PERIOD_US) {
+    if (!fast) {
+      std::this_thread::sleep_until(start +
+                                    std::chrono::microseconds(now_us));
+    }
+    if (now_us % WIRED_PERIOD_US == 0) {
+      if (read_host_frames(pty, &parser, &boards)) {
+        heard = true;
+        last_heartbeat_us = now_us;
+      }
+      for (SimulatedBoard& board : boards) {
+        uint8_t frame[FRAME_MAX_SIZE];
+        size_t size = board.ack_frame(frame, sizeof(frame));
+        if (size > 0 && !send(frame, size)) {
+          return 1;
+        }
+      }
+    }
+    if (wired && now_us % WIRED_PERIOD_US == 0) {
+      bool link_up = heard && now_us - last_heartbeat_us < LINK_TIMEOUT_US;
+      if (!boards.empty() && link_up != boards[0].wired()) {
+        std::fprintf(stderr, "%.3f s: link %s\n", now_us / 1e6,
+                     link_up ? "up, sending samples" : "down");
+        for (SimulatedBoard& board : boards) {
+          board.set_wired(link_up);
+        }
+      }
+    }
+    for (int i = 0; i < board_count; i++) {
+      boards[i].sample(now_us);
+      uint8_t frame[FRAME_MAX_SIZE];
+      size_t size;
+      if (boards[i].wired()) {
+        if (now_us % WIRED_PERIOD_US != 0) {
+          continue;
+        }
+        // Everything queued since the last period, like the wired task.
+        while ((size = boards[i].samples_frame(frame, sizeof(frame))) > 0) {
+          if (!send(frame, size)) {
+            return 1;
+          }
+        }
+      } else if (now_us % frame_period_us == 0) {
+        size = boards[i].frame(now_us, frame, sizeof(frame));
+        if (size > 0 && !send(frame, size)) {
+          return 1;
+        }
+      }
+    }
+  }
+  std::fprintf(stderr, "%llu frames, %llu corrupted\n",
+               static_cast<unsigned long long>(frames),
+               static_cast<unsigned long long>(corrupted));
+  // Let the reader drain the PTY before it goes away.
+  sleep(1);
+  close(pty);
+  return 0;
+}
@@ -0,0 +1,94 @@
+// Measures how fast the ground fan-in ingests telemetry as the number of
+// boards grows. Every board sends a frame at BOARD_SIM_FRAME_RATE_HZ; frames
+// are pre-encoded so only decode and merge are timed.
+//
+//   fan_in_sim [seconds of traffic per board]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "board_sim.h"
+#include "fan_in.h"
+#include "telemetry/frame.h"
+
+namespace {
+
+constexpr uint64_t SAMPLE_PERIOD_US = 1000;
+constexpr uint64_t MAX_DELAY_US = 30 * 1000;
+constexpr uint64_t REORDER_WINDOW_US = 100 * 1000;
+
+struct Arrival {
+  uint64_t rx_us;
+  std::vector<uint8_t> data;
+};
+
+std::vector<Arrival> generate(int nodes, uint64_t duration_us) {
+  std::mt19937 rng(nodes);
+  std::vector<SimulatedBoard> boards;
+  for (int i = 0; i < nodes; i++) {
+    boards.emplace_back(
+        i, std::uniform_int_distribution<uint64_t>(0, 20000000)(rng));
+  }
+  const uint64_t frame_period_us = 1e6 / BOARD_SIM_FRAME_RATE_HZ;
+
+  std::vector<Arrival> arrivals;
+  for (uint64_t now_us = 0; now_us < duration_us; now_us += SAMPLE_PERIOD_US) {
+    for (int i = 0; i < nodes; i++) {
+      boards[i].sample(now_us);
+      if ((now_us + i * 7000) % frame_period_us != 0) {
+        continue;
+      }
+      uint8_t frame[FRAME_MAX_SIZE];
+      size_t size = boards[i].frame(now_us, frame, sizeof(frame));
+      uint64_t delay_us =
+          std::uniform_int_distribution<uint64_t>(0, MAX_DELAY_US)(rng);
+      arrivals.push_back({now_us + delay_us,
+                          std::vector<uint8_t>(frame, frame + size)});
+    }
+  }
+  std::stable_sort(arrivals.begin(), arrivals.end(),
+                   [](const Arrival& a, const Arrival& b) {
+                     return a.rx_us < b.rx_us;
+                   });
+  return arrivals;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const double seconds = argc > 1 ? std::atof(argv[1]) : 60;
+  const uint64_t duration_us = seconds * 1e6;
+
+  std::printf("%6s %10s %10s %14s %14s %10s\n", "nodes", "frames", "samples",
+              "frames/s", "samples/s", "x realtime");
+  for (int nodes : {1, 2, 4, 8, 16, 32, 64, 128}) {
+    std::vector<Arrival> arrivals = generate(nodes, duration_us);
+
+    FanIn fan_in(REORDER_WINDOW_US);
+    std::vector<MergedSample> feed;
+    feed.reserve(arrivals.size() * BOARD_SIM_CHANNELS);
+    auto start = std::chrono::steady_clock::now();
+    for (const Arrival& arrival : arrivals) {
+      Frame frame;
+      if (decode_frame(arrival.data.data(), arrival.data.size(), &frame) ==
+          FrameError::kOk) {
+        fan_in.on_frame(frame, arrival.rx_us);
+      }
+      fan_in.drain(arrival.rx_us, &feed);
+    }
+    fan_in.flush(&feed);
+    double elapsed =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+            .count();
+
+    std::printf("%6d %10zu %10zu %14.0f %14.0f %10.0f\n", nodes,
+                arrivals.size(), feed.size(), arrivals.size() / elapsed,
+                feed.size() / elapsed, seconds / elapsed);
+  }
+  return 0;
+}
@@ -0,0 +1,40 @@
+// Prints the records of a flight-data log as CSV. Reads a file written by the
+// host build or a partition image from the board:
+//
+//   esptool.py read_flash 0x110000 0x78000 datalog.bin
+//   flash_log_dump datalog.bin > datalog.csv
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+
+#include "datalog/flash_log.h"
+#include "file_flash.h"
+
+int main(int argc, char** argv) {
+  if (argc != 2) {
+    std::fprintf(stderr, "usage: %s <image>\n", argv[0]);
+    return 2;
+  }
+  // FileFlash creates missing files; this tool must not.
+  if (!std::filesystem::exists(argv[1])) {
+    std::fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+  FileFlash flash(argv[1], UINT32_MAX / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE);
+  if (!flash.ok()) {
+    std::fprintf(stderr, "can't open %s\n", argv[1]);
+    return 1;
+  }
+
+  std::printf("session,t_us,type,id,aux,value\n");
+  uint32_t sectors = read_flash_log(
+      &flash, [](uint32_t session, const LogRecord& record) {
+        std::printf("%u,%llu,%u,%u,%u,%g\n", session,
+                    static_cast<unsigned long long>(record.t_us),
+                    static_cast<unsigned>(record.type), record.id, record.aux,
+                    record.value);
+      });
+  std::fprintf(stderr, "%u sectors\n", sectors);
+  return 0;
+}
@@ -0,0 +1,276 @@
+// Live ingest daemon. Reads downlink frames from a serial device or PTY,
+// appends the samples to a time-series store and serves plotting clients on a
+// Unix socket (see Ingest::handle_request for the protocol):
+//
+//   ingestd /dev/ttyUSB0 capture/ [--baud 921600] [--socket /tmp/ingestd.sock]
+//   echo latest | nc -U /tmp/ingestd.sock
+//
+// Reports its ingest rate and decode-error rate every few seconds on stderr.
+// Also sends a heartbeat frame on the device every HEARTBEAT_PERIOD_US, which
+// tells a board on the cable to stream full-rate samples over it instead of
+// LoRa telemetry (see control/src/wired.h), and answers the board's clock
+// synchronization requests so it stamps those samples in this host's Unix
+// time; their one-way latency is then part of the report.
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ingest.h"
+#include "serial_port.h"
+#include "series_store.h"
+#include "telemetry/frame.h"
+#include "telemetry/time_sync.h"
+
+namespace {
+
+constexpr uint64_t REORDER_WINDOW_US = 200 * 1000;
+constexpr int POLL_PERIOD_MS = 10;
+constexpr uint64_t FLUSH_PERIOD_US = 1000 * 1000;
+constexpr uint64_t REPORT_PERIOD_US = 5 * 1000 * 1000;
+constexpr size_t MAX_CLIENTS = 16;
+// A quarter of the board's link timeout.
+constexpr uint64_t HEARTBEAT_PERIOD_US = 250 * 1000;
+
+volatile std::sig_atomic_t STOP = 0;
+
+// Unix time: boards synchronize their clocks to it, and captures line up
+// with other recordings of the test.
+uint64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+int listen_unix(const std::string& path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  sockaddr_un addr = {};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    close(fd);
+    return -1;
+  }
+  std::strcpy(addr.sun_path, path.c_str());
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(fd, 4) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+struct Client {
+  int fd;
+  std::string pending;
+};
+
+// Answers every complete request line. Returns false once the client is
+// gone.
+bool serve(Client* client, const Ingest& ingest) {
+  char buffer[512];
+  ssize_t n = read(client->fd, buffer, sizeof(buffer));
+  if (n <= 0) {
+    return false;
+  }
+  client->pending.append(buffer, n);
+  size_t newline;
+  while ((newline = client->pending.find('\n')) != std::string::npos) {
+    std::string reply =
+        ingest.handle_request(client->pending.substr(0, newline));
+    client->pending.erase(0, newline + 1);
+    // Replies are small; a client that can't take one is dropped.
+    if (write(client->fd, reply.data(), reply.size()) !=
+        static_cast<ssize_t>(reply.size())) {
+      return false;
+    }
+  }
+  return client->pending.size() < 4096;
+}
+
+// Returns false if the heartbeat didn't fit in the device's buffer; it is
+// simply sent again next period.
+bool send_heartbeat(int serial, uint16_t seq) {
+  uint8_t frame[FRAME_OVERHEAD];
+  size_t size = encode_frame(FrameType::kHeartbeat, 0, seq, nullptr, 0, frame,
+                             sizeof(frame));
+  return write(serial, frame, size) == static_cast<ssize_t>(size);
+}
+
+// Answers the clock synchronization requests received so far, stamping each
+// reply as late as possible.
+void send_time_replies(int serial, Ingest* ingest, uint16_t* seq) {
+  std::vector<TimeReply> requests;
+  ingest->take_time_requests(&requests);
+  for (TimeReply& reply : requests) {
+    uint8_t frame[FRAME_OVERHEAD + TIME_REPLY_PAYLOAD_SIZE];
+    reply.t3_us = now_us();
+    size_t size = encode_time_reply(++*seq, reply, frame, sizeof(frame));
+    // A lost reply only costs the board one exchange.
+    if (write(serial, frame, size) != static_cast<ssize_t>(size)) {
+      break;
+    }
+  }
+}
+
+void report(const IngestStats& stats, const IngestStats& last,
+            double seconds) {
+  std::fprintf(stderr,
+               "%.0f B/s, %.1f frames/s, %.0f samples/s, decode errors "
+               "%.4f%% (%u bad crc, %u bad length, %u bytes skipped)\n",
+               (stats.bytes - last.bytes) / seconds,
+               (stats.stream.frames - last.stream.frames) / seconds,
+               (stats.samples - last.samples) / seconds,
+               100 * stats.decode_error_rate(), stats.stream.bad_crc,
+               stats.stream.bad_length, stats.stream.skipped_bytes);
+}
+
+void report_latency(const FanIn& fan_in) {
+  for (int id = 0; id <= FRAME_MAX_NODE; id++) {
+    const NodeStats& node = fan_in.node(id);
+    if (node.synced_frames > 0) {
+      std::fprintf(stderr,
+                   "node %d: one-way latency min/mean/max %.2f/%.2f/%.2f ms\n",
+                   id, node.latency_min_us / 1e3, node.latency_mean_us() / 1e3,
+                   node.latency_max_us / 1e3);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::fprintf(stderr,
+                 "usage: %s <device> <store dir> [--baud N] [--socket PATH]\n",
+                 argv[0]);
+    return 2;
+  }
+  std::string device = argv[1];
+  std::string directory = argv[2];
+  int baud = 0;
+  std::string socket_path = "/tmp/ingestd.sock";
+  for (int i = 3; i + 1 < argc; i += 2) {
+    if (std::strcmp(argv[i], "--baud") == 0) {
+      baud = std::atoi(argv[i + 1]);
+    } else if (std::strcmp(argv[i], "--socket") == 0) {
+      socket_path = argv[i + 1];
+    }
+  }
+
+  int serial = open_serial(device, baud);
+  if (serial < 0) {
+    std::fprintf(stderr, "can't open %s\n", device.c_str());
+    return 1;
+  }
+  SeriesStore store(directory);
+  if (!store.open()) {
+    std::fprintf(stderr, "can't create %s\n", directory.c_str());
+    return 1;
+  }
+  int listener = listen_unix(socket_path);
+  if (listener < 0) {
+    std::fprintf(stderr, "can't listen on %s\n", socket_path.c_str());
+    return 1;
+  }
+  std::signal(SIGINT, [](int) { STOP = 1; });
+  std::signal(SIGTERM, [](int) { STOP = 1; });
+  std::signal(SIGPIPE, SIG_IGN);
+
+  Ingest ingest(&store, REORDER_WINDOW_US);
+  std::vector<Client> clients;
+  uint64_t next_flush_us = now_us() + FLUSH_PERIOD_US;
+  uint64_t next_heartbeat_us = now_us();
+  uint16_t heartbeat_seq = 0;
+  uint16_t time_seq = 0;
+  uint64_t last_report_us = now_us();
+  IngestStats last_stats = ingest.stats();
+
+  while (!STOP) {
+    std::vector<pollfd> fds = {{serial, POLLIN, 0}, {listener, POLLIN, 0}};
+    for (const Client& client : clients) {
+      fds.push_back({client.fd, POLLIN, 0});
+    }
+    if (poll(fds.data(), fds.size(), POLL_PERIOD_MS) < 0 && !STOP) {
+      continue;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      uint8_t buffer[4096];
+      ssize_t n;
+      while ((n = read(serial, buffer, sizeof(buffer))) > 0) {
+        ingest.on_bytes(buffer, n, now_us());
+      }
+      send_time_replies(serial, &ingest, &time_seq);
+    } else if (fds[0].revents & (POLLHUP | POLLERR)) {
+      // A PTY whose producer went away; wait for the next one.
+      usleep(POLL_PERIOD_MS * 1000);
+    }
+    uint64_t now = now_us();
+    ingest.poll(now);
+
+    if (fds[1].revents & POLLIN) {
+      int fd = accept(listener, nullptr, nullptr);
+      if (fd >= 0 && clients.size() < MAX_CLIENTS) {
+        clients.push_back({fd, ""});
+      } else if (fd >= 0) {
+        close(fd);
+      }
+    }
+    for (size_t i = fds.size() - 1; i >= 2; i--) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Client& client = clients[i - 2];
+      if (!(fds[i].revents & POLLIN) || !serve(&client, ingest)) {
+        close(client.fd);
+        clients.erase(clients.begin() + (i - 2));
+      }
+    }
+
+    if (now >= next_heartbeat_us) {
+      send_heartbeat(serial, ++heartbeat_seq);
+      next_heartbeat_us = now + HEARTBEAT_PERIOD_US;
+    }
+    if (now >= next_flush_us) {
+      store.flush();
+      next_flush_us = now + FLUSH_PERIOD_US;
+    }
+    if (now - last_report_us >= REPORT_PERIOD_US) {
+      IngestStats stats = ingest.stats();
+      report(stats, last_stats, (now - last_report_us) / 1e6);
+      report_latency(ingest.fan_in());
+      last_stats = stats;
+      last_report_us = now;
+    }
+  }
+
+  ingest.flush();
+  store.flush();
+  for (const Client& client : clients) {
+    close(client.fd);
+  }
+  close(listener);
+  unlink(socket_path.c_str());
+  close(serial);
+  IngestStats stats = ingest.stats();
+  std::fprintf(stderr, "%" PRIu64 " bytes, %u frames, %" PRIu64
+               " samples stored\n",
+               stats.bytes, stats.stream.frames, store.samples());
+  return 0;
+}
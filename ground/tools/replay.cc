@@ -0,0 +1,168 @@
+// Replays a capture through the stand logic and compares its decisions with
+// the ones the board logged, or sweeps the limit of a redline to see when it
+// would have tripped:
+//
+//   replay datalog.bin
+//   replay datalog.bin --redline 0 400 5 --sweep 0 300 500 201 > sweep.csv
+//   replay columns.bin --scale 0 0.5 4.5 1500
+//
+// Reads a column file, or a flight-data log image (the last session unless
+// --session is given). Uses the board's configuration from
+// configs/stand_config.h and configs/pt_scale_config.h. Each --redline
+// replaces the board's redlines with one on PT over MAX_PSI for PERSIST_MS
+// while armed or firing; --sweep varies the limit of one of them.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "configs/pt_scale_config.h"
+#include "configs/stand_config.h"
+#include "datalog/flash_log.h"
+#include "replay.h"
+
+namespace {
+
+const char* decision_name(DecisionType type) {
+  return type == DecisionType::kAbort ? "abort" : "step";
+}
+
+void print_decisions(const char* label,
+                     const std::vector<StandDecision>& decisions) {
+  for (const StandDecision& decision : decisions) {
+    std::printf("%s,%llu,%s,%u\n", label,
+                static_cast<unsigned long long>(decision.t_us),
+                decision_name(decision.type), decision.index);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr,
+                 "usage: %s <image> [--session N] [--redline PT MAX_PSI "
+                 "PERSIST_MS]... [--sweep REDLINE MIN MAX STEPS] [--scale PT "
+                 "V_MIN V_MAX MAX_PSI]\n",
+                 argv[0]);
+    return 2;
+  }
+  uint32_t session = UINT32_MAX;
+  int sweep_redline = -1;
+  float sweep_min = 0;
+  float sweep_max = 0;
+  int sweep_steps = 0;
+  PtScale scales[std::size(PT_SCALES)];
+  std::copy(std::begin(PT_SCALES), std::end(PT_SCALES), scales);
+  bool rescaled = false;
+  std::vector<Redline> redlines(
+      STAND_LOGIC.redlines, STAND_LOGIC.redlines + STAND_LOGIC.redline_count);
+  bool redlines_given = false;
+  for (int i = 2; i < argc; i++) {
+    if (std::strcmp(argv[i], "--session") == 0 && i + 1 < argc) {
+      session = std::strtoul(argv[++i], nullptr, 10);
+    } else if (std::strcmp(argv[i], "--redline") == 0 && i + 3 < argc) {
+      size_t pt = std::strtoul(argv[++i], nullptr, 10);
+      float max_psi = std::atof(argv[++i]);
+      float persist_ms = std::atof(argv[++i]);
+      if (pt >= std::size(PT_SCALES)) {
+        std::fprintf(stderr, "invalid PT %zu\n", pt);
+        return 2;
+      }
+      if (!redlines_given) {
+        redlines.clear();
+        redlines_given = true;
+      }
+      redlines.push_back({
+          .pt = static_cast<uint8_t>(pt),
+          .states = stand_state_bit(StandState::kArmed) |
+                    stand_state_bit(StandState::kFiring),
+          .min_psi = 0,
+          .max_psi = max_psi,
+          .persist_us = static_cast<uint32_t>(persist_ms * 1000),
+      });
+    } else if (std::strcmp(argv[i], "--sweep") == 0 && i + 4 < argc) {
+      sweep_redline = std::atoi(argv[++i]);
+      sweep_min = std::atof(argv[++i]);
+      sweep_max = std::atof(argv[++i]);
+      sweep_steps = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--scale") == 0 && i + 4 < argc) {
+      size_t pt = std::strtoul(argv[++i], nullptr, 10);
+      float v_min = std::atof(argv[++i]);
+      float v_max = std::atof(argv[++i]);
+      uint16_t max_psi = std::atoi(argv[++i]);
+      if (pt >= std::size(scales)) {
+        std::fprintf(stderr, "invalid PT %zu\n", pt);
+        return 2;
+      }
+      scales[pt] = {.voltage_range = {v_min, v_max}, .max_pressure = max_psi};
+      rescaled = true;
+    } else {
+      std::fprintf(stderr, "unknown argument %s\n", argv[i]);
+      return 2;
+    }
+  }
+  if (sweep_redline >= static_cast<int>(redlines.size()) ||
+      (sweep_redline >= 0 && sweep_steps < 1)) {
+    std::fprintf(stderr, "invalid sweep\n");
+    return 2;
+  }
+
+  std::vector<LogRecord> records;
+  std::string error;
+  if (!load_column_file(argv[1], &records, &error) &&
+      !load_flash_log(argv[1], session, &records)) {
+    std::fprintf(stderr, "can't read a capture from %s\n", argv[1]);
+    return 1;
+  }
+
+  ReplayConfig config = {.logic = STAND_LOGIC};
+  config.logic.redlines = redlines.data();
+  config.logic.redline_count = redlines.size();
+  if (rescaled) {
+    config.recorded_scales = PT_SCALES;
+    config.scales = scales;
+    config.scale_count = std::size(scales);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t samples = 0;
+  if (sweep_redline < 0) {
+    ReplayResult result = replay(records, config);
+    samples = result.samples;
+    std::printf("source,t_us,decision,index\n");
+    print_decisions("replay", result.decisions);
+    print_decisions("board", result.recorded);
+    std::fprintf(stderr, "%zu decisions, %s the board's\n",
+                 result.decisions.size(),
+                 result.matches() ? "same as" : "DIFFERENT from");
+  } else {
+    std::printf("max_psi,first_abort_us,decisions\n");
+    for (int step = 0; step < sweep_steps; step++) {
+      float max_psi =
+          sweep_steps == 1
+              ? sweep_min
+              : sweep_min + (sweep_max - sweep_min) * step / (sweep_steps - 1);
+      redlines[sweep_redline].max_psi = max_psi;
+      ReplayResult result = replay(records, config);
+      samples += result.samples;
+      std::printf("%g,%llu,%zu\n", max_psi,
+                  static_cast<unsigned long long>(result.first_abort_us()),
+                  result.decisions.size());
+    }
+  }
+  double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+          .count();
+  std::fprintf(stderr, "%zu records, %llu samples replayed in %.3f s, %.0f "
+               "samples/s\n",
+               records.size(), static_cast<unsigned long long>(samples),
+               seconds, seconds > 0 ? samples / seconds : 0);
+  return 0;
+}
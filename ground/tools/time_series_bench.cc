@@ -0,0 +1,70 @@
+// Ingest and query cost of the time series pyramid on a 10 minute, 1 kHz,
+// 7-PT capture, against scanning the raw samples of the range.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "time_series.h"
+
+namespace {
+
+constexpr int CHANNELS = 7;
+constexpr uint64_t SAMPLES = 600 * 1000;
+
+// Keeps the compiler from discarding the scans.
+volatile float SINK;
+
+double us_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+int main() {
+  std::vector<float> wave(SAMPLES);
+  for (uint64_t i = 0; i < SAMPLES; i++) {
+    wave[i] = 500 * std::sin(i * 1e-4f);
+  }
+  std::vector<TimeSeries> channels(CHANNELS);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < SAMPLES; i++) {
+    for (int c = 0; c < CHANNELS; c++) {
+      channels[c].append(i * 1000, wave[i] + c);
+    }
+  }
+  double ingest_us = us_since(start);
+  std::printf("ingest: %.1f ns/sample, %zu levels\n",
+              ingest_us * 1000 / (SAMPLES * CHANNELS), channels[0].levels());
+
+  const TimeSeries& series = channels[0];
+  std::printf("%10s %8s %12s %12s\n", "range_s", "points", "query_us",
+              "scan_us");
+  for (uint64_t range_s : {1, 10, 60, 600}) {
+    for (size_t budget : {500, 2000}) {
+      uint64_t t1_us = range_s * 1000000 - 1;
+      std::vector<SeriesPoint> points;
+      points.reserve(budget);
+      start = std::chrono::steady_clock::now();
+      series.query(0, t1_us, budget, &points);
+      double query_us = us_since(start);
+
+      // What plotting without the index costs: one pass over the range.
+      start = std::chrono::steady_clock::now();
+      size_t n = std::min<size_t>(range_s * 1000, series.size());
+      auto minmax = std::minmax_element(series.values().begin(),
+                                        series.values().begin() + n);
+      double scan_us = us_since(start);
+      SINK = *minmax.first + *minmax.second;
+      std::printf("%10llu %8zu %12.1f %12.1f\n",
+                  static_cast<unsigned long long>(range_s), points.size(),
+                  query_us, scan_us);
+    }
+  }
+  return 0;
+}